@@ -0,0 +1,288 @@
+// BdaSimulator.cc: Compute visibilities for baseline dependent averaged (BDA)
+// rows (implementation of ModelComponentVisitor).
+//
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "BdaSimulator.h"
+#include "GaussianSource.h"
+#include "PointSource.h"
+
+#include <casacore/casa/BasicSL/Constants.h>
+
+#include <cmath>
+
+namespace dp3 {
+namespace base {
+
+namespace {
+// Compute LMN coordinates of \p direction relative to \p reference.
+void radec2lmn(const Direction& reference, const Direction& direction,
+               double* lmn) {
+  const double dRA = direction.ra - reference.ra;
+  const double pDEC = direction.dec;
+  const double rDEC = reference.dec;
+  const double cDEC = cos(pDEC);
+
+  const double l = cDEC * sin(dRA);
+  const double m = sin(pDEC) * cos(rDEC) - cDEC * sin(rDEC) * cos(dRA);
+
+  lmn[0] = l;
+  lmn[1] = m;
+  lmn[2] = sqrt(1.0 - l * l - m * m);
+}
+
+float computeSmearterm(double uvw, double halfwidth) {
+  float smearterm = uvw * halfwidth;
+  return (smearterm == 0.0f) ? 1.0f
+                             : std::fabs(std::sin(smearterm) / smearterm);
+}
+
+// Compute the component spectrum for the given frequencies.
+void spectrum(const PointSource& component,
+              const std::vector<double>& frequencies, bool stokes_i_only,
+              std::vector<double>& spectrum_real,
+              std::vector<double>& spectrum_imag) {
+  const size_t n_correlations = stokes_i_only ? 1 : 4;
+  spectrum_real.resize(frequencies.size() * n_correlations);
+  spectrum_imag.resize(frequencies.size() * n_correlations);
+  double* x = spectrum_real.data();
+  double* y = spectrum_imag.data();
+  for (double frequency : frequencies) {
+    const Stokes stokes = component.stokes(frequency);
+    if (stokes_i_only) {
+      *x++ = stokes.I;
+      *y++ = 0.0;
+    } else {
+      *x++ = stokes.I + stokes.Q;
+      *y++ = 0.0;
+      *x++ = stokes.U;
+      *y++ = stokes.V;
+      *x++ = stokes.U;
+      *y++ = -stokes.V;
+      *x++ = stokes.I - stokes.Q;
+      *y++ = 0.0;
+    }
+  }
+}
+}  // Unnamed namespace.
+
+BdaSimulator::BdaSimulator(const Direction& reference, size_t n_stations,
+                           const std::vector<ChannelLayout>& layouts,
+                           bool correct_freq_smearing, bool stokes_i_only)
+    : reference_(reference),
+      n_stations_(n_stations),
+      layouts_(layouts),
+      correct_freq_smearing_(correct_freq_smearing),
+      stokes_i_only_(stokes_i_only),
+      layout_rows_(layouts.size()),
+      layout_stations_(layouts.size()),
+      station_uvw_(3 * n_stations),
+      station_phases_(n_stations),
+      shift_index_(n_stations),
+      neighbours_(n_stations),
+      station_known_(n_stations) {}
+
+void BdaSimulator::SetRows(const std::vector<Row>& rows) {
+  rows_ = rows;
+  for (std::vector<size_t>& layout_rows : layout_rows_) layout_rows.clear();
+  for (std::vector<size_t>& stations : layout_stations_) stations.clear();
+
+  // shift_index_ temporarily marks the stations that were added to the
+  // current layout.
+  for (size_t layout = 0; layout != layouts_.size(); ++layout) {
+    std::fill(shift_index_.begin(), shift_index_.end(), 0);
+    for (size_t row = 0; row != rows_.size(); ++row) {
+      const Row& r = rows_[row];
+      if (r.layout != layout || r.station1 == r.station2) continue;
+      layout_rows_[layout].push_back(row);
+      for (size_t station : {r.station1, r.station2}) {
+        if (!shift_index_[station]) {
+          shift_index_[station] = 1;
+          layout_stations_[layout].push_back(station);
+        }
+      }
+    }
+  }
+
+  SplitUVW();
+}
+
+void BdaSimulator::SplitUVW() {
+  for (auto& neighbours : neighbours_) neighbours.clear();
+  for (size_t row = 0; row != rows_.size(); ++row) {
+    const Row& r = rows_[row];
+    if (r.station1 != r.station2) {
+      neighbours_[r.station1].emplace_back(r.station2, row);
+      neighbours_[r.station2].emplace_back(r.station1, row);
+    }
+  }
+
+  std::fill(station_uvw_.begin(), station_uvw_.end(), 0.0);
+  std::fill(station_known_.begin(), station_known_.end(), 0);
+  for (size_t root = 0; root != n_stations_; ++root) {
+    if (station_known_[root] || neighbours_[root].empty()) continue;
+    station_known_[root] = 1;
+    queue_.assign(1, root);
+    for (size_t i = 0; i != queue_.size(); ++i) {
+      const size_t station = queue_[i];
+      for (const std::pair<size_t, size_t>& neighbour : neighbours_[station]) {
+        const size_t other = neighbour.first;
+        if (station_known_[other]) continue;
+        // The baseline UVW is the UVW of station2 minus that of station1.
+        const Row& r = rows_[neighbour.second];
+        const double sign = (r.station1 == station) ? 1.0 : -1.0;
+        for (size_t j = 0; j != 3; ++j) {
+          station_uvw_[3 * other + j] =
+              station_uvw_[3 * station + j] + sign * r.uvw[j];
+        }
+        station_known_[other] = 1;
+        queue_.push_back(other);
+      }
+    }
+  }
+}
+
+void BdaSimulator::simulate(const ModelComponent::ConstPtr& component) {
+  component->accept(*this);
+}
+
+void BdaSimulator::visit(const PointSource& component) {
+  AddComponent(component, nullptr);
+}
+
+void BdaSimulator::visit(const GaussianSource& component) {
+  AddComponent(component, &component);
+}
+
+void BdaSimulator::ComputeStationShifts(size_t layout) {
+  const std::vector<double>& frequencies = layouts_[layout].frequencies;
+  const size_t n_channels = frequencies.size();
+  const std::vector<size_t>& stations = layout_stations_[layout];
+  shift_real_.resize(stations.size() * n_channels);
+  shift_imag_.resize(stations.size() * n_channels);
+  for (size_t i = 0; i != stations.size(); ++i) {
+    shift_index_[stations[i]] = i * n_channels;
+    double* shift_real = &shift_real_[i * n_channels];
+    double* shift_imag = &shift_imag_[i * n_channels];
+    const double station_phase = station_phases_[stations[i]];
+    for (size_t ch = 0; ch < n_channels; ++ch) {
+      sincos(station_phase * frequencies[ch], &shift_imag[ch], &shift_real[ch]);
+    }
+  }
+}
+
+void BdaSimulator::AddComponent(const PointSource& component,
+                                const GaussianSource* gaussian) {
+  double lmn[3];
+  radec2lmn(reference_, component.direction(), lmn);
+
+  const double cinv = casacore::C::_2pi / casacore::C::c;
+  for (size_t st = 0; st < n_stations_; ++st) {
+    const double* uvw = &station_uvw_[3 * st];
+    station_phases_[st] =
+        cinv * (uvw[0] * lmn[0] + uvw[1] * lmn[1] + uvw[2] * (lmn[2] - 1.0));
+  }
+
+  // Gaussian parameters, see Simulator::visit(const GaussianSource&).
+  double cos_phi = 0.0;
+  double sin_phi = 0.0;
+  double u_scale = 0.0;
+  double v_scale = 0.0;
+  if (gaussian) {
+    const double phi =
+        casacore::C::pi_2 + gaussian->positionAngle() + casacore::C::pi;
+    cos_phi = cos(phi);
+    sin_phi = sin(phi);
+    const double fwhm2sigma = 1.0 / (2.0 * std::sqrt(2.0 * std::log(2.0)));
+    u_scale = gaussian->majorAxis() * fwhm2sigma;
+    v_scale = gaussian->minorAxis() * fwhm2sigma;
+  }
+  const double inv_c_sqr = 1.0 / (casacore::C::c * casacore::C::c);
+  const size_t n_correlations = stokes_i_only_ ? 1 : 4;
+
+  for (size_t layout = 0; layout != layouts_.size(); ++layout) {
+    const std::vector<size_t>& layout_rows = layout_rows_[layout];
+    if (layout_rows.empty()) continue;
+    const std::vector<double>& frequencies = layouts_[layout].frequencies;
+    const std::vector<double>& widths = layouts_[layout].widths;
+    const size_t n_channels = frequencies.size();
+
+    spectrum(component, frequencies, stokes_i_only_, spectrum_real_,
+             spectrum_imag_);
+
+    // Sharing station phasors costs one sincos per station and channel,
+    // instead of one per row and channel.
+    const bool use_station_shifts =
+        layout_stations_[layout].size() < layout_rows.size();
+    if (use_station_shifts) ComputeStationShifts(layout);
+
+    phasor_real_.resize(n_channels);
+    phasor_imag_.resize(n_channels);
+    amplitudes_.resize(n_channels);
+
+    for (size_t row : layout_rows) {
+      const Row& r = rows_[row];
+      const size_t p = r.station1;
+      const size_t q = r.station2;
+      const double baseline_phase = station_phases_[q] - station_phases_[p];
+
+      // Note the notation:
+      // Each complex number is represented as  (x+ j y)
+      // where x: real part, y: imaginary part
+      // Subscripts _p and _q denote stations p and q
+      if (use_station_shifts) {
+        const double* x_p = &shift_real_[shift_index_[p]];
+        const double* y_p = &shift_imag_[shift_index_[p]];
+        const double* x_q = &shift_real_[shift_index_[q]];
+        const double* y_q = &shift_imag_[shift_index_[q]];
+#pragma GCC ivdep
+        for (size_t ch = 0; ch < n_channels; ++ch) {
+          phasor_real_[ch] = x_p[ch] * x_q[ch] + y_p[ch] * y_q[ch];
+          phasor_imag_[ch] = x_p[ch] * y_q[ch] - x_q[ch] * y_p[ch];
+        }
+      } else {
+        for (size_t ch = 0; ch < n_channels; ++ch) {
+          sincos(baseline_phase * frequencies[ch], &phasor_imag_[ch],
+                 &phasor_real_[ch]);
+        }
+      }
+
+      std::fill(amplitudes_.begin(), amplitudes_.end(), 1.0);
+      if (gaussian) {
+        const double u = station_uvw_[3 * q] - station_uvw_[3 * p];
+        const double v = station_uvw_[3 * q + 1] - station_uvw_[3 * p + 1];
+        const double u_prime = u_scale * (u * cos_phi - v * sin_phi);
+        const double v_prime = v_scale * (u * sin_phi + v * cos_phi);
+        const double uv_prime = (-2.0 * casacore::C::pi * casacore::C::pi) *
+                                (u_prime * u_prime + v_prime * v_prime);
+        for (size_t ch = 0; ch < n_channels; ++ch) {
+          amplitudes_[ch] = exp(frequencies[ch] * frequencies[ch] * inv_c_sqr *
+                                uv_prime);
+        }
+      }
+      if (correct_freq_smearing_) {
+        for (size_t ch = 0; ch < n_channels; ++ch) {
+          amplitudes_[ch] *= computeSmearterm(baseline_phase, widths[ch] * 0.5);
+        }
+      }
+
+      std::complex<double>* buffer = r.buffer;
+      const double* x_c = spectrum_real_.data();
+      const double* y_c = spectrum_imag_.data();
+      for (size_t ch = 0; ch < n_channels; ++ch) {
+        const double x = amplitudes_[ch] * phasor_real_[ch];
+        const double y = amplitudes_[ch] * phasor_imag_[ch];
+        for (size_t cr = 0; cr < n_correlations; ++cr) {
+          *buffer++ += std::complex<double>(x * (*x_c) - y * (*y_c),
+                                            x * (*y_c) + y * (*x_c));
+          ++x_c;
+          ++y_c;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace base
+}  // namespace dp3
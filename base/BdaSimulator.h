@@ -0,0 +1,127 @@
+// BdaSimulator.h: Compute visibilities for baseline dependent averaged (BDA)
+// rows (implementation of ModelComponentVisitor).
+//
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DPPP_BDASIMULATOR_H
+#define DPPP_BDASIMULATOR_H
+
+#include "ModelComponent.h"
+#include "ModelComponentVisitor.h"
+#include "Direction.h"
+
+#include <complex>
+#include <utility>
+#include <vector>
+
+namespace dp3 {
+namespace base {
+
+class PointSource;
+
+/// @{
+
+/// @brief Simulator for BDA rows that share the same time.
+///
+/// Unlike Simulator, which requires that all baselines have the same
+/// channels, every row has its own channel layout. The station UVWs are
+/// derived from the UVWs of the rows, so the station phase terms of a source
+/// are computed once for all rows. Rows that have the same channel layout
+/// also share the per-channel station phasors, when that is cheaper than
+/// computing a phasor per row.
+class BdaSimulator : public ModelComponentVisitor {
+ public:
+  /// Channel frequencies and widths (Hz) of one or more baselines.
+  struct ChannelLayout {
+    std::vector<double> frequencies;
+    std::vector<double> widths;
+  };
+
+  /// A row to simulate. The simulated visibilities are added to @c buffer,
+  /// which should have room for n_channels * n_correlations values, with the
+  /// correlation varying fastest. n_correlations is 1 if stokes_i_only is
+  /// true, else 4.
+  struct Row {
+    std::size_t station1;
+    std::size_t station2;
+    const double* uvw;
+    std::size_t layout;  ///< Index in the layouts given to the constructor.
+    std::complex<double>* buffer;
+  };
+
+  /**
+   * @param reference Phase reference direction.
+   * @param n_stations Number of stations.
+   * @param layouts Channel layouts of the rows. The simulator keeps a
+   * reference, so they should remain valid while the simulator is used.
+   * @param correct_freq_smearing Correct for frequency smearing.
+   * @param stokes_i_only Stokes I only, to avoid a loop over correlations.
+   */
+  BdaSimulator(const Direction& reference, std::size_t n_stations,
+               const std::vector<ChannelLayout>& layouts,
+               bool correct_freq_smearing, bool stokes_i_only);
+
+  /// Set the rows for the next simulate() calls. All rows should have the
+  /// same time. Autocorrelations are skipped.
+  void SetRows(const std::vector<Row>& rows);
+
+  void simulate(const ModelComponent::ConstPtr& component);
+
+ private:
+  void visit(const PointSource& component) override;
+  void visit(const GaussianSource& component) override;
+
+  /// Add the visibilities of a component to the rows. If @p gaussian is not
+  /// null, its amplitude is applied.
+  void AddComponent(const PointSource& component,
+                    const GaussianSource* gaussian);
+
+  /// Derive station UVWs from the row UVWs, with a spanning forest of the
+  /// baselines. The first station in each tree gets UVW (0, 0, 0).
+  void SplitUVW();
+
+  /// Compute the station phasors for the stations of a layout.
+  void ComputeStationShifts(std::size_t layout);
+
+  Direction reference_;
+  std::size_t n_stations_;
+  const std::vector<ChannelLayout>& layouts_;
+  bool correct_freq_smearing_;
+  bool stokes_i_only_;
+
+  std::vector<Row> rows_;
+  /// Per layout, the indices of its cross-correlation rows.
+  std::vector<std::vector<std::size_t>> layout_rows_;
+  /// Per layout, the stations that its rows use.
+  std::vector<std::vector<std::size_t>> layout_stations_;
+
+  /// Station UVWs, 3 values per station.
+  std::vector<double> station_uvw_;
+  std::vector<double> station_phases_;
+  /// Per station, the index of its phasors in shift_real_ and shift_imag_.
+  std::vector<std::size_t> shift_index_;
+  /// Station phasors of the current layout, shape (n stations, n channels).
+  std::vector<double> shift_real_;
+  std::vector<double> shift_imag_;
+  /// Spectrum of the current component and layout, shape (n channels,
+  /// n correlations).
+  std::vector<double> spectrum_real_;
+  std::vector<double> spectrum_imag_;
+  std::vector<double> phasor_real_;
+  std::vector<double> phasor_imag_;
+  std::vector<double> amplitudes_;
+
+  /// Scratch space for SplitUVW(): per station, pairs of (other station,
+  /// row index).
+  std::vector<std::vector<std::pair<std::size_t, std::size_t>>> neighbours_;
+  std::vector<std::size_t> queue_;
+  std::vector<char> station_known_;
+};
+
+/// @}
+
+}  // namespace base
+}  // namespace dp3
+
+#endif
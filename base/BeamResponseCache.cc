@@ -0,0 +1,199 @@
+// BeamResponseCache.cc: Cache of beam responses that is shared between steps
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "BeamResponseCache.h"
+
+#include <casacore/casa/Arrays/Vector.h>
+
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+
+namespace dp3 {
+namespace base {
+
+bool BeamResponseCache::Key::operator<(const Key& other) const {
+  return std::tie(context, mode, direction_type, longitude, latitude, time) <
+         std::tie(other.context, other.mode, other.direction_type,
+                  other.longitude, other.latitude, other.time);
+}
+
+BeamResponseCache& BeamResponseCache::Instance() {
+  static BeamResponseCache cache;
+  return cache;
+}
+
+void BeamResponseCache::SetMaxSize(size_t max_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_size_ = max_size;
+  Shrink();
+}
+
+size_t BeamResponseCache::MaxSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_size_;
+}
+
+void BeamResponseCache::SetTimeInterval(double time_interval) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (time_interval != time_interval_) {
+    time_interval_ = time_interval;
+    entries_.clear();
+    lru_.clear();
+    size_ = 0;
+  }
+}
+
+double BeamResponseCache::TimeInterval() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return time_interval_;
+}
+
+size_t BeamResponseCache::GetContext(const std::string& description) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto inserted = contexts_.emplace(description, contexts_.size());
+  return inserted.first->second;
+}
+
+std::string BeamResponseCache::MakeContextDescription(
+    const std::string& ms_name,
+    everybeam::ElementResponseModel element_response_model,
+    bool use_channel_frequency,
+    const casacore::Vector<casacore::String>& station_names,
+    const std::vector<double>& channel_frequencies) {
+  std::ostringstream description;
+  description << ms_name << ';' << static_cast<int>(element_response_model)
+              << ';' << use_channel_frequency << ';';
+  for (const casacore::String& name : station_names) {
+    description << name << ',';
+  }
+  description << ';' << std::setprecision(17);
+  for (double frequency : channel_frequencies) {
+    description << frequency << ',';
+  }
+  return description.str();
+}
+
+void BeamResponseCache::Get(size_t context, everybeam::CorrectionMode mode,
+                            const casacore::MDirection& direction, double time,
+                            const Evaluator& evaluate, Values& values) {
+  double time_interval;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    time_interval = max_size_ == 0 ? -1.0 : time_interval_;
+  }
+  if (time_interval < 0.0) {
+    evaluate(time, values);
+    return;
+  }
+
+  const casacore::Vector<double> angles =
+      direction.getValue().getAngle().getValue();
+  Key key;
+  key.context = context;
+  key.mode = static_cast<int>(mode);
+  key.direction_type = direction.getRef().getType();
+  key.longitude = angles[0];
+  key.latitude = angles[1];
+
+  if (time_interval == 0.0) {
+    key.time = time;
+    values = *Lookup(key, evaluate);
+    return;
+  }
+
+  const double position = time / time_interval;
+  const double index = std::floor(position);
+  key.time = index * time_interval;
+  const std::shared_ptr<const Values> first = Lookup(key, evaluate);
+  key.time = (index + 1.0) * time_interval;
+  const std::shared_ptr<const Values> second = Lookup(key, evaluate);
+
+  const double weight = position - index;
+  values.resize(first->size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = (*first)[i] * (1.0 - weight) + (*second)[i] * weight;
+  }
+}
+
+std::shared_ptr<const BeamResponseCache::Values> BeamResponseCache::Lookup(
+    const Key& key, const Evaluator& evaluate) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::map<Key, Entry>::iterator iter = entries_.find(key);
+  if (iter != entries_.end()) {
+    ++n_hits_;
+    lru_.splice(lru_.begin(), lru_, iter->second.lru_position);
+    const std::shared_future<std::shared_ptr<const Values>> future =
+        iter->second.values;
+    lock.unlock();
+    // This waits if another thread is still evaluating the entry.
+    return future.get();
+  }
+
+  ++n_misses_;
+  std::promise<std::shared_ptr<const Values>> promise;
+  lru_.push_front(key);
+  Entry& entry = entries_[key];
+  entry.values = promise.get_future().share();
+  entry.lru_position = lru_.begin();
+  lock.unlock();
+
+  std::shared_ptr<Values> values = std::make_shared<Values>();
+  try {
+    evaluate(key.time, *values);
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+    lock.lock();
+    iter = entries_.find(key);
+    if (iter != entries_.end()) {
+      lru_.erase(iter->second.lru_position);
+      entries_.erase(iter);
+    }
+    throw;
+  }
+  promise.set_value(values);
+
+  lock.lock();
+  // The entry may have been removed by Shrink() in the meantime.
+  iter = entries_.find(key);
+  if (iter != entries_.end()) {
+    iter->second.size = values->size() * sizeof(aocommon::MC2x2);
+    size_ += iter->second.size;
+    Shrink();
+  }
+  return values;
+}
+
+void BeamResponseCache::Shrink() {
+  while (!lru_.empty() && (size_ > max_size_ || max_size_ == 0)) {
+    std::map<Key, Entry>::iterator iter = entries_.find(lru_.back());
+    size_ -= iter->second.size;
+    entries_.erase(iter);
+    lru_.pop_back();
+  }
+}
+
+void BeamResponseCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+  size_ = 0;
+  n_hits_ = 0;
+  n_misses_ = 0;
+}
+
+size_t BeamResponseCache::NHits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return n_hits_;
+}
+
+size_t BeamResponseCache::NMisses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return n_misses_;
+}
+
+}  // namespace base
+}  // namespace dp3
@@ -0,0 +1,143 @@
+// BeamResponseCache.h: Cache of beam responses that is shared between steps
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/// @file
+/// @brief Cache of beam responses that is shared between steps
+
+#ifndef DP3_BEAMRESPONSECACHE_H
+#define DP3_BEAMRESPONSECACHE_H
+
+#include <EveryBeam/correctionmode.h>
+#include <EveryBeam/elementresponse.h>
+
+#include <aocommon/matrix2x2.h>
+
+#include <casacore/casa/Arrays/Vector.h>
+#include <casacore/casa/BasicSL/String.h>
+#include <casacore/measures/Measures/MDirection.h>
+
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dp3 {
+namespace base {
+
+/// @brief Cache of beam responses that is shared between steps.
+///
+/// Steps that apply the beam (ApplyBeam, and OnePredict as used by Predict,
+/// DDECal, GainCal and H5ParmPredict) can evaluate the same beam responses
+/// for the same directions and times. This process-wide cache lets them
+/// share those evaluations.
+///
+/// An entry holds the (non-inverted) responses of all stations and channels
+/// for a context, correction mode, direction and time. The context describes
+/// the telescope, the stations and the channel frequencies; see
+/// MakeContextDescription(). If a time interval is set, responses are cached
+/// on a grid of times with that interval and linearly interpolated in
+/// between.
+///
+/// The cache is thread-safe. When several threads request the same entry,
+/// only one evaluates it while the others wait. The least recently used
+/// entries are removed when the cache gets larger than its maximum size. By
+/// default the maximum size is 0, which disables the cache.
+class BeamResponseCache {
+ public:
+  /// Responses of all stations and channels, with index
+  /// station * n_channels + channel.
+  using Values = std::vector<aocommon::MC2x2>;
+
+  /// Function that evaluates the responses at the given time.
+  using Evaluator = std::function<void(double time, Values& values)>;
+
+  /// Get the cache of the process.
+  static BeamResponseCache& Instance();
+
+  /// Set the maximum size of the cached values in bytes. 0 disables the
+  /// cache and removes all entries.
+  void SetMaxSize(size_t max_size);
+  size_t MaxSize() const;
+
+  /// Set the time interval of the grid of cached times in seconds. 0 means
+  /// that responses are cached for the exact times that are requested.
+  /// Changing the interval removes all entries.
+  void SetTimeInterval(double time_interval);
+  double TimeInterval() const;
+
+  /// Get the context id for a context description. Steps that use the same
+  /// description share cache entries.
+  size_t GetContext(const std::string& description);
+
+  /// Make a context description for a telescope read from an MS.
+  static std::string MakeContextDescription(
+      const std::string& ms_name,
+      everybeam::ElementResponseModel element_response_model,
+      bool use_channel_frequency,
+      const casacore::Vector<casacore::String>& station_names,
+      const std::vector<double>& channel_frequencies);
+
+  /// Get the responses for a direction at a time into @p values. Responses
+  /// that are not cached are evaluated with @p evaluate. If the cache is
+  /// disabled, @p evaluate is called directly.
+  void Get(size_t context, everybeam::CorrectionMode mode,
+           const casacore::MDirection& direction, double time,
+           const Evaluator& evaluate, Values& values);
+
+  /// Remove all entries and reset the statistics.
+  void Clear();
+
+  size_t NHits() const;
+  size_t NMisses() const;
+
+ private:
+  struct Key {
+    size_t context;
+    int mode;
+    int direction_type;
+    double longitude;
+    double latitude;
+    double time;
+
+    bool operator<(const Key& other) const;
+  };
+
+  struct Entry {
+    std::shared_future<std::shared_ptr<const Values>> values;
+    std::list<Key>::iterator lru_position;
+    size_t size = 0;
+  };
+
+  BeamResponseCache() = default;
+  BeamResponseCache(const BeamResponseCache&) = delete;
+  BeamResponseCache& operator=(const BeamResponseCache&) = delete;
+
+  /// Get the values of an entry, evaluating them if they are not cached.
+  std::shared_ptr<const Values> Lookup(const Key& key,
+                                       const Evaluator& evaluate);
+
+  /// Remove the least recently used entries until the cache fits in its
+  /// maximum size. The mutex must be locked.
+  void Shrink();
+
+  mutable std::mutex mutex_;
+  size_t max_size_ = 0;
+  double time_interval_ = 0.0;
+  size_t size_ = 0;
+  size_t n_hits_ = 0;
+  size_t n_misses_ = 0;
+  std::map<std::string, size_t> contexts_;
+  std::map<Key, Entry> entries_;
+  /// Keys of the entries, the most recently used first.
+  std::list<Key> lru_;
+};
+
+}  // namespace base
+}  // namespace dp3
+
+#endif
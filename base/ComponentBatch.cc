@@ -0,0 +1,89 @@
+// ComponentBatch.cc: Model components of one kind, stored as arrays of their
+// properties.
+//
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "ComponentBatch.h"
+
+#include "GaussianSource.h"
+#include "ModelComponentVisitor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace dp3 {
+namespace base {
+
+namespace {
+/// Determines the kind of a component.
+class KindVisitor : public ModelComponentVisitor {
+ public:
+  void visit(const PointSource&) override {
+    kind = ComponentBatch::Kind::kPoint;
+  }
+  void visit(const GaussianSource&) override {
+    kind = ComponentBatch::Kind::kGaussian;
+  }
+
+  ComponentBatch::Kind kind = ComponentBatch::Kind::kPoint;
+};
+
+/// Index of the batch for a kind and spectrum, see MakeComponentBatches().
+size_t BatchIndex(ComponentBatch::Kind kind, bool has_spectrum) {
+  return (kind == ComponentBatch::Kind::kGaussian ? 2 : 0) +
+         (has_spectrum ? 1 : 0);
+}
+}  // namespace
+
+void ComponentBatch::Add(const PointSource::ConstPtr& source) {
+  directions_.push_back(source->direction());
+  // Without a spectrum, the Stokes parameters do not depend on the frequency.
+  stokes_.push_back(has_spectrum_ ? Stokes() : source->stokes(0.0));
+  sources_.push_back(source);
+  if (kind_ == Kind::kGaussian) {
+    const GaussianSource& gaussian =
+        static_cast<const GaussianSource&>(*source);
+    position_angles_.push_back(gaussian.positionAngle());
+    major_axes_.push_back(gaussian.majorAxis());
+    minor_axes_.push_back(gaussian.minorAxis());
+  }
+}
+
+std::vector<ComponentBatch> MakeComponentBatches(
+    const std::vector<std::pair<ModelComponent::ConstPtr, Patch::ConstPtr>>&
+        source_list,
+    size_t max_batch_size, bool per_patch) {
+  assert(max_batch_size > 0);
+  std::vector<ComponentBatch> batches;
+  // The batch that is being filled for each kind and spectrum, as an index
+  // in batches.
+  const size_t kNoBatch = std::numeric_limits<size_t>::max();
+  std::vector<size_t> open_batches(4, kNoBatch);
+  Patch::ConstPtr patch;
+  KindVisitor visitor;
+  for (const auto& source : source_list) {
+    if (per_patch && source.second != patch) {
+      std::fill(open_batches.begin(), open_batches.end(), kNoBatch);
+      patch = source.second;
+    }
+    // All model components are point sources or derived from them.
+    const PointSource::ConstPtr point_source =
+        std::static_pointer_cast<const PointSource>(source.first);
+    source.first->accept(visitor);
+    const bool has_spectrum = point_source->hasSpectralTerms() ||
+                              point_source->hasRotationMeasure();
+    size_t& index = open_batches[BatchIndex(visitor.kind, has_spectrum)];
+    if (index == kNoBatch || batches[index].Size() == max_batch_size) {
+      index = batches.size();
+      batches.emplace_back(visitor.kind, has_spectrum,
+                           per_patch ? patch : nullptr);
+    }
+    batches[index].Add(point_source);
+  }
+  return batches;
+}
+
+}  // namespace base
+}  // namespace dp3
@@ -0,0 +1,96 @@
+// ComponentBatch.h: Model components of one kind, stored as arrays of their
+// properties.
+//
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DP3_COMPONENTBATCH_H
+#define DP3_COMPONENTBATCH_H
+
+#include "Direction.h"
+#include "ModelComponent.h"
+#include "Patch.h"
+#include "PointSource.h"
+#include "Stokes.h"
+
+#include <utility>
+#include <vector>
+
+namespace dp3 {
+namespace base {
+
+/// @{
+
+/// @brief Model components of one kind, stored as arrays of their properties.
+///
+/// The Simulator predicts all components of a batch together, which avoids
+/// the visitor dispatch per component and adds all components to the
+/// visibilities of a baseline while these are in the cache. A batch holds
+/// either point sources or Gaussian sources, which either all have a flat
+/// spectrum or all have spectral terms or a rotation measure.
+class ComponentBatch {
+ public:
+  enum class Kind { kPoint, kGaussian };
+
+  ComponentBatch(Kind kind, bool has_spectrum, Patch::ConstPtr patch)
+      : kind_(kind), has_spectrum_(has_spectrum), patch_(std::move(patch)) {}
+
+  Kind GetKind() const { return kind_; }
+
+  /// Tell if the Stokes parameters of the components depend on the
+  /// frequency. If not, they are given by GetStokes().
+  bool HasSpectrum() const { return has_spectrum_; }
+
+  /// The patch of the components, if the batch was made per patch.
+  const Patch::ConstPtr& GetPatch() const { return patch_; }
+
+  size_t Size() const { return directions_.size(); }
+
+  /// Add a point source, or a Gaussian source for a Gaussian batch.
+  void Add(const PointSource::ConstPtr& source);
+
+  const std::vector<Direction>& GetDirections() const { return directions_; }
+  const std::vector<Stokes>& GetStokes() const { return stokes_; }
+  /// The sources, to evaluate their spectra.
+  const std::vector<PointSource::ConstPtr>& GetSources() const {
+    return sources_;
+  }
+
+  /// @name Gaussian properties
+  /// Position angles and axis lengths (FWHM) in radians.
+  /// @{
+  const std::vector<double>& GetPositionAngles() const {
+    return position_angles_;
+  }
+  const std::vector<double>& GetMajorAxes() const { return major_axes_; }
+  const std::vector<double>& GetMinorAxes() const { return minor_axes_; }
+  /// @}
+
+ private:
+  Kind kind_;
+  bool has_spectrum_;
+  Patch::ConstPtr patch_;
+  std::vector<Direction> directions_;
+  std::vector<Stokes> stokes_;
+  std::vector<PointSource::ConstPtr> sources_;
+  std::vector<double> position_angles_;
+  std::vector<double> major_axes_;
+  std::vector<double> minor_axes_;
+};
+
+/// Sort the components of a source list into batches of at most
+/// @p max_batch_size components. If @p per_patch is true, a batch only holds
+/// components of one patch, and the batches of a patch are consecutive. This
+/// is needed when a beam is applied per patch. Otherwise, the batches do not
+/// refer to a patch.
+std::vector<ComponentBatch> MakeComponentBatches(
+    const std::vector<std::pair<ModelComponent::ConstPtr, Patch::ConstPtr>>&
+        source_list,
+    size_t max_batch_size, bool per_patch);
+
+/// @}
+
+}  // namespace base
+}  // namespace dp3
+
+#endif
@@ -56,8 +56,16 @@
 #include <casacore/casa/OS/DirectoryIterator.h>
 #include <casacore/casa/OS/Timer.h>
 #include <casacore/casa/OS/DynLib.h>
+#include <casacore/casa/Quanta/MVTime.h>
 #include <casacore/casa/Utilities/Regex.h>
 
+#include <aocommon/threadpool.h>
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 using dp3::steps::InputStep;
 using dp3::steps::MSBDAWriter;
 using dp3::steps::MSUpdater;
@@ -70,6 +78,31 @@ using dp3::common::operator<<;
 namespace dp3 {
 namespace base {
 
+namespace {
+// Show the parset keys that were not used, which might be misspelled.
+void checkUnusedKeys(const common::ParameterSet& parset, int checkparset) {
+  if (checkparset >= 0) {
+    std::vector<std::string> unused = parset.unusedKeys();
+    if (!unused.empty()) {
+      DPLOG_WARN_STR(
+          "\n*** WARNING: the following parset keywords were not used ***"
+          << "\n             maybe they are misspelled"
+          << "\n    " << unused << std::endl);
+      if (checkparset != 0) throw Exception("Unused parset keywords found");
+    }
+  }
+}
+
+// Show the use of the beam response cache, if it is enabled.
+void showBeamCacheCounts() {
+  const BeamResponseCache& cache = BeamResponseCache::Instance();
+  if (cache.MaxSize() > 0) {
+    DPLOG_INFO_STR("\nBeam response cache: " << cache.NHits() << " hits, "
+                                             << cache.NMisses() << " misses");
+  }
+}
+}  // namespace
+
 // Initialize the statics.
 std::map<std::string, DP3::StepCtor*> DP3::theirStepMap;
 
@@ -137,6 +170,23 @@ void DP3::execute(const string& parsetName, int argc, char* argv[]) {
 
   unsigned int numThreads = parset.getInt("numthreads", 0);
 
+  // The beam response cache is shared by the steps that apply the beam.
+  BeamResponseCache::Instance().SetMaxSize(
+      std::size_t(parset.getUint("beamcachesize", 0)) * 1024 * 1024);
+  BeamResponseCache::Instance().SetTimeInterval(
+      parset.getDouble("beamcacheinterval", 0.0));
+
+  const unsigned int nTimeChunks = parset.getUint("timechunks", 1);
+  if (nTimeChunks > 1) {
+    executeTimeChunks(parset, nTimeChunks, numThreads, checkparset,
+                      showcounts);
+    std::ostringstream ostr;
+    ostr << std::endl;
+    timer.show(ostr, "Total NDPPP time");
+    DPLOG_INFO(ostr.str(), true);
+    return;
+  }
+
   // Create the steps, link them together
   std::shared_ptr<InputStep> firstStep = makeMainSteps(parset);
 
@@ -147,13 +197,7 @@ void DP3::execute(const string& parsetName, int argc, char* argv[]) {
   }
 
   // Call updateInfo()
-  DPInfo dpInfo;
-  if (numThreads > 0) {
-    dpInfo.setNThreads(numThreads);
-  }
-  dpInfo = firstStep->setInfo(dpInfo);
-  // Tell the reader if visibility data needs to be read.
-  firstStep->setReadVisData(dpInfo.needVisData());
+  initializeSteps(*firstStep, numThreads);
 
   // Show the steps.
   step = firstStep;
@@ -164,17 +208,7 @@ void DP3::execute(const string& parsetName, int argc, char* argv[]) {
     lastStep = step;
     step = step->getNextStep();
   }
-  if (checkparset >= 0) {
-    // Show unused parameters (might be misspelled).
-    std::vector<std::string> unused = parset.unusedKeys();
-    if (!unused.empty()) {
-      DPLOG_WARN_STR(
-          "\n*** WARNING: the following parset keywords were not used ***"
-          << "\n             maybe they are misspelled"
-          << "\n    " << unused << std::endl);
-      if (checkparset != 0) throw Exception("Unused parset keywords found");
-    }
-  }
+  checkUnusedKeys(parset, checkparset);
   // Process until the end.
   unsigned int ntodo = firstStep->getInfo().ntime();
   DPLOG_INFO_STR("Processing " << ntodo << " time slots ...");
@@ -211,6 +245,7 @@ void DP3::execute(const string& parsetName, int argc, char* argv[]) {
       DPLOG_INFO(os.str(), true);
       step = step->getNextStep();
     }
+    showBeamCacheCounts();
   }
   // Show the overall timer.
   nstimer.stop();
@@ -241,6 +276,135 @@ void DP3::execute(const string& parsetName, int argc, char* argv[]) {
   // The destructors are called automatically at this point.
 }
 
+void DP3::executeTimeChunks(common::ParameterSet& parset,
+                            unsigned int nChunks, unsigned int numThreads,
+                            int checkparset, bool showcounts) {
+  // Get the time range of the input from a separate reader.
+  double startTime = 0.0;
+  double interval = 0.0;
+  unsigned int nTimes = 0;
+  {
+    std::unique_ptr<InputStep> reader = InputStep::CreateReader(parset);
+    startTime = reader->getInfo().startTime();
+    interval = reader->getInfo().timeInterval();
+    nTimes = reader->getInfo().ntime();
+  }
+  const unsigned int chunkSize = (nTimes + nChunks - 1) / nChunks;
+  if (numThreads == 0) {
+    numThreads = aocommon::ThreadPool::NCPUs();
+  }
+  const unsigned int chainThreads = std::max(1u, numThreads / nChunks);
+
+  // Casacore tables and HDF5 files can not be used by multiple threads at the
+  // same time, so all chains share a mutex for accessing them.
+  std::mutex ioMutex;
+  std::vector<std::shared_ptr<InputStep>> chains;
+  parset.remove("msin.starttimeslot");
+  parset.remove("msin.endtime");
+  for (unsigned int first = 0; first < nTimes; first += chunkSize) {
+    // The steps read the parset when they are created, so the time range of
+    // the reader can be changed for each chain. The reader rounds starttime
+    // up to a time slot, so give the start of the first time slot.
+    const double chunkStart = startTime + first * interval;
+    parset.replace("msin.starttime",
+                   casacore::MVTime(chunkStart / (24 * 3600.))
+                       .string(casacore::MVTime::YMD, 12));
+    parset.replace("msin.ntimes",
+                   std::to_string(std::min(chunkSize, nTimes - first)));
+
+    std::shared_ptr<InputStep> firstStep = makeMainSteps(parset);
+    for (Step::ShPtr step = firstStep; step; step = step->getNextStep()) {
+      if (!step->canSplitTime()) {
+        std::ostringstream os;
+        step->show(os);
+        throw std::invalid_argument(
+            "timechunks can not be used, since the following step can not "
+            "process separate time ranges:\n" +
+            os.str() +
+            "Time chunks only support steps that keep no state over time "
+            "slots, so e.g. no averaging, and an msout that updates the "
+            "input MS.");
+      }
+    }
+    firstStep->setIoMutex(&ioMutex);
+    initializeSteps(*firstStep, chainThreads);
+    chains.push_back(firstStep);
+  }
+  if (chains.empty()) {
+    throw std::runtime_error("No time slots to process");
+  }
+
+  // Show the steps of the first chain; the others only differ in time range.
+  for (Step::ShPtr step = chains.front(); step; step = step->getNextStep()) {
+    std::ostringstream os;
+    step->show(os);
+    DPLOG_INFO(os.str(), true);
+  }
+  checkUnusedKeys(parset, checkparset);
+
+  DPLOG_INFO_STR("Processing " << nTimes << " time slots in " << chains.size()
+                               << " chunks of at most " << chunkSize
+                               << " time slots ...");
+  std::vector<std::exception_ptr> errors(chains.size());
+  std::vector<std::thread> threads;
+  threads.reserve(chains.size());
+  for (std::size_t i = 0; i < chains.size(); ++i) {
+    threads.emplace_back([&chains, &errors, i]() {
+      try {
+        DPBuffer buf;
+        while (chains[i]->process(buf)) {
+        }
+        chains[i]->finish();
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  DPLOG_INFO_STR("Finishing processing ...");
+
+  // Only the first chain adds to the MS, so e.g. the history is written once.
+  Step::ShPtr lastStep = chains.front();
+  while (lastStep->getNextStep()) {
+    lastStep = lastStep->getNextStep();
+  }
+  lastStep->addToMS("");
+
+  if (showcounts) {
+    for (std::size_t i = 0; i < chains.size(); ++i) {
+      DPLOG_INFO_STR("\nCounts of time chunk " << i);
+      for (Step::ShPtr step = chains[i]; step; step = step->getNextStep()) {
+        std::ostringstream os;
+        step->showCounts(os);
+        DPLOG_INFO(os.str(), true);
+      }
+    }
+    showBeamCacheCounts();
+  }
+}
+
+void DP3::initializeSteps(InputStep& firstStep, unsigned int numThreads) {
+  DPInfo dpInfo;
+  if (numThreads > 0) {
+    dpInfo.setNThreads(numThreads);
+  }
+  dpInfo = firstStep.setInfo(dpInfo);
+  // Tell the reader if visibility data needs to be read, and for which
+  // baselines.
+  if (dpInfo.needVisData() && !dpInfo.needVisDataBaselines().empty()) {
+    firstStep.setReadVisDataBaselines(dpInfo.needVisDataBaselines());
+  } else {
+    firstStep.setReadVisData(dpInfo.needVisData());
+  }
+}
+
 std::shared_ptr<InputStep> DP3::makeMainSteps(
     const common::ParameterSet& parset) {
   std::shared_ptr<InputStep> inputStep = InputStep::CreateReader(parset);
@@ -348,9 +512,11 @@ std::shared_ptr<Step> DP3::makeSingleStep(const std::string& type,
   } else if (type == "madflagger" || type == "madflag") {
     step = std::make_shared<steps::MedFlagger>(inputStep, parset, prefix);
   } else if (type == "preflagger" || type == "preflag") {
-    step = std::make_shared<steps::PreFlagger>(inputStep, parset, prefix);
+    step = std::make_shared<steps::PreFlagger>(inputStep, parset, prefix,
+                                               inputType);
   } else if (type == "uvwflagger" || type == "uvwflag") {
-    step = std::make_shared<steps::UVWFlagger>(inputStep, parset, prefix);
+    step = std::make_shared<steps::UVWFlagger>(inputStep, parset, prefix,
+                                               inputType);
   } else if (type == "columnreader") {
     step = std::make_shared<steps::ColumnReader>(*inputStep, parset, prefix);
   } else if (type == "counter" || type == "count") {
@@ -373,7 +539,8 @@ std::shared_ptr<Step> DP3::makeSingleStep(const std::string& type,
   } else if (type == "filter") {
     step = std::make_shared<steps::Filter>(inputStep, parset, prefix);
   } else if (type == "applycal" || type == "correct") {
-    step = std::make_shared<steps::ApplyCal>(inputStep, parset, prefix);
+    step = std::make_shared<steps::ApplyCal>(inputStep, parset, prefix, false,
+                                             "", inputType);
   } else if (type == "predict") {
     step =
         std::make_shared<steps::Predict>(*inputStep, parset, prefix, inputType);
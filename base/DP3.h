@@ -65,6 +65,19 @@ class DP3 {
                                            steps::Step::MsType inputType);
 
  private:
+  /// Run separate step chains on separate time ranges of the input
+  /// concurrently. Each chain is created from the parset, after limiting the
+  /// time range of msin in it to its chunk. It throws if a step can not be
+  /// used on separate time ranges.
+  static void executeTimeChunks(common::ParameterSet& parset,
+                                unsigned int nChunks, unsigned int numThreads,
+                                int checkparset, bool showcounts);
+
+  /// Call updateInfo() of the steps and tell the reader which visibility
+  /// data needs to be read.
+  static void initializeSteps(steps::InputStep& firstStep,
+                              unsigned int numThreads);
+
   /// Create an output step, either an MSWriter, MSUpdater or an MSBDAWriter
   /// If no data are modified (for example if only count was done),
   /// still an MSUpdater is created, but it will not write anything.
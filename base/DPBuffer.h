@@ -47,7 +47,9 @@ namespace base {
 ///   <td>The data flags as [ncorr,nchan,nbaseline] (True is bad).
 ///       Note that the ncorr axis is redundant because NDPPP will always
 ///       have the same flag for all correlations. The reason all
-///       correlations are there is because the MS expects them.</td>
+///       correlations are there is because the MS expects them.
+///       Class PackedFlags can hold them in compact form (one bit per
+///       channel and baseline), e.g. when a step keeps them in memory.</td>
 ///  </tr>
 ///  <tr>
 ///   <td>WEIGHT</td>
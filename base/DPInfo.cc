@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <numeric>
 
 using namespace casacore;
@@ -177,6 +178,32 @@ bool DPInfo::channelsAreRegular() const {
   return true;
 }
 
+std::vector<std::size_t> DPInfo::BdaChannelStarts(std::size_t baseline) const {
+  const std::vector<double>& widths =
+      chanWidths(hasBDAChannels() ? baseline : 0);
+  const double total_bw =
+      std::accumulate(channel_widths_.front().begin(),
+                      channel_widths_.front().end(), 0.0);
+  const double single_channel_bw = total_bw / n_channels_;
+  std::vector<std::size_t> starts;
+  starts.reserve(widths.size() + 1);
+  starts.push_back(0);
+  for (double width : widths) {
+    const std::size_t n = std::max(1.0, std::round(width / single_channel_bw));
+    starts.push_back(std::min<std::size_t>(starts.back() + n, n_channels_));
+  }
+  return starts;
+}
+
+std::pair<unsigned int, unsigned int> DPInfo::TimeSlots(
+    double time, double interval) const {
+  const double first = (time - 0.5 * interval - start_time_) / time_interval_;
+  const unsigned int first_slot = std::max(0.0, std::round(first));
+  const unsigned int n_slots =
+      std::max(1.0, std::round(interval / time_interval_));
+  return std::make_pair(first_slot, first_slot + n_slots);
+}
+
 void DPInfo::set(const MPosition& arrayPos, const MDirection& phaseCenter,
                  const MDirection& delayCenter, const MDirection& tileBeamDir) {
   array_position_ = arrayPos;
@@ -203,6 +230,25 @@ void DPInfo::set(const Vector<casacore::String>& antNames,
   setAntUsed();
 }
 
+void DPInfo::setNeedVisData(const std::vector<bool>& baselines) {
+  if (!need_data_) {
+    need_data_ = true;
+    need_data_baselines_ = baselines;
+  } else if (need_data_baselines_.size() != baselines.size()) {
+    // All baselines are needed already, or the vectors do not refer to the
+    // same baselines.
+    need_data_baselines_.clear();
+  } else {
+    std::transform(need_data_baselines_.begin(), need_data_baselines_.end(),
+                   baselines.begin(), need_data_baselines_.begin(),
+                   std::logical_or<bool>());
+  }
+  if (std::all_of(need_data_baselines_.begin(), need_data_baselines_.end(),
+                  [](bool need) { return need; })) {
+    need_data_baselines_.clear();
+  }
+}
+
 void DPInfo::setAntUsed() {
   antennas_used_.clear();
   antenna_map_.resize(antenna_names_.size());
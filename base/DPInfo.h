@@ -19,6 +19,8 @@
 
 #include <EveryBeam/correctionmode.h>
 
+#include <utility>
+
 namespace dp3 {
 namespace steps {
 class InputStep;
@@ -224,6 +226,11 @@ class DPInfo {
 
   /// Is the visibility data needed?
   bool needVisData() const { return need_data_; }
+  /// Get the baselines for which the visibility data is needed.
+  /// An empty vector means all baselines.
+  const std::vector<bool>& needVisDataBaselines() const {
+    return need_data_baselines_;
+  }
   /// Does the last step need to write data and/or flags?
   bool needWrite() const {
     return write_data_ || write_flags_ || write_weights_;
@@ -235,7 +242,16 @@ class DPInfo {
   bool metaChanged() const { return meta_changed_; }
 
   /// Set if visibility data needs to be read.
-  void setNeedVisData() { need_data_ = true; }
+  void setNeedVisData() {
+    need_data_ = true;
+    need_data_baselines_.clear();
+  }
+  /// Set that visibility data needs to be read, but only for the baselines
+  /// that are true in @p baselines. It is combined with the needs of other
+  /// steps, so the data of a baseline is read if any step needs it.
+  /// A step that changes the baselines should call setNeedVisData(), since
+  /// the vector refers to the baselines of the input step.
+  void setNeedVisData(const std::vector<bool>& baselines);
   /// Set if data needs to be written.
   void setWriteData() { write_data_ = true; }
   void setWriteFlags() { write_flags_ = true; }
@@ -282,6 +298,18 @@ class DPInfo {
   /// Determine if the channels have a regular layout.
   bool channelsAreRegular() const;
 
+  /// For BDA data, get the full resolution channels that the channels of a
+  /// baseline cover: channel i covers full resolution channels
+  /// [starts[i], starts[i+1]). The returned vector has one more element than
+  /// the number of channels of the baseline. As in BDAExpander, the full
+  /// resolution channel width is the total bandwidth divided by nchan().
+  std::vector<std::size_t> BdaChannelStarts(std::size_t baseline) const;
+
+  /// Get the full resolution time slots [first, second) that a (BDA) row
+  /// with the given centroid time and interval covers.
+  std::pair<unsigned int, unsigned int> TimeSlots(double time,
+                                                  double interval) const;
+
  private:
   /// Set which antennae are actually used.
   void setAntUsed();
@@ -291,6 +319,8 @@ class DPInfo {
       const casacore::MeasureHolder fromMeas);
 
   bool need_data_;      ///< Are the visibility data needed?
+  /// Baselines for which the visibility data are needed; empty is all.
+  std::vector<bool> need_data_baselines_;
   bool write_data_;     ///< Must the data be written?
   bool write_flags_;    ///< Must the flags be written?
   bool write_weights_;  ///< Must the weights be written?
@@ -96,6 +96,56 @@ void FlagCounter::add(const FlagCounter& that) {
                  std::plus<int64_t>());
 }
 
+void FlagCounter::countFlags(const PackedFlags& flags) {
+  assert(flags.NBaselines() == itsBLCounts.size());
+  assert(flags.NChannels() == itsChanCounts.size());
+  for (size_t bl = 0; bl < flags.NBaselines(); ++bl) {
+    itsBLCounts[bl] += flags.CountBaseline(bl);
+  }
+  flags.AddChannelCounts(itsChanCounts.data());
+}
+
+void FlagCounter::countNewFlags(const PackedFlags& before,
+                                const PackedFlags& after) {
+  assert(before.NBaselines() == after.NBaselines());
+  assert(before.NChannels() == after.NChannels());
+  assert(after.NBaselines() == itsBLCounts.size());
+  assert(after.NChannels() == itsChanCounts.size());
+  const size_t nwords = after.WordsPerBaseline();
+  for (size_t bl = 0; bl < after.NBaselines(); ++bl) {
+    const PackedFlags::Word* before_words = before.BaselineWords(bl);
+    const PackedFlags::Word* after_words = after.BaselineWords(bl);
+    for (size_t w = 0; w < nwords; ++w) {
+      PackedFlags::Word word = after_words[w] & ~before_words[w];
+      itsBLCounts[bl] += PackedFlags::PopCount(word);
+      // Only visit the new flags for the channel counts.
+      const size_t first_chan = w * PackedFlags::kBitsPerWord;
+      while (word != 0) {
+        ++itsChanCounts[first_chan + __builtin_ctzll(word)];
+        word &= word - 1;
+      }
+    }
+  }
+}
+
+void FlagCounter::initShards(size_t nthreads) {
+  itsShards.resize(nthreads);
+  for (FlagCounter& shard : itsShards) {
+    shard.itsBLCounts.assign(itsBLCounts.size(), 0);
+    shard.itsChanCounts.assign(itsChanCounts.size(), 0);
+    shard.itsCorrCounts.assign(itsCorrCounts.size(), 0);
+  }
+}
+
+void FlagCounter::mergeShards() {
+  for (FlagCounter& shard : itsShards) {
+    add(shard);
+    std::fill(shard.itsBLCounts.begin(), shard.itsBLCounts.end(), 0);
+    std::fill(shard.itsChanCounts.begin(), shard.itsChanCounts.end(), 0);
+    std::fill(shard.itsCorrCounts.begin(), shard.itsCorrCounts.end(), 0);
+  }
+}
+
 void FlagCounter::showStation(std::ostream& os, int64_t ntimes) const {
   const Vector<Int>& ant1 = itsInfo->getAnt1();
   const Vector<Int>& ant2 = itsInfo->getAnt2();
@@ -9,10 +9,13 @@
 #ifndef DPPP_FLAGCOUNTER_H
 #define DPPP_FLAGCOUNTER_H
 
+#include "PackedFlags.h"
+
 #include <casacore/casa/Arrays/Vector.h>
 
 #include <cstdint>
 #include <ostream>
+#include <vector>
 
 namespace dp3 {
 namespace common {
@@ -31,6 +34,15 @@ class DPInfo;
 /// Optionally the flagging percentages can be saved in a table.
 /// The name of the table is the MS name suffixed by the step name and
 /// '.flagxx'.
+///
+/// Instead of incrementing the counts per flag, the flags of an entire
+/// time slot can be counted from a PackedFlags mask using popcounts.
+/// When flags are counted from multiple threads, each thread should use
+/// its own shard (see initShards), which is merged into the counter
+/// using mergeShards.
+///
+/// For BDA data, the counts are kept per full resolution channel and time
+/// slot (see incrBdaChannel).
 
 class FlagCounter {
  public:
@@ -47,10 +59,26 @@ class FlagCounter {
   void init(const DPInfo& info);
 
   /// Increment the count per baseline.
-  void incrBaseline(unsigned int bl) { itsBLCounts[bl]++; }
+  void incrBaseline(unsigned int bl, int64_t count = 1) {
+    itsBLCounts[bl] += count;
+  }
 
   /// Increment the count per channel.
-  void incrChannel(unsigned int chan) { itsChanCounts[chan]++; }
+  void incrChannel(unsigned int chan, int64_t count = 1) {
+    itsChanCounts[chan] += count;
+  }
+
+  /// Count a flagged channel of a BDA row. It covers nslots full resolution
+  /// time slots and the full resolution channels [startChan, endChan), which
+  /// are all counted, such that the percentages are relative to the full
+  /// resolution data.
+  void incrBdaChannel(unsigned int bl, unsigned int startChan,
+                      unsigned int endChan, unsigned int nslots) {
+    itsBLCounts[bl] += int64_t(nslots) * (endChan - startChan);
+    for (unsigned int chan = startChan; chan < endChan; ++chan) {
+      itsChanCounts[chan] += nslots;
+    }
+  }
 
   /// Increment the count per correlation.
   void incrCorrelation(unsigned int corr) { itsCorrCounts[corr]++; }
@@ -58,6 +86,25 @@ class FlagCounter {
   /// Add the contents of that to this.
   void add(const FlagCounter& that);
 
+  /// Count the flags that are set in the mask per baseline and channel.
+  void countFlags(const PackedFlags& flags);
+
+  /// Count the flags that are set in the 'after' mask, but not in the
+  /// 'before' mask. It can be used by a step to count its new flags.
+  /// Both masks must have the same shape.
+  void countNewFlags(const PackedFlags& before, const PackedFlags& after);
+
+  /// Create nthreads empty counters with the same sizes as this one,
+  /// which can be used by different threads at the same time.
+  /// init must have been called before.
+  void initShards(size_t nthreads);
+
+  /// Get the counter for the given thread.
+  FlagCounter& shard(size_t thread) { return itsShards[thread]; }
+
+  /// Add the counts of all shards to this and clear the shards.
+  void mergeShards();
+
   /// Get the counts.
   ///@{
   const std::vector<int64_t>& baselineCounts() const { return itsBLCounts; }
@@ -97,6 +144,7 @@ class FlagCounter {
   std::vector<int64_t> itsBLCounts;
   std::vector<int64_t> itsChanCounts;
   std::vector<int64_t> itsCorrCounts;
+  std::vector<FlagCounter> itsShards;
 };
 
 }  // namespace base
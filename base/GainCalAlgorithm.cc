@@ -8,16 +8,123 @@
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include <limits>
 
 #include <iostream>
 
-using casacore::IPosition;
-using casacore::Vector;
-
 namespace dp3 {
 namespace base {
 
+namespace {
+/// Number of independent partial sums, such that the loops over stations
+/// can be vectorized without reordering floating point additions.
+constexpr size_t kLanes = 8;
+
+/// Add sum(|z|^2) to ww and sum(conj(z) v) to tt, with z = h m, over n
+/// stations. The partial sums are in single precision and are added to the
+/// double precision totals.
+void sumUnpolarized(const float* hr, const float* hi, const float* mr,
+                    const float* mi, const float* vr, const float* vi,
+                    size_t n, double& ww, std::complex<double>& tt) {
+  float w[kLanes] = {};
+  float tr[kLanes] = {};
+  float ti[kLanes] = {};
+  size_t st = 0;
+  for (; st + kLanes <= n; st += kLanes) {
+    for (size_t l = 0; l != kLanes; ++l) {
+      const size_t i = st + l;
+      const float zr = hr[i] * mr[i] - hi[i] * mi[i];
+      const float zi = hr[i] * mi[i] + hi[i] * mr[i];
+      w[l] += zr * zr + zi * zi;
+      tr[l] += zr * vr[i] + zi * vi[i];
+      ti[l] += zr * vi[i] - zi * vr[i];
+    }
+  }
+  for (; st != n; ++st) {
+    const float zr = hr[st] * mr[st] - hi[st] * mi[st];
+    const float zi = hr[st] * mi[st] + hi[st] * mr[st];
+    w[0] += zr * zr + zi * zi;
+    tr[0] += zr * vr[st] + zi * vi[st];
+    ti[0] += zr * vi[st] - zi * vr[st];
+  }
+  for (size_t l = 0; l != kLanes; ++l) {
+    ww += w[l];
+    tt += std::complex<double>(tr[l], ti[l]);
+  }
+}
+
+/// Pointers to the real and imaginary parts of the 2x2 correlations
+/// (indexed as pol2 + 2 * pol1) of all stations.
+struct PolarizedRows {
+  const float* real[4];
+  const float* imag[4];
+};
+
+/// Accumulates the normal matrix w and right hand side t of the polarized
+/// StefCal step over n stations, for z = h * mvis.
+void sumPolarized(const float* const* hr, const float* const* hi,
+                  const PolarizedRows& m, const PolarizedRows& v, size_t n,
+                  std::complex<double>* w, std::complex<double>* t) {
+  // Lane sums of w(0) (real), w(1) (complex), w(3) (real), t(0..3) (complex)
+  float w0[kLanes] = {};
+  float w1r[kLanes] = {};
+  float w1i[kLanes] = {};
+  float w3[kLanes] = {};
+  float tr[4][kLanes] = {};
+  float ti[4][kLanes] = {};
+  auto accumulate = [&](size_t i, size_t l) {
+    // z0 = h0 m00 + h2 m10, z1 = h0 m01 + h2 m11,
+    // z2 = h1 m00 + h3 m10, z3 = h1 m01 + h3 m11
+    float zr[4];
+    float zi[4];
+    for (size_t c = 0; c != 4; ++c) {
+      const size_t ha = c / 2;      // h0 or h1
+      const size_t hb = c / 2 + 2;  // h2 or h3
+      const size_t pol1 = c % 2;
+      const float mar = m.real[2 * pol1][i];
+      const float mai = m.imag[2 * pol1][i];
+      const float mbr = m.real[1 + 2 * pol1][i];
+      const float mbi = m.imag[1 + 2 * pol1][i];
+      zr[c] = hr[ha][i] * mar - hi[ha][i] * mai + hr[hb][i] * mbr -
+              hi[hb][i] * mbi;
+      zi[c] = hr[ha][i] * mai + hi[ha][i] * mar + hr[hb][i] * mbi +
+              hi[hb][i] * mbr;
+    }
+    w0[l] += zr[0] * zr[0] + zi[0] * zi[0] + zr[2] * zr[2] + zi[2] * zi[2];
+    w1r[l] += zr[0] * zr[1] + zi[0] * zi[1] + zr[2] * zr[3] + zi[2] * zi[3];
+    w1i[l] += zr[0] * zi[1] - zi[0] * zr[1] + zr[2] * zi[3] - zi[2] * zr[3];
+    w3[l] += zr[1] * zr[1] + zi[1] * zi[1] + zr[3] * zr[3] + zi[3] * zi[3];
+    // t(k) = conj(za) v(pol2=0, pol1) + conj(zb) v(pol2=1, pol1), with
+    // za = z0 or z1 and zb = z2 or z3 for k < 2 resp. k >= 2.
+    for (size_t k = 0; k != 4; ++k) {
+      const size_t za = k / 2;
+      const size_t zb = k / 2 + 2;
+      const size_t pol1 = k % 2;
+      const float v0r = v.real[2 * pol1][i];
+      const float v0i = v.imag[2 * pol1][i];
+      const float v1r = v.real[1 + 2 * pol1][i];
+      const float v1i = v.imag[1 + 2 * pol1][i];
+      tr[k][l] += zr[za] * v0r + zi[za] * v0i + zr[zb] * v1r + zi[zb] * v1i;
+      ti[k][l] += zr[za] * v0i - zi[za] * v0r + zr[zb] * v1i - zi[zb] * v1r;
+    }
+  };
+  size_t st = 0;
+  for (; st + kLanes <= n; st += kLanes) {
+    for (size_t l = 0; l != kLanes; ++l) accumulate(st + l, l);
+  }
+  for (; st != n; ++st) accumulate(st, 0);
+  for (size_t l = 0; l != kLanes; ++l) {
+    w[0] += w0[l];
+    w[1] += std::complex<double>(w1r[l], w1i[l]);
+    w[3] += w3[l];
+    for (size_t k = 0; k != 4; ++k) {
+      t[k] += std::complex<double>(tr[k][l], ti[k][l]);
+    }
+  }
+}
+}  // namespace
+
 GainCalAlgorithm::GainCalAlgorithm(unsigned int solInt, unsigned int nChan,
                                    Mode mode, bool scalar, double tolerance,
                                    unsigned int maxAntennas,
@@ -53,8 +160,11 @@ GainCalAlgorithm::GainCalAlgorithm(unsigned int solInt, unsigned int nChan,
     _savedNCr = 2;
   }
 
-  _vis.resize(IPosition(6, _nSt, 2, _solInt, _nChan, 2, _nSt));
-  _mvis.resize(IPosition(6, _nSt, 2, _solInt, _nChan, 2, _nSt));
+  const size_t visSize = size_t(_nSt) * 2 * _solInt * _nChan * 2 * _nSt;
+  _visReal.resize(visSize);
+  _visImag.resize(visSize);
+  _mvisReal.resize(visSize);
+  _mvisImag.resize(visSize);
 
   if (_scalar || _mode == FULLJONES) {
     _nUn = _nSt;
@@ -66,8 +176,8 @@ GainCalAlgorithm::GainCalAlgorithm(unsigned int solInt, unsigned int nChan,
   _gold.resize(_nUn, _nCr);
   _gx.resize(_nUn, _nCr);
   _gxx.resize(_nUn, _nCr);
-  _h.resize(_nUn, _nCr);
-  _z.resize(_nUn * _nChan * _solInt * _nSp, _nCr);
+  _hReal.resize(_nUn * _nCr);
+  _hImag.resize(_nUn * _nCr);
 
   _stationFlagged.resize(_nSt, false);
 
@@ -75,8 +185,10 @@ GainCalAlgorithm::GainCalAlgorithm(unsigned int solInt, unsigned int nChan,
 }
 
 void GainCalAlgorithm::resetVis() {
-  _vis = 0;
-  _mvis = 0;
+  std::fill(_visReal.begin(), _visReal.end(), 0.0f);
+  std::fill(_visImag.begin(), _visImag.end(), 0.0f);
+  std::fill(_mvisReal.begin(), _mvisReal.end(), 0.0f);
+  std::fill(_mvisImag.begin(), _mvisImag.end(), 0.0f);
   _totalWeight = 0.;
 }
 
@@ -97,13 +209,12 @@ void GainCalAlgorithm::init(bool initSolutions) {
       double fronormvis = 0;
       double fronormmod = 0;
 
-      DComplex* t_vis_p = _vis.data();
-      DComplex* t_mvis_p = _mvis.data();
-
-      unsigned int vissize = _vis.size();
-      for (unsigned int i = 0; i < vissize; ++i) {
-        fronormvis += norm(t_vis_p[i]);
-        fronormmod += norm(t_mvis_p[i]);
+      const size_t vissize = _visReal.size();
+      for (size_t i = 0; i < vissize; ++i) {
+        fronormvis += double(_visReal[i]) * _visReal[i] +
+                      double(_visImag[i]) * _visImag[i];
+        fronormmod += double(_mvisReal[i]) * _mvisReal[i] +
+                      double(_mvisImag[i]) * _mvisImag[i];
       }
 
       fronormvis = sqrt(fronormvis);
@@ -177,7 +288,8 @@ double GainCalAlgorithm::getAverageUnflaggedSolution() {
   }
 }
 
-GainCalAlgorithm::Status GainCalAlgorithm::doStep(unsigned int iter) {
+GainCalAlgorithm::Status GainCalAlgorithm::doStep(
+    unsigned int iter, aocommon::ParallelFor<size_t>* stationLoop) {
   _gxx = _gx;
   _gx = _g;
 
@@ -193,211 +305,153 @@ GainCalAlgorithm::Status GainCalAlgorithm::doStep(unsigned int iter) {
   }
 
   if (_mode == FULLJONES) {
-    doStep_polarized();
-    doStep_polarized();
+    doStep_polarized(stationLoop);
+    doStep_polarized(stationLoop);
     return relax(2 * iter);
   } else {
-    doStep_unpolarized();
-    doStep_unpolarized();
+    doStep_unpolarized(stationLoop);
+    doStep_unpolarized(stationLoop);
     return relax(2 * iter);
   }
 }
 
-void GainCalAlgorithm::doStep_polarized() {
-  _gold = _g;
+void GainCalAlgorithm::forEachStation(
+    unsigned int nStations, aocommon::ParallelFor<size_t>* stationLoop,
+    const std::function<void(size_t)>& function) {
+  if (stationLoop) {
+    stationLoop->Run(0, nStations,
+                     [&](size_t st, size_t /*thread*/) { function(st); });
+  } else {
+    for (size_t st = 0; st < nStations; ++st) {
+      function(st);
+    }
+  }
+}
 
-  for (unsigned int st = 0; st < _nSt; ++st) {
-    _h(st, 0) = conj(_g(st, 0));
-    _h(st, 1) = conj(_g(st, 1));
-    _h(st, 2) = conj(_g(st, 2));
-    _h(st, 3) = conj(_g(st, 3));
+void GainCalAlgorithm::setConjugateSolution() {
+  const DComplex* g = _g.data();
+  for (size_t i = 0; i < _hReal.size(); ++i) {
+    _hReal[i] = g[i].real();
+    _hImag[i] = -g[i].imag();
   }
+}
 
-  for (unsigned int st1 = 0; st1 < _nSt; ++st1) {
-    if (_stationFlagged[st1]) {
-      continue;
-    }
+void GainCalAlgorithm::doStep_polarized(
+    aocommon::ParallelFor<size_t>* stationLoop) {
+  _gold = _g;
+  setConjugateSolution();
 
-    DComplex* vis_p;
-    DComplex* mvis_p;
-    Vector<DComplex> w(_nCr);
-    Vector<DComplex> t(_nCr);
+  const float* hr[4];
+  const float* hi[4];
+  for (unsigned int cr = 0; cr < 4; ++cr) {
+    hr[cr] = &_hReal[cr * _nUn];
+    hi[cr] = &_hImag[cr * _nUn];
+  }
 
-    for (unsigned int time = 0; time < _solInt; ++time) {
-      for (unsigned int ch = 0; ch < _nChan; ++ch) {
-        unsigned int zoff = _nSt * ch + _nSt * _nChan * time;
-        mvis_p = &_mvis(IPosition(6, 0, 0, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 0) = _h(st2, 0) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,0,time,ch,0,st1))
-        mvis_p = &_mvis(IPosition(6, 0, 1, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 0) += _h(st2, 2) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,0,time,ch,1,st1))
-        mvis_p = &_mvis(IPosition(6, 0, 0, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 1) = _h(st2, 0) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,1,time,ch,0,st1))
-        mvis_p = &_mvis(IPosition(6, 0, 1, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 1) += _h(st2, 2) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,1,time,ch,1,st1))
-        mvis_p = &_mvis(IPosition(6, 0, 0, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 2) = _h(st2, 1) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,0,time,ch,0,st1))
-        mvis_p = &_mvis(IPosition(6, 0, 1, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 2) += _h(st2, 3) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,0,time,ch,1,st1))
-        mvis_p = &_mvis(IPosition(6, 0, 0, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 3) = _h(st2, 1) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,1,time,ch,0,st1))
-        mvis_p = &_mvis(IPosition(6, 0, 1, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          _z(st2 + zoff, 3) += _h(st2, 3) * mvis_p[st2];
-        }  // itsMVis(IPosition(6,st2,1,time,ch,1,st1))
-      }
+  forEachStation(_nSt, stationLoop, [&](size_t st1) {
+    if (_stationFlagged[st1]) {
+      return;
     }
 
-    w = 0;
-
+    DComplex w[4] = {0., 0., 0., 0.};
+    DComplex t[4] = {0., 0., 0., 0.};
     for (unsigned int time = 0; time < _solInt; ++time) {
       for (unsigned int ch = 0; ch < _nChan; ++ch) {
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          unsigned int zoff = st2 + _nSt * ch + _nSt * _nChan * time;
-          w(0) +=
-              conj(_z(zoff, 0)) * _z(zoff, 0) + conj(_z(zoff, 2)) * _z(zoff, 2);
-          w(1) +=
-              conj(_z(zoff, 0)) * _z(zoff, 1) + conj(_z(zoff, 2)) * _z(zoff, 3);
-          w(3) +=
-              conj(_z(zoff, 1)) * _z(zoff, 1) + conj(_z(zoff, 3)) * _z(zoff, 3);
+        PolarizedRows mvis;
+        PolarizedRows vis;
+        for (unsigned int pol1 = 0; pol1 < 2; ++pol1) {
+          for (unsigned int pol2 = 0; pol2 < 2; ++pol2) {
+            const size_t index = visIndex(0, pol2, time, ch, pol1, st1);
+            mvis.real[pol2 + 2 * pol1] = &_mvisReal[index];
+            mvis.imag[pol2 + 2 * pol1] = &_mvisImag[index];
+            vis.real[pol2 + 2 * pol1] = &_visReal[index];
+            vis.imag[pol2 + 2 * pol1] = &_visImag[index];
+          }
         }
+        sumPolarized(hr, hi, mvis, vis, _nSt, w, t);
       }
     }
-    w(2) = conj(w(1));
-
-    t = 0;
+    w[2] = conj(w[1]);
 
-    for (unsigned int time = 0; time < _solInt; ++time) {
-      for (unsigned int ch = 0; ch < _nChan; ++ch) {
-        vis_p = &_vis(IPosition(6, 0, 0, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(0) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 0)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,0,time,ch,0,st1))
-        vis_p = &_vis(IPosition(6, 0, 1, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(0) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 2)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,0,time,ch,1,st1))
-        vis_p = &_vis(IPosition(6, 0, 0, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(1) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 0)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,1,time,ch,0,st1))
-        vis_p = &_vis(IPosition(6, 0, 1, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(1) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 2)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,1,time,ch,1,st1))
-        vis_p = &_vis(IPosition(6, 0, 0, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(2) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 1)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,0,time,ch,0,st1))
-        vis_p = &_vis(IPosition(6, 0, 1, time, ch, 0, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(2) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 3)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,0,time,ch,1,st1))
-        vis_p = &_vis(IPosition(6, 0, 0, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(3) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 1)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,1,time,ch,0,st1))
-        vis_p = &_vis(IPosition(6, 0, 1, time, ch, 1, st1));
-        for (unsigned int st2 = 0; st2 < _nSt; ++st2) {
-          t(3) +=
-              conj(_z(st2 + _nSt * ch + _nSt * _nChan * time, 3)) * vis_p[st2];
-        }  // itsVis(IPosition(6,st2,1,time,ch,1,st1))
-      }
-    }
-    DComplex invdet = w(0) * w(3) - w(1) * w(2);
+    DComplex invdet = w[0] * w[3] - w[1] * w[2];
     if (std::abs(invdet) == 0) {
       _stationFlagged[st1] = true;
       _g(st1, 0) = 0;
-      continue;
+      return;
     }
     invdet = 1. / invdet;
-    _g(st1, 0) = invdet * (w(3) * t(0) - w(1) * t(2));
-    _g(st1, 1) = invdet * (w(3) * t(1) - w(1) * t(3));
-    _g(st1, 2) = invdet * (w(0) * t(2) - w(2) * t(0));
-    _g(st1, 3) = invdet * (w(0) * t(3) - w(2) * t(1));
-  }
+    _g(st1, 0) = invdet * (w[3] * t[0] - w[1] * t[2]);
+    _g(st1, 1) = invdet * (w[3] * t[1] - w[1] * t[3]);
+    _g(st1, 2) = invdet * (w[0] * t[2] - w[2] * t[0]);
+    _g(st1, 3) = invdet * (w[0] * t[3] - w[2] * t[1]);
+  });
 }
 
-void GainCalAlgorithm::doStep_unpolarized() {
+void GainCalAlgorithm::doStep_unpolarized(
+    aocommon::ParallelFor<size_t>* stationLoop) {
   _gold = _g;
+  setConjugateSolution();
+
+  // Exceptions can not be thrown from within the loop, so they are thrown
+  // afterwards.
+  enum Error { kNoError, kZeroGain, kNonFiniteGain };
+  std::atomic<int> error(kNoError);
+
+  // In diagonal mode, a station has a solution per polarization. These are
+  // solved in the same task, because they share the station flag.
+  const size_t nPol = _nUn / _nSt;
+  forEachStation(_nSt, stationLoop, [&](size_t st) {
+    for (size_t pol = 0; pol < nPol; ++pol) {
+      if (_stationFlagged[st]) {
+        return;
+      }
+      const size_t st1 = pol * _nSt + st;
+      double ww = 0;    // Same as w, but specifically for pol==false
+      DComplex tt = 0;  // Same as t, but specifically for pol==false
+
+      // The data for st1 is a contiguous range of blocks of _nUn elements,
+      // that each contain all st2 (and for scalar mode, the st2pol).
+      // For scalar mode, the range contains both st1pol.
+      const size_t start = visIndex(0, 0, 0, 0, pol, st);
+      const size_t nBlocks = _nSp * _nChan * _solInt * _nSp;
+      for (size_t block = 0; block < nBlocks; ++block) {
+        const size_t offset = start + block * _nUn;
+        sumUnpolarized(_hReal.data(), _hImag.data(), &_mvisReal[offset],
+                       &_mvisImag[offset], &_visReal[offset],
+                       &_visImag[offset], _nUn, ww, tt);
+      }
 
-  for (unsigned int ant = 0; ant < _nUn; ++ant) {
-    _h(ant, 0) = conj(_g(ant, 0));
-  }
+      // Flag a station if all baselines are flagged or all data is zero
+      if (ww == 0 || std::abs(tt) == 0) {
+        _stationFlagged[st] = true;
+        _g(st1, 0) = 0;
+        return;
+      }
+      _g(st1, 0) = tt / ww;
 
-  for (unsigned int st1 = 0; st1 < _nUn; ++st1) {
-    if (_stationFlagged[st1 % _nSt]) {
-      continue;
-    }
-    DComplex* vis_p;
-    DComplex* mvis_p;
-    double ww = 0;    // Same as w, but specifically for pol==false
-    DComplex tt = 0;  // Same as t, but specifically for pol==false
-
-    mvis_p = &_mvis(IPosition(6, 0, 0, 0, 0, st1 / _nSt, st1 % _nSt));
-    vis_p = &_vis(IPosition(6, 0, 0, 0, 0, st1 / _nSt, st1 % _nSt));
-    for (unsigned int st1pol = 0; st1pol < _nSp; ++st1pol) {
-      for (unsigned int ch = 0; ch < _nChan; ++ch) {
-        for (unsigned int time = 0; time < _solInt; ++time) {
-          for (unsigned int st2pol = 0; st2pol < _nSp; ++st2pol) {
-            DComplex* h_p = _h.data();
-            for (unsigned int st2 = 0; st2 < _nUn; ++st2) {
-              DComplex z(
-                  h_p[st2] *
-                  *mvis_p);  // itsMVis(IPosition(6,st2%nSt,st2/nSt,time,ch,st1/nSt,st1%nSt));
-              ww += norm(z);
-              tt +=
-                  conj(z) *
-                  *vis_p;  // itsVis(IPosition(6,st2%nSt,st2/nSt,time,ch,st1/nSt,st1%nSt));
-              mvis_p++;
-              vis_p++;
-            }
-          }
+      // Constrain solutions
+      if (_mode == PHASEONLY) {
+        if (std::abs(_g(st1, 0)) == 0.0) {
+          error = kZeroGain;
+          continue;
+        }
+        _g(st1, 0) /= std::abs(_g(st1, 0));
+        if (!isFinite(_g(st1, 0))) {
+          error = kNonFiniteGain;
         }
+      } else if (_mode == AMPLITUDEONLY) {
+        _g(st1, 0) = std::abs(_g(st1, 0));
       }
     }
-
-    // Flag a station if all baselines are flagged or all data is zero
-    if (ww == 0 || std::abs(tt) == 0) {
-      _stationFlagged[st1 % _nSt] = true;
-      _g(st1, 0) = 0;
-      continue;
-    }
-    _g(st1, 0) = tt / ww;
-
-    // Constrain solutions
-    if (_mode == PHASEONLY) {
-      if (std::abs(_g(st1, 0)) == 0.0)
-        throw std::runtime_error(
-            "One of the gains solved to zero in gaincal algorithm");
-      _g(st1, 0) /= std::abs(_g(st1, 0));
-      if (!isFinite(_g(st1, 0)))
-        throw std::runtime_error(
-            "One of the gains was found to converge to a non-finite value in "
-            "gaincal algorithm");
-    } else if (_mode == AMPLITUDEONLY) {
-      _g(st1, 0) = std::abs(_g(st1, 0));
-    }
+  });
+
+  if (error == kZeroGain) {
+    throw std::runtime_error(
+        "One of the gains solved to zero in gaincal algorithm");
+  } else if (error == kNonFiniteGain) {
+    throw std::runtime_error(
+        "One of the gains was found to converge to a non-finite value in "
+        "gaincal algorithm");
   }
 }
 
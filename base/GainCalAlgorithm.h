@@ -12,6 +12,12 @@
 #include <casacore/casa/Arrays/Cube.h>
 #include <casacore/casa/Arrays/ArrayMath.h>
 
+#include <aocommon/parallelfor.h>
+
+#include <complex>
+#include <functional>
+#include <vector>
+
 namespace dp3 {
 
 namespace base {
@@ -39,8 +45,10 @@ class GainCalAlgorithm {
   void init(bool initSolutions);
 
   /// Perform an iteration of gaincal. Returns CONVERGED, NOTCONVERGED
-  /// or STALLED
-  Status doStep(unsigned int iter);
+  /// or STALLED.
+  /// If a loop is given, the stations are solved in parallel using it.
+  Status doStep(unsigned int iter,
+                aocommon::ParallelFor<size_t>* stationLoop = nullptr);
 
   /// Returns the solution. The return matrix has a length of maxAntennas,
   /// which is zero for antennas for which no solution was computed.
@@ -52,11 +60,18 @@ class GainCalAlgorithm {
   /// Increments the weight (only relevant for TEC-fitting)
   void incrementWeight(float weight);
 
-  /// Returns a reference to the visibility matrix
-  casacore::Array<std::complex<double>>& getVis() { return _vis; }
-
-  /// Returns a reference to the model visibility matrix
-  casacore::Array<std::complex<double>>& getMVis() { return _mvis; }
+  /// Set an element of the (weighted) visibility matrix and the model
+  /// visibility matrix. The indices are the same as those of the previous
+  /// 6-dim casacore arrays: [st2, pol2, time, ch, pol1, st1].
+  void setVisibility(unsigned int st2, unsigned int pol2, unsigned int time,
+                     unsigned int ch, unsigned int pol1, unsigned int st1,
+                     std::complex<float> vis, std::complex<float> mvis) {
+    const size_t index = visIndex(st2, pol2, time, ch, pol1, st1);
+    _visReal[index] = vis.real();
+    _visImag[index] = vis.imag();
+    _mvisReal[index] = mvis.real();
+    _mvisImag[index] = mvis.imag();
+  }
 
   casacore::Vector<bool>& getStationFlagged() { return _stationFlagged; }
 
@@ -76,25 +91,50 @@ class GainCalAlgorithm {
     return std::isfinite(val.real()) && std::isfinite(val.imag());
   }
 
-  void doStep_polarized();
-  void doStep_unpolarized();
+  /// Index in the visibility buffers, where st2 is the fastest changing axis.
+  size_t visIndex(unsigned int st2, unsigned int pol2, unsigned int time,
+                  unsigned int ch, unsigned int pol1, unsigned int st1) const {
+    return st2 +
+           _nSt * (pol2 +
+                   2 * (time + _solInt * (ch + _nChan * (pol1 + 2 * st1))));
+  }
+
+  /// Call function(station) for all stations, in parallel if a loop is given.
+  void forEachStation(unsigned int nStations,
+                      aocommon::ParallelFor<size_t>* stationLoop,
+                      const std::function<void(size_t)>& function);
+
+  /// Store the conjugate of the current solution in _hReal and _hImag.
+  void setConjugateSolution();
+
+  void doStep_polarized(aocommon::ParallelFor<size_t>* stationLoop);
+  void doStep_unpolarized(aocommon::ParallelFor<size_t>* stationLoop);
 
   double getAverageUnflaggedSolution();
 
   unsigned int _savedNCr;
   casacore::Vector<bool>
       _stationFlagged;  ///< Contains true for totally flagged stations
-  casacore::Array<std::complex<double>> _vis;   ///< Visibility matrix
-  casacore::Array<std::complex<double>> _mvis;  ///< Model visibility matrix
+  /// Visibility and model visibility matrices, stored contiguously in
+  /// single precision with separate real and imaginary parts, such that the
+  /// loops over stations can be vectorized. See visIndex() for the layout.
+  /// @{
+  std::vector<float> _visReal;
+  std::vector<float> _visImag;
+  std::vector<float> _mvisReal;
+  std::vector<float> _mvisImag;
+  /// @}
   casacore::Matrix<std::complex<double>>
       _g;  ///< Solution, indexed by station, correlation
   casacore::Matrix<std::complex<double>> _gx;  ///< Previous solution
   casacore::Matrix<std::complex<double>>
       _gxx;  ///< Solution before previous solution
   casacore::Matrix<std::complex<double>> _gold;  ///< Previous solution
-  casacore::Matrix<std::complex<double>>
-      _h;  ///< Hermitian transpose of previous solution
-  casacore::Matrix<std::complex<double>> _z;  ///< Internal algorithm vector
+  /// Hermitian transpose of previous solution, in the same layout as _g
+  /// @{
+  std::vector<float> _hReal;
+  std::vector<float> _hImag;
+  /// @}
 
   unsigned int _nSt;       ///< number of stations in the current solution
   unsigned int _nUn;       ///< number of unknowns
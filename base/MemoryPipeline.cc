@@ -0,0 +1,76 @@
+// MemoryPipeline.cc: Run steps on buffers given by the caller
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "MemoryPipeline.h"
+
+#include "DP3.h"
+
+#include "../common/ParameterSet.h"
+#include "../steps/MemoryInput.h"
+#include "../steps/Step.h"
+
+using dp3::steps::MemoryInput;
+using dp3::steps::MultiResultStep;
+using dp3::steps::Step;
+
+namespace dp3 {
+namespace base {
+
+MemoryPipeline::MemoryPipeline(const common::ParameterSet& parset,
+                               const DPInfo& info)
+    : input_(std::make_shared<MemoryInput>(info)),
+      result_(std::make_shared<MultiResultStep>(0)) {
+  Step::ShPtr step;
+  if (parset.isDefined("steps")) {
+    step = DP3::makeStepsFromParset(parset, "", "steps", *input_, false,
+                                    Step::MsType::kRegular);
+  }
+  if (step) {
+    input_->setNextStep(step);
+  } else {
+    step = input_;
+  }
+  while (step->getNextStep()) {
+    step = step->getNextStep();
+  }
+  if (step->outputs() != Step::MsType::kRegular) {
+    throw std::invalid_argument(
+        "The last step of an in-memory pipeline should output regular data");
+  }
+  step->setNextStep(result_);
+
+  input_->setInfo(DPInfo());
+}
+
+MemoryPipeline::~MemoryPipeline() {}
+
+void MemoryPipeline::process(const DPBuffer& buffer) {
+  input_->process(buffer);
+}
+
+void MemoryPipeline::finish() { input_->finish(); }
+
+const DPInfo& MemoryPipeline::getInputInfo() const {
+  return input_->getInfo();
+}
+
+const DPInfo& MemoryPipeline::getInfo() const { return result_->getInfo(); }
+
+const std::vector<DPBuffer>& MemoryPipeline::getResults() const {
+  return result_->get();
+}
+
+std::size_t MemoryPipeline::nResults() const { return result_->size(); }
+
+void MemoryPipeline::clearResults() { result_->clear(); }
+
+void MemoryPipeline::show(std::ostream& os) const {
+  for (Step::ShPtr step = input_; step != result_;
+       step = step->getNextStep()) {
+    step->show(os);
+  }
+}
+
+}  // namespace base
+}  // namespace dp3
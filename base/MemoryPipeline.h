@@ -0,0 +1,75 @@
+// MemoryPipeline.h: Run steps on buffers given by the caller
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DPPP_MEMORYPIPELINE_H
+#define DPPP_MEMORYPIPELINE_H
+
+#include "DPBuffer.h"
+#include "DPInfo.h"
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace dp3 {
+namespace common {
+class ParameterSet;
+}
+namespace steps {
+class MemoryInput;
+class MultiResultStep;
+}  // namespace steps
+
+namespace base {
+
+/// @brief Run the steps of a parset on buffers given by the caller.
+
+/// The steps are created from the 'steps' key of the parset, like DP3 does,
+/// but they are not preceded by an MS reader and not followed by an output
+/// step. Instead, a steps::MemoryInput passes the buffers given to process()
+/// on to the steps and a steps::MultiResultStep keeps the output buffers.
+/// This makes it possible to use DP3 steps inside another program, without
+/// a MeasurementSet on disk.
+///
+/// Only regular (non-BDA) data is supported.
+class MemoryPipeline {
+ public:
+  /// Create the steps and initialize them with the meta data of the input.
+  MemoryPipeline(const common::ParameterSet& parset, const DPInfo& info);
+
+  ~MemoryPipeline();
+
+  /// Process a time slot. The buffer should contain the data, flags, weights
+  /// and UVW coordinates. Depending on the steps, the output for the time slot
+  /// is available immediately or only after later calls.
+  void process(const DPBuffer& buffer);
+
+  /// Finish the processing, which flushes the time slots that steps still
+  /// hold.
+  void finish();
+
+  /// Get the meta data of the input, as given to the constructor.
+  const DPInfo& getInputInfo() const;
+
+  /// Get the meta data of the output.
+  const DPInfo& getInfo() const;
+
+  /// Get the output buffers since the last clearResults(). Their number is
+  /// nResults(); the vector may have more (unused) elements.
+  const std::vector<DPBuffer>& getResults() const;
+  std::size_t nResults() const;
+  void clearResults();
+
+  /// Show the steps and their parameters.
+  void show(std::ostream& os) const;
+
+ private:
+  std::shared_ptr<steps::MemoryInput> input_;
+  std::shared_ptr<steps::MultiResultStep> result_;
+};
+
+}  // namespace base
+}  // namespace dp3
+
+#endif
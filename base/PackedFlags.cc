@@ -0,0 +1,139 @@
+// PackedFlags.cc: Bit-packed flags per channel and baseline
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "PackedFlags.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace dp3 {
+namespace base {
+
+constexpr std::size_t PackedFlags::kBitsPerWord;
+
+PackedFlags::PackedFlags()
+    : n_channels_(0), n_baselines_(0), words_per_baseline_(0) {}
+
+PackedFlags::PackedFlags(std::size_t nchan, std::size_t nbl) {
+  Resize(nchan, nbl);
+}
+
+void PackedFlags::Resize(std::size_t nchan, std::size_t nbl) {
+  n_channels_ = nchan;
+  n_baselines_ = nbl;
+  words_per_baseline_ = (nchan + kBitsPerWord - 1) / kBitsPerWord;
+  words_.assign(words_per_baseline_ * nbl, 0);
+}
+
+bool PackedFlags::Pack(const casacore::Cube<bool>& flags) {
+  const std::size_t ncorr = flags.shape()[0];
+  const std::size_t nchan = flags.shape()[1];
+  const std::size_t nbl = flags.shape()[2];
+  if (nchan != n_channels_ || nbl != n_baselines_) {
+    Resize(nchan, nbl);
+  }
+  const bool* flag_ptr = flags.data();
+  bool uniform = true;
+  for (std::size_t bl = 0; bl < nbl; ++bl) {
+    Word* words = BaselineWords(bl);
+    for (std::size_t w = 0; w < words_per_baseline_; ++w) {
+      const std::size_t nbits =
+          std::min(kBitsPerWord, nchan - w * kBitsPerWord);
+      Word word = 0;
+      for (std::size_t bit = 0; bit < nbits; ++bit) {
+        bool flag = false;
+        bool all = true;
+        for (std::size_t corr = 0; corr < ncorr; ++corr) {
+          flag = flag || flag_ptr[corr];
+          all = all && flag_ptr[corr];
+        }
+        uniform = uniform && (flag == all);
+        word |= Word(flag) << bit;
+        flag_ptr += ncorr;
+      }
+      words[w] = word;
+    }
+  }
+  return uniform;
+}
+
+void PackedFlags::Unpack(casacore::Cube<bool>& flags, std::size_t ncorr) const {
+  const casacore::IPosition shape(3, ncorr, n_channels_, n_baselines_);
+  if (flags.shape() != shape) {
+    flags.resize(shape);
+  }
+  bool* flag_ptr = flags.data();
+  for (std::size_t bl = 0; bl < n_baselines_; ++bl) {
+    const Word* words = BaselineWords(bl);
+    for (std::size_t chan = 0; chan < n_channels_; ++chan) {
+      const bool flag =
+          (words[chan / kBitsPerWord] >> (chan % kBitsPerWord)) & 1;
+      std::fill_n(flag_ptr, ncorr, flag);
+      flag_ptr += ncorr;
+    }
+  }
+}
+
+void PackedFlags::SetBaseline(std::size_t bl) {
+  Word* words = BaselineWords(bl);
+  std::fill_n(words, words_per_baseline_, ~Word(0));
+  // Keep the padding bits zero.
+  const std::size_t remainder = n_channels_ % kBitsPerWord;
+  if (remainder != 0) {
+    words[words_per_baseline_ - 1] = (Word(1) << remainder) - 1;
+  }
+}
+
+void PackedFlags::Clear() { std::fill(words_.begin(), words_.end(), 0); }
+
+void PackedFlags::Merge(const PackedFlags& other) {
+  assert(other.words_.size() == words_.size());
+  for (std::size_t i = 0; i < words_.size(); ++i) {
+    words_[i] |= other.words_[i];
+  }
+}
+
+std::size_t PackedFlags::Count() const {
+  std::size_t count = 0;
+  for (const Word word : words_) {
+    count += PopCount(word);
+  }
+  return count;
+}
+
+std::size_t PackedFlags::CountBaseline(std::size_t bl) const {
+  const Word* words = BaselineWords(bl);
+  std::size_t count = 0;
+  for (std::size_t w = 0; w < words_per_baseline_; ++w) {
+    count += PopCount(words[w]);
+  }
+  return count;
+}
+
+std::size_t PackedFlags::CountNew(const PackedFlags& before) const {
+  assert(before.words_.size() == words_.size());
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < words_.size(); ++i) {
+    count += PopCount(words_[i] & ~before.words_[i]);
+  }
+  return count;
+}
+
+void PackedFlags::AddChannelCounts(int64_t* counts) const {
+  for (std::size_t bl = 0; bl < n_baselines_; ++bl) {
+    const Word* words = BaselineWords(bl);
+    for (std::size_t w = 0; w < words_per_baseline_; ++w) {
+      // Only visit the set bits.
+      Word word = words[w];
+      while (word != 0) {
+        const std::size_t bit = __builtin_ctzll(word);
+        ++counts[w * kBitsPerWord + bit];
+        word &= word - 1;
+      }
+    }
+  }
+}
+
+}  // namespace base
+}  // namespace dp3
@@ -0,0 +1,117 @@
+// PackedFlags.h: Bit-packed flags per channel and baseline
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/// @file
+/// @brief Bit-packed flags per channel and baseline
+
+#ifndef DP3_PACKEDFLAGS_H
+#define DP3_PACKEDFLAGS_H
+
+#include <casacore/casa/Arrays/Cube.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dp3 {
+namespace base {
+
+/// @brief Bit-packed flags per channel and baseline
+
+/// DP3 always uses the same flag for all correlations of a visibility
+/// (see DPBuffer), so the correlation axis of the FLAG array is redundant.
+/// This class keeps a single flag bit per channel and baseline, which
+/// makes it 8*ncorr times smaller than a [ncorr,nchan,nbl] Cube<bool>.
+///
+/// The bits of a baseline start at a word boundary, so operations like
+/// counting and merging can be done per 64-bit word, with padding bits
+/// that are always zero.
+class PackedFlags {
+ public:
+  using Word = uint64_t;
+  static constexpr std::size_t kBitsPerWord = 64;
+
+  /// Create an empty object.
+  PackedFlags();
+
+  /// Create an object with all flags unset.
+  PackedFlags(std::size_t nchan, std::size_t nbl);
+
+  /// Resize the object and unset all flags.
+  void Resize(std::size_t nchan, std::size_t nbl);
+
+  /// Set the flags from a [ncorr,nchan,nbl] flag cube. A channel is
+  /// flagged if any of its correlations is flagged.
+  /// @return True if all correlations of each channel had the same flag,
+  /// i.e., if the packing was lossless.
+  bool Pack(const casacore::Cube<bool>& flags);
+
+  /// Set the flags in a [ncorr,nchan,nbl] flag cube. The cube is resized
+  /// if needed. All correlations of a channel get the same flag.
+  void Unpack(casacore::Cube<bool>& flags, std::size_t ncorr) const;
+
+  /// Get or set a single flag.
+  bool Get(std::size_t chan, std::size_t bl) const {
+    return (BaselineWords(bl)[chan / kBitsPerWord] >>
+            (chan % kBitsPerWord)) &
+           1;
+  }
+  void Set(std::size_t chan, std::size_t bl, bool flag) {
+    Word& word = BaselineWords(bl)[chan / kBitsPerWord];
+    const Word mask = Word(1) << (chan % kBitsPerWord);
+    word = flag ? (word | mask) : (word & ~mask);
+  }
+
+  /// Set all flags of a baseline.
+  void SetBaseline(std::size_t bl);
+
+  /// Unset all flags.
+  void Clear();
+
+  /// Merge the flags of the other object into this one (logical or).
+  /// Both objects must have the same shape.
+  void Merge(const PackedFlags& other);
+
+  /// Count the number of set flags.
+  std::size_t Count() const;
+
+  /// Count the number of set flags of a baseline.
+  std::size_t CountBaseline(std::size_t bl) const;
+
+  /// Count the number of flags that are set in this object, but not in
+  /// the other one, e.g. to count the new flags set by a flagging step.
+  /// Both objects must have the same shape.
+  std::size_t CountNew(const PackedFlags& before) const;
+
+  /// Add the number of set flags per channel to the counts, which must
+  /// have (at least) nchan elements.
+  void AddChannelCounts(int64_t* counts) const;
+
+  bool Empty() const { return words_.empty(); }
+  std::size_t NChannels() const { return n_channels_; }
+  std::size_t NBaselines() const { return n_baselines_; }
+  std::size_t WordsPerBaseline() const { return words_per_baseline_; }
+
+  /// Get the words of a baseline.
+  const Word* BaselineWords(std::size_t bl) const {
+    return words_.data() + bl * words_per_baseline_;
+  }
+  Word* BaselineWords(std::size_t bl) {
+    return words_.data() + bl * words_per_baseline_;
+  }
+
+  /// Count the number of set bits in a word.
+  static std::size_t PopCount(Word word) { return __builtin_popcountll(word); }
+
+ private:
+  std::size_t n_channels_;
+  std::size_t n_baselines_;
+  std::size_t words_per_baseline_;
+  std::vector<Word> words_;
+};
+
+}  // namespace base
+}  // namespace dp3
+
+#endif
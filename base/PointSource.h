@@ -43,11 +43,12 @@ class PointSource : public ModelComponent {
 
   Stokes stokes(double freq) const;
 
+  bool hasSpectralTerms() const;
+  bool hasRotationMeasure() const;
+
   virtual void accept(ModelComponentVisitor &visitor) const;
 
  private:
-  bool hasSpectralTerms() const;
-  bool hasRotationMeasure() const;
 
   Direction itsDirection;
   Stokes itsStokes;
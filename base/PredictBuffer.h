@@ -19,29 +19,50 @@ class PredictBuffer {
  public:
   typedef std::complex<double> dcomplex;
 
+  /// Resize the buffers. With @p single_precision, the single precision
+  /// (patch) model buffers are used instead of the double precision ones.
   void resize(size_t n_threads, size_t n_correlations, size_t n_channels,
-              size_t n_baselines, size_t n_stations, bool include_beam) {
-    model_visibilities_.resize(n_threads);
-    for (size_t i = 0; i != n_threads; ++i) {
-      model_visibilities_[i].resize(n_correlations, n_channels, n_baselines);
+              size_t n_baselines, size_t n_stations, bool include_beam,
+              bool single_precision = false) {
+    if (single_precision) {
+      ResizeModels(single_model_visibilities_,
+                   single_patch_model_visibilities_, n_threads, n_correlations,
+                   n_channels, n_baselines, include_beam);
+    } else {
+      ResizeModels(model_visibilities_, patch_model_visibilities_, n_threads,
+                   n_correlations, n_channels, n_baselines, include_beam);
     }
 
     if (include_beam) {
-      patch_model_visibilities_.resize(n_threads);
       // TODO the full buffer is not used when Stokes I is used -- conditionally
       // allocating full/scalar will save some memory.
       full_beam_values_.resize(n_threads);
       scalar_beam_values_.resize(n_threads);
 
       for (size_t i = 0; i != n_threads; ++i) {
-        patch_model_visibilities_[i].resize(n_correlations, n_channels,
-                                            n_baselines);
         full_beam_values_[i].resize(n_stations * n_channels);
         scalar_beam_values_[i].resize(n_stations * n_channels);
       }
     }
   }
 
+  /// True if resize() with these arguments keeps the existing model
+  /// buffers, so references to them remain valid. This is the case if the
+  /// buffers are not allocated yet, or if they already have this shape.
+  bool IsCompatible(size_t n_threads, size_t n_correlations,
+                    size_t n_channels, size_t n_baselines,
+                    bool single_precision = false) const {
+    const casacore::IPosition shape(3, n_correlations, n_channels,
+                                    n_baselines);
+    if (single_precision) {
+      return HasShape(single_model_visibilities_, n_threads, shape) &&
+             HasShape(single_patch_model_visibilities_, n_threads, shape);
+    } else {
+      return HasShape(model_visibilities_, n_threads, shape) &&
+             HasShape(patch_model_visibilities_, n_threads, shape);
+    }
+  }
+
   casacore::Cube<dcomplex>& GetModel(size_t threadIndex) {
     return model_visibilities_[threadIndex];
   }
@@ -50,6 +71,15 @@ class PredictBuffer {
     return patch_model_visibilities_[threadIndex];
   }
 
+  casacore::Cube<std::complex<float>>& GetSingleModel(size_t threadIndex) {
+    return single_model_visibilities_[threadIndex];
+  }
+
+  casacore::Cube<std::complex<float>>& GetSinglePatchModel(
+      size_t threadIndex) {
+    return single_patch_model_visibilities_[threadIndex];
+  }
+
   std::vector<aocommon::MC2x2>& GetFullBeamValues(size_t threadIndex) {
     return full_beam_values_[threadIndex];
   }
@@ -63,8 +93,40 @@ class PredictBuffer {
   }
 
  private:
+  template <typename T>
+  static bool HasShape(const std::vector<casacore::Cube<T>>& models,
+                       size_t n_threads, const casacore::IPosition& shape) {
+    if (models.empty()) return true;
+    if (models.size() != n_threads) return false;
+    for (const casacore::Cube<T>& model : models) {
+      if (!model.shape().isEqual(shape)) return false;
+    }
+    return true;
+  }
+
+  template <typename T>
+  static void ResizeModels(std::vector<casacore::Cube<T>>& models,
+                           std::vector<casacore::Cube<T>>& patch_models,
+                           size_t n_threads, size_t n_correlations,
+                           size_t n_channels, size_t n_baselines,
+                           bool include_beam) {
+    models.resize(n_threads);
+    for (size_t i = 0; i != n_threads; ++i) {
+      models[i].resize(n_correlations, n_channels, n_baselines);
+    }
+    if (include_beam) {
+      patch_models.resize(n_threads);
+      for (size_t i = 0; i != n_threads; ++i) {
+        patch_models[i].resize(n_correlations, n_channels, n_baselines);
+      }
+    }
+  }
+
   std::vector<casacore::Cube<dcomplex>> model_visibilities_;
   std::vector<casacore::Cube<dcomplex>> patch_model_visibilities_;
+  std::vector<casacore::Cube<std::complex<float>>> single_model_visibilities_;
+  std::vector<casacore::Cube<std::complex<float>>>
+      single_patch_model_visibilities_;
   std::vector<std::vector<aocommon::MC2x2>> full_beam_values_;
   std::vector<std::vector<everybeam::complex_t>> scalar_beam_values_;
   std::vector<std::shared_ptr<everybeam::Station>> station_list_;
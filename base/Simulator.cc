@@ -12,12 +12,17 @@
 
 #include <casacore/casa/BasicSL/Constants.h>
 
+#include <algorithm>
+
 #include "../common/StreamUtil.h"
 
 namespace dp3 {
 namespace base {
 
 namespace {
+// Number of channels that the batched predict processes at once.
+constexpr size_t kChannelBlockSize = 64;
+
 // Compute LMN coordinates of \p direction relative to \p reference.
 //
 // \param[in]   reference
@@ -58,6 +63,24 @@ float computeSmearterm(double uvw, double halfwidth);
 void spectrum(const PointSource& component, size_t nChannel,
               const casacore::Vector<double>& freq,
               Simulator::DuoMatrix<double>& spectrum, bool stokesIOnly);
+
+// Store the correlations for \p stokes in column \p ch of \p spectrum.
+void stokesToCorrelations(const Stokes& stokes, size_t ch,
+                          Simulator::DuoMatrix<double>& spectrum,
+                          bool stokesIOnly);
+
+// Add sums with index corr * stride + ch to a buffer with index
+// ch * nCorr + corr.
+template <typename T>
+void addSums(const double* sumReal, const double* sumImag, size_t stride,
+             size_t nCorr, size_t nChannel, std::complex<T>* buffer) {
+  for (size_t ch = 0; ch < nChannel; ++ch) {
+    for (size_t corr = 0; corr < nCorr; ++corr) {
+      *buffer++ += std::complex<T>(sumReal[corr * stride + ch],
+                                   sumImag[corr * stride + ch]);
+    }
+  }
+}
 }  // Unnamed namespace.
 
 Simulator::Simulator(const Direction& reference, size_t nStation,
@@ -67,17 +90,43 @@ Simulator::Simulator(const Direction& reference, size_t nStation,
                      const casacore::Matrix<double>& stationUVW,
                      casacore::Cube<dcomplex>& buffer, bool correctFreqSmearing,
                      bool stokesIOnly)
+    : Simulator(reference, nStation, baselines, freq, chanWidths, stationUVW,
+                correctFreqSmearing, stokesIOnly) {
+  itsBuffer.reference(buffer);
+}
+
+Simulator::Simulator(const Direction& reference, size_t nStation,
+                     const std::vector<Baseline>& baselines,
+                     const casacore::Vector<double>& freq,
+                     const casacore::Vector<double>& chanWidths,
+                     const casacore::Matrix<double>& stationUVW,
+                     casacore::Cube<std::complex<float>>& buffer,
+                     bool correctFreqSmearing, bool stokesIOnly)
+    : Simulator(reference, nStation, baselines, freq, chanWidths, stationUVW,
+                correctFreqSmearing, stokesIOnly) {
+  itsSingleBuffer.reference(buffer);
+  itsSinglePrecision = true;
+}
+
+Simulator::Simulator(const Direction& reference, size_t nStation,
+                     const std::vector<Baseline>& baselines,
+                     const casacore::Vector<double>& freq,
+                     const casacore::Vector<double>& chanWidths,
+                     const casacore::Matrix<double>& stationUVW,
+                     bool correctFreqSmearing, bool stokesIOnly)
     : itsReference(reference),
       itsNStation(nStation),
       itsNBaseline(baselines.size()),
       itsNChannel(freq.size()),
       itsCorrectFreqSmearing(correctFreqSmearing),
       itsStokesIOnly(stokesIOnly),
+      itsSinglePrecision(false),
       itsBaselines(baselines),
       itsFreq(freq),
       itsChanWidths(chanWidths),
       itsStationUVW(stationUVW),
-      itsBuffer(buffer),
+      itsBuffer(),
+      itsSingleBuffer(),
       itsShiftBuffer(),
       itsSpectrumBuffer() {
   itsShiftBuffer.resize(itsNChannel, nStation);
@@ -90,7 +139,194 @@ Simulator::Simulator(const Direction& reference, size_t nStation,
 }
 
 void Simulator::simulate(const ModelComponent::ConstPtr& component) {
-  component->accept(*this);
+  if (itsSinglePrecision) {
+    // Only the batched predict writes single precision visibilities.
+    const std::vector<ComponentBatch> batches =
+        MakeComponentBatches({{component, nullptr}}, 1, false);
+    simulate(batches.front());
+  } else {
+    component->accept(*this);
+  }
+}
+
+size_t Simulator::BatchSize(size_t nStation, size_t nChannel) {
+  // For a block of channels, a component has a phasor table and up to four
+  // weighted phasor tables, which should stay in the cache together.
+  const size_t kBatchBufferSize = 2 * 1024 * 1024;
+  const size_t componentSize = nStation *
+                               std::min(nChannel, kChannelBlockSize) * 5 * 2 *
+                               sizeof(double);
+  if (componentSize == 0) return 1;
+  return std::max<size_t>(1, kBatchBufferSize / componentSize);
+}
+
+void Simulator::simulate(const ComponentBatch& batch) {
+  const size_t nComponent = batch.Size();
+  const size_t nCorr = itsStokesIOnly ? 1 : 4;
+  const bool isGaussian = batch.GetKind() == ComponentBatch::Kind::kGaussian;
+  const bool hasSpectrum = batch.HasSpectrum();
+  // Amplitudes per baseline and channel are needed for Gaussians and
+  // smearing.
+  const bool hasAmplitudes = isGaussian || itsCorrectFreqSmearing;
+
+  if (itsBatchShiftBuffers.size() < nComponent) {
+    itsBatchStationPhases.resize(nComponent);
+    itsBatchShiftBuffers.resize(nComponent);
+    itsBatchWeightedShiftBuffers.resize(nComponent * 4);
+  }
+
+  // The visibility of a component on baseline pq is conj(A_p) * S * A_q,
+  // with A the phase shift of a station and S the spectrum. The phase shifts
+  // A and the weighted phase shifts W = S * A (for each correlation) are
+  // computed once per station, such that the baselines only need
+  // conj(A_p) * W_q.
+  for (size_t c = 0; c < nComponent; ++c) {
+    double lmn[3];
+    radec2lmn(itsReference, batch.GetDirections()[c], lmn);
+    DuoMatrix<double>& shift = itsBatchShiftBuffers[c];
+    shift.resize(itsNChannel, itsNStation);
+    itsBatchStationPhases[c].resize(itsNStation);
+    phases(itsNStation, itsNChannel, lmn, itsStationUVW, itsFreq, shift,
+           itsBatchStationPhases[c]);
+
+    // A flat spectrum is only stored for the first channel.
+    if (hasSpectrum) {
+      spectrum(*batch.GetSources()[c], itsNChannel, itsFreq, itsSpectrumBuffer,
+               itsStokesIOnly);
+    } else {
+      stokesToCorrelations(batch.GetStokes()[c], 0, itsSpectrumBuffer,
+                           itsStokesIOnly);
+    }
+
+    for (size_t corr = 0; corr < nCorr; ++corr) {
+      DuoMatrix<double>& weighted = itsBatchWeightedShiftBuffers[c * 4 + corr];
+      weighted.resize(itsNChannel, itsNStation);
+      for (size_t st = 0; st < itsNStation; ++st) {
+        const double* x = &shift.real(0, st);
+        const double* y = &shift.imag(0, st);
+        double* w_real = &weighted.real(0, st);
+        double* w_imag = &weighted.imag(0, st);
+        if (hasSpectrum) {
+#pragma GCC ivdep
+          for (size_t ch = 0; ch < itsNChannel; ++ch) {
+            const double x_c = itsSpectrumBuffer.real(corr, ch);
+            const double y_c = itsSpectrumBuffer.imag(corr, ch);
+            w_real[ch] = x[ch] * x_c - y[ch] * y_c;
+            w_imag[ch] = x[ch] * y_c + y[ch] * x_c;
+          }
+        } else {
+          const double x_c = itsSpectrumBuffer.real(corr, 0);
+          const double y_c = itsSpectrumBuffer.imag(corr, 0);
+#pragma GCC ivdep
+          for (size_t ch = 0; ch < itsNChannel; ++ch) {
+            w_real[ch] = x[ch] * x_c - y[ch] * y_c;
+            w_imag[ch] = x[ch] * y_c + y[ch] * x_c;
+          }
+        }
+      }
+    }
+  }
+
+  // See visit(const GaussianSource&) for the meaning of these terms.
+  std::vector<double> cosPhi, sinPhi, uScale, vScale;
+  if (isGaussian) {
+    const double fwhm2sigma = 1.0 / (2.0 * std::sqrt(2.0 * std::log(2.0)));
+    for (size_t c = 0; c < nComponent; ++c) {
+      const double phi = casacore::C::pi_2 + batch.GetPositionAngles()[c] +
+                         casacore::C::pi;
+      cosPhi.push_back(cos(phi));
+      sinPhi.push_back(sin(phi));
+      uScale.push_back(batch.GetMajorAxes()[c] * fwhm2sigma);
+      vScale.push_back(batch.GetMinorAxes()[c] * fwhm2sigma);
+    }
+  }
+  const double inv_c_sqr = 1.0 / (casacore::C::c * casacore::C::c);
+
+  // The channels are processed in blocks, such that the sums and the
+  // phasors of a block stay in the cache while the components of a baseline
+  // are added.
+  std::vector<double> amplitudes(kChannelBlockSize);
+  // Sums over the components, with index corr * kChannelBlockSize + ch.
+  std::vector<double> sum_real(nCorr * kChannelBlockSize);
+  std::vector<double> sum_imag(nCorr * kChannelBlockSize);
+
+  for (size_t chStart = 0; chStart < itsNChannel;
+       chStart += kChannelBlockSize) {
+    const size_t nBlock = std::min(kChannelBlockSize, itsNChannel - chStart);
+
+    for (size_t bl = 0; bl < itsNBaseline; ++bl) {
+      const size_t p = itsBaselines[bl].first;
+      const size_t q = itsBaselines[bl].second;
+      if (p == q) continue;
+
+      std::fill(sum_real.begin(), sum_real.end(), 0.0);
+      std::fill(sum_imag.begin(), sum_imag.end(), 0.0);
+
+      for (size_t c = 0; c < nComponent; ++c) {
+        if (isGaussian) {
+          const double u = itsStationUVW(0, q) - itsStationUVW(0, p);
+          const double v = itsStationUVW(1, q) - itsStationUVW(1, p);
+          const double uPrime = uScale[c] * (u * cosPhi[c] - v * sinPhi[c]);
+          const double vPrime = vScale[c] * (u * sinPhi[c] + v * cosPhi[c]);
+          const double uvPrime = (-2.0 * casacore::C::pi * casacore::C::pi) *
+                                 (uPrime * uPrime + vPrime * vPrime);
+#pragma GCC ivdep
+          for (size_t ch = 0; ch < nBlock; ++ch) {
+            const double freq = itsFreq[chStart + ch];
+            amplitudes[ch] = exp(freq * freq * inv_c_sqr * uvPrime);
+          }
+        } else if (hasAmplitudes) {
+          std::fill(amplitudes.begin(), amplitudes.end(), 1.0);
+        }
+        if (itsCorrectFreqSmearing) {
+          const double phaseDifference =
+              itsBatchStationPhases[c][q] - itsBatchStationPhases[c][p];
+#pragma GCC ivdep
+          for (size_t ch = 0; ch < nBlock; ++ch) {
+            amplitudes[ch] *= computeSmearterm(
+                phaseDifference, itsChanWidths[chStart + ch] * 0.5);
+          }
+        }
+
+        DuoMatrix<double>& shift = itsBatchShiftBuffers[c];
+        const double* x_p = &shift.real(chStart, p);
+        const double* y_p = &shift.imag(chStart, p);
+        for (size_t corr = 0; corr < nCorr; ++corr) {
+          DuoMatrix<double>& weighted =
+              itsBatchWeightedShiftBuffers[c * 4 + corr];
+          const double* x_q = &weighted.real(chStart, q);
+          const double* y_q = &weighted.imag(chStart, q);
+          double* s_real = &sum_real[corr * kChannelBlockSize];
+          double* s_imag = &sum_imag[corr * kChannelBlockSize];
+          if (hasAmplitudes) {
+#pragma GCC ivdep
+            for (size_t ch = 0; ch < nBlock; ++ch) {
+              s_real[ch] +=
+                  amplitudes[ch] * (x_p[ch] * x_q[ch] + y_p[ch] * y_q[ch]);
+              s_imag[ch] +=
+                  amplitudes[ch] * (x_p[ch] * y_q[ch] - y_p[ch] * x_q[ch]);
+            }
+          } else {
+#pragma GCC ivdep
+            for (size_t ch = 0; ch < nBlock; ++ch) {
+              s_real[ch] += x_p[ch] * x_q[ch] + y_p[ch] * y_q[ch];
+              s_imag[ch] += x_p[ch] * y_q[ch] - y_p[ch] * x_q[ch];
+            }
+          }
+        }
+      }  // Components.
+
+      // The sums of a batch are computed in double precision, which limits
+      // the rounding errors in a single precision buffer to one per batch.
+      if (itsSinglePrecision) {
+        addSums(sum_real.data(), sum_imag.data(), kChannelBlockSize, nCorr,
+                nBlock, &itsSingleBuffer(0, chStart, bl));
+      } else {
+        addSums(sum_real.data(), sum_imag.data(), kChannelBlockSize, nCorr,
+                nBlock, &itsBuffer(0, chStart, bl));
+      }
+    }  // Baselines.
+  }    // Channel blocks.
 }
 
 void Simulator::visit(const PointSource& component) {
@@ -460,21 +696,26 @@ inline void spectrum(const PointSource& component, size_t nChannel,
                      bool stokesIOnly = false) {
 #pragma GCC ivdep
   for (size_t ch = 0; ch < nChannel; ++ch) {
-    Stokes stokes = component.stokes(freq[ch]);
+    stokesToCorrelations(component.stokes(freq[ch]), ch, spectrum,
+                         stokesIOnly);
+  }
+}
 
-    if (stokesIOnly) {
-      spectrum.real(0, ch) = stokes.I;
-      spectrum.imag(0, ch) = 0.0;
-    } else {
-      spectrum.real(0, ch) = stokes.I + stokes.Q;
-      spectrum.imag(0, ch) = 0.0;
-      spectrum.real(1, ch) = stokes.U;
-      spectrum.imag(1, ch) = stokes.V;
-      spectrum.real(2, ch) = stokes.U;
-      spectrum.imag(2, ch) = -stokes.V;
-      spectrum.real(3, ch) = stokes.I - stokes.Q;
-      spectrum.imag(3, ch) = 0.0;
-    }
+inline void stokesToCorrelations(const Stokes& stokes, size_t ch,
+                                 Simulator::DuoMatrix<double>& spectrum,
+                                 bool stokesIOnly) {
+  if (stokesIOnly) {
+    spectrum.real(0, ch) = stokes.I;
+    spectrum.imag(0, ch) = 0.0;
+  } else {
+    spectrum.real(0, ch) = stokes.I + stokes.Q;
+    spectrum.imag(0, ch) = 0.0;
+    spectrum.real(1, ch) = stokes.U;
+    spectrum.imag(1, ch) = stokes.V;
+    spectrum.real(2, ch) = stokes.U;
+    spectrum.imag(2, ch) = -stokes.V;
+    spectrum.real(3, ch) = stokes.I - stokes.Q;
+    spectrum.imag(3, ch) = 0.0;
   }
 }
 
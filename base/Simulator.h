@@ -8,6 +8,7 @@
 #define DPPP_SIMULATOR_H
 
 #include "Baseline.h"
+#include "ComponentBatch.h"
 #include "ModelComponent.h"
 #include "ModelComponentVisitor.h"
 #include "Direction.h"
@@ -47,6 +48,17 @@ class Simulator : public ModelComponentVisitor {
             casacore::Cube<dcomplex>& buffer, bool correctFreqSmearing,
             bool stokesIOnly);
 
+  /// Construct a Simulator that adds single precision visibilities to
+  /// @p buffer. The visibilities of a batch are summed in double precision
+  /// before they are added to the buffer. Other arguments are as above.
+  Simulator(const Direction& reference, size_t nStation,
+            const std::vector<Baseline>& baselines,
+            const casacore::Vector<double>& freq,
+            const casacore::Vector<double>& chanWidths,
+            const casacore::Matrix<double>& stationUVW,
+            casacore::Cube<std::complex<float>>& buffer,
+            bool correctFreqSmearing, bool stokesIOnly);
+
   // Note DuoMatrix is actually two T matrices
   // T: floating point type, ideally float, double, or long double.
   template <typename T>
@@ -81,9 +93,29 @@ class Simulator : public ModelComponentVisitor {
     size_t itsNRows;
   };
 
+  /// Set the phase reference direction, e.g. when it moves in time.
+  void setReference(const Direction& reference) { itsReference = reference; }
+
   void simulate(const ModelComponent::ConstPtr& component);
 
+  /// Add the visibilities of all components of a batch. Tables with the
+  /// phase shifts per station, and with the phase shifts multiplied by the
+  /// spectrum, are computed first. The visibilities of a baseline are then
+  /// sums of products of two table rows, computed in blocks of channels.
+  void simulate(const ComponentBatch& batch);
+
+  /// Get the number of components per batch for which the phase shift
+  /// tables of a batch take about 2 MB per block of channels.
+  static size_t BatchSize(size_t nStation, size_t nChannel);
+
  private:
+  Simulator(const Direction& reference, size_t nStation,
+            const std::vector<Baseline>& baselines,
+            const casacore::Vector<double>& freq,
+            const casacore::Vector<double>& chanWidths,
+            const casacore::Matrix<double>& stationUVW,
+            bool correctFreqSmearing, bool stokesIOnly);
+
   virtual void visit(const PointSource& component);
   virtual void visit(const GaussianSource& component);
 
@@ -92,14 +124,23 @@ class Simulator : public ModelComponentVisitor {
   size_t itsNStation, itsNBaseline, itsNChannel;
   bool itsCorrectFreqSmearing;
   bool itsStokesIOnly;
+  /// If true, itsSingleBuffer is used instead of itsBuffer.
+  bool itsSinglePrecision;
   const std::vector<Baseline> itsBaselines;
   const casacore::Vector<double> itsFreq;
   const casacore::Vector<double> itsChanWidths;
   const casacore::Matrix<double> itsStationUVW;
   casacore::Cube<dcomplex> itsBuffer;
+  casacore::Cube<std::complex<float>> itsSingleBuffer;
   std::vector<double> itsStationPhases;
   DuoMatrix<double> itsShiftBuffer;
   DuoMatrix<double> itsSpectrumBuffer;
+  /// Station phases and phase shifts per component of a batch.
+  std::vector<std::vector<double>> itsBatchStationPhases;
+  std::vector<DuoMatrix<double>> itsBatchShiftBuffers;
+  /// Phase shifts multiplied by the spectrum, with index
+  /// component * 4 + correlation.
+  std::vector<DuoMatrix<double>> itsBatchWeightedShiftBuffers;
 };
 
 /// @}
@@ -5,6 +5,8 @@
 
 #include "SolutionInterval.h"
 
+#include <algorithm>
+
 using dp3::steps::InputStep;
 
 namespace dp3 {
@@ -21,7 +23,9 @@ SolutionInterval::SolutionInterval(InputStep& input,
       buffer_index_(0),
       buffers_(buffer_size),
       original_flags_(buffer_size),
-      original_weights_(buffer_size) {}
+      original_full_flags_(buffer_size),
+      original_weights_(buffer_size),
+      original_full_weights_(buffer_size) {}
 
 SolutionInterval::~SolutionInterval() {}
 
@@ -36,17 +40,67 @@ void SolutionInterval::PushBack(const DPBuffer& buffer) {
 
   buffers_[buffer_index_].copy(buffer);
 
-  original_flags_[buffer_index_].assign(buffer.getFlags());
-  original_weights_[buffer_index_].assign(buffer.getWeights());
+  if (original_flags_[buffer_index_].Pack(buffer.getFlags())) {
+    original_full_flags_[buffer_index_].resize();
+  } else {
+    original_full_flags_[buffer_index_].assign(buffer.getFlags());
+  }
+  StoreWeights(buffers_[buffer_index_].getWeights(),
+               original_weights_[buffer_index_],
+               original_full_weights_[buffer_index_]);
 
   ++buffer_index_;
 }
 
 void SolutionInterval::RestoreFlagsAndWeights() {
   for (std::size_t index = 0; index < buffer_index_; ++index) {
-    buffers_[index].getFlags().assign(original_flags_[index]);
-    buffers_[index].getWeights().assign(original_weights_[index]);
+    casacore::Cube<bool>& flags = buffers_[index].getFlags();
+    if (original_full_flags_[index].empty()) {
+      original_flags_[index].Unpack(flags, flags.shape()[0]);
+    } else {
+      flags.assign(original_full_flags_[index]);
+    }
+    casacore::Cube<float>& weights = buffers_[index].getWeights();
+    if (original_full_weights_[index].empty()) {
+      const casacore::Matrix<float>& compact = original_weights_[index];
+      const std::size_t ncorr = weights.shape()[0];
+      float* weight_ptr = weights.data();
+      for (const float weight : compact) {
+        std::fill_n(weight_ptr, ncorr, weight);
+        weight_ptr += ncorr;
+      }
+    } else {
+      weights.assign(original_full_weights_[index]);
+    }
+  }
+}
+
+void SolutionInterval::StoreWeights(const casacore::Cube<float>& weights,
+                                    casacore::Matrix<float>& compact,
+                                    casacore::Cube<float>& full) {
+  if (weights.empty()) {
+    compact.resize();
+    full.resize();
+    return;
+  }
+  const std::size_t ncorr = weights.shape()[0];
+  const std::size_t n = weights.size() / ncorr;
+  compact.resize(weights.shape()[1], weights.shape()[2]);
+  const float* weight_ptr = weights.data();
+  float* compact_ptr = compact.data();
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t corr = 1; corr < ncorr; ++corr) {
+      if (weight_ptr[corr] != weight_ptr[0]) {
+        // The weights differ per correlation, so keep all of them.
+        compact.resize();
+        full.assign(weights);
+        return;
+      }
+    }
+    compact_ptr[i] = weight_ptr[0];
+    weight_ptr += ncorr;
   }
+  full.resize();
 }
 
 }  // namespace base
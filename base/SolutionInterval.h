@@ -12,6 +12,7 @@
 #define COMMON_SOLUTION_INTERVAL
 
 #include "../base/DPBuffer.h"
+#include "../base/PackedFlags.h"
 #include "../steps/InputStep.h"
 
 #include <casacore/casa/Arrays/Cube.h>
@@ -53,6 +54,12 @@ class SolutionInterval {
   /**@}*/
 
  private:
+  /// Store the weights in compact form if they are equal for all
+  /// correlations, otherwise store them in full.
+  static void StoreWeights(const casacore::Cube<float>& weights,
+                           casacore::Matrix<float>& compact,
+                           casacore::Cube<float>& full);
+
   const std::size_t buffer_size_;
   const std::size_t n_solution_;
 
@@ -61,8 +68,14 @@ class SolutionInterval {
   std::size_t buffer_index_;  ///< Current index where to insert the next buffer
   std::vector<DPBuffer> buffers_;  ///< Vector of DPBuffer copies
 
-  std::vector<casacore::Cube<bool>> original_flags_;
-  std::vector<casacore::Cube<float>> original_weights_;
+  /// The original flags and weights are kept in compact form, with one flag
+  /// bit and one weight per channel and baseline, because the correlation
+  /// axis is normally redundant. If the flags or weights differ per
+  /// correlation, they are kept in full.
+  std::vector<PackedFlags> original_flags_;
+  std::vector<casacore::Cube<bool>> original_full_flags_;
+  std::vector<casacore::Matrix<float>> original_weights_;
+  std::vector<casacore::Cube<float>> original_full_weights_;
 };
 
 }  // namespace base
@@ -17,7 +17,10 @@
 
 #include <boost/utility/string_view.hpp>
 
+#include <sys/stat.h>
+
 #include <cassert>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -26,6 +29,34 @@ namespace base {
 using parmdb::SourceData;
 using parmdb::SourceInfo;
 
+static PointSource::Ptr MakeSource(SourceInfo::Type type,
+                                   const Direction& direction,
+                                   const Stokes& stokes, double orientation,
+                                   double major_axis, double minor_axis) {
+  switch (type) {
+    case SourceInfo::POINT:
+      return PointSource::Ptr(new PointSource(direction, stokes));
+
+    case SourceInfo::GAUSSIAN: {
+      GaussianSource::Ptr gauss(new GaussianSource(direction, stokes));
+
+      const double deg2rad = (casacore::C::pi / 180.0);
+      gauss->setPositionAngle(orientation * deg2rad);
+
+      const double arcsec2rad = (casacore::C::pi / 3600.0) / 180.0;
+      gauss->setMajorAxis(major_axis * arcsec2rad);
+      gauss->setMinorAxis(minor_axis * arcsec2rad);
+      return gauss;
+    }
+
+    default: {
+      throw Exception(
+          "Only point sources and Gaussian sources are"
+          " supported at this time.");
+    }
+  }
+}
+
 static PointSource::Ptr MakePointSource(const SourceData& src) {
   // Fetch direction.
   if (src.getInfo().getRefType() != "J2000")
@@ -41,30 +72,9 @@ static PointSource::Ptr MakePointSource(const SourceData& src) {
     stokes.U = src.getU();
   }
 
-  PointSource::Ptr source;
-  switch (src.getInfo().getType()) {
-    case SourceInfo::POINT: {
-      source = PointSource::Ptr(new PointSource(direction, stokes));
-    } break;
-
-    case SourceInfo::GAUSSIAN: {
-      GaussianSource::Ptr gauss(new GaussianSource(direction, stokes));
-
-      const double deg2rad = (casacore::C::pi / 180.0);
-      gauss->setPositionAngle(src.getOrientation() * deg2rad);
-
-      const double arcsec2rad = (casacore::C::pi / 3600.0) / 180.0;
-      gauss->setMajorAxis(src.getMajorAxis() * arcsec2rad);
-      gauss->setMinorAxis(src.getMinorAxis() * arcsec2rad);
-      source = gauss;
-    } break;
-
-    default: {
-      throw Exception(
-          "Only point sources and Gaussian sources are"
-          " supported at this time.");
-    }
-  }
+  PointSource::Ptr source =
+      MakeSource(src.getInfo().getType(), direction, stokes,
+                 src.getOrientation(), src.getMajorAxis(), src.getMinorAxis());
 
   // Fetch spectral index attributes (if applicable).
   bool isLogarithmic = src.getInfo().getHasLogarithmicSI();
@@ -84,6 +94,86 @@ static PointSource::Ptr MakePointSource(const SourceData& src) {
   return source;
 }
 
+static PointSource::Ptr MakePointSource(
+    const parmdb::SourceDBCompiled& source_db, size_t index) {
+  if (!source_db.IsJ2000(index))
+    throw std::runtime_error("Reference type should be J2000");
+  const Direction direction(source_db.Ra()[index], source_db.Dec()[index]);
+
+  Stokes stokes;
+  stokes.I = source_db.I()[index];
+  stokes.V = source_db.V()[index];
+  if (!source_db.UseRotationMeasure(index)) {
+    stokes.Q = source_db.Q()[index];
+    stokes.U = source_db.U()[index];
+  }
+
+  PointSource::Ptr source = MakeSource(
+      static_cast<SourceInfo::Type>(source_db.Type()[index]), direction,
+      stokes, source_db.Orientation()[index], source_db.MajorAxis()[index],
+      source_db.MinorAxis()[index]);
+
+  if (source_db.SpectralTermsBegin(index) !=
+      source_db.SpectralTermsEnd(index)) {
+    source->setSpectralTerms(source_db.SpectralTermsRefFreq()[index],
+                             source_db.HasLogarithmicSI(index),
+                             source_db.SpectralTermsBegin(index),
+                             source_db.SpectralTermsEnd(index));
+  }
+
+  if (source_db.UseRotationMeasure(index)) {
+    source->setRotationMeasure(source_db.PolarizedFraction()[index],
+                               source_db.PolarizationAngle()[index],
+                               source_db.RotationMeasure()[index]);
+  }
+
+  return source;
+}
+
+CompiledSkyModel::CompiledSkyModel(const std::string& filename)
+    : source_db_(filename), patches_(source_db_.NPatches()) {}
+
+std::shared_ptr<CompiledSkyModel> CompiledSkyModel::Open(
+    const std::string& filename) {
+  static std::mutex mutex;
+  // The file identity is kept with each sky model, such that a file that was
+  // replaced by makesourcedb is opened again.
+  static std::map<std::string,
+                  std::pair<ino_t, std::weak_ptr<CompiledSkyModel>>>
+      sky_models;
+
+  struct stat status;
+  const ino_t inode = stat(filename.c_str(), &status) == 0 ? status.st_ino : 0;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::pair<ino_t, std::weak_ptr<CompiledSkyModel>>& entry =
+      sky_models[filename];
+  std::shared_ptr<CompiledSkyModel> sky_model = entry.second.lock();
+  if (!sky_model || entry.first != inode) {
+    sky_model = std::make_shared<CompiledSkyModel>(filename);
+    entry = std::make_pair(inode, sky_model);
+  }
+  return sky_model;
+}
+
+Patch::ConstPtr CompiledSkyModel::GetPatch(size_t patch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!patches_[patch]) {
+    std::vector<ModelComponent::Ptr> components;
+    for (size_t source = source_db_.FirstSource(patch);
+         source != source_db_.FirstSource(patch + 1); ++source) {
+      components.push_back(MakePointSource(source_db_, source));
+    }
+    auto ppatch = std::make_shared<Patch>(source_db_.PatchName(patch),
+                                          components.begin(), components.end());
+    ppatch->setDirection(
+        Direction(source_db_.PatchRa(patch), source_db_.PatchDec(patch)));
+    ppatch->setBrightness(source_db_.PatchBrightness(patch));
+    patches_[patch] = std::move(ppatch);
+  }
+  return patches_[patch];
+}
+
 std::vector<Patch::ConstPtr> makePatches(parmdb::SourceDB& sourceDB,
                                          const std::vector<string>& patchNames,
                                          unsigned int nModel) {
@@ -164,6 +254,21 @@ std::vector<Patch::ConstPtr> MakePatches(
   return patchList;
 }
 
+std::vector<Patch::ConstPtr> MakePatches(
+    CompiledSkyModel& sky_model, const std::vector<std::string>& patch_names) {
+  const parmdb::SourceDBCompiled& source_db = sky_model.SourceDB();
+  std::vector<Patch::ConstPtr> patchList;
+  patchList.reserve(patch_names.size());
+  for (const std::string& patch_name : patch_names) {
+    const size_t patch = source_db.FindPatch(patch_name);
+    if (patch == source_db.NPatches() ||
+        source_db.FirstSource(patch) == source_db.FirstSource(patch + 1))
+      throw Exception("No sources found for patch " + patch_name);
+    patchList.push_back(sky_model.GetPatch(patch));
+  }
+  return patchList;
+}
+
 std::vector<std::pair<ModelComponent::ConstPtr, Patch::ConstPtr>>
 makeSourceList(const std::vector<Patch::ConstPtr>& patchList) {
   std::vector<Patch::ConstPtr>::const_iterator pIter = patchList.begin();
@@ -285,9 +390,10 @@ std::vector<string> makePatchList(parmdb::SourceDB& sourceDB,
   return std::vector<string>(patches.begin(), patches.end());
 }
 
-std::vector<std::string> MakePatchList(
-    const parmdb::SourceDBSkymodel& source_db,
-    const std::vector<std::string>& patterns) {
+/// Find the patches of a SourceDBSkymodel or SourceDBCompiled.
+template <typename SourceDBType>
+static std::vector<std::string> FindPatches(
+    const SourceDBType& source_db, const std::vector<std::string>& patterns) {
   if (patterns.empty()) return source_db.FindPatches("*");
 
   std::set<std::string> patches;
@@ -304,6 +410,18 @@ std::vector<std::string> MakePatchList(
   return std::vector<std::string>(patches.begin(), patches.end());
 }
 
+std::vector<std::string> MakePatchList(
+    const parmdb::SourceDBSkymodel& source_db,
+    const std::vector<std::string>& patterns) {
+  return FindPatches(source_db, patterns);
+}
+
+std::vector<std::string> MakePatchList(
+    const parmdb::SourceDBCompiled& source_db,
+    const std::vector<std::string>& patterns) {
+  return FindPatches(source_db, patterns);
+}
+
 bool checkPolarized(parmdb::SourceDB& sourceDB,
                     const std::vector<string>& patchNames,
                     unsigned int nModel) {
@@ -345,6 +463,20 @@ bool CheckPolarized(const parmdb::SourceDBSkymodel& source_db,
   return false;
 }
 
+bool CheckPolarized(const parmdb::SourceDBCompiled& source_db,
+                    const std::vector<std::string>& patch_names) {
+  for (const auto& patch_name : patch_names) {
+    const size_t patch = source_db.FindPatch(patch_name);
+    if (patch == source_db.NPatches()) continue;
+    for (size_t source = source_db.FirstSource(patch);
+         source != source_db.FirstSource(patch + 1); ++source)
+      if (source_db.V()[source] > 0.0 || source_db.Q()[source] > 0.0 ||
+          source_db.U()[source] > 0.0)
+        return true;
+  }
+  return false;
+}
+
 static bool HasSkymodelExtension(const std::string& source_db_name) {
   static const boost::string_view kSymodelExtension = ".skymodel";
   static const boost::string_view kTxtExtension = ".txt";
@@ -363,7 +495,11 @@ SourceDB::SourceDB(const std::string& source_db_name,
     throw std::runtime_error("Empty source pattern not allowed");
   }
 
-  if (HasSkymodelExtension(source_db_name)) {
+  if (parmdb::SourceDBCompiled::IsCompiled(source_db_name)) {
+    source_db_ = CompiledSkyModel::Open(source_db_name);
+    patch_names_ = base::MakePatchList(
+        Get<std::shared_ptr<CompiledSkyModel>>()->SourceDB(), source_patterns);
+  } else if (HasSkymodelExtension(source_db_name)) {
     source_db_ = parmdb::skymodel_to_source_db::MakeSourceDBSkymodel(
         source_db_name,
         parmdb::skymodel_to_source_db::ReadFormat("", source_db_name));
@@ -382,6 +518,9 @@ std::vector<Patch::ConstPtr> SourceDB::MakePatchList() {
          "The constructor should have properly initialized the source_db_");
   if (HoldsAlternative<parmdb::SourceDBSkymodel>())
     return base::MakePatches(Get<parmdb::SourceDBSkymodel>(), patch_names_);
+  if (HoldsAlternative<std::shared_ptr<CompiledSkyModel>>())
+    return base::MakePatches(*Get<std::shared_ptr<CompiledSkyModel>>(),
+                             patch_names_);
 
   return base::makePatches(Get<parmdb::SourceDB>(), patch_names_,
                            patch_names_.size());
@@ -393,6 +532,9 @@ bool SourceDB::CheckPolarized() {
 
   if (HoldsAlternative<parmdb::SourceDBSkymodel>())
     return base::CheckPolarized(Get<parmdb::SourceDBSkymodel>(), patch_names_);
+  if (HoldsAlternative<std::shared_ptr<CompiledSkyModel>>())
+    return base::CheckPolarized(
+        Get<std::shared_ptr<CompiledSkyModel>>()->SourceDB(), patch_names_);
 
   return base::checkPolarized(Get<parmdb::SourceDB>(), patch_names_,
                               patch_names_.size());
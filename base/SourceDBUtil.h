@@ -12,16 +12,42 @@
 
 #include "Patch.h"
 #include "../parmdb/SourceDB.h"
+#include "../parmdb/SourceDBCompiled.h"
 #include "../parmdb/SourceDBSkymodel.h"
 
 #include <boost/variant.hpp>
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace dp3 {
 namespace base {
 
+/// A compiled sky model and the patches that are made from it.
+///
+/// Opening a compiled sky model that is already open in the process returns
+/// the same object, such that all predict steps share its memory mapping and
+/// its patches and components.
+class CompiledSkyModel {
+ public:
+  /// Use Open() to share the sky model with other users.
+  explicit CompiledSkyModel(const std::string &filename);
+
+  static std::shared_ptr<CompiledSkyModel> Open(const std::string &filename);
+
+  const parmdb::SourceDBCompiled &SourceDB() const { return source_db_; }
+
+  /// Get a patch with its components, which are made on first use.
+  Patch::ConstPtr GetPatch(size_t patch);
+
+ private:
+  parmdb::SourceDBCompiled source_db_;
+  std::mutex mutex_;
+  std::vector<Patch::ConstPtr> patches_;
+};
+
 std::vector<Patch::ConstPtr> makePatches(
     parmdb::SourceDB &sourceDB, const std::vector<std::string> &patchNames,
     unsigned int nModel);
@@ -30,6 +56,9 @@ std::vector<Patch::ConstPtr> MakePatches(
     const parmdb::SourceDBSkymodel &source_db,
     const std::vector<std::string> &patch_names);
 
+std::vector<Patch::ConstPtr> MakePatches(
+    CompiledSkyModel &sky_model, const std::vector<std::string> &patch_names);
+
 /// Create a source list (with patch name) from a patchlist
 /// Needed for efficient multithreading
 std::vector<std::pair<ModelComponent::ConstPtr, Patch::ConstPtr>>
@@ -49,6 +78,10 @@ std::vector<std::string> MakePatchList(
     const parmdb::SourceDBSkymodel &source_db,
     const std::vector<std::string> &patterns);
 
+std::vector<std::string> MakePatchList(
+    const parmdb::SourceDBCompiled &source_db,
+    const std::vector<std::string> &patterns);
+
 bool checkPolarized(parmdb::SourceDB &sourceDB,
                     const std::vector<std::string> &patchNames,
                     unsigned int nModel);
@@ -56,9 +89,13 @@ bool checkPolarized(parmdb::SourceDB &sourceDB,
 bool CheckPolarized(const parmdb::SourceDBSkymodel &source_db,
                     const std::vector<std::string> &patch_names);
 
+bool CheckPolarized(const parmdb::SourceDBCompiled &source_db,
+                    const std::vector<std::string> &patch_names);
+
 /// A SourceDB abstraction layer.
 ///
-/// A SourceDB can be read as a SourceDB database or a .skymodel file. This
+/// A SourceDB can be read as a SourceDB database, a .skymodel file or a
+/// compiled sky model. This
 /// class abstracts the processing of the data regardless of the data source
 /// used.
 class SourceDB {
@@ -79,7 +116,8 @@ class SourceDB {
   /// std::variant easier.
   using monostate = int;
   std::vector<std::string> patch_names_;
-  boost::variant<monostate, parmdb::SourceDB, parmdb::SourceDBSkymodel>
+  boost::variant<monostate, parmdb::SourceDB, parmdb::SourceDBSkymodel,
+                 std::shared_ptr<CompiledSkyModel>>
       source_db_;
 
   template <class T>
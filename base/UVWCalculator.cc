@@ -11,14 +11,50 @@
 #include <casacore/measures/Measures/MEpoch.h>
 #include <casacore/measures/Measures/Muvw.h>
 
+#include <cmath>
+#include <limits>
+
 using namespace casacore;
 
 namespace dp3 {
 namespace base {
 
+namespace {
+/// Rotation rate of the Earth (in rad per second), see IERS conventions.
+/// An inaccuracy in it is absorbed by the interpolation of the slowly
+/// varying part of the rotation.
+constexpr double kEarthRotationRate = 7.2921158553e-5;
+
+std::array<double, 9> Multiply(const std::array<double, 9>& lhs,
+                               const std::array<double, 9>& rhs) {
+  std::array<double, 9> result;
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 3; ++col) {
+      result[row * 3 + col] = lhs[row * 3] * rhs[col] +
+                              lhs[row * 3 + 1] * rhs[3 + col] +
+                              lhs[row * 3 + 2] * rhs[6 + col];
+    }
+  }
+  return result;
+}
+
+/// Rotation around the celestial pole caused by the Earth rotating
+/// during the given time interval.
+std::array<double, 9> EarthRotation(double interval) {
+  const double angle = kEarthRotationRate * interval;
+  const double c = std::cos(angle);
+  const double s = std::sin(angle);
+  return {c, -s, 0.0, s, c, 0.0, 0.0, 0.0, 1.0};
+}
+}  // namespace
+
+constexpr double UVWCalculator::kDefaultRefreshInterval;
+
 UVWCalculator::UVWCalculator(const MDirection& phaseDir,
                              const MPosition& arrayPos,
-                             const vector<MPosition>& stationPositions) {
+                             const vector<MPosition>& stationPositions,
+                             double refreshInterval)
+    : itsRefreshInterval(refreshInterval) {
   // Convert the station positions to a baseline in ITRF.
   int nrant = stationPositions.size();
   Vector<Double> pos0;
@@ -32,6 +68,8 @@ UVWCalculator::UVWCalculator(const MDirection& phaseDir,
     MVPosition mvpos((pos[0] - pos0[0]), (pos[1] - pos0[1]),
                      (pos[2] - pos0[2]));
     itsAntMB.push_back(MBaseline(MVBaseline(mvpos), MBaseline::ITRF));
+    itsAntPos.push_back(
+        {pos[0] - pos0[0], pos[1] - pos0[1], pos[2] - pos0[2]});
   }
   // Initialize the converters.
   // Set up the frame for epoch and antenna position.
@@ -54,9 +92,25 @@ UVWCalculator::UVWCalculator(const MDirection& phaseDir,
   // The cache is only useful if the MS is accessed in time order, but that
   // is normally the case.
   itsLastTime = 0;
+  itsFrameTime = 0;
   itsAntUvw.resize(nrant);
   itsUvwFilled.resize(nrant);
   itsUvwFilled = false;
+  // A UVW is a linear function of the J2000 baseline, so the projection
+  // matrix follows from the UVWs of the unit vectors.
+  // A moving phase direction does not use it.
+  itsGridTime = -std::numeric_limits<double>::infinity();
+  if (!itsMovingPhaseDir) {
+    for (int col = 0; col < 3; ++col) {
+      MVBaseline unit(col == 0 ? 1.0 : 0.0, col == 1 ? 1.0 : 0.0,
+                      col == 2 ? 1.0 : 0.0);
+      MVuvw uvw(unit, itsPhaseDir.getValue());
+      const Vector<Double> values = uvw.getVector();
+      for (int row = 0; row < 3; ++row) {
+        itsUvwProjection[row * 3 + col] = values[row];
+      }
+    }
+  }
 }
 
 std::array<double, 3> UVWCalculator::getUVW(unsigned int ant1,
@@ -64,35 +118,127 @@ std::array<double, 3> UVWCalculator::getUVW(unsigned int ant1,
   // If a different time, we have to calculate the UVWs.
   if (time != itsLastTime) {
     itsLastTime = time;
+    itsUvwFilled = false;
+    calculateAntennaUVWs(time);
+  }
+  // Calculate the UVWs for this timestamp if not done yet.
+  if (!itsUvwFilled[ant1]) calculateAntennaUVWCasacore(ant1);
+  if (!itsUvwFilled[ant2]) calculateAntennaUVWCasacore(ant2);
+  // The UVW of the baseline is the difference of the antennae.
+  return {itsAntUvw[ant2][0] - itsAntUvw[ant1][0],
+          itsAntUvw[ant2][1] - itsAntUvw[ant1][1],
+          itsAntUvw[ant2][2] - itsAntUvw[ant1][2]};
+}
+
+void UVWCalculator::getUVWs(double time, const Vector<int>& ant1,
+                            const Vector<int>& ant2, Matrix<double>& uvws) {
+  const std::vector<std::array<double, 3>>& antUvw = getAntennaUVWs(time);
+  uvws.resize(3, ant1.size());
+  double* uvwPtr = uvws.data();
+  for (unsigned int i = 0; i < ant1.size(); ++i) {
+    const std::array<double, 3>& uvw1 = antUvw[ant1[i]];
+    const std::array<double, 3>& uvw2 = antUvw[ant2[i]];
+    *uvwPtr++ = uvw2[0] - uvw1[0];
+    *uvwPtr++ = uvw2[1] - uvw1[1];
+    *uvwPtr++ = uvw2[2] - uvw1[2];
+  }
+}
+
+const std::vector<std::array<double, 3>>& UVWCalculator::getAntennaUVWs(
+    double time) {
+  if (time != itsLastTime) {
+    itsLastTime = time;
+    itsUvwFilled = false;
+    calculateAntennaUVWs(time);
+  }
+  for (unsigned int ant = 0; ant < itsAntUvw.size(); ++ant) {
+    if (!itsUvwFilled[ant]) calculateAntennaUVWCasacore(ant);
+  }
+  return itsAntUvw;
+}
+
+void UVWCalculator::calculateAntennaUVWs(double time) {
+  if (itsMovingPhaseDir || itsRefreshInterval <= 0) {
+    // The antenna UVWs are calculated by casacore when needed.
+    setEpoch(time);
+    return;
+  }
+  const double gridTime =
+      std::floor(time / itsRefreshInterval) * itsRefreshInterval;
+  if (gridTime != itsGridTime) {
+    // Normally time advances, so the end of the previous grid interval
+    // is the start of the new one.
+    if (gridTime == itsGridTime + itsRefreshInterval) {
+      itsRotStart = Multiply(itsRotEnd, EarthRotation(itsRefreshInterval));
+    } else {
+      itsRotStart = getRotation(gridTime);
+    }
+    itsRotEnd = Multiply(getRotation(gridTime + itsRefreshInterval),
+                         EarthRotation(-itsRefreshInterval));
+    itsGridTime = gridTime;
+  }
+  // Interpolate the slowly varying part and apply the Earth rotation
+  // since the start of the grid interval.
+  const double interval = time - gridTime;
+  const double factor = interval / itsRefreshInterval;
+  Matrix3 rotation;
+  for (unsigned int i = 0; i < rotation.size(); ++i) {
+    rotation[i] = itsRotStart[i] + factor * (itsRotEnd[i] - itsRotStart[i]);
+  }
+  const Matrix3 toUvw = Multiply(
+      itsUvwProjection, Multiply(rotation, EarthRotation(interval)));
+  for (unsigned int ant = 0; ant < itsAntPos.size(); ++ant) {
+    const std::array<double, 3>& pos = itsAntPos[ant];
+    std::array<double, 3>& uvw = itsAntUvw[ant];
+    for (int row = 0; row < 3; ++row) {
+      uvw[row] = toUvw[row * 3] * pos[0] + toUvw[row * 3 + 1] * pos[1] +
+                 toUvw[row * 3 + 2] * pos[2];
+    }
+  }
+  itsUvwFilled = true;
+}
+
+void UVWCalculator::calculateAntennaUVWCasacore(unsigned int ant) {
+  MBaseline& mbl = itsAntMB[ant];
+  mbl.getRefPtr()->set(itsFrame);  // attach frame
+  MBaseline::Convert mcvt(mbl, MBaseline::J2000);
+  MVBaseline bas = mcvt().getValue();
+  MVuvw jvguvw(bas, itsPhaseDir.getValue());
+  const casacore::Vector<double>& uvw =
+      Muvw(jvguvw, Muvw::J2000).getValue().getVector();
+  std::copy_n(uvw.data(), itsAntUvw[ant].size(), itsAntUvw[ant].data());
+  itsUvwFilled[ant] = true;
+}
+
+UVWCalculator::Matrix3 UVWCalculator::getRotation(double time) {
+  setEpoch(time);
+  // The columns of the rotation matrix are the converted unit vectors.
+  Matrix3 rotation;
+  for (int col = 0; col < 3; ++col) {
+    MBaseline mbl(MVBaseline(col == 0 ? 1.0 : 0.0, col == 1 ? 1.0 : 0.0,
+                             col == 2 ? 1.0 : 0.0),
+                  MBaseline::ITRF);
+    mbl.getRefPtr()->set(itsFrame);
+    MBaseline::Convert mcvt(mbl, MBaseline::J2000);
+    const Vector<Double> values = mcvt().getValue().getVector();
+    for (int row = 0; row < 3; ++row) {
+      rotation[row * 3 + col] = values[row];
+    }
+  }
+  return rotation;
+}
+
+void UVWCalculator::setEpoch(double time) {
+  if (time != itsFrameTime) {
+    itsFrameTime = time;
     Quantum<Double> tm(time, "s");
     itsFrame.resetEpoch(MEpoch(MVEpoch(tm.get("d").getValue()), MEpoch::UTC));
-    itsUvwFilled = false;
     // If phase dir is moving, calculate it for this time.
     if (itsMovingPhaseDir) {
       itsPhaseDir = itsDirToJ2000();
       itsFrame.resetDirection(itsPhaseDir);
     }
   }
-  // Calculate the UVWs for this timestamp if not done yet.
-  int ant = ant1;
-  for (int i = 0; i < 2; ++i) {
-    if (!itsUvwFilled[ant]) {
-      MBaseline& mbl = itsAntMB[ant];
-      mbl.getRefPtr()->set(itsFrame);  // attach frame
-      MBaseline::Convert mcvt(mbl, MBaseline::J2000);
-      MVBaseline bas = mcvt().getValue();
-      MVuvw jvguvw(bas, itsPhaseDir.getValue());
-      const casacore::Vector<double>& uvw =
-          Muvw(jvguvw, Muvw::J2000).getValue().getVector();
-      std::copy_n(uvw.data(), itsAntUvw[ant].size(), itsAntUvw[ant].data());
-      itsUvwFilled[ant] = true;
-    }
-    ant = ant2;
-  }
-  // The UVW of the baseline is the difference of the antennae.
-  return {itsAntUvw[ant2][0] - itsAntUvw[ant1][0],
-          itsAntUvw[ant2][1] - itsAntUvw[ant1][1],
-          itsAntUvw[ant2][2] - itsAntUvw[ant1][2]};
 }
 
 }  // namespace base
@@ -18,8 +18,12 @@
 #include <casacore/measures/Measures/MCDirection.h>
 #include <casacore/measures/Measures/MCPosition.h>
 #include <casacore/measures/Measures/MCBaseline.h>
+#include <casacore/casa/Arrays/Matrix.h>
 #include <casacore/casa/Arrays/Vector.h>
 
+#include <array>
+#include <vector>
+
 namespace dp3 {
 namespace base {
 
@@ -31,29 +35,87 @@ namespace base {
 /// It calculates and caches the UVW coordinates per antenna and combines
 /// them to get the baseline UVW coordinates. This is much faster than
 /// calculating baseline UVW coordinates directly.
+///
+/// The per-antenna UVWs of a time slot are all calculated at once.
+/// The ITRF to J2000 conversion of a baseline is a rotation, which is
+/// the product of the slowly changing precession/nutation (and polar motion)
+/// and the fast Earth rotation. The full rotation is only obtained from
+/// casacore on a coarse time grid (given by the refresh interval). In between
+/// the grid points the slowly changing part is interpolated linearly and the
+/// Earth rotation is applied analytically. Because it avoids a casacore
+/// conversion per antenna per time, it is much faster, while the difference
+/// with the full casacore conversion stays well below a micrometre for
+/// baselines of a few hundred kilometres.
+/// A refresh interval of 0 (the default) uses the full casacore conversion
+/// for each time, so the interpolation has to be enabled explicitly.
+/// The full conversion is always used for a moving phase direction (like SUN).
 
 class UVWCalculator {
  public:
   /// Construct the object for the given phase direction, array position,
   /// and station positions.
+  /// The refresh interval (in seconds) defines the time grid on which the
+  /// ITRF to J2000 rotation is obtained from casacore. The default 0 gives
+  /// the exact UVWs for each time.
   UVWCalculator(const casacore::MDirection& phaseDir,
                 const casacore::MPosition& arrayPosition,
-                const std::vector<casacore::MPosition>& stationPositions);
+                const std::vector<casacore::MPosition>& stationPositions,
+                double refreshInterval = kDefaultRefreshInterval);
 
   /// get the UVW coordinates for the given baseline and time.
   std::array<double, 3> getUVW(unsigned int ant1, unsigned int ant2,
                                double time);
 
+  /// Get the UVW coordinates of all given baselines for the given time.
+  /// The result is sized to [3,nbaseline].
+  void getUVWs(double time, const casacore::Vector<int>& ant1,
+               const casacore::Vector<int>& ant2,
+               casacore::Matrix<double>& uvws);
+
+  /// Get the J2000 UVW coordinates of all antennae for the given time.
+  /// They are relative to the first antenna.
+  const std::vector<std::array<double, 3>>& getAntennaUVWs(double time);
+
+  /// Default interval (in seconds) of the time grid for the rotation.
+  /// It is 0, which disables the interpolation.
+  static constexpr double kDefaultRefreshInterval = 0.0;
+
  private:
+  /// Row-major 3x3 matrix.
+  using Matrix3 = std::array<double, 9>;
+
+  /// Calculate the UVWs of all antennae for the current time.
+  void calculateAntennaUVWs(double time);
+
+  /// Calculate the UVW of a single antenna using casacore conversions.
+  void calculateAntennaUVWCasacore(unsigned int ant);
+
+  /// Get the ITRF to J2000 rotation for the given time from casacore.
+  Matrix3 getRotation(double time);
+
+  /// Set the epoch in the frame; also update a moving phase direction.
+  void setEpoch(double time);
+
   casacore::MDirection itsPhaseDir;
   bool itsMovingPhaseDir;
   casacore::MDirection::Convert itsDirToJ2000;  ///< direction to J2000
   casacore::MBaseline::Convert itsBLToJ2000;    ///< convert ITRF to J2000
   casacore::MeasFrame itsFrame;
   std::vector<casacore::MBaseline> itsAntMB;
+  std::vector<std::array<double, 3>> itsAntPos;  ///< ITRF wrt first antenna
   std::vector<std::array<double, 3>> itsAntUvw;
   casacore::Block<bool> itsUvwFilled;
   double itsLastTime;
+  double itsFrameTime;  ///< epoch set in itsFrame
+  double itsRefreshInterval;
+  /// Projection of a J2000 baseline on the UVW axes.
+  Matrix3 itsUvwProjection;
+  /// Start time of the grid interval for which the rotations are valid.
+  double itsGridTime;
+  /// Slowly varying part of the rotation at the start and end of the grid
+  /// interval, i.e. with the Earth rotation since the start removed.
+  Matrix3 itsRotStart;
+  Matrix3 itsRotEnd;
 };
 
 }  // namespace base
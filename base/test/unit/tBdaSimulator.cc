@@ -0,0 +1,165 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "../../BdaSimulator.h"
+#include "../../Stokes.h"
+#include "../../Direction.h"
+#include "../../PointSource.h"
+
+#include <casacore/casa/BasicSL/Constants.h>
+
+#include <array>
+#include <complex>
+#include <vector>
+
+namespace dp3 {
+namespace base {
+namespace test {
+
+namespace {
+const Direction kReference(0.5, 0.1);
+// Offset 1/2 deg in radians in RA and DEC
+const Direction kOffsetSource(kReference.ra + 0.02, kReference.dec + 0.02);
+const size_t kNStations = 4;
+
+std::array<double, 3> StationUvw(size_t station) {
+  return {station * 5000.0, station * 1000.0 - 300.0, station * 10.0};
+}
+
+// Layout 0 has three channels and is used by all baselines except 0-3.
+// Layout 1 averages those channels and is only used by baseline 0-3, such
+// that the simulator uses both the shared station phasors and per-row
+// phasors.
+std::vector<BdaSimulator::ChannelLayout> MakeLayouts() {
+  return {{{130.0e6, 131.0e6, 132.0e6}, {1.0e6, 1.0e6, 1.0e6}},
+          {{131.0e6}, {3.0e6}}};
+}
+
+struct TestRows {
+  std::vector<std::array<double, 3>> uvws;
+  std::vector<std::vector<std::complex<double>>> buffers;
+  std::vector<BdaSimulator::Row> rows;
+};
+
+TestRows MakeRows(const std::vector<BdaSimulator::ChannelLayout>& layouts,
+                  size_t n_correlations) {
+  TestRows result;
+  std::vector<std::pair<size_t, size_t>> baselines;
+  for (size_t st1 = 0; st1 < kNStations; ++st1) {
+    for (size_t st2 = st1; st2 < kNStations; ++st2) {
+      baselines.emplace_back(st1, st2);
+    }
+  }
+  result.uvws.reserve(baselines.size());
+  result.buffers.reserve(baselines.size());
+  for (const std::pair<size_t, size_t>& baseline : baselines) {
+    const std::array<double, 3> uvw1 = StationUvw(baseline.first);
+    const std::array<double, 3> uvw2 = StationUvw(baseline.second);
+    result.uvws.push_back(
+        {uvw2[0] - uvw1[0], uvw2[1] - uvw1[1], uvw2[2] - uvw1[2]});
+    const size_t layout = (baseline.first == 0 && baseline.second == 3) ? 1 : 0;
+    result.buffers.emplace_back(
+        layouts[layout].frequencies.size() * n_correlations);
+    result.rows.push_back({baseline.first, baseline.second,
+                           result.uvws.back().data(), layout,
+                           result.buffers.back().data()});
+  }
+  return result;
+}
+
+// Direct evaluation of the visibility of a point source, without smearing.
+std::complex<double> ExpectedPhasor(const double* uvw, double frequency) {
+  const double d_ra = kOffsetSource.ra - kReference.ra;
+  const double l = cos(kOffsetSource.dec) * sin(d_ra);
+  const double m = sin(kOffsetSource.dec) * cos(kReference.dec) -
+                   cos(kOffsetSource.dec) * sin(kReference.dec) * cos(d_ra);
+  const double n = sqrt(1.0 - l * l - m * m);
+  const double phase = casacore::C::_2pi / casacore::C::c * frequency *
+                       (uvw[0] * l + uvw[1] * m + uvw[2] * (n - 1.0));
+  return std::polar(1.0, phase);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(bdasimulator)
+
+BOOST_AUTO_TEST_CASE(pointsource_stokes_i) {
+  Stokes stokes;
+  stokes.I = 2.0;
+  const std::vector<BdaSimulator::ChannelLayout> layouts = MakeLayouts();
+  TestRows test_rows = MakeRows(layouts, 1);
+
+  BdaSimulator simulator(kReference, kNStations, layouts, false, true);
+  simulator.SetRows(test_rows.rows);
+  simulator.simulate(std::make_shared<PointSource>(kOffsetSource, stokes));
+
+  for (const BdaSimulator::Row& row : test_rows.rows) {
+    const std::vector<double>& frequencies = layouts[row.layout].frequencies;
+    for (size_t ch = 0; ch < frequencies.size(); ++ch) {
+      const std::complex<double> expected =
+          row.station1 == row.station2
+              ? 0.0
+              : 2.0 * ExpectedPhasor(row.uvw, frequencies[ch]);
+      BOOST_CHECK_SMALL(std::abs(row.buffer[ch] - expected), 1.0e-9);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pointsource_fullstokes) {
+  Stokes stokes;
+  stokes.I = 2.0;
+  stokes.Q = 0.5;
+  stokes.U = 0.25;
+  stokes.V = 0.125;
+  const std::vector<BdaSimulator::ChannelLayout> layouts = MakeLayouts();
+  TestRows test_rows = MakeRows(layouts, 4);
+
+  BdaSimulator simulator(kReference, kNStations, layouts, false, false);
+  simulator.SetRows(test_rows.rows);
+  // Simulating twice should add the visibilities.
+  const auto source = std::make_shared<PointSource>(kOffsetSource, stokes);
+  simulator.simulate(source);
+  simulator.simulate(source);
+
+  const std::array<std::complex<double>, 4> coherencies{
+      std::complex<double>(2.5, 0.0), std::complex<double>(0.25, 0.125),
+      std::complex<double>(0.25, -0.125), std::complex<double>(1.5, 0.0)};
+  for (const BdaSimulator::Row& row : test_rows.rows) {
+    if (row.station1 == row.station2) continue;
+    const std::vector<double>& frequencies = layouts[row.layout].frequencies;
+    for (size_t ch = 0; ch < frequencies.size(); ++ch) {
+      const std::complex<double> phasor =
+          ExpectedPhasor(row.uvw, frequencies[ch]);
+      for (size_t cr = 0; cr < 4; ++cr) {
+        BOOST_CHECK_SMALL(
+            std::abs(row.buffer[ch * 4 + cr] - 2.0 * phasor * coherencies[cr]),
+            1.0e-9);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(freq_smearing) {
+  Stokes stokes;
+  stokes.I = 1.0;
+  const std::vector<BdaSimulator::ChannelLayout> layouts = MakeLayouts();
+  TestRows test_rows = MakeRows(layouts, 1);
+
+  BdaSimulator simulator(kReference, kNStations, layouts, true, true);
+  simulator.SetRows(test_rows.rows);
+  simulator.simulate(std::make_shared<PointSource>(kOffsetSource, stokes));
+
+  // Smearing reduces the amplitude, and more so for wider channels.
+  const BdaSimulator::Row& narrow = test_rows.rows[1];  // Baseline 0-1.
+  const BdaSimulator::Row& wide = test_rows.rows[3];    // Baseline 0-3.
+  BOOST_REQUIRE_EQUAL(wide.layout, 1u);
+  BOOST_CHECK_LT(std::abs(narrow.buffer[0]), 1.0);
+  BOOST_CHECK_LT(std::abs(wide.buffer[0]), std::abs(narrow.buffer[0]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace test
+}  // namespace base
+}  // namespace dp3
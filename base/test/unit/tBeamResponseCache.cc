@@ -0,0 +1,186 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "../../BeamResponseCache.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using dp3::base::BeamResponseCache;
+
+namespace {
+const size_t kNValues = 6;
+
+/// Evaluator that fills the values with the time and counts its calls.
+class CountingEvaluator {
+ public:
+  BeamResponseCache::Evaluator Function() {
+    return [this](double time, BeamResponseCache::Values& values) {
+      ++n_calls_;
+      values.assign(kNValues, aocommon::MC2x2(time, 0.0, 0.0, 2.0 * time));
+    };
+  }
+  size_t NCalls() const { return n_calls_; }
+
+ private:
+  size_t n_calls_ = 0;
+};
+
+const casacore::MDirection kDirection(casacore::MVDirection(0.1, 0.2),
+                                      casacore::MDirection::J2000);
+
+/// Reset the process-wide cache before a test.
+BeamResponseCache& ResetCache(size_t max_size, double time_interval) {
+  BeamResponseCache& cache = BeamResponseCache::Instance();
+  cache.SetMaxSize(max_size);
+  cache.SetTimeInterval(time_interval);
+  cache.Clear();
+  return cache;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(beamresponsecache)
+
+BOOST_AUTO_TEST_CASE(disabled) {
+  BeamResponseCache& cache = ResetCache(0, 0.0);
+  CountingEvaluator evaluator;
+  BeamResponseCache::Values values;
+  for (int i = 0; i < 3; ++i) {
+    cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, 10.0,
+              evaluator.Function(), values);
+  }
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 3u);
+  BOOST_CHECK_EQUAL(cache.NHits(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(shared_entries) {
+  BeamResponseCache& cache = ResetCache(1024 * 1024, 0.0);
+  const size_t context = cache.GetContext("ms;0;1;st0,st1,;1e8,");
+  BOOST_CHECK_EQUAL(cache.GetContext("ms;0;1;st0,st1,;1e8,"), context);
+  const size_t other_context = cache.GetContext("other");
+  BOOST_CHECK_NE(other_context, context);
+
+  CountingEvaluator evaluator;
+  BeamResponseCache::Values values;
+  cache.Get(context, everybeam::CorrectionMode::kFull, kDirection, 10.0,
+            evaluator.Function(), values);
+  cache.Get(context, everybeam::CorrectionMode::kFull, kDirection, 10.0,
+            evaluator.Function(), values);
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 1u);
+  BOOST_REQUIRE_EQUAL(values.size(), kNValues);
+  BOOST_CHECK_EQUAL(values[0][0], std::complex<double>(10.0, 0.0));
+
+  // Other times, modes, directions and contexts are different entries.
+  cache.Get(context, everybeam::CorrectionMode::kFull, kDirection, 20.0,
+            evaluator.Function(), values);
+  cache.Get(context, everybeam::CorrectionMode::kArrayFactor, kDirection,
+            10.0, evaluator.Function(), values);
+  cache.Get(context, everybeam::CorrectionMode::kFull,
+            casacore::MDirection(casacore::MVDirection(0.1, 0.3),
+                                 casacore::MDirection::J2000),
+            10.0, evaluator.Function(), values);
+  cache.Get(other_context, everybeam::CorrectionMode::kFull, kDirection, 10.0,
+            evaluator.Function(), values);
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 5u);
+  BOOST_CHECK_EQUAL(cache.NHits(), 1u);
+  BOOST_CHECK_EQUAL(cache.NMisses(), 5u);
+  ResetCache(0, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(time_interpolation) {
+  BeamResponseCache& cache = ResetCache(1024 * 1024, 60.0);
+  CountingEvaluator evaluator;
+  BeamResponseCache::Values values;
+  cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, 75.0,
+            evaluator.Function(), values);
+  // The beam is evaluated at 60 and 120 s and interpolated.
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 2u);
+  BOOST_REQUIRE_EQUAL(values.size(), kNValues);
+  BOOST_CHECK_CLOSE(values[0][0].real(), 75.0, 1.0e-8);
+  BOOST_CHECK_CLOSE(values[0][3].real(), 150.0, 1.0e-8);
+
+  cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, 105.0,
+            evaluator.Function(), values);
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 2u);
+  BOOST_CHECK_CLOSE(values[0][0].real(), 105.0, 1.0e-8);
+
+  // Only the grid point at 180 s is new.
+  cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, 125.0,
+            evaluator.Function(), values);
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 3u);
+  BOOST_CHECK_CLOSE(values[0][0].real(), 125.0, 1.0e-8);
+  ResetCache(0, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used) {
+  // Room for two entries.
+  BeamResponseCache& cache =
+      ResetCache(2 * kNValues * sizeof(aocommon::MC2x2), 0.0);
+  CountingEvaluator evaluator;
+  BeamResponseCache::Values values;
+  for (double time : {1.0, 2.0, 1.0, 3.0}) {
+    cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, time,
+              evaluator.Function(), values);
+  }
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 3u);
+  // Time 2 was removed, while time 1 was used more recently.
+  cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, 1.0,
+            evaluator.Function(), values);
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 3u);
+  cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, 2.0,
+            evaluator.Function(), values);
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 4u);
+  ResetCache(0, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(evaluation_error) {
+  BeamResponseCache& cache = ResetCache(1024 * 1024, 0.0);
+  const BeamResponseCache::Evaluator failing =
+      [](double, BeamResponseCache::Values&) {
+        throw std::runtime_error("evaluation failed");
+      };
+  BeamResponseCache::Values values;
+  BOOST_CHECK_THROW(cache.Get(0, everybeam::CorrectionMode::kFull, kDirection,
+                              1.0, failing, values),
+                    std::runtime_error);
+  // A failed evaluation is not cached.
+  CountingEvaluator evaluator;
+  cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, 1.0,
+            evaluator.Function(), values);
+  BOOST_CHECK_EQUAL(evaluator.NCalls(), 1u);
+  ResetCache(0, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(threads) {
+  BeamResponseCache& cache = ResetCache(1024 * 1024, 0.0);
+  std::atomic<size_t> n_calls(0);
+  std::atomic<bool> all_correct(true);
+  const BeamResponseCache::Evaluator evaluate =
+      [&n_calls](double time, BeamResponseCache::Values& values) {
+        ++n_calls;
+        values.assign(kNValues, aocommon::MC2x2(time, 0.0, 0.0, time));
+      };
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    // Boost test assertions are not thread-safe, so only collect a result.
+    threads.emplace_back([&cache, &evaluate, &all_correct]() {
+      BeamResponseCache::Values values;
+      for (int time = 0; time < 100; ++time) {
+        cache.Get(0, everybeam::CorrectionMode::kFull, kDirection, time,
+                  evaluate, values);
+        if (values[0][0].real() != time) all_correct = false;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  BOOST_CHECK(all_correct);
+  // Every time is evaluated only once, by one of the threads.
+  BOOST_CHECK_EQUAL(n_calls.load(), 100u);
+  ResetCache(0, 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
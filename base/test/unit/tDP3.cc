@@ -630,6 +630,75 @@ BOOST_FIXTURE_TEST_CASE(test_update_scale, FixtureCopyInput) {
   BOOST_CHECK(allEQ(flags_input.getColumn(), flags_output.getColumn()));
 }
 
+// Test if updating works fine when time chunks are processed concurrently.
+BOOST_FIXTURE_TEST_CASE(test_update_time_chunks, FixtureCopyInput) {
+  {
+    std::ofstream ostr(kParsetFile);
+    ostr << "checkparset=1\n";
+    ostr << "timechunks=4\n";
+    ostr << "msin=" << kCopyMs << '\n';
+    ostr << "msout=.\n";
+    ostr << "steps=[preflag,scaledata]\n";
+    ostr << "preflag.baseline=0&1\n";
+    ostr << "scaledata.coeffs=2\n";
+    ostr << "scaledata.stations=*\n";
+    ostr << "scaledata.scalesize=false\n";
+  }
+  dp3::base::DP3::execute(kParsetFile);
+
+  // All time slots should be scaled once, and only baseline 0-1 is flagged.
+  const Table table_input(kInputMs);
+  const ArrayColumn<Complex> data_input(table_input, "DATA");
+  const ArrayColumn<bool> flags_input(table_input, "FLAG");
+  const ScalarColumn<int> ant1(table_input, "ANTENNA1");
+  const ScalarColumn<int> ant2(table_input, "ANTENNA2");
+
+  const Table table_output(kCopyMs);
+  const ArrayColumn<Complex> data_output(table_output, "DATA");
+  const ArrayColumn<bool> flags_output(table_output, "FLAG");
+
+  BOOST_CHECK(allNear(data_input.getColumn() * Complex(2, 0),
+                      data_output.getColumn(), 1e-6));
+  for (unsigned int row = 0; row < table_output.nrow(); ++row) {
+    if (ant1(row) == 0 && ant2(row) == 1) {
+      BOOST_CHECK(allEQ(flags_output(row), true));
+    } else {
+      BOOST_CHECK(allEQ(flags_output(row), flags_input(row)));
+    }
+  }
+}
+
+// Steps that keep state over time can not be used with time chunks.
+BOOST_FIXTURE_TEST_CASE(test_time_chunks_stateful_step, FixtureCopyInput) {
+  {
+    std::ofstream ostr(kParsetFile);
+    ostr << "timechunks=2\n";
+    ostr << "msin=" << kCopyMs << '\n';
+    // The MSUpdater can process separate time ranges, so only the averager
+    // makes the time chunks fail.
+    ostr << "msout=.\n";
+    ostr << "steps=[avg]\n";
+    ostr << "avg.type=average\n";
+    ostr << "avg.timestep=2\n";
+  }
+  BOOST_CHECK_THROW(dp3::base::DP3::execute(kParsetFile),
+                    std::invalid_argument);
+}
+
+// Writing a new MS appends rows in time order, so it can not be used with
+// time chunks.
+BOOST_FIXTURE_TEST_CASE(test_time_chunks_new_ms, FixtureDirectory) {
+  {
+    std::ofstream ostr(kParsetFile);
+    ostr << "timechunks=2\n";
+    ostr << "msin=" << kInputMs << '\n';
+    ostr << "msout=tNDPPP_tmp.chunks.MS\n";
+    ostr << "steps=[]\n";
+  }
+  BOOST_CHECK_THROW(dp3::base::DP3::execute(kParsetFile),
+                    std::invalid_argument);
+}
+
 namespace {
 
 void CheckFullResFlags(const std::string& out_ms) {
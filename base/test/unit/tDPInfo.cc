@@ -108,4 +108,80 @@ BOOST_AUTO_TEST_CASE(channels_are_regular) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(bda_channel_starts_and_time_slots) {
+  const std::vector<int> kAnt(3, 0);
+  // Baseline 0 has the full resolution: 6 channels of 10 Hz. Baseline 1
+  // averages 2 and 4 channels and baseline 2 averages all channels.
+  const std::vector<std::vector<double>> kFreqs{
+      {5.0, 15.0, 25.0, 35.0, 45.0, 55.0}, {10.0, 40.0}, {30.0}};
+  const std::vector<std::vector<double>> kWidths{
+      {10.0, 10.0, 10.0, 10.0, 10.0, 10.0}, {20.0, 40.0}, {60.0}};
+  const double kStartTime = 100.0;
+  const double kInterval = 10.0;
+
+  dp3::base::DPInfo info;
+  info.init(1, 0, 6, 8, kStartTime, kInterval, "", "");
+  info.set(kAntNames, kAntDiam, kAntPos, kAnt, kAnt);  // Set baseline count.
+  info.set(std::vector<std::vector<double>>(kFreqs),
+           std::vector<std::vector<double>>(kWidths));
+  BOOST_TEST(info.BdaChannelStarts(0) ==
+                 std::vector<std::size_t>({0, 1, 2, 3, 4, 5, 6}),
+             boost::test_tools::per_element());
+  BOOST_TEST(info.BdaChannelStarts(1) == std::vector<std::size_t>({0, 2, 6}),
+             boost::test_tools::per_element());
+  BOOST_TEST(info.BdaChannelStarts(2) == std::vector<std::size_t>({0, 6}),
+             boost::test_tools::per_element());
+
+  // Rows of a single time slot, e.g. of baseline 0.
+  using Slots = std::pair<unsigned int, unsigned int>;
+  BOOST_TEST((info.TimeSlots(105.0, kInterval) == Slots(0, 1)));
+  BOOST_TEST((info.TimeSlots(135.0, kInterval) == Slots(3, 4)));
+  // Small deviations of the row time do not change the time slots.
+  BOOST_TEST((info.TimeSlots(135.0 + 1.0e-6, kInterval) == Slots(3, 4)));
+  BOOST_TEST((info.TimeSlots(135.0 - 1.0e-6, kInterval) == Slots(3, 4)));
+  // Rows that average 2 time slots, e.g. of baseline 1.
+  BOOST_TEST((info.TimeSlots(110.0, 2 * kInterval) == Slots(0, 2)));
+  BOOST_TEST((info.TimeSlots(150.0, 2 * kInterval) == Slots(4, 6)));
+  // A row that averages 4 time slots, e.g. of baseline 2.
+  BOOST_TEST((info.TimeSlots(160.0, 4 * kInterval) == Slots(4, 8)));
+}
+
+BOOST_AUTO_TEST_CASE(bda_channel_starts_regular) {
+  const std::vector<double> kFreqs{10.0, 20.0, 30.0};
+  const std::vector<double> kWidths{10.0, 10.0, 10.0};
+
+  // For regular data, each channel covers a single full resolution channel.
+  dp3::base::DPInfo info;
+  info.init(1, 0, kFreqs.size(), 1, 0.0, 1.0, "", "");
+  info.set(std::vector<double>(kFreqs), std::vector<double>(kWidths));
+  BOOST_TEST(info.BdaChannelStarts(0) == std::vector<std::size_t>({0, 1, 2, 3}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(need_vis_data_baselines) {
+  const std::vector<bool> kFirst{true, false, false};
+  const std::vector<bool> kSecond{false, false, true};
+  const std::vector<bool> kCombined{true, false, true};
+
+  dp3::base::DPInfo info;
+  BOOST_TEST(!info.needVisData());
+  info.setNeedVisData(kFirst);
+  BOOST_TEST(info.needVisData());
+  BOOST_TEST(info.needVisDataBaselines() == kFirst);
+  info.setNeedVisData(kSecond);
+  BOOST_TEST(info.needVisDataBaselines() == kCombined);
+
+  // Needing all baselines is not undone by a later selection.
+  info.setNeedVisData();
+  BOOST_TEST(info.needVisDataBaselines().empty());
+  info.setNeedVisData(kFirst);
+  BOOST_TEST(info.needVisData());
+  BOOST_TEST(info.needVisDataBaselines().empty());
+
+  // A selection of all baselines is the same as all baselines.
+  dp3::base::DPInfo info_all;
+  info_all.setNeedVisData(std::vector<bool>(3, true));
+  BOOST_TEST(info_all.needVisDataBaselines().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "../../MemoryPipeline.h"
+#include "../../../common/ParameterSet.h"
+
+#include <casacore/measures/Measures/MPosition.h>
+
+#include <vector>
+
+using dp3::base::DPBuffer;
+using dp3::base::DPInfo;
+using dp3::base::MemoryPipeline;
+
+namespace {
+const unsigned int kNCorr = 4;
+const unsigned int kNChan = 3;
+const unsigned int kNTimes = 4;
+const double kInterval = 10.0;
+
+DPInfo MakeInfo() {
+  DPInfo info;
+  info.init(kNCorr, 0, kNChan, kNTimes, 0.0, kInterval, "", "");
+  const std::vector<casacore::MPosition> positions(
+      2, casacore::MPosition(casacore::MVPosition(0.0, 0.0, 0.0),
+                             casacore::MPosition::ITRF));
+  casacore::Vector<casacore::String> names(2);
+  names[0] = "st0";
+  names[1] = "st1";
+  casacore::Vector<casacore::Int> ant1(2);
+  casacore::Vector<casacore::Int> ant2(2);
+  ant1[0] = 0;
+  ant2[0] = 0;
+  ant1[1] = 0;
+  ant2[1] = 1;
+  info.set(names, casacore::Vector<casacore::Double>(2, 30.0), positions, ant1,
+           ant2);
+  info.set(std::vector<double>{100.0e6, 101.0e6, 102.0e6},
+           std::vector<double>(kNChan, 1.0e6));
+  return info;
+}
+
+DPBuffer MakeBuffer(unsigned int time_index, unsigned int n_baselines) {
+  const casacore::IPosition shape(3, kNCorr, kNChan, n_baselines);
+  DPBuffer buffer((time_index + 0.5) * kInterval, kInterval);
+  buffer.getData().resize(shape);
+  buffer.getData() = DPBuffer::Complex(time_index, 1.0);
+  buffer.getFlags().resize(shape);
+  buffer.getFlags() = false;
+  buffer.getWeights().resize(shape);
+  buffer.getWeights() = 1.0f;
+  buffer.getUVW().resize(3, n_baselines);
+  buffer.getUVW() = 0.0;
+  return buffer;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(memorypipeline)
+
+BOOST_AUTO_TEST_CASE(no_steps) {
+  const DPInfo info = MakeInfo();
+  MemoryPipeline pipeline(dp3::common::ParameterSet(), info);
+  BOOST_CHECK_EQUAL(pipeline.getInfo().nchan(), kNChan);
+
+  for (unsigned int t = 0; t < kNTimes; ++t) {
+    pipeline.process(MakeBuffer(t, info.nbaselines()));
+  }
+  pipeline.finish();
+
+  // More buffers than the initial size should be kept.
+  BOOST_REQUIRE_EQUAL(pipeline.nResults(), kNTimes);
+  for (unsigned int t = 0; t < kNTimes; ++t) {
+    const DPBuffer& result = pipeline.getResults()[t];
+    BOOST_CHECK_CLOSE(result.getTime(), (t + 0.5) * kInterval, 1.0e-8);
+    BOOST_CHECK_EQUAL(result.getData()(0, 0, 1), DPBuffer::Complex(t, 1.0));
+  }
+  pipeline.clearResults();
+  BOOST_CHECK_EQUAL(pipeline.nResults(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(averager) {
+  dp3::common::ParameterSet parset;
+  parset.add("steps", "[avg]");
+  parset.add("avg.type", "averager");
+  parset.add("avg.timestep", "2");
+  parset.add("avg.freqstep", "3");
+  const DPInfo info = MakeInfo();
+  MemoryPipeline pipeline(parset, info);
+  BOOST_CHECK_EQUAL(pipeline.getInputInfo().nchan(), kNChan);
+  BOOST_CHECK_EQUAL(pipeline.getInfo().nchan(), 1u);
+  BOOST_CHECK_EQUAL(pipeline.getInfo().timeInterval(), 2 * kInterval);
+
+  for (unsigned int t = 0; t < kNTimes; ++t) {
+    pipeline.process(MakeBuffer(t, info.nbaselines()));
+  }
+  pipeline.finish();
+
+  BOOST_REQUIRE_EQUAL(pipeline.nResults(), kNTimes / 2);
+  for (unsigned int i = 0; i < kNTimes / 2; ++i) {
+    const DPBuffer& result = pipeline.getResults()[i];
+    BOOST_CHECK_EQUAL(result.getData().shape(),
+                      casacore::IPosition(3, kNCorr, 1, info.nbaselines()));
+    const DPBuffer::Complex expected(2 * i + 0.5, 1.0);
+    BOOST_CHECK_SMALL(std::abs(result.getData()(0, 0, 1) - expected), 1.0e-6f);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../../PackedFlags.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using dp3::base::PackedFlags;
+
+namespace {
+const std::size_t kNCorr = 4;
+const std::size_t kNChan = 70;  // More than one word per baseline.
+const std::size_t kNBl = 3;
+
+/// Flag every third channel of a baseline, with an offset per baseline.
+casacore::Cube<bool> CreateFlags() {
+  casacore::Cube<bool> flags(kNCorr, kNChan, kNBl, false);
+  for (std::size_t bl = 0; bl < kNBl; ++bl) {
+    for (std::size_t chan = bl; chan < kNChan; chan += 3) {
+      for (std::size_t corr = 0; corr < kNCorr; ++corr) {
+        flags(corr, chan, bl) = true;
+      }
+    }
+  }
+  return flags;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(packedflags)
+
+BOOST_AUTO_TEST_CASE(constructor) {
+  const PackedFlags empty;
+  BOOST_CHECK(empty.Empty());
+  BOOST_CHECK_EQUAL(empty.Count(), 0u);
+
+  const PackedFlags flags(kNChan, kNBl);
+  BOOST_CHECK(!flags.Empty());
+  BOOST_CHECK_EQUAL(flags.NChannels(), kNChan);
+  BOOST_CHECK_EQUAL(flags.NBaselines(), kNBl);
+  BOOST_CHECK_EQUAL(flags.WordsPerBaseline(), 2u);
+  BOOST_CHECK_EQUAL(flags.Count(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(pack_unpack) {
+  const casacore::Cube<bool> flags = CreateFlags();
+  PackedFlags packed;
+  BOOST_CHECK(packed.Pack(flags));
+  BOOST_CHECK_EQUAL(packed.NChannels(), kNChan);
+  BOOST_CHECK_EQUAL(packed.NBaselines(), kNBl);
+  for (std::size_t bl = 0; bl < kNBl; ++bl) {
+    for (std::size_t chan = 0; chan < kNChan; ++chan) {
+      BOOST_CHECK_EQUAL(packed.Get(chan, bl), flags(0, chan, bl));
+    }
+  }
+
+  casacore::Cube<bool> unpacked;
+  packed.Unpack(unpacked, kNCorr);
+  BOOST_REQUIRE(unpacked.shape() == flags.shape());
+  BOOST_CHECK_EQUAL_COLLECTIONS(unpacked.begin(), unpacked.end(),
+                                flags.begin(), flags.end());
+}
+
+BOOST_AUTO_TEST_CASE(pack_non_uniform) {
+  casacore::Cube<bool> flags(kNCorr, kNChan, kNBl, false);
+  flags(1, 5, 2) = true;
+  PackedFlags packed;
+  BOOST_CHECK(!packed.Pack(flags));
+  // A channel is flagged if any correlation is flagged.
+  BOOST_CHECK(packed.Get(5, 2));
+  BOOST_CHECK_EQUAL(packed.Count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(count) {
+  PackedFlags packed;
+  packed.Pack(CreateFlags());
+  std::size_t total = 0;
+  for (std::size_t bl = 0; bl < kNBl; ++bl) {
+    const std::size_t expected = (kNChan - bl + 2) / 3;
+    BOOST_CHECK_EQUAL(packed.CountBaseline(bl), expected);
+    total += expected;
+  }
+  BOOST_CHECK_EQUAL(packed.Count(), total);
+
+  std::vector<int64_t> counts(kNChan, 0);
+  packed.AddChannelCounts(counts.data());
+  for (std::size_t chan = 0; chan < kNChan; ++chan) {
+    // Each channel is flagged in exactly one of the three baselines.
+    BOOST_CHECK_EQUAL(counts[chan], 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(set_and_merge) {
+  PackedFlags before;
+  before.Pack(CreateFlags());
+  PackedFlags after(kNChan, kNBl);
+  after.SetBaseline(1);
+  BOOST_CHECK_EQUAL(after.CountBaseline(1), kNChan);
+  after.Set(3, 0, true);
+  after.Set(4, 0, true);
+  after.Set(4, 0, false);
+  BOOST_CHECK(after.Get(3, 0));
+  BOOST_CHECK(!after.Get(4, 0));
+
+  // Channel 3 of baseline 0 was already set in 'before'.
+  const std::size_t new_flags = after.CountNew(before);
+  BOOST_CHECK_EQUAL(new_flags, kNChan - before.CountBaseline(1));
+
+  const std::size_t count_before = before.Count();
+  before.Merge(after);
+  BOOST_CHECK_EQUAL(before.Count(), count_before + new_flags);
+
+  before.Clear();
+  BOOST_CHECK_EQUAL(before.Count(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
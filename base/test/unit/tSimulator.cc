@@ -4,8 +4,10 @@
 #include <boost/test/unit_test.hpp>
 
 #include "../../Simulator.h"
+#include "../../ComponentBatch.h"
 #include "../../Stokes.h"
 #include "../../Direction.h"
+#include "../../GaussianSource.h"
 #include "../../PointSource.h"
 
 #include <sstream>
@@ -22,9 +24,14 @@ const Direction kReference(0.5, 0.1);
 const Direction kOffsetSource(kReference.ra + 0.02, kReference.dec + 0.02);
 const size_t kNStations = 4;
 const size_t kNChan = 2;
+// More channels than fit in one channel block of the batched prediction,
+// with a partially filled last block.
+const size_t kNManyChan = 130;
 
+template <typename T>
 Simulator MakeSimulator(bool correct_freq_smearing, bool stokes_i_only,
-                        casacore::Cube<std::complex<double>>& buffer) {
+                        casacore::Cube<std::complex<T>>& buffer,
+                        size_t n_channels = kNChan) {
   std::vector<Baseline> baselines;
   for (size_t st1 = 0; st1 < kNStations - 1; ++st1) {
     for (size_t st2 = st1 + 1; st2 < kNStations; ++st2) {
@@ -33,10 +40,10 @@ Simulator MakeSimulator(bool correct_freq_smearing, bool stokes_i_only,
   }
 
   std::vector<double> chan_freqs;
-  for (size_t chan = 0; chan < kNChan; ++chan) {
+  for (size_t chan = 0; chan < n_channels; ++chan) {
     chan_freqs.push_back(130.0e6 + chan * 1.0e6);
   }
-  std::vector<double> chan_widths(kNChan, 1.0e6);
+  std::vector<double> chan_widths(n_channels, 1.0e6);
 
   casacore::Matrix<double> uvw(3, kNStations);
 
@@ -117,6 +124,166 @@ BOOST_AUTO_TEST_CASE(test_pointsource_onlyI_freqsmear) {
   BOOST_CHECK_CLOSE(std::abs(buffer(1, 0, kNStations - 1)), 0.759154, 1.0e-3);
 }
 
+// Point sources and Gaussians, with and without a spectrum.
+std::vector<ModelComponent::ConstPtr> MakeComponents() {
+  Stokes stokes;
+  stokes.I = 2.0;
+  stokes.Q = 0.5;
+  stokes.U = 0.2;
+  stokes.V = 0.1;
+
+  std::vector<ModelComponent::ConstPtr> components;
+  components.push_back(std::make_shared<PointSource>(kOffsetSource, stokes));
+  components.push_back(std::make_shared<PointSource>(kReference, stokes));
+  auto spectral = std::make_shared<PointSource>(
+      Direction(kReference.ra - 0.01, kReference.dec + 0.03), stokes);
+  const std::vector<double> terms{-0.7, 0.1};
+  spectral->setSpectralTerms(120.0e6, true, terms.begin(), terms.end());
+  components.push_back(spectral);
+  auto rotated = std::make_shared<PointSource>(
+      Direction(kReference.ra + 0.01, kReference.dec - 0.02), stokes);
+  rotated->setRotationMeasure(0.3, 0.4, 2.0);
+  components.push_back(rotated);
+  for (size_t i = 0; i < 3; ++i) {
+    auto gaussian = std::make_shared<GaussianSource>(
+        Direction(kReference.ra + 0.01 * i, kReference.dec), stokes);
+    gaussian->setPositionAngle(0.3 * i);
+    gaussian->setMajorAxis(1.0e-4 * (i + 1));
+    gaussian->setMinorAxis(0.5e-4 * (i + 1));
+    if (i == 2) {
+      gaussian->setSpectralTerms(120.0e6, false, terms.begin(), terms.end());
+    }
+    components.push_back(gaussian);
+  }
+  return components;
+}
+
+// Check that predicting the batches gives the same result as predicting the
+// components one by one.
+void CheckBatches(const std::vector<ModelComponent::ConstPtr>& components,
+                  const std::vector<ComponentBatch>& batches,
+                  size_t n_channels) {
+  const size_t nbaselines = kNStations * (kNStations - 1) / 2;
+  for (bool stokes_i_only : {false, true}) {
+    for (bool correct_freq_smearing : {false, true}) {
+      const size_t ncorr = stokes_i_only ? 1 : 4;
+      casacore::Cube<std::complex<double>> expected(ncorr, n_channels,
+                                                    nbaselines, 0.0);
+      Simulator sim = MakeSimulator(correct_freq_smearing, stokes_i_only,
+                                    expected, n_channels);
+      for (const ModelComponent::ConstPtr& component : components) {
+        sim.simulate(component);
+      }
+
+      casacore::Cube<std::complex<double>> result(ncorr, n_channels,
+                                                  nbaselines, 0.0);
+      Simulator batch_sim = MakeSimulator(correct_freq_smearing, stokes_i_only,
+                                          result, n_channels);
+      for (const ComponentBatch& batch : batches) {
+        batch_sim.simulate(batch);
+      }
+
+      for (size_t i = 0; i < expected.size(); ++i) {
+        BOOST_CHECK_SMALL(std::abs(result.data()[i] - expected.data()[i]),
+                          1.0e-9);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_batches) {
+  const std::vector<ModelComponent::ConstPtr> components = MakeComponents();
+  const auto patch =
+      std::make_shared<Patch>("patch", components.begin(), components.end());
+  std::vector<std::pair<ModelComponent::ConstPtr, Patch::ConstPtr>>
+      source_list;
+  for (const ModelComponent::ConstPtr& component : components) {
+    source_list.emplace_back(component, patch);
+  }
+
+  const std::vector<ComponentBatch> batches =
+      MakeComponentBatches(source_list, 2, true);
+  // Flat and spectral point sources and Gaussians.
+  BOOST_REQUIRE_EQUAL(batches.size(), 4u);
+  for (const ComponentBatch& batch : batches) {
+    BOOST_CHECK_EQUAL(batch.GetPatch(), patch);
+  }
+
+  CheckBatches(components, batches, kNChan);
+}
+
+BOOST_AUTO_TEST_CASE(test_batches_many_channels) {
+  const std::vector<ModelComponent::ConstPtr> components = MakeComponents();
+  std::vector<std::pair<ModelComponent::ConstPtr, Patch::ConstPtr>>
+      source_list;
+  for (const ModelComponent::ConstPtr& component : components) {
+    source_list.emplace_back(component, nullptr);
+  }
+  const std::vector<ComponentBatch> batches =
+      MakeComponentBatches(source_list, 3, false);
+
+  CheckBatches(components, batches, kNManyChan);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_size) {
+  // The tables of a batch are used per block of channels, so a batch of a
+  // LOFAR-sized observation should hold several components.
+  BOOST_CHECK_GT(Simulator::BatchSize(60, 1000), 1u);
+  BOOST_CHECK_EQUAL(Simulator::BatchSize(60, 1000),
+                    Simulator::BatchSize(60, 64));
+  BOOST_CHECK_GT(Simulator::BatchSize(60, 16), Simulator::BatchSize(60, 64));
+}
+
+BOOST_AUTO_TEST_CASE(test_single_precision) {
+  const std::vector<ModelComponent::ConstPtr> components = MakeComponents();
+  std::vector<std::pair<ModelComponent::ConstPtr, Patch::ConstPtr>>
+      source_list;
+  for (const ModelComponent::ConstPtr& component : components) {
+    source_list.emplace_back(component, nullptr);
+  }
+  const std::vector<ComponentBatch> batches =
+      MakeComponentBatches(source_list, 2, false);
+
+  const size_t nbaselines = kNStations * (kNStations - 1) / 2;
+  for (bool stokes_i_only : {false, true}) {
+    for (bool correct_freq_smearing : {false, true}) {
+      const size_t ncorr = stokes_i_only ? 1 : 4;
+      casacore::Cube<std::complex<double>> expected(ncorr, kNChan, nbaselines,
+                                                    0.0);
+      Simulator sim =
+          MakeSimulator(correct_freq_smearing, stokes_i_only, expected);
+      for (const ComponentBatch& batch : batches) {
+        sim.simulate(batch);
+      }
+
+      casacore::Cube<std::complex<float>> result(ncorr, kNChan, nbaselines,
+                                                 0.0f);
+      Simulator single_sim =
+          MakeSimulator(correct_freq_smearing, stokes_i_only, result);
+      for (const ComponentBatch& batch : batches) {
+        single_sim.simulate(batch);
+      }
+      // Single components are predicted as a batch of one component.
+      casacore::Cube<std::complex<float>> component_result(
+          ncorr, kNChan, nbaselines, 0.0f);
+      Simulator component_sim = MakeSimulator(
+          correct_freq_smearing, stokes_i_only, component_result);
+      for (const ModelComponent::ConstPtr& component : components) {
+        component_sim.simulate(component);
+      }
+
+      for (size_t i = 0; i < expected.size(); ++i) {
+        const std::complex<double> value = expected.data()[i];
+        BOOST_CHECK_SMALL(
+            std::abs(std::complex<double>(result.data()[i]) - value), 1.0e-5);
+        BOOST_CHECK_SMALL(
+            std::abs(std::complex<double>(component_result.data()[i]) - value),
+            1.0e-5);
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }  // namespace test
 }  // namespace base
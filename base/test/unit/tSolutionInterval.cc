@@ -150,4 +150,28 @@ BOOST_AUTO_TEST_CASE(restore) {
              buffer.getWeights().tovector());
 }
 
+/// Test that flags and weights that differ per correlation are restored
+BOOST_AUTO_TEST_CASE(restore_per_correlation) {
+  MockInput input;
+  NSTimer timer;
+  DPBuffer buffer = InitBuffer();
+  const casacore::IPosition shape(3, 2, 3, kNBL);
+  buffer.setData(casacore::Cube<casacore::Complex>(shape, 1.0f));
+  casacore::Cube<bool> flags(shape, false);
+  flags(1, 2, 0) = true;
+  buffer.setFlags(flags);
+  casacore::Cube<float> weights(shape, 1.0f);
+  weights(1, 1, 1) = 2.0f;
+  buffer.setWeights(weights);
+
+  SolutionInterval solInt(input, 0, 1, timer);
+  solInt.PushBack(buffer);
+  solInt.DataBuffers()[0].getFlags() = true;
+  solInt.DataBuffers()[0].getWeights() = 0.5f;
+  solInt.RestoreFlagsAndWeights();
+
+  BOOST_TEST(solInt[0].getFlags().tovector() == flags.tovector());
+  BOOST_TEST(solInt[0].getWeights().tovector() == weights.tovector());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 
 #include "../../../common/test/unit/fixtures/fDirectory.h"
 #include "../../../common/test/unit/fixtures/fSkymodel.h"
+#include "../../../parmdb/SkymodelToSourceDB.h"
 #include "../../../parmdb/SourceDB.h"
 
 #include <boost/test/unit_test.hpp>
@@ -18,6 +19,16 @@ using dp3::base::PointSource;
 
 static const std::string kSkymodelName = "unittest.skymodel";
 static const std::string kSourceDBName = "unittest.sourcedb";
+static const std::string kCompiledName = "unittest.compiled";
+
+static void MakeCompiled(const std::string& skymodel_name,
+                         const std::string& compiled_name) {
+  dp3::parmdb::skymodel_to_source_db::MakeCompiledSourceDb(
+      skymodel_name, compiled_name,
+      dp3::parmdb::skymodel_to_source_db::ReadFormat("", skymodel_name), "",
+      "", true, false,
+      dp3::parmdb::skymodel_to_source_db::GetSearchInfo("", "", ""));
+}
 
 BOOST_AUTO_TEST_SUITE(
     source_db_util,
@@ -121,6 +132,31 @@ BOOST_AUTO_TEST_CASE(source_db_make_patch_list) {
   const std::vector<std::string> source_patterns;
   TestPatches(dp3::base::SourceDB{kSkymodelName, source_patterns});
   TestPatches(dp3::base::SourceDB{kSourceDBName, source_patterns});
+  MakeCompiled(kSkymodelName, kCompiledName);
+  TestPatches(dp3::base::SourceDB{kCompiledName, source_patterns});
+}
+
+BOOST_AUTO_TEST_CASE(source_db_compiled_shared) {
+  MakeCompiled(kSkymodelName, kCompiledName);
+  const std::vector<std::string> source_patterns{"ra*", "center"};
+  dp3::base::SourceDB source_db{kCompiledName, source_patterns};
+  const std::vector<Patch::ConstPtr> patches = source_db.MakePatchList();
+  BOOST_REQUIRE_EQUAL(patches.size(), 3);
+  CheckEqual(*patches[0], test_source_db::Expected[0]);
+  CheckEqual(*patches[1], test_source_db::Expected[1]);
+  CheckEqual(*patches[2], test_source_db::Expected[2]);
+
+  // The patches and components are shared with other users.
+  const std::vector<Patch::ConstPtr> other_patches =
+      dp3::base::SourceDB{kCompiledName, std::vector<std::string>{"ra_off"}}
+          .MakePatchList();
+  BOOST_REQUIRE_EQUAL(other_patches.size(), 1);
+  BOOST_CHECK_EQUAL(other_patches[0], patches[1]);
+
+  BOOST_CHECK_THROW(
+      (dp3::base::SourceDB{kCompiledName, std::vector<std::string>{"@none"}}
+           .MakePatchList()),
+      std::exception);
 }
 
 static void TestPatchesExplicit(dp3::base::SourceDB&& source_db) {
@@ -153,6 +189,9 @@ VirA2, point, VirAx , 21.1deg, 10.1deg, 2)"}};
 
   TestPatchesExplicit(dp3::base::SourceDB{kSkymodel, source_patterns});
   TestPatchesExplicit(dp3::base::SourceDB{kSourceDB, source_patterns});
+  const std::string kCompiled = "explicit.compiled";
+  MakeCompiled(kSkymodel, kCompiled);
+  TestPatchesExplicit(dp3::base::SourceDB{kCompiled, source_patterns});
 }
 
 static void TestPolarized(dp3::base::SourceDB&& source_db) {
@@ -163,6 +202,8 @@ BOOST_AUTO_TEST_CASE(source_db_check_polarised) {
   const std::vector<std::string> source_patterns;
   TestPolarized(dp3::base::SourceDB{kSkymodelName, source_patterns});
   TestPolarized(dp3::base::SourceDB{kSourceDBName, source_patterns});
+  MakeCompiled(kSkymodelName, kCompiledName);
+  TestPolarized(dp3::base::SourceDB{kCompiledName, source_patterns});
 }
 
 BOOST_AUTO_TEST_CASE(source_db_empty_source_pattern_string) {
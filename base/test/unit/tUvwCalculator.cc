@@ -51,6 +51,55 @@ void TestRelativeUvw(const casacore::MDirection& phase_direction) {
   BOOST_CHECK_CLOSE(uvw_0_1[2] + uvw_1_2[2], uvw_0_2[2], 1.0e-6);
 }
 
+/**
+ * Test that the interpolated rotation used by the UVWCalculator gives the
+ * same UVWs as the full casacore conversions, which are used by default
+ * (i.e. when the refresh interval is zero).
+ */
+void TestCasacoreUvw(const casacore::MDirection& phase_direction) {
+  // Approximate ITRF positions of some LOFAR stations, with baselines
+  // from about 100 m to 600 km.
+  const std::vector<std::vector<double>> station_values{
+      {3826577.5, 461022.6, 5064892.8},
+      {3826979.4, 461005.5, 5064584.6},
+      {3828733.6, 454692.4, 5063849.9},
+      {3850980.9, 483694.2, 5046978.9},
+      {4034101.9, 487012.4, 4900230.2},
+      {3370272.0, 712125.6, 5349991.2}};
+  std::vector<casacore::MPosition> station_positions;
+  for (const std::vector<double>& values : station_values) {
+    station_positions.emplace_back(
+        casacore::Quantum<casacore::Vector<double>>(values, "m"),
+        casacore::MPosition::ITRF);
+  }
+  const casacore::MPosition& array_position = station_positions.front();
+
+  UVWCalculator fast(phase_direction, array_position, station_positions,
+                     600.0);
+  UVWCalculator exact(phase_direction, array_position, station_positions);
+  casacore::Vector<int> ant1(station_values.size() - 1, 0);
+  casacore::Vector<int> ant2(ant1.size());
+  for (size_t i = 0; i < ant2.size(); ++i) ant2[i] = i + 1;
+
+  // Cover a few grid intervals with irregular time steps.
+  const double kStartTime = 4.87e9;
+  for (double offset = 0.0; offset < 2000.0; offset += 97.3) {
+    const double time = kStartTime + offset;
+    casacore::Matrix<double> uvws;
+    fast.getUVWs(time, ant1, ant2, uvws);
+    BOOST_REQUIRE_EQUAL(uvws.ncolumn(), ant1.size());
+    for (size_t bl = 0; bl < ant1.size(); ++bl) {
+      const std::array<double, 3> expected =
+          exact.getUVW(ant1[bl], ant2[bl], time);
+      const std::array<double, 3> uvw = fast.getUVW(ant1[bl], ant2[bl], time);
+      for (size_t i = 0; i < 3; ++i) {
+        BOOST_CHECK_SMALL(uvws(i, bl) - expected[i], 1.0e-6);
+        BOOST_CHECK_SMALL(uvw[i] - expected[i], 1.0e-6);
+      }
+    }
+  }
+}
+
 }  // namespace
 
 BOOST_AUTO_TEST_SUITE(uvwcalculator)
@@ -66,4 +115,17 @@ BOOST_AUTO_TEST_CASE(relative_uvw_moving_phasedirection) {
   TestRelativeUvw(casacore::MDirection::makeMDirection("Sun"));
 }
 
+BOOST_AUTO_TEST_CASE(interpolated_rotation) {
+  TestCasacoreUvw(casacore::MDirection(casacore::Quantity(123.4, "deg"),
+                                       casacore::Quantity(48.2, "deg"),
+                                       casacore::MDirection::J2000));
+  TestCasacoreUvw(casacore::MDirection(casacore::Quantity(2.1, "rad"),
+                                       casacore::Quantity(-0.3, "rad"),
+                                       casacore::MDirection::J2000));
+}
+
+BOOST_AUTO_TEST_CASE(moving_phasedirection_uses_casacore) {
+  TestCasacoreUvw(casacore::MDirection::makeMDirection("Sun"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -5,11 +5,10 @@
 
 #include "ProximityClustering.h"
 
-#include <iostream>
-#include <sstream>
-#include <memory>
+#include <algorithm>
 #include <cmath>
-#include <cassert>
+#include <functional>
+#include <unordered_map>
 
 using std::size_t;
 
@@ -20,10 +19,24 @@ ProximityClustering::ProximityClustering(
     const std::vector<ProximityClustering::Coordinate> &coordinates)
     : coordinates_(coordinates) {}
 
-ProximityClustering::Coordinate ProximityClustering::GetCoordinate(
-    size_t i) const {
-  assert(i < coordinates_.size());
-  return coordinates_[i];
+size_t ProximityClustering::CellHash::operator()(const Cell &cell) const {
+  const std::hash<std::int64_t> hash;
+  return hash(cell.first) * 0x9E3779B97F4A7C15ull ^ hash(cell.second);
+}
+
+ProximityClustering::Cell ProximityClustering::GetCell(Coordinate x,
+                                                       NumType cell_size) {
+  // Clamp the cell indices, such that they fit in the index type. Sources in
+  // the clamped cells are still compared using their coordinates.
+  const NumType kMaxIndex = 1.0e15;
+  const NumType i = std::floor(x.first / cell_size);
+  const NumType j = std::floor(x.second / cell_size);
+  return Cell(std::max(-kMaxIndex, std::min(i, kMaxIndex)),
+              std::max(-kMaxIndex, std::min(j, kMaxIndex)));
+}
+
+bool ProximityClustering::IsFinite(Coordinate x) {
+  return std::isfinite(x.first) && std::isfinite(x.second);
 }
 
 ProximityClustering::NumType ProximityClustering::EuclidDistance(
@@ -32,58 +45,61 @@ ProximityClustering::NumType ProximityClustering::EuclidDistance(
                    (x1.second - x2.second) * (x1.second - x2.second));
 }
 
-ProximityClustering::Coordinate ProximityClustering::Centroid(size_t i) const {
-  assert(!clusters_[i].empty());
-  NumType x = 0;
-  NumType y = 0;
-  for (size_t j : clusters_[i]) {
-    x += GetCoordinate(j).first;
-    y += GetCoordinate(j).second;
-  }
-  x /= clusters_[i].size();
-  y /= clusters_[i].size();
-  return std::make_pair(x, y);
-}
-
-ProximityClustering::NumType ProximityClustering::ClusterDistance(
-    size_t i, size_t j) const {
-  Coordinate centroid1 = Centroid(i);
-  Coordinate centroid2 = Centroid(j);
-  return EuclidDistance(centroid1, centroid2);
-}
+std::vector<std::vector<size_t>> ProximityClustering::Group(
+    NumType max_distance) {
+  const size_t n_sources = coordinates_.size();
+  std::vector<std::vector<size_t>> clusters;
 
-void ProximityClustering::GroupSource(size_t source_index,
-                                      NumType max_distance) {
-  std::vector<std::vector<size_t>> new_clusters;
-  for (size_t j = 0; j < source_index + 1; ++j) {
-    new_clusters.push_back(clusters_[j]);
-  }
-  for (size_t j = source_index + 1; j < clusters_.size(); ++j) {
-    if (ClusterDistance(source_index, j) < max_distance) {
-      new_clusters[source_index].insert(new_clusters[source_index].end(),
-                                        clusters_[j].begin(),
-                                        clusters_[j].end());
-    } else {
-      new_clusters.push_back(clusters_[j]);
+  // Sources that lie closer than max_distance to each other are in the same
+  // or in neighbouring cells. Sources with non-finite coordinates are not
+  // close to any source, and are not put in the grid.
+  const bool use_grid = max_distance > 0.0;
+  std::vector<Cell> cells(n_sources);
+  std::unordered_map<Cell, std::vector<size_t>, CellHash> grid;
+  if (use_grid) {
+    for (size_t i = 0; i != n_sources; ++i) {
+      if (IsFinite(coordinates_[i])) {
+        cells[i] = GetCell(coordinates_[i], max_distance);
+        grid[cells[i]].push_back(i);
+      }
     }
   }
-  clusters_ = std::move(new_clusters);
-}
 
-std::vector<std::vector<size_t>> ProximityClustering::Group(
-    NumType max_distance) {
-  clusters_.clear();
-  for (size_t i = 0; i < coordinates_.size(); ++i) {
-    clusters_.emplace_back(1, i);
-  }
+  std::vector<bool> grouped(n_sources, false);
+  std::vector<size_t> neighbours;
+  for (size_t i = 0; i != n_sources; ++i) {
+    if (grouped[i]) continue;
+    grouped[i] = true;
+    clusters.emplace_back(1, i);
+    if (!use_grid || !IsFinite(coordinates_[i])) continue;
 
-  size_t i = 0;
-  while (i < clusters_.size()) {  // while loop because the number of clusters
-                                  // decreases in an iteration
-    GroupSource(i, max_distance);
-    ++i;
+    neighbours.clear();
+    for (std::int64_t di = -1; di <= 1; ++di) {
+      for (std::int64_t dj = -1; dj <= 1; ++dj) {
+        auto cell = grid.find(Cell(cells[i].first + di, cells[i].second + dj));
+        if (cell == grid.end()) continue;
+        // Collect the neighbours and remove them, and the sources that were
+        // grouped before, from the cell.
+        std::vector<size_t> &members = cell->second;
+        size_t n_kept = 0;
+        for (size_t j : members) {
+          if (grouped[j]) continue;
+          if (EuclidDistance(coordinates_[i], coordinates_[j]) < max_distance) {
+            grouped[j] = true;
+            neighbours.push_back(j);
+          } else {
+            members[n_kept] = j;
+            ++n_kept;
+          }
+        }
+        members.resize(n_kept);
+      }
+    }
+    std::sort(neighbours.begin(), neighbours.end());
+    clusters.back().insert(clusters.back().end(), neighbours.begin(),
+                           neighbours.end());
   }
-  return std::move(clusters_);
+  return clusters;
 }
 
 }  // namespace common
@@ -6,6 +6,7 @@
 #ifndef PROXIMITY_CLUSTERING_H
 #define PROXIMITY_CLUSTERING_H
 
+#include <cstdint>
 #include <vector>
 #include <utility>
 
@@ -22,16 +23,30 @@ class ProximityClustering {
   using Coordinate = std::pair<NumType, NumType>;
 
   ProximityClustering(const std::vector<Coordinate> &coordinates);
+
+  /**
+   * Group the sources. The sources are visited in order. A source that is
+   * not yet grouped starts a new group, which gets all later sources that are
+   * not yet grouped and that lie closer than max_distance to it, in
+   * increasing order.
+   *
+   * Nearby sources are found using a grid with cells of max_distance, such
+   * that grouping n sources takes O(n log n) time when the number of sources
+   * per cell is bounded.
+   */
   std::vector<std::vector<std::size_t>> Group(NumType max_distance);
 
  private:
-  Coordinate GetCoordinate(std::size_t i) const;
-  NumType ClusterDistance(std::size_t i, std::size_t j) const;
-  void GroupSource(std::size_t source_index, NumType max_distance);
-  Coordinate Centroid(std::size_t i) const;
+  using Cell = std::pair<std::int64_t, std::int64_t>;
+
+  struct CellHash {
+    std::size_t operator()(const Cell &cell) const;
+  };
+
+  static Cell GetCell(Coordinate x, NumType cell_size);
+  static bool IsFinite(Coordinate x);
   static NumType EuclidDistance(Coordinate x1, Coordinate x2);
 
-  std::vector<std::vector<std::size_t>> clusters_;
   const std::vector<Coordinate> &coordinates_;
 };
 
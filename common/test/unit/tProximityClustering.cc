@@ -5,8 +5,34 @@
 
 #include "../../ProximityClustering.h"
 
+#include <cmath>
+#include <limits>
+#include <random>
+
 using dp3::common::ProximityClustering;
 
+namespace {
+/// Straightforward quadratic implementation of the grouping.
+std::vector<std::vector<size_t>> ReferenceGroup(
+    const std::vector<std::pair<double, double>>& coords, double max_distance) {
+  std::vector<std::vector<size_t>> groups;
+  std::vector<bool> grouped(coords.size(), false);
+  for (size_t i = 0; i != coords.size(); ++i) {
+    if (grouped[i]) continue;
+    groups.emplace_back(1, i);
+    for (size_t j = i + 1; j != coords.size(); ++j) {
+      const double dx = coords[i].first - coords[j].first;
+      const double dy = coords[i].second - coords[j].second;
+      if (!grouped[j] && std::sqrt(dx * dx + dy * dy) < max_distance) {
+        grouped[j] = true;
+        groups.back().push_back(j);
+      }
+    }
+  }
+  return groups;
+}
+}  // namespace
+
 BOOST_AUTO_TEST_SUITE(proximity_clustering)
 
 BOOST_AUTO_TEST_CASE(small_set) {
@@ -49,4 +75,37 @@ BOOST_AUTO_TEST_CASE(large_set) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(random_set) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  std::vector<std::pair<double, double>> coords;
+  for (size_t i = 0; i != 2000; ++i) {
+    coords.emplace_back(distribution(generator), distribution(generator));
+  }
+  for (double max_distance : {0.0, 0.01, 0.05, 0.3, 5.0}) {
+    ProximityClustering pc(coords);
+    const std::vector<std::vector<size_t>> groups = pc.Group(max_distance);
+    const std::vector<std::vector<size_t>> reference =
+        ReferenceGroup(coords, max_distance);
+    BOOST_REQUIRE_EQUAL(groups.size(), reference.size());
+    for (size_t i = 0; i != groups.size(); ++i) {
+      BOOST_CHECK_EQUAL_COLLECTIONS(groups[i].begin(), groups[i].end(),
+                                    reference[i].begin(), reference[i].end());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(non_finite) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<std::pair<double, double>> coords{
+      {0.0, 0.0}, {nan, 0.0}, {0.5, 0.0}, {nan, nan}};
+  ProximityClustering pc(coords);
+  std::vector<std::vector<size_t>> groups = pc.Group(1.0);
+  BOOST_REQUIRE_EQUAL(groups.size(), 3u);
+  BOOST_REQUIRE_EQUAL(groups[0].size(), 2u);
+  BOOST_CHECK_EQUAL(groups[0][1], 2u);
+  BOOST_CHECK_EQUAL(groups[1].front(), 1u);
+  BOOST_CHECK_EQUAL(groups[2].front(), 3u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "MemoryPlan.h"
+
+#include <algorithm>
+
+namespace dp3 {
+namespace ddecal {
+
+namespace {
+// Bytes per visibility of a buffered time step: the complex float data,
+// the flags and weights, and the copies of the flags and weights that are
+// restored after solving.
+constexpr size_t kDataBytes = 8 + 1 + 4 + 1 + 4;
+// Bytes per visibility and direction of a predicted time step: the complex
+// float model data, flags and weights.
+constexpr size_t kModelBytes = 8 + 1 + 4;
+// Bytes per visibility of a complex float.
+constexpr size_t kComplexFloatBytes = 8;
+// Bytes per visibility of a complex double.
+constexpr size_t kComplexDoubleBytes = 16;
+
+double ToGB(double bytes) { return bytes / (1024.0 * 1024.0 * 1024.0); }
+}  // namespace
+
+size_t EstimateIntervalMemory(size_t n_baselines, size_t n_channels,
+                              size_t n_correlations, size_t n_directions,
+                              size_t solution_interval, bool keep_model) {
+  const size_t n_visibilities =
+      n_baselines * n_channels * n_correlations * solution_interval;
+  size_t bytes_per_visibility = kDataBytes + n_directions * kModelBytes;
+  if (keep_model) bytes_per_visibility += n_directions * kComplexFloatBytes;
+  return n_visibilities * bytes_per_visibility;
+}
+
+size_t EstimateSolverMemory(SolverAlgorithm algorithm, size_t n_baselines,
+                            size_t n_channels, size_t n_correlations,
+                            size_t n_directions, size_t solution_interval) {
+  const size_t n_visibilities =
+      n_baselines * n_channels * n_correlations * solution_interval;
+  // The weighted data and model data are stored twice: in the solver buffer
+  // and in the solve data.
+  size_t bytes_per_visibility =
+      2 * (1 + n_directions) * kComplexFloatBytes;
+  switch (algorithm) {
+    case SolverAlgorithm::kDirectionSolve:
+    case SolverAlgorithm::kHybrid:
+      // The linear systems have a complex double coefficient per
+      // visibility and direction.
+      bytes_per_visibility += n_directions * kComplexDoubleBytes;
+      break;
+    case SolverAlgorithm::kDirectionIterative:
+      // The residual data.
+      bytes_per_visibility += kComplexFloatBytes;
+      break;
+  }
+  return n_visibilities * bytes_per_visibility;
+}
+
+MemoryPlan MakeMemoryPlan(double budget, size_t interval_memory,
+                          size_t solver_memory, size_t max_intervals) {
+  MemoryPlan plan;
+  plan.interval_memory = interval_memory;
+  plan.solver_memory = solver_memory;
+  plan.budget = budget;
+  plan.n_buffered_intervals = 1;
+  if (interval_memory > 0 && budget > solver_memory + interval_memory) {
+    const size_t n_fitting =
+        static_cast<size_t>((budget - solver_memory) / interval_memory);
+    plan.n_buffered_intervals = std::min(n_fitting, max_intervals);
+  }
+  plan.n_buffered_intervals = std::max<size_t>(plan.n_buffered_intervals, 1);
+  return plan;
+}
+
+void ShowMemoryPlan(std::ostream& output, const MemoryPlan& plan) {
+  output << "  memory per solint:   " << ToGB(plan.interval_memory) << " GB\n"
+         << "  solver memory:       " << ToGB(plan.solver_memory) << " GB\n"
+         << "  memory budget:       " << ToGB(plan.budget) << " GB\n"
+         << "  buffered solints:    " << plan.n_buffered_intervals << '\n';
+}
+
+}  // namespace ddecal
+}  // namespace dp3
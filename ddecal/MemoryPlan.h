@@ -0,0 +1,69 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DP3_DDECAL_MEMORYPLAN_H_
+#define DP3_DDECAL_MEMORYPLAN_H_
+
+#include "Settings.h"
+
+#include <cstddef>
+#include <ostream>
+
+namespace dp3 {
+namespace ddecal {
+
+/**
+ * @brief Estimated memory use of DDECal and the number of solution intervals
+ * that it buffers within a memory budget.
+ *
+ * The estimates only count the largest structures: the buffered data and
+ * model data, and the buffers of the solver. These grow with the number of
+ * baselines, channels, directions and the solution interval.
+ */
+struct MemoryPlan {
+  /// Bytes for the data and model data of one buffered solution interval.
+  size_t interval_memory = 0;
+  /// Bytes that the solver uses while solving one solution interval.
+  size_t solver_memory = 0;
+  /// Available memory in bytes.
+  double budget = 0.0;
+  /// Number of solution intervals that are buffered before solving.
+  size_t n_buffered_intervals = 1;
+
+  /// True if the solver and a single buffered interval do not fit in the
+  /// budget.
+  bool ExceedsBudget() const {
+    return solver_memory + interval_memory > budget;
+  }
+};
+
+/**
+ * Estimate the memory of one buffered solution interval.
+ * @param keep_model True if the model data is stored for subtracting it
+ * after solving.
+ */
+size_t EstimateIntervalMemory(size_t n_baselines, size_t n_channels,
+                              size_t n_correlations, size_t n_directions,
+                              size_t solution_interval, bool keep_model);
+
+/**
+ * Estimate the memory that a solver uses while solving one solution interval.
+ */
+size_t EstimateSolverMemory(SolverAlgorithm algorithm, size_t n_baselines,
+                            size_t n_channels, size_t n_correlations,
+                            size_t n_directions, size_t solution_interval);
+
+/**
+ * Choose the number of solution intervals to buffer: as many as fit in the
+ * budget, but at most @p max_intervals and at least one.
+ */
+MemoryPlan MakeMemoryPlan(double budget, size_t interval_memory,
+                          size_t solver_memory, size_t max_intervals);
+
+/** Writes the memory estimates and the chosen plan to the @a output. */
+void ShowMemoryPlan(std::ostream& output, const MemoryPlan& plan);
+
+}  // namespace ddecal
+}  // namespace dp3
+
+#endif
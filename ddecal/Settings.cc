@@ -71,6 +71,8 @@ Settings::Settings(const common::ParameterSet& _parset,
       solution_interval(GetUint("solint", 1)),
       min_vis_ratio(GetDouble("minvisratio", 0.0)),
       n_channels(GetUint("nchan", 1)),
+      memory_max(GetDouble("memorymax", 0.0)),
+      memory_percentage(GetDouble("memoryperc", 0.0)),
       core_constraint(GetDouble("coreconstraint", 0.0)),
       antenna_constraint(ReadAntennaConstraint()),
       smoothness_constraint(GetDouble("smoothnessconstraint", 0.0)),
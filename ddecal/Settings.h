@@ -100,6 +100,10 @@ struct Settings {
   const size_t solution_interval;
   const double min_vis_ratio;
   const size_t n_channels;
+  /// Maximum memory in GB and percentage of the system memory that DDECal
+  /// may use for buffering solution intervals. Zero means no limit.
+  const double memory_max;
+  const double memory_percentage;
 
   // Constraint settings.
   const double core_constraint;
@@ -7,6 +7,8 @@
 #include "../common/StringTools.h"
 
 #include <cassert>
+#include <cmath>
+#include <ctime>
 #include <numeric>
 #include <algorithm>
 
@@ -14,6 +16,12 @@ using dp3::base::CalType;
 using dp3::common::operator<<;
 
 namespace {
+/// Approximate size in bytes of the HDF5 chunks of the soltabs.
+constexpr size_t kChunkSize = 1024 * 1024;
+
+/// Maximum number of solution intervals that wait for the writer thread.
+constexpr size_t kMaxPendingIntervals = 4;
+
 std::vector<std::string> GetDirectionNames(
     const std::vector<std::vector<std::string>>& directions) {
   std::vector<std::string> result;
@@ -27,13 +35,198 @@ std::vector<std::string> GetDirectionNames(
 
   return result;
 }
+
+void WriteStringAttribute(H5::DataSet& dataset, const std::string& name,
+                          const std::string& value) {
+  const H5::StrType type(H5::PredType::C_S1, value.size());
+  H5::Attribute attribute =
+      dataset.createAttribute(name, type, H5::DataSpace());
+  attribute.write(type, value);
+}
+
+/// Write the history with the current time, if it is given.
+void WriteHistory(H5::DataSet& dataset, const std::string& history) {
+  if (history.empty()) return;
+  const time_t raw_time = time(nullptr);
+  char time_buffer[80];
+  strftime(time_buffer, sizeof(time_buffer), "%d-%m-%Y %H:%M:%S",
+           localtime(&raw_time));
+  WriteStringAttribute(dataset, "HISTORY000",
+                       std::string(time_buffer) + ": " + history);
+}
+
+/// Get the axes as a comma separated string, as used in the AXES attribute.
+std::string AxesString(
+    const std::vector<schaapcommon::h5parm::AxisInfo>& axes) {
+  std::string axes_string = axes.front().name;
+  for (size_t i = 1; i < axes.size(); ++i) {
+    axes_string += "," + axes[i].name;
+  }
+  return axes_string;
+}
+
+/// Get the weights for @p vals: ones if @p weights is empty, and zero for
+/// NaN values.
+std::vector<double> FullWeights(const std::vector<double>& vals,
+                                const std::vector<double>& weights) {
+  std::vector<double> full_weights;
+  if (weights.empty()) {
+    full_weights.resize(vals.size(), 1.0);
+  } else {
+    if (weights.size() != vals.size()) {
+      throw std::runtime_error(
+          "Values for H5Parm weights do not have the expected size: they have "
+          "size " +
+          std::to_string(weights.size()) + ", expected is " +
+          std::to_string(vals.size()));
+    }
+    full_weights = weights;
+  }
+  for (size_t i = 0; i < vals.size(); ++i) {
+    if (std::isnan(vals[i])) full_weights[i] = 0.0;
+  }
+  return full_weights;
+}
+
+/// Extend a dataset along its first axis and write @p values in the new
+/// part.
+void AppendToDataSet(H5::DataSet dataset, hsize_t n_new,
+                     const std::vector<double>& values) {
+  const H5::DataSpace old_space = dataset.getSpace();
+  std::vector<hsize_t> dims(old_space.getSimpleExtentNdims());
+  old_space.getSimpleExtentDims(dims.data());
+
+  std::vector<hsize_t> offset(dims.size(), 0);
+  offset[0] = dims[0];
+  std::vector<hsize_t> count = dims;
+  count[0] = n_new;
+  dims[0] += n_new;
+  dataset.extend(dims.data());
+
+  H5::DataSpace file_space = dataset.getSpace();
+  file_space.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
+  const H5::DataSpace memory_space(count.size(), count.data());
+  dataset.write(values.data(), H5::PredType::IEEE_F64LE, memory_space,
+                file_space);
+}
+
+std::vector<std::string> GetPolarizations(size_t n_polarizations) {
+  switch (n_polarizations) {
+    case 2:
+      return {"XX", "YY"};
+    case 4:
+      return {"XX", "XY", "YX", "YY"};
+    default:
+      throw std::runtime_error("No metadata for numpolarizations = " +
+                               std::to_string(n_polarizations));
+  }
+}
 }  // namespace
 
 namespace dp3 {
 namespace ddecal {
 
+ExtendibleSolTabs::ExtendibleSolTabs(const std::string& filename)
+    : file_(filename, H5F_ACC_RDWR) {}
+
+void ExtendibleSolTabs::Create(schaapcommon::h5parm::SolTab& soltab,
+                               const std::string& history,
+                               size_t chunk_size) {
+  std::vector<schaapcommon::h5parm::AxisInfo>& axes = soltab.GetAxes();
+  if (axes.empty() || axes.front().name != "time") {
+    throw std::runtime_error("The first axis of extendible SolTab " +
+                             soltab.GetName() + " should be time");
+  }
+  axes.front().size = 0;
+
+  // The dimensions are initially empty along the time axis.
+  std::vector<hsize_t> dims(axes.size());
+  std::vector<hsize_t> max_dims(axes.size());
+  std::vector<hsize_t> chunk_dims(axes.size());
+  size_t time_slot_size = sizeof(double);
+  for (size_t i = 1; i < axes.size(); ++i) {
+    dims[i] = axes[i].size;
+    max_dims[i] = axes[i].size;
+    chunk_dims[i] = std::max<hsize_t>(axes[i].size, 1);
+    time_slot_size *= chunk_dims[i];
+  }
+  dims[0] = 0;
+  max_dims[0] = H5S_UNLIMITED;
+  chunk_dims[0] = std::max<hsize_t>(chunk_size / time_slot_size, 1);
+
+  H5::Group group = file_.openGroup("/" + soltab.GetName());
+  const std::string axes_string = AxesString(axes);
+  const H5::DataSpace dataspace(dims.size(), dims.data(), max_dims.data());
+  H5::DSetCreatPropList properties;
+  properties.setChunk(chunk_dims.size(), chunk_dims.data());
+
+  H5::DataSet dataset = group.createDataSet("val", H5::PredType::IEEE_F64LE,
+                                            dataspace, properties);
+  WriteStringAttribute(dataset, "AXES", axes_string);
+  WriteHistory(dataset, history);
+
+  // Like SolTab::SetValues(), do not use half floats for the weights, since
+  // their typical range can be 1.e-14.
+  H5::DataSet weightset = group.createDataSet(
+      "weight", H5::PredType::IEEE_F32LE, dataspace, properties);
+  WriteStringAttribute(weightset, "AXES", axes_string);
+
+  const H5::DataSpace time_dataspace(1, &dims[0], &max_dims[0]);
+  H5::DSetCreatPropList time_properties;
+  time_properties.setChunk(1, &chunk_dims[0]);
+  group.createDataSet("time", H5::PredType::IEEE_F64LE, time_dataspace,
+                      time_properties);
+}
+
+void ExtendibleSolTabs::Append(schaapcommon::h5parm::SolTab& soltab,
+                               const std::vector<double>& vals,
+                               const std::vector<double>& weights,
+                               const std::vector<double>& times) {
+  std::vector<schaapcommon::h5parm::AxisInfo>& axes = soltab.GetAxes();
+  size_t expected_size = times.size();
+  for (size_t i = 1; i < axes.size(); ++i) {
+    expected_size *= axes[i].size;
+  }
+  if (expected_size != vals.size()) {
+    throw std::runtime_error(
+        "Values for H5Parm do not have the expected size: they have size " +
+        std::to_string(vals.size()) + ", expected is " +
+        std::to_string(expected_size));
+  }
+  if (times.empty()) return;
+
+  const std::vector<double> full_weights = FullWeights(vals, weights);
+  H5::Group group = file_.openGroup("/" + soltab.GetName());
+  AppendToDataSet(group.openDataSet("val"), times.size(), vals);
+  AppendToDataSet(group.openDataSet("weight"), times.size(), full_weights);
+  AppendToDataSet(group.openDataSet("time"), times.size(), times);
+  axes.front().size += times.size();
+
+  file_.flush(H5F_SCOPE_GLOBAL);
+}
+
+void ExtendibleSolTabs::AppendComplex(
+    schaapcommon::h5parm::SolTab& soltab,
+    const std::vector<std::complex<double>>& vals,
+    const std::vector<double>& weights, bool to_amplitudes,
+    const std::vector<double>& times) {
+  // Convert values to real numbers by taking amplitude or argument
+  std::vector<double> real_vals(vals.size());
+  for (size_t i = 0; i < vals.size(); ++i) {
+    real_vals[i] = to_amplitudes ? std::abs(vals[i]) : std::arg(vals[i]);
+  }
+  Append(soltab, real_vals, weights, times);
+}
+
 SolutionWriter::SolutionWriter(const std::string& filename)
-    : h5parm_(filename, true) {}
+    : h5parm_(filename, true), extendible_soltabs_(filename) {}
+
+SolutionWriter::~SolutionWriter() {
+  if (writer_thread_.joinable()) {
+    tasks_.write_end();
+    writer_thread_.join();
+  }
+}
 
 void SolutionWriter::AddAntennas(
     const std::vector<std::string>& all_antenna_names,
@@ -41,242 +234,293 @@ void SolutionWriter::AddAntennas(
   h5parm_.AddAntennas(all_antenna_names, all_antenna_positions);
 }
 
-void SolutionWriter::Write(
-    const std::vector<std::vector<std::vector<std::complex<double>>>>&
-        solutions,
-    const std::vector<std::vector<std::vector<ddecal::Constraint::Result>>>&
-        constraint_solutions,
+void SolutionWriter::Start(
     const double start_time, const double solution_interval,
     const base::CalType mode,
     const std::vector<std::string>& used_antenna_names,
     const std::vector<base::Direction>& source_directions,
     const std::vector<std::vector<std::string>>& directions,
     const std::vector<double>& chan_freqs,
-    const std::vector<double>& chan_block_freqs, const std::string& history) {
-  const size_t n_times = solutions.size();
-  const size_t n_channel_blocks = chan_block_freqs.size();
-  const size_t n_antennas = used_antenna_names.size();
-  const size_t n_directions = directions.size();
-  const std::vector<std::string> direction_names =
-      GetDirectionNames(directions);
+    const std::vector<double>& chan_block_freqs, const std::string& history,
+    const bool asynchronous) {
+  if (writer_thread_.joinable()) {
+    throw std::runtime_error(
+        "SolutionWriter::Start() is called before the previous writing was "
+        "finished");
+  }
+  start_time_ = start_time;
+  solution_interval_ = solution_interval;
+  mode_ = mode;
+  used_antenna_names_ = used_antenna_names;
+  direction_names_ = GetDirectionNames(directions);
+  chan_freqs_ = chan_freqs;
+  chan_block_freqs_ = chan_block_freqs;
+  history_ = history;
+  n_added_ = 0;
+  outputs_.clear();
 
   std::vector<std::pair<double, double>> h5_source_directions;
   h5_source_directions.reserve(source_directions.size());
   for (const base::Direction& direction : source_directions) {
     h5_source_directions.emplace_back(direction.ra, direction.dec);
   }
-  h5parm_.AddSources(direction_names, h5_source_directions);
+  h5parm_.AddSources(direction_names_, h5_source_directions);
+
+  // Writing in a separate thread requires that HDF5 can be used by multiple
+  // threads, since the caller may use HDF5 (e.g. to read H5Parm files) while
+  // solutions are written.
+  if (asynchronous && schaapcommon::h5parm::H5Parm::IsThreadSafe()) {
+    tasks_.resize(kMaxPendingIntervals);
+    writer_thread_ = std::thread(&SolutionWriter::WriterThread, this);
+  }
+}
 
-  std::vector<double> sol_times(n_times);
-  for (size_t t = 0; t < n_times; ++t) {
-    sol_times[t] = start_time + (t + 0.5) * solution_interval;
+void SolutionWriter::AddSolutions(Solutions solutions,
+                                  ConstraintResults constraint_results) {
+  Task task{std::move(solutions), std::move(constraint_results), n_added_};
+  ++n_added_;
+  if (writer_thread_.joinable()) {
+    tasks_.write(std::move(task));
+  } else {
+    WriteTask(task);
   }
+}
 
-  if (constraint_solutions.empty() || constraint_solutions.front().empty()) {
-    // Record the actual iterands of the solver, not constraint results
-    unsigned int n_pol;
-
-    std::vector<std::string> polarizations;
-    if (mode == CalType::kDiagonal || mode == CalType::kDiagonalPhase ||
-        mode == CalType::kDiagonalAmplitude) {
-      n_pol = 2;
-      polarizations.emplace_back("XX");
-      polarizations.emplace_back("YY");
-    } else if (mode == CalType::kFullJones) {
-      polarizations.emplace_back("XX");
-      polarizations.emplace_back("XY");
-      polarizations.emplace_back("YX");
-      polarizations.emplace_back("YY");
-      n_pol = 4;
-    } else {
-      n_pol = 1;
+void SolutionWriter::Finish() {
+  if (writer_thread_.joinable()) {
+    tasks_.write_end();
+    writer_thread_.join();
+  }
+  if (writer_error_) {
+    std::exception_ptr error = writer_error_;
+    writer_error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void SolutionWriter::Write(
+    const std::vector<std::vector<std::vector<std::complex<double>>>>&
+        solutions,
+    const std::vector<std::vector<std::vector<ddecal::Constraint::Result>>>&
+        constraint_solutions,
+    const double start_time, const double solution_interval,
+    const base::CalType mode,
+    const std::vector<std::string>& used_antenna_names,
+    const std::vector<base::Direction>& source_directions,
+    const std::vector<std::vector<std::string>>& directions,
+    const std::vector<double>& chan_freqs,
+    const std::vector<double>& chan_block_freqs, const std::string& history) {
+  Start(start_time, solution_interval, mode, used_antenna_names,
+        source_directions, directions, chan_freqs, chan_block_freqs, history,
+        false);
+  for (size_t time = 0; time < solutions.size(); ++time) {
+    AddSolutions(solutions[time], time < constraint_solutions.size()
+                                      ? constraint_solutions[time]
+                                      : ConstraintResults());
+  }
+  Finish();
+}
+
+void SolutionWriter::WriterThread() {
+  Task task;
+  while (tasks_.read(task)) {
+    // After an error, keep reading the tasks, such that AddSolutions()
+    // does not block. Finish() rethrows the error.
+    if (!writer_error_) {
+      try {
+        WriteTask(task);
+      } catch (...) {
+        writer_error_ = std::current_exception();
+      }
     }
+  }
+}
+
+void SolutionWriter::WriteTask(const Task& task) {
+  if (task.index == 0) CreateSolTabs(task);
+  if (outputs_.empty()) return;
+
+  const std::vector<double> times(
+      1, start_time_ + (task.index + 0.5) * solution_interval_);
 
+  if (outputs_.front().from_solutions) {
     // Put solutions in a contiguous piece of memory
     std::vector<std::complex<double>> contiguous_solutions;
-    const size_t n_solutions =
-        n_times * n_channel_blocks * n_antennas * n_directions * n_pol;
-    contiguous_solutions.reserve(n_solutions);
-    for (const auto& time_solution : solutions) {
-      for (const auto& block_solution : time_solution) {
-        contiguous_solutions.insert(contiguous_solutions.end(),
-                                    block_solution.begin(),
-                                    block_solution.end());
+    for (const std::vector<std::complex<double>>& block_solution :
+         task.solutions) {
+      contiguous_solutions.insert(contiguous_solutions.end(),
+                                  block_solution.begin(), block_solution.end());
+    }
+    for (const Output& output : outputs_) {
+      extendible_soltabs_.AppendComplex(*output.soltab, contiguous_solutions,
+                                        std::vector<double>(),
+                                        output.to_amplitudes, times);
+    }
+  } else {
+    if (task.constraint_results.size() != n_constraints_) {
+      throw std::runtime_error(
+          "Constraints did not produce a correct output at time step " +
+          std::to_string(task.index) + ": got " +
+          std::to_string(task.constraint_results.size()) +
+          " results, expecting " + std::to_string(n_constraints_));
+    }
+    for (const Output& output : outputs_) {
+      const std::vector<ddecal::Constraint::Result>& results =
+          task.constraint_results[output.constraint_index];
+      if (output.result_index >= results.size()) {
+        throw std::runtime_error(
+            "Constraint " + std::to_string(output.constraint_index) +
+            " did not produce a correct output at time step " +
+            std::to_string(task.index));
       }
+      const ddecal::Constraint::Result& result = results[output.result_index];
+      extendible_soltabs_.Append(*output.soltab, result.vals, result.weights,
+                                 times);
     }
-    assert(contiguous_solutions.size() == n_solutions);
+  }
+}
 
-    std::vector<schaapcommon::h5parm::AxisInfo> axes;
-    axes.emplace_back(schaapcommon::h5parm::AxisInfo("time", n_times));
-    axes.emplace_back(schaapcommon::h5parm::AxisInfo("freq", n_channel_blocks));
-    axes.emplace_back(schaapcommon::h5parm::AxisInfo("ant", n_antennas));
-    axes.emplace_back(schaapcommon::h5parm::AxisInfo("dir", n_directions));
-    if (n_pol > 1) {
-      axes.emplace_back(schaapcommon::h5parm::AxisInfo("pol", n_pol));
+void SolutionWriter::CreateSolTabs(const Task& first_task) {
+  if (first_task.constraint_results.empty()) {
+    // Record the actual iterands of the solver, not constraint results
+    CreateSolutionSolTabs();
+  } else {
+    // Record the Constraint::Result in the H5Parm
+    CreateConstraintSolTabs(first_task.constraint_results);
+  }
+}
+
+void SolutionWriter::CreateSolutionSolTabs() {
+  size_t n_pol;
+  if (mode_ == CalType::kDiagonal || mode_ == CalType::kDiagonalPhase ||
+      mode_ == CalType::kDiagonalAmplitude) {
+    n_pol = 2;
+  } else if (mode_ == CalType::kFullJones) {
+    n_pol = 4;
+  } else {
+    n_pol = 1;
+  }
+
+  // The time axis is extended when solutions are added.
+  std::vector<schaapcommon::h5parm::AxisInfo> axes;
+  axes.emplace_back(schaapcommon::h5parm::AxisInfo("time", 0));
+  axes.emplace_back(
+      schaapcommon::h5parm::AxisInfo("freq", chan_block_freqs_.size()));
+  axes.emplace_back(
+      schaapcommon::h5parm::AxisInfo("ant", used_antenna_names_.size()));
+  axes.emplace_back(
+      schaapcommon::h5parm::AxisInfo("dir", direction_names_.size()));
+  if (n_pol > 1) {
+    axes.emplace_back(schaapcommon::h5parm::AxisInfo("pol", n_pol));
+  }
+
+  int n_soltabs = 1;
+  // For [scalar]complexgain, store two soltabs: phase and amplitude.
+  if (mode_ == CalType::kScalar || mode_ == CalType::kDiagonal ||
+      mode_ == CalType::kFullJones) {
+    n_soltabs = 2;
+  }
+  for (int soltab_index = 0; soltab_index < n_soltabs; ++soltab_index) {
+    bool store_phase = true;  // false means store amplitude.
+    switch (mode_) {
+      case CalType::kScalar:
+      case CalType::kDiagonal:
+      case CalType::kFullJones:
+        store_phase = soltab_index == 0;
+        break;
+      case CalType::kScalarPhase:
+      case CalType::kDiagonalPhase:
+        store_phase = true;
+        break;
+      case CalType::kScalarAmplitude:
+      case CalType::kDiagonalAmplitude:
+        store_phase = false;
+        break;
+      default:
+        throw std::runtime_error("Constraint should have produced output");
     }
 
-    int n_soltabs = 1;
-    // For [scalar]complexgain, store two soltabs: phase and amplitude.
-    if (mode == CalType::kScalar || mode == CalType::kDiagonal ||
-        mode == CalType::kFullJones) {
-      n_soltabs = 2;
+    schaapcommon::h5parm::SolTab& soltab =
+        store_phase ? h5parm_.CreateSolTab("phase000", "phase", axes)
+                    : h5parm_.CreateSolTab("amplitude000", "amplitude", axes);
+
+    extendible_soltabs_.Create(soltab, history_, kChunkSize);
+    soltab.SetAntennas(used_antenna_names_);
+    soltab.SetSources(direction_names_);
+    if (n_pol > 1) {
+      soltab.SetPolarizations(GetPolarizations(n_pol));
     }
-    for (int soltab_index = 0; soltab_index < n_soltabs; ++soltab_index) {
-      bool store_phase = true;  // false means store amplitude.
-      switch (mode) {
-        case CalType::kScalar:
-        case CalType::kDiagonal:
-        case CalType::kFullJones:
-          store_phase = soltab_index == 0;
-          break;
-        case CalType::kScalarPhase:
-        case CalType::kDiagonalPhase:
-          store_phase = true;
-          break;
-        case CalType::kScalarAmplitude:
-        case CalType::kDiagonalAmplitude:
-          store_phase = false;
-          break;
-        default:
-          throw std::runtime_error("Constraint should have produced output");
+    soltab.SetFreqs(chan_block_freqs_);
+
+    outputs_.push_back(Output{&soltab, true, !store_phase, 0, 0});
+  }
+}
+
+void SolutionWriter::CreateConstraintSolTabs(
+    const ConstraintResults& first_results) {
+  n_constraints_ = first_results.size();
+
+  for (size_t constraint_index = 0; constraint_index < n_constraints_;
+       ++constraint_index) {
+    // Number of solution names, e.g. 2 for "TEC" and "ScalarPhase"
+    const size_t n_names = first_results[constraint_index].size();
+    for (size_t name_index = 0; name_index < n_names; ++name_index) {
+      // Get the result of the constraint solution at first time to get
+      // metadata
+      const ddecal::Constraint::Result& first_result =
+          first_results[constraint_index][name_index];
+
+      std::vector<std::string> firstaxesnames =
+          common::stringtools::tokenize(first_result.axes, ",");
+
+      // The time axis is extended when solutions are added.
+      std::vector<schaapcommon::h5parm::AxisInfo> axes;
+      axes.emplace_back(schaapcommon::h5parm::AxisInfo("time", 0));
+      for (size_t axis_index = 0; axis_index < firstaxesnames.size();
+           ++axis_index) {
+        axes.emplace_back(schaapcommon::h5parm::AxisInfo(
+            firstaxesnames[axis_index], first_result.dims[axis_index]));
       }
 
+      std::string solTabName = first_result.name + "000";
       schaapcommon::h5parm::SolTab& soltab =
-          store_phase ? h5parm_.CreateSolTab("phase000", "phase", axes)
-                      : h5parm_.CreateSolTab("amplitude000", "amplitude", axes);
-
-      soltab.SetComplexValues(contiguous_solutions, std::vector<double>(),
-                              !store_phase, history);
-      soltab.SetAntennas(used_antenna_names);
-      soltab.SetSources(GetDirectionNames(directions));
-      if (n_pol > 1) {
-        soltab.SetPolarizations(polarizations);
+          h5parm_.CreateSolTab(solTabName, first_result.name, axes);
+      extendible_soltabs_.Create(soltab, history_, kChunkSize);
+      soltab.SetAntennas(used_antenna_names_);
+      soltab.SetSources(direction_names_);
+
+      if (soltab.HasAxis("pol")) {
+        soltab.SetPolarizations(
+            GetPolarizations(soltab.GetAxis("pol").size));
       }
-      soltab.SetFreqs(chan_block_freqs);
-      soltab.SetTimes(sol_times);
-    }  // solnums loop
-  } else {
-    // Record the Constraint::Result in the H5Parm
-    size_t n_constraints = constraint_solutions.front().size();
-
-    for (size_t constraint_index = 0; constraint_index < n_constraints;
-         ++constraint_index) {
-      // Number of solution names, e.g. 2 for "TEC" and "ScalarPhase"
-      size_t n_names = constraint_solutions[0][constraint_index].size();
-      for (size_t name_index = 0; name_index < n_names; ++name_index) {
-        // Get the result of the constraint solution at first time to get
-        // metadata
-        ddecal::Constraint::Result first_result =
-            constraint_solutions[0][constraint_index][name_index];
-
-        std::vector<hsize_t> dims(first_result.dims.size() +
-                                  1);  // Add time dimension at beginning
-        dims[0] = constraint_solutions.size();  // Number of times
-        size_t n_solutions = dims[0];
-        for (size_t i = 1; i < dims.size(); ++i) {
-          dims[i] = first_result.dims[i - 1];
-          n_solutions *= dims[i];
-        }
-
-        std::vector<std::string> firstaxesnames =
-            common::stringtools::tokenize(first_result.axes, ",");
-
-        std::vector<schaapcommon::h5parm::AxisInfo> axes;
-        axes.emplace_back(schaapcommon::h5parm::AxisInfo(
-            "time", constraint_solutions.size()));
-        for (size_t axis_index = 0; axis_index < firstaxesnames.size();
-             ++axis_index) {
-          axes.emplace_back(schaapcommon::h5parm::AxisInfo(
-              firstaxesnames[axis_index], first_result.dims[axis_index]));
-        }
-
-        // Put solutions in a contiguous piece of memory
-        std::vector<double> contiguous_solutions;
-        contiguous_solutions.reserve(n_solutions);
-        for (size_t time = 0; time < n_times; ++time) {
-          if (constraint_solutions[time].size() !=
-              constraint_solutions.front().size())
-            throw std::runtime_error(
-                "Constraint " + std::to_string(constraint_index) +
-                " did not produce a correct output at time step " +
-                std::to_string(time) + ": got " +
-                std::to_string(constraint_solutions[time].size()) +
-                " results, expecting " +
-                std::to_string(constraint_solutions.front().size()));
-          const std::vector<double>& cs_vals =
-              constraint_solutions[time][constraint_index][name_index].vals;
-          contiguous_solutions.insert(contiguous_solutions.end(),
-                                      cs_vals.begin(), cs_vals.end());
-        }
-
-        // Put solution weights in a contiguous piece of memory
-        std::vector<double> weights;
-        if (!constraint_solutions.front()[constraint_index][name_index]
-                 .weights.empty()) {
-          weights.reserve(n_solutions);
-          for (unsigned int time = 0; time < solutions.size(); ++time) {
-            const std::vector<double>& cs_weights =
-                constraint_solutions[time][constraint_index][name_index]
-                    .weights;
-            weights.insert(weights.end(), cs_weights.begin(), cs_weights.end());
-          }
-        }
-
-        std::string solTabName = first_result.name + "000";
-        schaapcommon::h5parm::SolTab& soltab =
-            h5parm_.CreateSolTab(solTabName, first_result.name, axes);
-        soltab.SetValues(contiguous_solutions, weights, history);
-        soltab.SetAntennas(used_antenna_names);
-        soltab.SetSources(GetDirectionNames(directions));
-
-        if (soltab.HasAxis("pol")) {
-          std::vector<std::string> polarizations;
-          switch (soltab.GetAxis("pol").size) {
-            case 2:
-              polarizations.emplace_back("XX");
-              polarizations.emplace_back("YY");
-              break;
-            case 4:
-              polarizations.emplace_back("XX");
-              polarizations.emplace_back("XY");
-              polarizations.emplace_back("YX");
-              polarizations.emplace_back("YY");
-              break;
-            default:
-              throw std::runtime_error(
-                  "No metadata for numpolarizations = " +
-                  std::to_string(soltab.GetAxis("pol").size));
-          }
-          soltab.SetPolarizations(polarizations);
-        }
-
-        // Set channel block frequencies. Do not use chan_block_freqs, because
-        // constraint may have changed size.
-        unsigned int n_channel_blocks = 1;
-        if (soltab.HasAxis("freq")) {
-          n_channel_blocks = soltab.GetAxis("freq").size;
-        }
-        std::vector<double> freqs(n_channel_blocks);
-        size_t channel_index_start = 0;
-        const size_t n_channels = chan_freqs.size();
-        for (size_t block = 0; block != n_channel_blocks; ++block) {
-          const size_t channel_index_end =
-              (block + 1) * n_channels / n_channel_blocks;
-          const size_t block_size = channel_index_end - channel_index_start;
-          const double mean_freq =
-              std::accumulate(chan_freqs.begin() + channel_index_start,
-                              chan_freqs.begin() + channel_index_end, 0.0) /
-              block_size;
-          freqs[block] = mean_freq;
-          channel_index_start = channel_index_end;
-        }
-        soltab.SetFreqs(freqs);
-
-        soltab.SetTimes(sol_times);
+
+      // Set channel block frequencies. Do not use chan_block_freqs_, because
+      // constraint may have changed size.
+      unsigned int n_channel_blocks = 1;
+      if (soltab.HasAxis("freq")) {
+        n_channel_blocks = soltab.GetAxis("freq").size;
+      }
+      std::vector<double> freqs(n_channel_blocks);
+      size_t channel_index_start = 0;
+      const size_t n_channels = chan_freqs_.size();
+      for (size_t block = 0; block != n_channel_blocks; ++block) {
+        const size_t channel_index_end =
+            (block + 1) * n_channels / n_channel_blocks;
+        const size_t block_size = channel_index_end - channel_index_start;
+        const double mean_freq =
+            std::accumulate(chan_freqs_.begin() + channel_index_start,
+                            chan_freqs_.begin() + channel_index_end, 0.0) /
+            block_size;
+        freqs[block] = mean_freq;
+        channel_index_start = channel_index_end;
       }
+      soltab.SetFreqs(freqs);
+
+      outputs_.push_back(
+          Output{&soltab, false, false, constraint_index, name_index});
     }
   }
 }
 
 }  // namespace ddecal
-}  // namespace dp3
\ No newline at end of file
+}  // namespace dp3
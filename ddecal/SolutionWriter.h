@@ -9,19 +9,91 @@
 #include "../base/CalType.h"
 #include "../base/Direction.h"
 
+#include <aocommon/lane.h>
+
 #include <schaapcommon/h5parm/h5parm.h>
 
+#include <H5Cpp.h>
+
+#include <complex>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace dp3 {
 namespace ddecal {
 
+/**
+ * Writes soltabs whose values, weights and time axis are extendible along
+ * the time axis, which must be their first axis. A SolTab itself only writes
+ * values with a fixed number of time slots, so this class accesses the
+ * datasets of the soltabs with its own handle to the H5Parm file. The file
+ * should be open for writing by the H5Parm that holds the soltabs.
+ */
+class ExtendibleSolTabs {
+ public:
+  explicit ExtendibleSolTabs(const std::string& filename);
+
+  /**
+   * Create empty values, weights and time axis in @p soltab. The size of
+   * its time axis is ignored. Use Append() or AppendComplex() to add time
+   * slots; SolTab::SetTimes() should not be used.
+   * @param chunk_size Approximate size in bytes of an HDF5 chunk. A chunk
+   * holds at least one time slot.
+   */
+  void Create(schaapcommon::h5parm::SolTab& soltab,
+              const std::string& history = "",
+              size_t chunk_size = 1024 * 1024);
+
+  /**
+   * Append real values for one or more time slots to a soltab that was
+   * prepared with Create(). If weights are empty, write ones everywhere.
+   * The file is flushed afterwards, such that the values are kept when the
+   * writing process stops unexpectedly.
+   */
+  void Append(schaapcommon::h5parm::SolTab& soltab,
+              const std::vector<double>& vals,
+              const std::vector<double>& weights,
+              const std::vector<double>& times);
+
+  /** Append complex values, taking either amplitude or phase. */
+  void AppendComplex(schaapcommon::h5parm::SolTab& soltab,
+                     const std::vector<std::complex<double>>& vals,
+                     const std::vector<double>& weights, bool to_amplitudes,
+                     const std::vector<double>& times);
+
+ private:
+  H5::H5File file_;
+};
+
+/**
+ * Writes calibration solutions to an H5Parm file.
+ *
+ * Solutions can be written incrementally: after Start(), each call to
+ * AddSolutions() appends one solution interval to extendible soltabs, and
+ * Finish() completes the writing. The memory use then does not depend on the
+ * number of solution intervals, and the file contains the solutions that were
+ * added so far if the process stops unexpectedly. When the HDF5 library is
+ * thread-safe, the solutions are written by a separate thread.
+ */
 class SolutionWriter {
  public:
+  using Solutions = std::vector<std::vector<std::complex<double>>>;
+  using ConstraintResults = std::vector<std::vector<Constraint::Result>>;
+
   /**
    * Constructor. Initializes the writer for writing to a specific file.
    * @param filename Name of H5Parm file. Will be overwritten if it exists.
    */
   explicit SolutionWriter(const std::string& filename);
 
+  /**
+   * Waits until the solutions that were added are written, if Finish() was
+   * not called.
+   */
+  ~SolutionWriter();
+
   /**
    * Write main antenna properties.
    */
@@ -29,6 +101,38 @@ class SolutionWriter {
       const std::vector<std::string>& all_antenna_names,
       const std::vector<std::array<double, 3>>& all_antenna_positions);
 
+  /**
+   * Prepare writing solutions incrementally. Writes the sources and stores
+   * the metadata for the soltabs, which are created when the first solutions
+   * are added.
+   * @param asynchronous Write the solutions in a separate thread. This is
+   * only done if the HDF5 library is thread-safe.
+   */
+  void Start(double start_time, double solution_interval, base::CalType mode,
+             const std::vector<std::string>& used_antenna_names,
+             const std::vector<base::Direction>& source_directions,
+             const std::vector<std::vector<std::string>>& directions,
+             const std::vector<double>& chan_freqs,
+             const std::vector<double>& chan_block_freqs,
+             const std::string& history, bool asynchronous);
+
+  /**
+   * Append the solutions of the next solution interval.
+   * @param solutions Solutions for each channel block, with the antenna,
+   * direction and polarization index varying from slow to fast.
+   * @param constraint_results Results of the constraints. If the first call
+   * has no constraint results, the solutions are written as phase and/or
+   * amplitude, depending on the mode. Otherwise the constraint results are
+   * written.
+   */
+  void AddSolutions(Solutions solutions, ConstraintResults constraint_results);
+
+  /**
+   * Wait until all added solutions are written. Rethrows errors that
+   * occurred while writing.
+   */
+  void Finish();
+
   /**
    * (Over)write solutions to the H5Parm file.
    */
@@ -45,7 +149,49 @@ class SolutionWriter {
       const std::vector<double>& chan_block_freqs, const std::string& history);
 
  private:
+  struct Task {
+    Solutions solutions;
+    ConstraintResults constraint_results;
+    size_t index;  ///< Index of the solution interval
+  };
+
+  /// Soltab with the part of the solutions that it stores.
+  struct Output {
+    schaapcommon::h5parm::SolTab* soltab;
+    /// If true, the soltab stores the phase or amplitude of the solutions.
+    /// Otherwise it stores a constraint result.
+    bool from_solutions;
+    bool to_amplitudes;
+    size_t constraint_index;
+    size_t result_index;
+  };
+
+  void WriteTask(const Task& task);
+  void CreateSolTabs(const Task& first_task);
+  void CreateSolutionSolTabs();
+  void CreateConstraintSolTabs(const ConstraintResults& first_results);
+  void WriterThread();
+
   schaapcommon::h5parm::H5Parm h5parm_;
+  ExtendibleSolTabs extendible_soltabs_;
+
+  double start_time_ = 0.0;
+  double solution_interval_ = 0.0;
+  base::CalType mode_ = base::CalType::kScalar;
+  std::vector<std::string> used_antenna_names_;
+  std::vector<std::string> direction_names_;
+  std::vector<double> chan_freqs_;
+  std::vector<double> chan_block_freqs_;
+  std::string history_;
+
+  size_t n_added_ = 0;
+  size_t n_constraints_ = 0;
+  std::vector<Output> outputs_;
+
+  aocommon::Lane<Task> tasks_;
+  std::thread writer_thread_;
+  /// Error of the writer thread, which is rethrown by Finish().
+  std::exception_ptr writer_error_;
 };
 
 }  // namespace ddecal
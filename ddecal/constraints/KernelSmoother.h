@@ -4,8 +4,10 @@
 #ifndef DP3_DDECAL_KERNEL_SMOOTHER_H_
 #define DP3_DDECAL_KERNEL_SMOOTHER_H_
 
+#include <algorithm>
 #include <cmath>
 #include <complex>
+#include <map>
 #include <stdexcept>
 #include <vector>
 #include <limits>
@@ -19,7 +21,8 @@ namespace ddecal {
  *
  * The class is optimized to smooth many series which are all placed on the same
  * grid. This is the case when smoothing the solutions on a (a possibly
- * irregular) channel grid.
+ * irregular) channel grid. The kernel values only depend on the grid, and are
+ * therefore calculated once for each kernel size factor.
  *
  * This class uses internally stored scratch space, and is therefore not thread
  * safe. To smooth with multiple threads, instantiate a KernelSmoother for each
@@ -90,7 +93,99 @@ class KernelSmoother {
    * @param weight Associated weights, array of size @c n.
    */
   void Smooth(DataType* data, const NumType* weight, NumType kernelSizeFactor) {
-    size_t n = _frequencies.size();
+    const BandedKernel& kernel = GetKernel(kernelSizeFactor);
+    const size_t n = _frequencies.size();
+    for (size_t i = 0; i != n; ++i) {
+      const NumType* kernelValues = &kernel.values[kernel.offsets[i]];
+      DataType sum(0.0);
+      NumType weightSum(0.0);
+      for (size_t j = kernel.starts[i]; j != kernel.ends[i]; ++j) {
+        const NumType w = *kernelValues * weight[j];
+        sum += data[j] * w;
+        weightSum += w;
+        ++kernelValues;
+      }
+      if (weightSum == 0.0)
+        _scratch[i] = quiet_NaN(_scratch[i]);
+      else
+        _scratch[i] = sum / weightSum;
+    }
+    std::copy_n(_scratch.begin(), n, data);
+  }
+
+  /**
+   * Smooths many series on the same grid in one pass. This is faster
+   * than smoothing each series separately, because the kernel value of a
+   * channel pair is combined with the weights of all series at once.
+   * @param data Data array of size @c n * @p nSeries, where the series are
+   * the fastest changing index: data[channel * nSeries + series].
+   * @param weight Associated weights, with the same shape as @p data.
+   */
+  void Smooth(DataType* data, const NumType* weight, size_t nSeries,
+              NumType kernelSizeFactor) {
+    const BandedKernel& kernel = GetKernel(kernelSizeFactor);
+    const size_t n = _frequencies.size();
+    if (_scratch.size() < n * nSeries) _scratch.resize(n * nSeries);
+    _weightSums.resize(nSeries);
+    for (size_t i = 0; i != n; ++i) {
+      const NumType* kernelValues = &kernel.values[kernel.offsets[i]];
+      DataType* sum = &_scratch[i * nSeries];
+      std::fill_n(sum, nSeries, DataType(0.0));
+      std::fill(_weightSums.begin(), _weightSums.end(), NumType(0.0));
+      for (size_t j = kernel.starts[i]; j != kernel.ends[i]; ++j) {
+        const NumType k = *kernelValues;
+        ++kernelValues;
+        if (k == 0.0) continue;
+        const DataType* dataRow = &data[j * nSeries];
+        const NumType* weightRow = &weight[j * nSeries];
+        for (size_t s = 0; s != nSeries; ++s) {
+          const NumType w = k * weightRow[s];
+          sum[s] += dataRow[s] * w;
+          _weightSums[s] += w;
+        }
+      }
+      for (size_t s = 0; s != nSeries; ++s) {
+        if (_weightSums[s] == 0.0)
+          sum[s] = quiet_NaN(sum[s]);
+        else
+          sum[s] /= _weightSums[s];
+      }
+    }
+    std::copy_n(_scratch.begin(), n * nSeries, data);
+  }
+
+ private:
+  /**
+   * Kernel values of the band of channels that contribute to each channel.
+   * For channel i, the channels [starts[i], ends[i]) contribute, and their
+   * kernel values are stored consecutively from values[offsets[i]].
+   */
+  struct BandedKernel {
+    std::vector<size_t> starts;
+    std::vector<size_t> ends;
+    std::vector<size_t> offsets;
+    std::vector<NumType> values;
+  };
+
+  /**
+   * Returns the banded kernel for the given kernel size factor. The kernel
+   * only depends on the grid, so it is calculated once per factor.
+   */
+  const BandedKernel& GetKernel(NumType kernelSizeFactor) {
+    auto iter = _kernels.find(kernelSizeFactor);
+    if (iter == _kernels.end()) {
+      iter = _kernels.emplace(kernelSizeFactor, MakeKernel(kernelSizeFactor))
+                 .first;
+    }
+    return iter->second;
+  }
+
+  BandedKernel MakeKernel(NumType kernelSizeFactor) const {
+    const size_t n = _frequencies.size();
+    BandedKernel kernel;
+    kernel.starts.reserve(n);
+    kernel.ends.reserve(n);
+    kernel.offsets.reserve(n);
 
     size_t bandLeft = 0;
     /// find right-most kernel value corresponding to the first element of data
@@ -116,26 +211,20 @@ class KernelSmoother {
       /// an unnecessary value has no effect)
       const size_t start = bandLeft > 0 ? bandLeft - 1 : 0;
       const size_t end = bandRight < n ? bandRight + 1 : n;
+      kernel.starts.push_back(start);
+      kernel.ends.push_back(end);
+      kernel.offsets.push_back(kernel.values.size());
 
-      DataType sum(0.0);
-      NumType weightSum(0.0);
       const NumType frequencyCorrection = _bandwidth / localBandwidth;
       const NumType kernelCorrection = frequencyCorrection * kernelSizeFactor;
       for (size_t j = start; j != end; ++j) {
         NumType distance = _frequencies[i] - _frequencies[j];
-        double w = Kernel(distance * kernelCorrection) * weight[j];
-        sum += data[j] * w;
-        weightSum += w;
+        kernel.values.push_back(Kernel(distance * kernelCorrection));
       }
-      if (weightSum == 0.0)
-        _scratch[i] = quiet_NaN(_scratch[i]);
-      else
-        _scratch[i] = sum / weightSum;
     }
-    std::copy(_scratch.begin(), _scratch.end(), data);
+    return kernel;
   }
 
- private:
   double quiet_NaN(double) { return std::numeric_limits<double>::quiet_NaN(); }
 
   std::complex<double> quiet_NaN(std::complex<double>) {
@@ -145,6 +234,8 @@ class KernelSmoother {
 
   std::vector<NumType> _frequencies;
   std::vector<DataType> _scratch;
+  std::vector<NumType> _weightSums;
+  std::map<NumType, BandedKernel> _kernels;
   enum KernelType _kernelType;
   NumType _bandwidth;
   NumType _bandwidthRefFrequency;
@@ -6,6 +6,8 @@
 #include <aocommon/parallelfor.h>
 #include <boost/make_unique.hpp>
 
+#include <algorithm>
+
 namespace dp3 {
 namespace ddecal {
 
@@ -44,32 +46,38 @@ std::vector<Constraint::Result> SmoothnessConstraint::Apply(
     [[maybe_unused]] std::ostream* stat_stream) {
   const size_t n_pol = solutions.front().size() / (NAntennas() * NDirections());
 
-  loop_->Run(
-      0, NAntennas() * NDirections(), [&](size_t ant_dir_index, size_t thread) {
-        size_t ant_index = ant_dir_index / NDirections();
-        for (size_t pol = 0; pol != n_pol; ++pol) {
-          size_t solution_index = ant_dir_index * n_pol + pol;
-          for (size_t ch = 0; ch != NChannelBlocks(); ++ch) {
-            // Flag channels where calibration yielded inf or nan
-            if (isfinite(solutions[ch][solution_index])) {
-              fit_data_[thread].data[ch] = solutions[ch][solution_index];
-              fit_data_[thread].weight[ch] =
-                  weights_[ant_index * NChannelBlocks() + ch];
-            } else {
-              fit_data_[thread].data[ch] = 0.0;
-              fit_data_[thread].weight[ch] = 0.0;
-            }
-          }
+  // All directions and polarizations of an antenna use the same kernel, so
+  // they are smoothed together as one batch of series.
+  const size_t n_series = NDirections() * n_pol;
+  loop_->Run(0, NAntennas(), [&](size_t ant_index, size_t thread) {
+    FitData& fit_data = fit_data_[thread];
+    fit_data.data.resize(NChannelBlocks() * n_series);
+    fit_data.weight.resize(NChannelBlocks() * n_series);
+    const size_t first_solution = ant_index * n_series;
+    for (size_t ch = 0; ch != NChannelBlocks(); ++ch) {
+      const double weight = weights_[ant_index * NChannelBlocks() + ch];
+      for (size_t series = 0; series != n_series; ++series) {
+        const dcomplex& solution = solutions[ch][first_solution + series];
+        const size_t index = ch * n_series + series;
+        // Flag channels where calibration yielded inf or nan
+        if (isfinite(solution)) {
+          fit_data.data[index] = solution;
+          fit_data.weight[index] = weight;
+        } else {
+          fit_data.data[index] = 0.0;
+          fit_data.weight[index] = 0.0;
+        }
+      }
+    }
 
-          fit_data_[thread].smoother.Smooth(
-              fit_data_[thread].data.data(), fit_data_[thread].weight.data(),
-              antenna_distance_factors_[ant_index]);
+    fit_data.smoother.Smooth(fit_data.data.data(), fit_data.weight.data(),
+                             n_series, antenna_distance_factors_[ant_index]);
 
-          for (size_t ch = 0; ch != NChannelBlocks(); ++ch) {
-            solutions[ch][solution_index] = fit_data_[thread].data[ch];
-          }
-        }
-      });
+    for (size_t ch = 0; ch != NChannelBlocks(); ++ch) {
+      std::copy_n(&fit_data.data[ch * n_series], n_series,
+                  &solutions[ch][first_solution]);
+    }
+  });
 
   return std::vector<Constraint::Result>();
 }
@@ -4,7 +4,7 @@
 #include "DiagonalSolver.h"
 #include "SolveData.h"
 
-#include "../linear_solvers/LLSSolver.h"
+#include "../linear_solvers/BatchedLLSSolver.h"
 
 #include <aocommon/matrix2x2.h>
 #include <aocommon/parallelfor.h>
@@ -33,7 +33,10 @@ DiagonalSolver::SolveResult DiagonalSolver::Solve(
   // for each channelblock. The following loop allocates all structures
   std::vector<std::vector<Matrix>> g_times_cs(NChannelBlocks());
   std::vector<std::vector<std::vector<Complex>>> vs(NChannelBlocks());
+  std::vector<BatchedLLSSolver> lls_solvers;
+  lls_solvers.reserve(NChannelBlocks());
   for (size_t ch_block = 0; ch_block != NChannelBlocks(); ++ch_block) {
+    lls_solvers.push_back(CreateBatchedLLSSolver(NDirections(), 1));
     const SolveData::ChannelBlockData& channelBlock =
         data.ChannelBlock(ch_block);
     next_solutions[ch_block].resize(NDirections() * NAntennas() * 2);
@@ -73,9 +76,9 @@ DiagonalSolver::SolveResult DiagonalSolver::Solve(
              [&](size_t ch_block, [[maybe_unused]] size_t thread) {
                const SolveData::ChannelBlockData& channelBlock =
                    data.ChannelBlock(ch_block);
-               PerformIteration(channelBlock, g_times_cs[ch_block],
-                                vs[ch_block], solutions[ch_block],
-                                next_solutions[ch_block]);
+               PerformIteration(channelBlock, lls_solvers[ch_block],
+                                g_times_cs[ch_block], vs[ch_block],
+                                solutions[ch_block], next_solutions[ch_block]);
              });
 
     Step(solutions, next_solutions);
@@ -113,7 +116,8 @@ DiagonalSolver::SolveResult DiagonalSolver::Solve(
 }
 
 void DiagonalSolver::PerformIteration(
-    const SolveData::ChannelBlockData& cb_data, std::vector<Matrix>& g_times_cs,
+    const SolveData::ChannelBlockData& cb_data, BatchedLLSSolver& lls_solver,
+    std::vector<Matrix>& g_times_cs,
     std::vector<std::vector<Complex>>& vs,
     const std::vector<DComplex>& solutions,
     std::vector<DComplex>& next_solutions) {
@@ -176,24 +180,28 @@ void DiagonalSolver::PerformIteration(
 
   // The matrices have been filled; compute the linear solution
   // for each antenna.
-  const size_t n = NDirections();
-  const size_t nrhs = 1;
-
-  std::vector<Complex> x0(NDirections());
+  std::vector<Complex> x0(NAntennas() * 2 * NDirections());
+  std::vector<BatchedLLSSolver::Problem> problems;
+  problems.reserve(NAntennas() * 2);
   for (size_t ant = 0; ant != NAntennas(); ++ant) {
     for (size_t pol = 0; pol != 2; ++pol) {
       std::vector<Complex>& x = vs[ant * 2 + pol];
-      const size_t m = x.size();
-      // TODO it would be nice to have a solver resize function to avoid too
-      // many reallocations
-      std::unique_ptr<LLSSolver> solver = CreateLLSSolver(m, n, nrhs);
-      // solve x^H in [g C] x^H  = v
+      Complex* initial_value = &x0[(ant * 2 + pol) * NDirections()];
       for (size_t d = 0; d != NDirections(); ++d) {
-        x0[d] = solutions[(ant * NDirections() + d) * 2 + pol];
+        initial_value[d] = solutions[(ant * NDirections() + d) * 2 + pol];
       }
-      bool success =
-          solver->Solve(g_times_cs[ant * 2 + pol].data(), x.data(), x0.data());
-      if (success && x[0] != Complex(0.0, 0.0)) {
+      // solve x^H in [g C] x^H  = v
+      problems.push_back({x.size(), g_times_cs[ant * 2 + pol].data(),
+                          x.data(), initial_value});
+    }
+  }
+  std::vector<bool> success;
+  lls_solver.Solve(problems, success);
+
+  for (size_t ant = 0; ant != NAntennas(); ++ant) {
+    for (size_t pol = 0; pol != 2; ++pol) {
+      const std::vector<Complex>& x = vs[ant * 2 + pol];
+      if (success[ant * 2 + pol] && x[0] != Complex(0.0, 0.0)) {
         for (size_t d = 0; d != NDirections(); ++d)
           next_solutions[(ant * NDirections() + d) * 2 + pol] = x[d];
       } else {
@@ -22,6 +22,7 @@ class DiagonalSolver final : public SolverBase {
 
  private:
   void PerformIteration(const SolveData::ChannelBlockData& cb_data,
+                        BatchedLLSSolver& lls_solver,
                         std::vector<Matrix>& g_times_cs,
                         std::vector<std::vector<Complex>>& vs,
                         const std::vector<DComplex>& solutions,
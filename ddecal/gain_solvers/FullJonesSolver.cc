@@ -3,7 +3,7 @@
 
 #include "FullJonesSolver.h"
 
-#include "../linear_solvers/QRSolver.h"
+#include "../linear_solvers/BatchedLLSSolver.h"
 
 #include <aocommon/matrix2x2.h>
 #include <aocommon/parallelfor.h>
@@ -62,7 +62,11 @@ FullJonesSolver::SolveResult FullJonesSolver::Solve(
   // The following loop allocates all structures:
   std::vector<std::vector<Matrix>> g_times_cs(NChannelBlocks());
   std::vector<std::vector<Matrix>> vs(NChannelBlocks());
+  // TODO Use the configured solver type, like the other solvers do.
+  std::vector<BatchedLLSSolver> lls_solvers;
+  lls_solvers.reserve(NChannelBlocks());
   for (size_t ch_block = 0; ch_block != NChannelBlocks(); ++ch_block) {
+    lls_solvers.emplace_back(LLSSolverType::QR, NDirections() * 2, 2);
     const SolveData::ChannelBlockData& channel_block_data =
         data.ChannelBlock(ch_block);
     next_solutions[ch_block].resize(NDirections() * NAntennas() * 4);
@@ -97,7 +101,8 @@ FullJonesSolver::SolveResult FullJonesSolver::Solve(
     loop.Run(0, NChannelBlocks(),
              [&](size_t ch_block, [[maybe_unused]] size_t thread) {
                PerformIteration(data.ChannelBlock(ch_block),
-                                g_times_cs[ch_block], vs[ch_block],
+                                lls_solvers[ch_block], g_times_cs[ch_block],
+                                vs[ch_block],
                                 solutions[ch_block], next_solutions[ch_block]);
              });
 
@@ -137,7 +142,8 @@ FullJonesSolver::SolveResult FullJonesSolver::Solve(
 }
 
 void FullJonesSolver::PerformIteration(
-    const SolveData::ChannelBlockData& cb_data, std::vector<Matrix>& g_times_cs,
+    const SolveData::ChannelBlockData& cb_data, BatchedLLSSolver& lls_solver,
+    std::vector<Matrix>& g_times_cs,
     std::vector<Matrix>& vs, const std::vector<DComplex>& solutions,
     std::vector<DComplex>& next_solutions) {
   using aocommon::MC2x2;
@@ -225,20 +231,19 @@ void FullJonesSolver::PerformIteration(
   }
 
   // Compute the linear solution for each antenna.
-  const size_t n = NDirections() * 2;
-  const size_t n_rhs = 2;
-
+  std::vector<BatchedLLSSolver::Problem> problems;
+  problems.reserve(NAntennas());
   for (size_t ant = 0; ant != NAntennas(); ++ant) {
     const size_t m = cb_data.NAntennaVisibilities(ant) * 2;
-    // TODO it would be nice to have a solver resize function to avoid too many
-    // reallocations
-    // TODO Create the solver using CreateLLSSolver, like the other solvers do.
-    QRSolver solver(m, n, n_rhs);
-
     // solve x^H in [g C] x^H  = v
-    bool success = solver.Solve(g_times_cs[ant].data(), vs[ant].data());
+    problems.push_back({m, g_times_cs[ant].data(), vs[ant].data(), nullptr});
+  }
+  std::vector<bool> success;
+  lls_solver.Solve(problems, success);
+
+  for (size_t ant = 0; ant != NAntennas(); ++ant) {
     Matrix& x = vs[ant];
-    if (success && x(0, 0) != Complex(0.0, 0.0)) {
+    if (success[ant] && x(0, 0) != Complex(0.0, 0.0)) {
       for (size_t d = 0; d != NDirections(); ++d)
         for (size_t p = 0; p != 4; ++p) {
           // The conj transpose is also performed at this point (note swap of %
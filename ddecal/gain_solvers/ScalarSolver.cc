@@ -4,7 +4,7 @@
 #include "ScalarSolver.h"
 #include "SolveData.h"
 
-#include "../linear_solvers/LLSSolver.h"
+#include "../linear_solvers/BatchedLLSSolver.h"
 
 #include <aocommon/matrix2x2.h>
 #include <aocommon/parallelfor.h>
@@ -32,7 +32,10 @@ ScalarSolver::SolveResult ScalarSolver::Solve(
   // The following loop allocates all structures
   std::vector<std::vector<Matrix>> g_times_cs(NChannelBlocks());
   std::vector<std::vector<Matrix>> vs(NChannelBlocks());
+  std::vector<BatchedLLSSolver> lls_solvers;
+  lls_solvers.reserve(NChannelBlocks());
   for (size_t chBlock = 0; chBlock != NChannelBlocks(); ++chBlock) {
+    lls_solvers.push_back(CreateBatchedLLSSolver(NDirections(), 1));
     const SolveData::ChannelBlockData& channelBlock =
         data.ChannelBlock(chBlock);
     next_solutions[chBlock].resize(NDirections() * NAntennas());
@@ -71,7 +74,8 @@ ScalarSolver::SolveResult ScalarSolver::Solve(
              [&](size_t chBlock, [[maybe_unused]] size_t thread) {
                const SolveData::ChannelBlockData& channelBlock =
                    data.ChannelBlock(chBlock);
-               PerformIteration(channelBlock, g_times_cs[chBlock], vs[chBlock],
+               PerformIteration(channelBlock, lls_solvers[chBlock],
+                                g_times_cs[chBlock], vs[chBlock],
                                 solutions[chBlock], next_solutions[chBlock]);
              });
 
@@ -110,6 +114,7 @@ ScalarSolver::SolveResult ScalarSolver::Solve(
 }
 
 void ScalarSolver::PerformIteration(const SolveData::ChannelBlockData& cb_data,
+                                    BatchedLLSSolver& lls_solver,
                                     std::vector<Matrix>& g_times_cs,
                                     std::vector<Matrix>& vs,
                                     const std::vector<DComplex>& solutions,
@@ -171,23 +176,25 @@ void ScalarSolver::PerformIteration(const SolveData::ChannelBlockData& cb_data,
 
   // The matrices have been filled; compute the linear solution
   // for each antenna.
-  const size_t n = NDirections();
-  const size_t nrhs = 1;
-
+  std::vector<Complex> x0(NAntennas() * NDirections());
+  std::vector<BatchedLLSSolver::Problem> problems;
+  problems.reserve(NAntennas());
   for (size_t ant = 0; ant != NAntennas(); ++ant) {
     const size_t m = cb_data.NAntennaVisibilities(ant) * 4;
-    // TODO it would be nice to have a solver resize function to avoid too many
-    // reallocations
-    std::unique_ptr<LLSSolver> solver = CreateLLSSolver(m, n, nrhs);
-    // solve x^H in [g C] x^H  = v
-    std::vector<Complex> x0(NDirections());
+    Complex* initial_value = &x0[ant * NDirections()];
     for (size_t d = 0; d != NDirections(); ++d) {
-      x0[d] = solutions[(ant * NDirections() + d)];
+      initial_value[d] = solutions[(ant * NDirections() + d)];
     }
-    bool success =
-        solver->Solve(g_times_cs[ant].data(), vs[ant].data(), x0.data());
+    // solve x^H in [g C] x^H  = v
+    problems.push_back(
+        {m, g_times_cs[ant].data(), vs[ant].data(), initial_value});
+  }
+  std::vector<bool> success;
+  lls_solver.Solve(problems, success);
+
+  for (size_t ant = 0; ant != NAntennas(); ++ant) {
     Matrix& x = vs[ant];
-    if (success && x(0, 0) != Complex(0.0, 0.0)) {
+    if (success[ant] && x(0, 0) != Complex(0.0, 0.0)) {
       for (size_t d = 0; d != NDirections(); ++d)
         next_solutions[ant * NDirections() + d] = x(d, 0);
     } else {
@@ -20,6 +20,7 @@ class ScalarSolver final : public SolverBase {
 
  private:
   void PerformIteration(const SolveData::ChannelBlockData& cb_data,
+                        BatchedLLSSolver& lls_solver,
                         std::vector<Matrix>& g_times_cs,
                         std::vector<Matrix>& vs,
                         const std::vector<DComplex>& solutions,
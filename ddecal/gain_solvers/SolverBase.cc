@@ -306,5 +306,10 @@ std::unique_ptr<LLSSolver> SolverBase::CreateLLSSolver(
   return LLSSolver::Make(lls_solver_type_, m, n, nrhs);
 }
 
+BatchedLLSSolver SolverBase::CreateBatchedLLSSolver(const size_t n,
+                                                    const size_t nrhs) const {
+  return BatchedLLSSolver(lls_solver_type_, n, nrhs);
+}
+
 }  // namespace ddecal
 }  // namespace dp3
@@ -5,6 +5,7 @@
 #define DDECAL_SOLVER_BASE_H
 
 #include "../constraints/Constraint.h"
+#include "../linear_solvers/BatchedLLSSolver.h"
 #include "../linear_solvers/LLSSolver.h"
 
 #include <cassert>
@@ -261,6 +262,12 @@ class SolverBase {
   std::unique_ptr<LLSSolver> CreateLLSSolver(size_t m, size_t n,
                                              size_t nrhs) const;
 
+  /**
+   * Create a solver for many least-squares problems with n unknowns and
+   * nrhs right-hand sides, using the configured LLSSolverType.
+   */
+  BatchedLLSSolver CreateBatchedLLSSolver(size_t n, size_t nrhs) const;
+
  private:
   size_t n_antennas_;
   size_t n_directions_;
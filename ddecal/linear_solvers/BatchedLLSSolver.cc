@@ -0,0 +1,275 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "BatchedLLSSolver.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace dp3 {
+namespace ddecal {
+
+namespace {
+
+constexpr size_t kBatchSize = BatchedLLSSolver::kBatchSize;
+
+/// Offset of element (row, column) of an N x N matrix in the interleaved
+/// layout.
+template <size_t N>
+constexpr size_t Offset(size_t row, size_t column) {
+  return (row * N + column) * kBatchSize;
+}
+
+/**
+ * Solves a batch of Hermitian positive definite systems with a Cholesky
+ * decomposition A = L L^H, followed by forward and back substitution.
+ * Only the lower triangle of the interleaved matrices is used; it is
+ * overwritten by L. The right-hand sides, stored interleaved as
+ * [nrhs][N][kBatchSize], are overwritten by the solutions.
+ */
+template <size_t N>
+void CholeskySolve(float* a_real, float* a_imag, float* b_real, float* b_imag,
+                   size_t nrhs, bool* success) {
+  std::array<bool, kBatchSize> valid;
+  valid.fill(true);
+  std::array<float, kBatchSize> reciprocal;
+  for (size_t j = 0; j != N; ++j) {
+    float* l_jj = &a_real[Offset<N>(j, j)];
+    for (size_t k = 0; k != j; ++k) {
+      const float* l_jk_real = &a_real[Offset<N>(j, k)];
+      const float* l_jk_imag = &a_imag[Offset<N>(j, k)];
+      for (size_t p = 0; p != kBatchSize; ++p) {
+        l_jj[p] -= l_jk_real[p] * l_jk_real[p] + l_jk_imag[p] * l_jk_imag[p];
+      }
+    }
+    for (size_t p = 0; p != kBatchSize; ++p) {
+      // This also catches NaNs.
+      const bool positive = l_jj[p] > 0.0f;
+      valid[p] = valid[p] && positive;
+      l_jj[p] = positive ? std::sqrt(l_jj[p]) : 1.0f;
+      reciprocal[p] = 1.0f / l_jj[p];
+    }
+    for (size_t i = j + 1; i != N; ++i) {
+      float* l_ij_real = &a_real[Offset<N>(i, j)];
+      float* l_ij_imag = &a_imag[Offset<N>(i, j)];
+      for (size_t k = 0; k != j; ++k) {
+        const float* l_ik_real = &a_real[Offset<N>(i, k)];
+        const float* l_ik_imag = &a_imag[Offset<N>(i, k)];
+        const float* l_jk_real = &a_real[Offset<N>(j, k)];
+        const float* l_jk_imag = &a_imag[Offset<N>(j, k)];
+        // l_ij -= l_ik * conj(l_jk)
+        for (size_t p = 0; p != kBatchSize; ++p) {
+          l_ij_real[p] -=
+              l_ik_real[p] * l_jk_real[p] + l_ik_imag[p] * l_jk_imag[p];
+          l_ij_imag[p] -=
+              l_ik_imag[p] * l_jk_real[p] - l_ik_real[p] * l_jk_imag[p];
+        }
+      }
+      for (size_t p = 0; p != kBatchSize; ++p) {
+        l_ij_real[p] *= reciprocal[p];
+        l_ij_imag[p] *= reciprocal[p];
+      }
+    }
+  }
+
+  for (size_t r = 0; r != nrhs; ++r) {
+    float* x_real = &b_real[r * N * kBatchSize];
+    float* x_imag = &b_imag[r * N * kBatchSize];
+    // Forward substitution: solve L y = b.
+    for (size_t i = 0; i != N; ++i) {
+      float* y_i_real = &x_real[i * kBatchSize];
+      float* y_i_imag = &x_imag[i * kBatchSize];
+      for (size_t k = 0; k != i; ++k) {
+        const float* l_ik_real = &a_real[Offset<N>(i, k)];
+        const float* l_ik_imag = &a_imag[Offset<N>(i, k)];
+        const float* y_k_real = &x_real[k * kBatchSize];
+        const float* y_k_imag = &x_imag[k * kBatchSize];
+        for (size_t p = 0; p != kBatchSize; ++p) {
+          y_i_real[p] -=
+              l_ik_real[p] * y_k_real[p] - l_ik_imag[p] * y_k_imag[p];
+          y_i_imag[p] -=
+              l_ik_real[p] * y_k_imag[p] + l_ik_imag[p] * y_k_real[p];
+        }
+      }
+      const float* l_ii = &a_real[Offset<N>(i, i)];
+      for (size_t p = 0; p != kBatchSize; ++p) {
+        y_i_real[p] /= l_ii[p];
+        y_i_imag[p] /= l_ii[p];
+      }
+    }
+    // Back substitution: solve L^H x = y.
+    for (size_t i = N; i != 0; --i) {
+      float* x_i_real = &x_real[(i - 1) * kBatchSize];
+      float* x_i_imag = &x_imag[(i - 1) * kBatchSize];
+      for (size_t k = i; k != N; ++k) {
+        const float* l_ki_real = &a_real[Offset<N>(k, i - 1)];
+        const float* l_ki_imag = &a_imag[Offset<N>(k, i - 1)];
+        const float* x_k_real = &x_real[k * kBatchSize];
+        const float* x_k_imag = &x_imag[k * kBatchSize];
+        // x_i -= conj(l_ki) * x_k
+        for (size_t p = 0; p != kBatchSize; ++p) {
+          x_i_real[p] -=
+              l_ki_real[p] * x_k_real[p] + l_ki_imag[p] * x_k_imag[p];
+          x_i_imag[p] -=
+              l_ki_real[p] * x_k_imag[p] - l_ki_imag[p] * x_k_real[p];
+        }
+      }
+      const float* l_ii = &a_real[Offset<N>(i - 1, i - 1)];
+      for (size_t p = 0; p != kBatchSize; ++p) {
+        x_i_real[p] /= l_ii[p];
+        x_i_imag[p] /= l_ii[p];
+      }
+    }
+  }
+  std::copy(valid.begin(), valid.end(), success);
+}
+
+using SolveFunction = void (*)(float*, float*, float*, float*, size_t, bool*);
+
+/// Fills table[n - 1] with CholeskySolve<n> for n = 1 ... N.
+template <size_t N>
+struct SolveFunctionTable {
+  static void Fill(SolveFunction* table) {
+    table[N - 1] = &CholeskySolve<N>;
+    SolveFunctionTable<N - 1>::Fill(table);
+  }
+};
+
+template <>
+struct SolveFunctionTable<0> {
+  static void Fill(SolveFunction*) {}
+};
+
+std::array<SolveFunction, BatchedLLSSolver::kMaxFixedSize>
+MakeSolveFunctions() {
+  std::array<SolveFunction, BatchedLLSSolver::kMaxFixedSize> table;
+  SolveFunctionTable<BatchedLLSSolver::kMaxFixedSize>::Fill(table.data());
+  return table;
+}
+
+/// kSolveFunctions[n - 1] solves systems with n unknowns.
+const std::array<SolveFunction, BatchedLLSSolver::kMaxFixedSize>
+    kSolveFunctions = MakeSolveFunctions();
+
+}  // namespace
+
+constexpr size_t BatchedLLSSolver::kBatchSize;
+constexpr size_t BatchedLLSSolver::kMaxFixedSize;
+
+BatchedLLSSolver::BatchedLLSSolver(LLSSolverType type, size_t n, size_t nrhs)
+    : type_(type),
+      n_(n),
+      nrhs_(nrhs),
+      is_batched_(type == LLSSolverType::NORMAL_EQUATIONS && n > 0 &&
+                  n <= kMaxFixedSize) {
+  if (is_batched_) {
+    normal_real_.resize(n_ * n_ * kBatchSize);
+    normal_imag_.resize(n_ * n_ * kBatchSize);
+    rhs_real_.resize(nrhs_ * n_ * kBatchSize);
+    rhs_imag_.resize(nrhs_ * n_ * kBatchSize);
+  }
+}
+
+BatchedLLSSolver::~BatchedLLSSolver() = default;
+
+void BatchedLLSSolver::Solve(const std::vector<Problem>& problems,
+                             std::vector<bool>& success) {
+  success.resize(problems.size());
+  if (is_batched_) {
+    std::array<bool, kBatchSize> batch_success;
+    for (size_t first = 0; first < problems.size(); first += kBatchSize) {
+      const size_t n_problems = std::min(kBatchSize, problems.size() - first);
+      SolveBatch(&problems[first], n_problems, batch_success.data());
+      std::copy_n(batch_success.begin(), n_problems, success.begin() + first);
+    }
+  } else {
+    for (size_t i = 0; i != problems.size(); ++i) {
+      const Problem& problem = problems[i];
+      LLSSolver& solver = FallbackSolver(problem.m);
+      success[i] = problem.initial_value
+                       ? solver.Solve(problem.a, problem.b,
+                                      problem.initial_value)
+                       : solver.Solve(problem.a, problem.b);
+      if (type_ == LLSSolverType::NORMAL_EQUATIONS && nrhs_ > 1) {
+        // NormalEquationsSolver returns the solution with leading dimension
+        // n; spread it to the leading dimension that LAPACK would use.
+        const size_t ldb = std::max(problem.m, n_);
+        for (size_t r = nrhs_ - 1; r != 0; --r) {
+          std::copy_backward(problem.b + r * n_, problem.b + (r + 1) * n_,
+                             problem.b + r * ldb + n_);
+        }
+      }
+    }
+  }
+}
+
+void BatchedLLSSolver::SolveBatch(const Problem* problems, size_t n_problems,
+                                  bool* success) {
+  // Unused slots of the batch get an identity matrix, so they do not produce
+  // NaNs or failures.
+  std::fill(normal_real_.begin(), normal_real_.end(), 0.0f);
+  std::fill(normal_imag_.begin(), normal_imag_.end(), 0.0f);
+  std::fill(rhs_real_.begin(), rhs_real_.end(), 0.0f);
+  std::fill(rhs_imag_.begin(), rhs_imag_.end(), 0.0f);
+  for (size_t i = 0; i != n_; ++i) {
+    for (size_t p = n_problems; p != kBatchSize; ++p) {
+      normal_real_[(i * n_ + i) * kBatchSize + p] = 1.0f;
+    }
+  }
+
+  // Form the normal equations A^H A x = A^H b. Only the lower triangle of
+  // A^H A is needed.
+  for (size_t p = 0; p != n_problems; ++p) {
+    const Problem& problem = problems[p];
+    const size_t m = problem.m;
+    const size_t ldb = std::max(m, n_);
+    for (size_t i = 0; i != n_; ++i) {
+      const complex* a_i = problem.a + i * m;
+      for (size_t j = 0; j <= i; ++j) {
+        const complex* a_j = problem.a + j * m;
+        complex sum(0.0f, 0.0f);
+        for (size_t row = 0; row != m; ++row) {
+          sum += std::conj(a_i[row]) * a_j[row];
+        }
+        normal_real_[(i * n_ + j) * kBatchSize + p] = sum.real();
+        normal_imag_[(i * n_ + j) * kBatchSize + p] = sum.imag();
+      }
+      for (size_t r = 0; r != nrhs_; ++r) {
+        const complex* b_r = problem.b + r * ldb;
+        complex sum(0.0f, 0.0f);
+        for (size_t row = 0; row != m; ++row) {
+          sum += std::conj(a_i[row]) * b_r[row];
+        }
+        rhs_real_[(r * n_ + i) * kBatchSize + p] = sum.real();
+        rhs_imag_[(r * n_ + i) * kBatchSize + p] = sum.imag();
+      }
+    }
+  }
+
+  kSolveFunctions[n_ - 1](normal_real_.data(), normal_imag_.data(),
+                          rhs_real_.data(), rhs_imag_.data(), nrhs_, success);
+
+  for (size_t p = 0; p != n_problems; ++p) {
+    const Problem& problem = problems[p];
+    const size_t ldb = std::max(problem.m, n_);
+    for (size_t r = 0; r != nrhs_; ++r) {
+      for (size_t i = 0; i != n_; ++i) {
+        const size_t index = (r * n_ + i) * kBatchSize + p;
+        problem.b[r * ldb + i] = complex(rhs_real_[index], rhs_imag_[index]);
+      }
+    }
+  }
+}
+
+LLSSolver& BatchedLLSSolver::FallbackSolver(size_t m) {
+  std::unique_ptr<LLSSolver>& solver = fallback_solvers_[m];
+  if (!solver) {
+    solver = LLSSolver::Make(type_, m, n_, nrhs_);
+  }
+  return *solver;
+}
+
+}  // namespace ddecal
+}  // namespace dp3
@@ -0,0 +1,108 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DDECAL_BATCHED_LLS_SOLVER_H
+#define DDECAL_BATCHED_LLS_SOLVER_H
+
+#include "LLSSolver.h"
+
+#include <complex>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace dp3 {
+namespace ddecal {
+
+/**
+ * Solves many small linear least-squares problems that all have the same
+ * number of unknowns, such as the per-antenna problems of the direct
+ * solvers (ScalarSolver, DiagonalSolver and FullJonesSolver).
+ *
+ * For normal equations with at most @ref kMaxFixedSize unknowns, the
+ * problems are solved in batches of @ref kBatchSize. The normal matrices of a
+ * batch are stored interleaved (structure of arrays, with separate real and
+ * imaginary parts), such that the Cholesky decomposition and the
+ * substitutions process all problems of a batch with the same instructions.
+ * These routines are specialised on the number of unknowns.
+ *
+ * Other problems are solved one by one with the LLSSolver of the given type.
+ * Those solvers are kept per number of rows, so their workspaces are only
+ * allocated once.
+ *
+ * The class keeps internal workspace and is therefore not thread safe.
+ */
+class BatchedLLSSolver {
+ public:
+  using complex = std::complex<float>;
+
+  /// Nr of problems that are processed together in the interleaved layout.
+  static constexpr size_t kBatchSize = 8;
+  /// Largest number of unknowns that uses the batched normal equations.
+  static constexpr size_t kMaxFixedSize = 32;
+
+  /**
+   * A problem: find X that minimizes || B - A*X ||.
+   * @c a is the column-major M-by-N matrix A. @c b is the column-major
+   * M-by-NRHS matrix B, with leading dimension max(M, N). On successful exit,
+   * @c b contains the solution, with the same leading dimension, like LAPACK
+   * returns it.
+   */
+  struct Problem {
+    size_t m;
+    complex* a;
+    complex* b;
+    complex* initial_value;  ///< May be nullptr.
+  };
+
+  /**
+   * @param type Type of solver. Only LLSSolverType::NORMAL_EQUATIONS
+   * uses the batched solver.
+   * @param n Number of unknowns (columns of A) of all problems.
+   * @param nrhs Number of right-hand sides (columns of B) of all problems.
+   */
+  BatchedLLSSolver(LLSSolverType type, size_t n, size_t nrhs);
+
+  BatchedLLSSolver(BatchedLLSSolver&&) = default;
+  BatchedLLSSolver& operator=(BatchedLLSSolver&&) = default;
+
+  ~BatchedLLSSolver();
+
+  /**
+   * Solve all problems.
+   * @param success Is set to the result for each problem: false if the
+   * problem could not be solved (e.g. because A is rank deficient).
+   */
+  void Solve(const std::vector<Problem>& problems, std::vector<bool>& success);
+
+  /**
+   * True if the problems are solved in batches by this class, false if
+   * they are passed on to an LLSSolver.
+   */
+  bool IsBatched() const { return is_batched_; }
+
+ private:
+  void SolveBatch(const Problem* problems, size_t n_problems, bool* success);
+
+  LLSSolver& FallbackSolver(size_t m);
+
+  LLSSolverType type_;
+  size_t n_;
+  size_t nrhs_;
+  bool is_batched_;
+
+  /// Interleaved workspace: element i of problem p is at [i * kBatchSize + p].
+  /// @{
+  std::vector<float> normal_real_;
+  std::vector<float> normal_imag_;
+  std::vector<float> rhs_real_;
+  std::vector<float> rhs_imag_;
+  /// @}
+
+  std::map<size_t, std::unique_ptr<LLSSolver>> fallback_solvers_;
+};
+
+}  // namespace ddecal
+}  // namespace dp3
+
+#endif
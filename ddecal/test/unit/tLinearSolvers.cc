@@ -1,11 +1,71 @@
 // Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include "../../linear_solvers/BatchedLLSSolver.h"
 #include "../../linear_solvers/NormalEquationsSolver.h"
 
 #include <boost/test/unit_test.hpp>
 #include <boost/test/data/test_case.hpp>
 
+using dp3::ddecal::BatchedLLSSolver;
+
+namespace {
+void TestBatchedSolver(dp3::ddecal::LLSSolverType type) {
+  // More problems than fit in one batch, with different numbers of rows.
+  const size_t n = 3;
+  const size_t nrhs = 2;
+  const size_t n_problems = BatchedLLSSolver::kBatchSize + 3;
+  std::vector<std::vector<std::complex<float>>> as(n_problems);
+  std::vector<std::vector<std::complex<float>>> bs(n_problems);
+  std::vector<std::vector<std::complex<float>>> references(n_problems);
+  std::vector<BatchedLLSSolver::Problem> problems;
+  for (size_t p = 0; p != n_problems; ++p) {
+    const size_t m = 5 + p % 3;
+    as[p].resize(m * n);
+    for (size_t i = 0; i != m * n; ++i) {
+      as[p][i] = {float((i * 7 + p) % 11) - 5.0f,
+                  float((i * 3 + 2 * p) % 5) - 2.0f};
+    }
+    // The right-hand sides are an exact product A x.
+    references[p].resize(n * nrhs);
+    for (size_t i = 0; i != n * nrhs; ++i) {
+      references[p][i] = {float(i) + 1.0f, float(p) - 2.0f};
+    }
+    bs[p].assign(m * nrhs, 0.0f);
+    for (size_t r = 0; r != nrhs; ++r) {
+      for (size_t row = 0; row != m; ++row) {
+        for (size_t col = 0; col != n; ++col) {
+          bs[p][r * m + row] +=
+              as[p][col * m + row] * references[p][r * n + col];
+        }
+      }
+    }
+    problems.push_back({m, as[p].data(), bs[p].data(), nullptr});
+  }
+  // The last problem is rank deficient. LAPACK's QR solver returns a zero
+  // solution for a zero matrix, but the Cholesky decomposition fails.
+  std::fill(as.back().begin(), as.back().end(), 0.0f);
+
+  BatchedLLSSolver solver(type, n, nrhs);
+  BOOST_CHECK_EQUAL(solver.IsBatched(),
+                    type == dp3::ddecal::LLSSolverType::NORMAL_EQUATIONS);
+  std::vector<bool> success;
+  solver.Solve(problems, success);
+  BOOST_REQUIRE_EQUAL(success.size(), n_problems);
+  BOOST_CHECK_EQUAL(success.back(), !solver.IsBatched());
+  for (size_t p = 0; p != n_problems - 1; ++p) {
+    BOOST_CHECK(success[p]);
+    for (size_t r = 0; r != nrhs; ++r) {
+      for (size_t i = 0; i != n; ++i) {
+        const std::complex<float> value = bs[p][r * problems[p].m + i];
+        const std::complex<float> expected = references[p][r * n + i];
+        BOOST_CHECK_SMALL(std::abs(value - expected), 1.0e-3f);
+      }
+    }
+  }
+}
+}  // namespace
+
 BOOST_AUTO_TEST_SUITE(linear_solvers)
 
 BOOST_AUTO_TEST_CASE(normaleq_solver) {
@@ -22,4 +82,12 @@ BOOST_AUTO_TEST_CASE(normaleq_solver) {
   BOOST_CHECK_CLOSE(b[1].real(), 2.79757662, 1.0E-3);
 }
 
+BOOST_AUTO_TEST_CASE(batched_normal_equations) {
+  TestBatchedSolver(dp3::ddecal::LLSSolverType::NORMAL_EQUATIONS);
+}
+
+BOOST_AUTO_TEST_CASE(batched_qr_fallback) {
+  TestBatchedSolver(dp3::ddecal::LLSSolverType::QR);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,67 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../../MemoryPlan.h"
+
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+using dp3::ddecal::EstimateIntervalMemory;
+using dp3::ddecal::EstimateSolverMemory;
+using dp3::ddecal::MakeMemoryPlan;
+using dp3::ddecal::MemoryPlan;
+using dp3::ddecal::SolverAlgorithm;
+
+BOOST_AUTO_TEST_SUITE(memory_plan)
+
+BOOST_AUTO_TEST_CASE(interval_memory) {
+  const size_t one_direction = EstimateIntervalMemory(10, 8, 4, 1, 2, false);
+  BOOST_CHECK_GT(one_direction, 10u * 8u * 4u * 2u);
+  // The memory grows linearly with the solution interval.
+  BOOST_CHECK_EQUAL(EstimateIntervalMemory(10, 8, 4, 1, 4, false),
+                    2 * one_direction);
+  // Each direction adds model data.
+  BOOST_CHECK_GT(EstimateIntervalMemory(10, 8, 4, 3, 2, false),
+                 one_direction);
+  // Keeping the model data for subtracting uses more memory.
+  BOOST_CHECK_GT(EstimateIntervalMemory(10, 8, 4, 3, 2, true),
+                 EstimateIntervalMemory(10, 8, 4, 3, 2, false));
+}
+
+BOOST_AUTO_TEST_CASE(solver_memory) {
+  const size_t direction_solve =
+      EstimateSolverMemory(SolverAlgorithm::kDirectionSolve, 10, 8, 4, 5, 2);
+  const size_t iterative = EstimateSolverMemory(
+      SolverAlgorithm::kDirectionIterative, 10, 8, 4, 5, 2);
+  BOOST_CHECK_GT(iterative, 0u);
+  BOOST_CHECK_GT(direction_solve, iterative);
+  BOOST_CHECK_EQUAL(
+      EstimateSolverMemory(SolverAlgorithm::kHybrid, 10, 8, 4, 5, 2),
+      direction_solve);
+}
+
+BOOST_AUTO_TEST_CASE(buffered_intervals) {
+  // Limited by the budget: (1000 - 200) / 100 = 8 intervals.
+  const MemoryPlan limited = MakeMemoryPlan(1000.0, 100, 200, 20);
+  BOOST_CHECK_EQUAL(limited.n_buffered_intervals, 8u);
+  BOOST_CHECK(!limited.ExceedsBudget());
+
+  // Limited by the wanted number of intervals.
+  BOOST_CHECK_EQUAL(MakeMemoryPlan(1000.0, 100, 200, 3).n_buffered_intervals,
+                    3u);
+
+  // At least one interval, even if it does not fit.
+  const MemoryPlan exceeding = MakeMemoryPlan(250.0, 100, 200, 20);
+  BOOST_CHECK_EQUAL(exceeding.n_buffered_intervals, 1u);
+  BOOST_CHECK(exceeding.ExceedsBudget());
+}
+
+BOOST_AUTO_TEST_CASE(show) {
+  std::ostringstream output;
+  ShowMemoryPlan(output, MakeMemoryPlan(1000.0, 100, 200, 20));
+  BOOST_CHECK_NE(output.str().find("buffered solints:    8"),
+                 std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
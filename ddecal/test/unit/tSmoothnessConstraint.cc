@@ -9,6 +9,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/data/test_case.hpp>
 
+using dp3::ddecal::KernelSmoother;
 using dp3::ddecal::SmoothnessConstraint;
 
 namespace {
@@ -111,4 +112,45 @@ BOOST_AUTO_TEST_CASE(flagged_channels) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(batched_smoothing) {
+  using Smoother = KernelSmoother<std::complex<double>, double>;
+  // An irregular grid with a frequency dependent kernel size.
+  const std::vector<double> frequencies{1.0e6, 1.5e6, 2.5e6, 3.0e6,
+                                        4.5e6, 5.0e6, 5.5e6, 7.0e6};
+  const size_t n_series = 3;
+  const size_t n = frequencies.size();
+  std::vector<std::complex<double>> data(n * n_series);
+  std::vector<double> weights(n * n_series);
+  for (size_t ch = 0; ch != n; ++ch) {
+    for (size_t s = 0; s != n_series; ++s) {
+      data[ch * n_series + s] = {double(ch * ch) + s, double(s) - ch};
+      weights[ch * n_series + s] = (ch + s) % 4 == 0 ? 0.0 : 1.0 + s;
+    }
+  }
+
+  Smoother smoother(frequencies, Smoother::GaussianKernel, bandwidth_hz,
+                    3.0e6);
+  for (const double kernel_size_factor : {1.0, 0.5}) {
+    std::vector<std::complex<double>> batched = data;
+    smoother.Smooth(batched.data(), weights.data(), n_series,
+                    kernel_size_factor);
+    for (size_t s = 0; s != n_series; ++s) {
+      std::vector<std::complex<double>> series(n);
+      std::vector<double> series_weights(n);
+      for (size_t ch = 0; ch != n; ++ch) {
+        series[ch] = data[ch * n_series + s];
+        series_weights[ch] = weights[ch * n_series + s];
+      }
+      smoother.Smooth(series.data(), series_weights.data(),
+                      kernel_size_factor);
+      for (size_t ch = 0; ch != n; ++ch) {
+        BOOST_CHECK_CLOSE(batched[ch * n_series + s].real(), series[ch].real(),
+                          1e-8);
+        BOOST_CHECK_CLOSE(batched[ch * n_series + s].imag(), series[ch].imag(),
+                          1e-8);
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
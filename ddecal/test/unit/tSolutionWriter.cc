@@ -0,0 +1,59 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../../SolutionWriter.h"
+
+#include "../../../common/test/unit/fixtures/fDirectory.h"
+
+#include <boost/test/unit_test.hpp>
+
+using dp3::ddecal::ExtendibleSolTabs;
+using schaapcommon::h5parm::AxisInfo;
+using schaapcommon::h5parm::H5Parm;
+using schaapcommon::h5parm::SolTab;
+
+namespace {
+const std::string kH5ParmName = "tSolutionWriter.h5";
+}
+
+BOOST_AUTO_TEST_SUITE(solution_writer)
+
+BOOST_FIXTURE_TEST_CASE(append_values, FixtureDirectory) {
+  {
+    H5Parm h5parm(kH5ParmName, true);
+    ExtendibleSolTabs extendible_soltabs(kH5ParmName);
+    const std::vector<AxisInfo> axes{AxisInfo("time", 0), AxisInfo("ant", 3)};
+    SolTab& soltab = h5parm.CreateSolTab("appended", "phase", axes);
+    // A chunk size of one byte results in chunks of one time slot.
+    extendible_soltabs.Create(soltab, "CREATE by tSolutionWriter", 1);
+    soltab.SetAntennas({"Antenna1", "Antenna12", "Antenna123"});
+
+    extendible_soltabs.Append(soltab, {1.0, 2.0, 3.0}, {}, {10.0});
+    extendible_soltabs.AppendComplex(soltab,
+                                     {{4.0, 0.0},
+                                      {5.0, 0.0},
+                                      {6.0, 0.0},
+                                      {7.0, 0.0},
+                                      {8.0, 0.0},
+                                      {9.0, 0.0}},
+                                     {}, true, {12.0, 14.0});
+    BOOST_CHECK_EQUAL(soltab.GetAxis("time").size, 3u);
+    BOOST_CHECK_THROW(extendible_soltabs.Append(soltab, {1.0, 2.0}, {}, {16.0}),
+                      std::runtime_error);
+  }
+
+  H5Parm h5parm(kH5ParmName, false, false, "sol000");
+  SolTab soltab = h5parm.GetSolTab("appended");
+  BOOST_CHECK_EQUAL(soltab.GetAxis("time").size, 3u);
+  const std::vector<double> times = soltab.GetRealAxis("time");
+  const std::vector<double> expected_times{10.0, 12.0, 14.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(times.begin(), times.end(),
+                                expected_times.begin(), expected_times.end());
+  const std::vector<double> values =
+      soltab.GetValues("Antenna12", 0, 3, 1, 0, 1, 1, 0, 0);
+  const std::vector<double> expected_values{2.0, 5.0, 8.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+                                expected_values.begin(), expected_values.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "SkymodelToSourceDB.h"
+#include "SourceDBCompiled.h"
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -987,6 +988,42 @@ SourceDB MakeSourceDb(const std::string& in, const std::string& out,
   return pdb;
 }
 
+void MakeCompiledSourceDb(const std::string& in, const std::string& out,
+                          const std::string& format, const std::string& prefix,
+                          const std::string& suffix, bool average, bool check,
+                          const SearchInfo& search_info) {
+  const SdbFormat sdbf = getFormat(format);
+  SourceDBSkymodel source_db;
+  int nrpatch = 0;
+  int nrsource = 0;
+  int nrpatchfnd = 0;
+  int nrsourcefnd = 0;
+  std::map<std::string, PatchSumInfo> patchSumInfo;
+  if (!in.empty()) {
+    std::ifstream infile(in.c_str());
+    if (!infile)
+      throw std::runtime_error("File " + in + " could not be opened");
+
+    ParseSkyModel(source_db, infile, sdbf, prefix, suffix, check, nrpatch,
+                  nrsource, nrpatchfnd, nrsourcefnd, patchSumInfo,
+                  search_info);
+  }
+  // Write the calculated ra/dec/flux of the patches.
+  if (average) {
+    for (const auto& patch : patchSumInfo) {
+      const PatchSumInfo& info = patch.second;
+      if (info.getFlux() != 0) {
+        source_db.updatePatch(info.getPatchId(), info.getFlux(), info.getRa(),
+                              info.getDec());
+      }
+    }
+  }
+  SourceDBCompiled::Write(source_db, out);
+  std::cout << "Wrote " << nrpatchfnd << " patches (out of " << nrpatch
+            << ") and " << nrsourcefnd << " sources (out of " << nrsource
+            << ") into " << out << '\n';
+}
+
 SourceDBSkymodel MakeSourceDBSkymodel(const std::string& filename,
                                       const std::string& format) {
   SdbFormat sdb_format = getFormat(format);
@@ -56,6 +56,13 @@ SourceDB MakeSourceDb(const std::string& in, const std::string& out,
                       bool append, bool average, bool check,
                       const SearchInfo& search_info);
 
+/// Convert a text sky model into a compiled sky model (see
+/// SourceDBCompiled). An existing file is overwritten.
+void MakeCompiledSourceDb(const std::string& in, const std::string& out,
+                          const std::string& format, const std::string& prefix,
+                          const std::string& suffix, bool average, bool check,
+                          const SearchInfo& search_info);
+
 SourceDBSkymodel MakeSourceDBSkymodel(const std::string& filename,
                                       const std::string& format);
 
@@ -0,0 +1,360 @@
+// SourceDBCompiled.cc: Sky model in a compact binary format that is mapped into
+// memory
+//
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "SourceDBCompiled.h"
+
+#include "SourceDBSkymodel.h"
+
+#include <casacore/casa/Utilities/Regex.h>
+
+#include <boost/utility/string_view.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace dp3 {
+namespace parmdb {
+
+namespace {
+
+constexpr char kMagic[8] = {'D', 'P', '3', 'S', 'K', 'Y', 'C', 'M'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+/// Every array in the file starts at a multiple of this number of bytes.
+constexpr size_t kAlignment = 8;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t n_patches;
+  uint64_t n_sources;
+  uint64_t n_spectral_terms;
+  uint64_t n_name_bytes;
+};
+
+size_t Padded(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+template <typename T>
+void WriteArray(std::ostream& stream, const std::vector<T>& values) {
+  static const char kPadding[kAlignment] = {};
+  const size_t size = values.size() * sizeof(T);
+  stream.write(reinterpret_cast<const char*>(values.data()), size);
+  stream.write(kPadding, Padded(size) - size);
+}
+
+/// Gets the consecutive arrays from a mapped file.
+class ArrayReader {
+ public:
+  ArrayReader(const char* data, size_t size, const std::string& filename)
+      : data_(data), size_(size), position_(0), filename_(filename) {}
+
+  template <typename T>
+  const T* Next(size_t n) {
+    if (n > (size_ - position_) / sizeof(T) ||
+        Padded(n * sizeof(T)) > size_ - position_) {
+      throw std::runtime_error("Compiled sky model " + filename_ +
+                               " is truncated");
+    }
+    const T* result = reinterpret_cast<const T*>(data_ + position_);
+    position_ += Padded(n * sizeof(T));
+    return result;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t position_;
+  const std::string& filename_;
+};
+
+/// Check that offsets are ascending and end at the given total.
+void CheckOffsets(const uint64_t* offsets, size_t n, uint64_t total,
+                  const std::string& filename) {
+  bool valid = offsets[0] == 0 && offsets[n] == total;
+  for (size_t i = 0; valid && i != n; ++i) {
+    valid = offsets[i] <= offsets[i + 1];
+  }
+  if (!valid) {
+    throw std::runtime_error("Compiled sky model " + filename +
+                             " has invalid offsets");
+  }
+}
+
+bool IsValidHeader(const Header& header) {
+  return std::equal(kMagic, kMagic + sizeof(kMagic), header.magic) &&
+         header.version == kVersion && header.byte_order == kByteOrderMark;
+}
+
+}  // namespace
+
+constexpr uint32_t SourceDBCompiled::kJ2000Flag;
+constexpr uint32_t SourceDBCompiled::kLogarithmicSIFlag;
+constexpr uint32_t SourceDBCompiled::kRotationMeasureFlag;
+
+SourceDBCompiled::SourceDBCompiled(const std::string& filename) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Compiled sky model " + filename +
+                             " could not be opened");
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      static_cast<size_t>(status.st_size) < sizeof(Header)) {
+    close(fd);
+    throw std::runtime_error(filename + " is not a compiled sky model");
+  }
+  size_ = status.st_size;
+  data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    throw std::runtime_error("Compiled sky model " + filename +
+                             " could not be mapped into memory");
+  }
+
+  try {
+    ArrayReader reader(static_cast<const char*>(data_), size_, filename);
+    const Header& header = *reader.Next<Header>(1);
+    if (!IsValidHeader(header)) {
+      throw std::runtime_error(filename +
+                               " is not a compiled sky model of version " +
+                               std::to_string(kVersion));
+    }
+    // Every patch and source takes more than a byte, which also prevents
+    // overflows in the array sizes below.
+    if (header.n_patches >= size_ || header.n_sources >= size_) {
+      throw std::runtime_error("Compiled sky model " + filename +
+                               " is truncated");
+    }
+    n_patches_ = header.n_patches;
+    n_sources_ = header.n_sources;
+
+    patch_name_offset_ = reader.Next<uint64_t>(n_patches_ + 1);
+    patch_first_source_ = reader.Next<uint64_t>(n_patches_ + 1);
+    patch_ra_ = reader.Next<double>(n_patches_);
+    patch_dec_ = reader.Next<double>(n_patches_);
+    patch_brightness_ = reader.Next<double>(n_patches_);
+
+    source_spectral_offset_ = reader.Next<uint64_t>(n_sources_ + 1);
+    source_type_ = reader.Next<int32_t>(n_sources_);
+    source_flags_ = reader.Next<uint32_t>(n_sources_);
+    source_ra_ = reader.Next<double>(n_sources_);
+    source_dec_ = reader.Next<double>(n_sources_);
+    source_i_ = reader.Next<double>(n_sources_);
+    source_q_ = reader.Next<double>(n_sources_);
+    source_u_ = reader.Next<double>(n_sources_);
+    source_v_ = reader.Next<double>(n_sources_);
+    source_major_axis_ = reader.Next<double>(n_sources_);
+    source_minor_axis_ = reader.Next<double>(n_sources_);
+    source_orientation_ = reader.Next<double>(n_sources_);
+    source_ref_freq_ = reader.Next<double>(n_sources_);
+    source_polarized_fraction_ = reader.Next<double>(n_sources_);
+    source_polarization_angle_ = reader.Next<double>(n_sources_);
+    source_rotation_measure_ = reader.Next<double>(n_sources_);
+
+    spectral_terms_ = reader.Next<double>(header.n_spectral_terms);
+    names_ = reader.Next<char>(header.n_name_bytes);
+
+    CheckOffsets(patch_name_offset_, n_patches_, header.n_name_bytes, filename);
+    CheckOffsets(patch_first_source_, n_patches_, n_sources_, filename);
+    CheckOffsets(source_spectral_offset_, n_sources_, header.n_spectral_terms,
+                 filename);
+  } catch (...) {
+    munmap(data_, size_);
+    throw;
+  }
+}
+
+SourceDBCompiled::~SourceDBCompiled() { munmap(data_, size_); }
+
+bool SourceDBCompiled::IsCompiled(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  Header header;
+  return file.read(reinterpret_cast<char*>(&header), sizeof(Header)) &&
+         IsValidHeader(header);
+}
+
+void SourceDBCompiled::Write(const SourceDBSkymodel& source_db,
+                             const std::string& filename) {
+  // FindPatches sorts the patches by name.
+  const std::vector<std::string> patch_names = source_db.FindPatches("*");
+  std::map<std::string, size_t> patch_indices;
+  for (size_t i = 0; i != patch_names.size(); ++i) {
+    patch_indices.emplace(patch_names[i], i);
+  }
+
+  // Group the sources per patch, keeping their order within a patch.
+  const std::vector<SourceData>& sources = source_db.GetSources();
+  std::vector<std::vector<const SourceData*>> patch_sources(patch_names.size());
+  for (const SourceData& source : sources) {
+    const auto iter = patch_indices.find(source.getPatchName());
+    if (iter == patch_indices.end()) {
+      throw std::runtime_error("Patch " + source.getPatchName() +
+                               " of source " + source.getInfo().getName() +
+                               " does not exist");
+    }
+    patch_sources[iter->second].push_back(&source);
+  }
+
+  std::vector<uint64_t> patch_name_offset{0};
+  std::vector<uint64_t> patch_first_source{0};
+  std::vector<double> patch_ra;
+  std::vector<double> patch_dec;
+  std::vector<double> patch_brightness;
+  std::string names;
+  for (size_t i = 0; i != patch_names.size(); ++i) {
+    const PatchInfo& info = source_db.GetPatch(patch_names[i]);
+    names += patch_names[i];
+    patch_name_offset.push_back(names.size());
+    patch_first_source.push_back(patch_first_source.back() +
+                                 patch_sources[i].size());
+    patch_ra.push_back(info.getRa());
+    patch_dec.push_back(info.getDec());
+    patch_brightness.push_back(info.apparentBrightness());
+  }
+
+  std::vector<uint64_t> spectral_offset{0};
+  std::vector<int32_t> type;
+  std::vector<uint32_t> flags;
+  std::vector<double> ra, dec, stokes_i, stokes_q, stokes_u, stokes_v,
+      major_axis, minor_axis, orientation,
+      ref_freq, polarized_fraction, polarization_angle, rotation_measure;
+  std::vector<double> spectral_terms;
+  for (const std::vector<const SourceData*>& patch : patch_sources) {
+    for (const SourceData* source : patch) {
+      const SourceInfo& info = source->getInfo();
+      spectral_terms.insert(spectral_terms.end(),
+                            source->getSpectralTerms().begin(),
+                            source->getSpectralTerms().end());
+      spectral_offset.push_back(spectral_terms.size());
+      type.push_back(info.getType());
+      flags.push_back(
+          (info.getRefType() == "J2000" ? kJ2000Flag : 0) |
+          (info.getHasLogarithmicSI() ? kLogarithmicSIFlag : 0) |
+          (info.getUseRotationMeasure() ? kRotationMeasureFlag : 0));
+      ra.push_back(source->getRa());
+      dec.push_back(source->getDec());
+      stokes_i.push_back(source->getI());
+      stokes_q.push_back(source->getQ());
+      stokes_u.push_back(source->getU());
+      stokes_v.push_back(source->getV());
+      major_axis.push_back(source->getMajorAxis());
+      minor_axis.push_back(source->getMinorAxis());
+      orientation.push_back(source->getOrientation());
+      ref_freq.push_back(info.getSpectralTermsRefFreq());
+      polarized_fraction.push_back(source->getPolarizedFraction());
+      polarization_angle.push_back(source->getPolarizationAngle());
+      rotation_measure.push_back(source->getRotationMeasure());
+    }
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  std::copy(kMagic, kMagic + sizeof(kMagic), header.magic);
+  header.version = kVersion;
+  header.byte_order = kByteOrderMark;
+  header.n_patches = patch_names.size();
+  header.n_sources = sources.size();
+  header.n_spectral_terms = spectral_terms.size();
+  header.n_name_bytes = names.size();
+
+  // Write to a temporary file that replaces the file at the end, such that
+  // processes that have mapped the old file keep a valid mapping.
+  const std::string temporary_name = filename + ".tmp";
+  std::ofstream file(temporary_name, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Compiled sky model " + filename +
+                             " could not be created");
+  }
+  WriteArray(file, std::vector<Header>{header});
+  WriteArray(file, patch_name_offset);
+  WriteArray(file, patch_first_source);
+  WriteArray(file, patch_ra);
+  WriteArray(file, patch_dec);
+  WriteArray(file, patch_brightness);
+  WriteArray(file, spectral_offset);
+  WriteArray(file, type);
+  WriteArray(file, flags);
+  for (const std::vector<double>* column :
+       {&ra, &dec, &stokes_i, &stokes_q, &stokes_u, &stokes_v, &major_axis,
+        &minor_axis, &orientation, &ref_freq, &polarized_fraction,
+        &polarization_angle, &rotation_measure}) {
+    WriteArray(file, *column);
+  }
+  WriteArray(file, spectral_terms);
+  WriteArray(file, std::vector<char>(names.begin(), names.end()));
+  file.close();
+  if (!file || std::rename(temporary_name.c_str(), filename.c_str()) != 0) {
+    std::remove(temporary_name.c_str());
+    throw std::runtime_error("Compiled sky model " + filename +
+                             " could not be written");
+  }
+}
+
+std::string SourceDBCompiled::PatchName(size_t patch) const {
+  return std::string(names_ + patch_name_offset_[patch],
+                     names_ + patch_name_offset_[patch + 1]);
+}
+
+size_t SourceDBCompiled::FindPatch(const std::string& patch_name) const {
+  const auto name = [this](size_t patch) {
+    return boost::string_view(
+        names_ + patch_name_offset_[patch],
+        patch_name_offset_[patch + 1] - patch_name_offset_[patch]);
+  };
+  // The patches are sorted by name, so use a binary search.
+  size_t first = 0;
+  size_t count = n_patches_;
+  while (count > 0) {
+    const size_t step = count / 2;
+    if (name(first + step) < patch_name) {
+      first += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  return first != n_patches_ && name(first) == patch_name ? first : n_patches_;
+}
+
+std::vector<std::string> SourceDBCompiled::FindPatches(
+    const std::string& pattern) const {
+  assert(!pattern.empty() && "The pattern should contain data.");
+  std::vector<std::string> result;
+  if (pattern == "*") {
+    result.reserve(n_patches_);
+    for (size_t patch = 0; patch != n_patches_; ++patch) {
+      result.push_back(PatchName(patch));
+    }
+    return result;
+  }
+
+  const casacore::Regex regex{casacore::Regex::fromPattern(pattern)};
+  for (size_t patch = 0; patch != n_patches_; ++patch) {
+    std::string name = PatchName(patch);
+    if (regex.match(name.data(), name.size()) == name.size()) {
+      result.push_back(std::move(name));
+    }
+  }
+  return result;
+}
+
+}  // namespace parmdb
+}  // namespace dp3
@@ -0,0 +1,160 @@
+// SourceDBCompiled.h: Sky model in a compact binary format that is mapped into
+// memory
+//
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DP3_PARMDB_SOURCEDBCOMPILED_H
+#define DP3_PARMDB_SOURCEDBCOMPILED_H
+
+#include "SourceInfo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dp3 {
+namespace parmdb {
+
+class SourceDBSkymodel;
+
+/// @ingroup ParmDB
+/// @{
+
+/// @brief Sky model in a compact binary format that is mapped into memory.
+///
+/// A compiled sky model is made by makesourcedb (outtype=compiled) from a
+/// text sky model. It stores the patches and sources as arrays of each
+/// property (a structure of arrays), such that opening it only requires
+/// mapping the file into memory instead of parsing text.
+///
+/// The patches are sorted by name. The sources of a patch are stored
+/// contiguously, in the order of the text sky model. Source names and
+/// shapelet information are not stored.
+///
+/// The file must be written and read on machines with the same byte order.
+class SourceDBCompiled {
+ public:
+  /// Map a compiled sky model into memory.
+  /// @throw std::runtime_error If the file can not be opened or is not a
+  /// (valid) compiled sky model.
+  explicit SourceDBCompiled(const std::string& filename);
+
+  ~SourceDBCompiled();
+
+  SourceDBCompiled(const SourceDBCompiled&) = delete;
+  SourceDBCompiled& operator=(const SourceDBCompiled&) = delete;
+
+  /// Tell if a file is a compiled sky model, by checking its header.
+  static bool IsCompiled(const std::string& filename);
+
+  /// Write the patches and sources of a sky model in compiled form.
+  static void Write(const SourceDBSkymodel& source_db,
+                    const std::string& filename);
+
+  size_t NPatches() const { return n_patches_; }
+  size_t NSources() const { return n_sources_; }
+
+  std::string PatchName(size_t patch) const;
+  double PatchRa(size_t patch) const { return patch_ra_[patch]; }
+  double PatchDec(size_t patch) const { return patch_dec_[patch]; }
+  double PatchBrightness(size_t patch) const {
+    return patch_brightness_[patch];
+  }
+
+  /// Get the index of a patch, or NPatches() if the patch does not exist.
+  size_t FindPatch(const std::string& patch_name) const;
+
+  /// Get the names of the patches that match a file name pattern, sorted.
+  std::vector<std::string> FindPatches(const std::string& pattern) const;
+
+  /// The sources of patch p have indices [FirstSource(p), FirstSource(p+1)).
+  size_t FirstSource(size_t patch) const {
+    return patch_first_source_[patch];
+  }
+
+  /// @name Source properties
+  /// Arrays with a value per source. The units are as in the text sky
+  /// model: radians for positions, arcsec for the axes and degrees for the
+  /// orientation.
+  /// @{
+  const int32_t* Type() const { return source_type_; }
+  const double* Ra() const { return source_ra_; }
+  const double* Dec() const { return source_dec_; }
+  const double* I() const { return source_i_; }
+  const double* Q() const { return source_q_; }
+  const double* U() const { return source_u_; }
+  const double* V() const { return source_v_; }
+  const double* MajorAxis() const { return source_major_axis_; }
+  const double* MinorAxis() const { return source_minor_axis_; }
+  const double* Orientation() const { return source_orientation_; }
+  const double* SpectralTermsRefFreq() const { return source_ref_freq_; }
+  const double* PolarizedFraction() const { return source_polarized_fraction_; }
+  const double* PolarizationAngle() const { return source_polarization_angle_; }
+  const double* RotationMeasure() const { return source_rotation_measure_; }
+  /// @}
+
+  bool IsJ2000(size_t source) const {
+    return source_flags_[source] & kJ2000Flag;
+  }
+  bool HasLogarithmicSI(size_t source) const {
+    return source_flags_[source] & kLogarithmicSIFlag;
+  }
+  bool UseRotationMeasure(size_t source) const {
+    return source_flags_[source] & kRotationMeasureFlag;
+  }
+
+  /// The spectral terms of a source are [SpectralTermsBegin(s),
+  /// SpectralTermsEnd(s)).
+  const double* SpectralTermsBegin(size_t source) const {
+    return spectral_terms_ + source_spectral_offset_[source];
+  }
+  const double* SpectralTermsEnd(size_t source) const {
+    return spectral_terms_ + source_spectral_offset_[source + 1];
+  }
+
+ private:
+  static constexpr uint32_t kJ2000Flag = 1;
+  static constexpr uint32_t kLogarithmicSIFlag = 2;
+  static constexpr uint32_t kRotationMeasureFlag = 4;
+
+  void* data_ = nullptr;
+  size_t size_ = 0;
+
+  size_t n_patches_ = 0;
+  size_t n_sources_ = 0;
+
+  const uint64_t* patch_name_offset_ = nullptr;
+  const uint64_t* patch_first_source_ = nullptr;
+  const double* patch_ra_ = nullptr;
+  const double* patch_dec_ = nullptr;
+  const double* patch_brightness_ = nullptr;
+
+  const uint64_t* source_spectral_offset_ = nullptr;
+  const int32_t* source_type_ = nullptr;
+  const uint32_t* source_flags_ = nullptr;
+  const double* source_ra_ = nullptr;
+  const double* source_dec_ = nullptr;
+  const double* source_i_ = nullptr;
+  const double* source_q_ = nullptr;
+  const double* source_u_ = nullptr;
+  const double* source_v_ = nullptr;
+  const double* source_major_axis_ = nullptr;
+  const double* source_minor_axis_ = nullptr;
+  const double* source_orientation_ = nullptr;
+  const double* source_ref_freq_ = nullptr;
+  const double* source_polarized_fraction_ = nullptr;
+  const double* source_polarization_angle_ = nullptr;
+  const double* source_rotation_measure_ = nullptr;
+
+  const double* spectral_terms_ = nullptr;
+  const char* names_ = nullptr;
+};
+
+/// @}
+
+}  // namespace parmdb
+}  // namespace dp3
+
+#endif
@@ -17,6 +17,10 @@
 // format  defines the format of the input file
 // append  defines if the sourcedb is created or appended (default is appended)
 // average defines if the average patch ra/dec are calculated (default is true)
+// outtype defines the type of the sourcedb: casa (default), blob, or compiled.
+//         A compiled sky model is a binary file that DP3 maps into memory,
+//         which avoids parsing large sky models at the start of each step.
+//         It is always created anew, so append is ignored.
 // center  defines the field center (ra and dec) of a search cone or box
 // radius  defines the radius if searching using a cone
 // width   defines the widths in ra and dec if searching using a box
@@ -114,7 +118,8 @@ int main(int argc, char* argv[]) {
     inputs.version("GvD 2013-May-16");
     inputs.create("in", "", "Input file name", "string");
     inputs.create("out", "", "Output sourcedb name", "string");
-    inputs.create("outtype", "casa", "Output type (casa or blob)", "string");
+    inputs.create("outtype", "casa", "Output type (casa, blob or compiled)",
+                  "string");
     inputs.create("format", "<",
                   "Format of the input lines or name of file containing format",
                   "string");
@@ -171,10 +176,17 @@ int main(int argc, char* argv[]) {
           dp3::parmdb::skymodel_to_source_db::ReadFormat(format.substr(st), in);
     }
 
-    dp3::parmdb::skymodel_to_source_db::MakeSourceDb(
-        in, out, outType, format, prefix, suffix, append, average, check,
+    const SearchInfo search_info =
         dp3::parmdb::skymodel_to_source_db::GetSearchInfo(center, radius,
-                                                          width));
+                                                          width);
+    if (outType == "compiled") {
+      dp3::parmdb::skymodel_to_source_db::MakeCompiledSourceDb(
+          in, out, format, prefix, suffix, average, check, search_info);
+    } else {
+      dp3::parmdb::skymodel_to_source_db::MakeSourceDb(
+          in, out, outType, format, prefix, suffix, append, average, check,
+          search_info);
+    }
   } catch (std::exception& x) {
     std::cerr << "Caught exception: " << x.what() << '\n';
     return 1;
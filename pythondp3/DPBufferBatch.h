@@ -0,0 +1,141 @@
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DPPP_PYDPBUFFERBATCH_H
+#define DPPP_PYDPBUFFERBATCH_H
+
+#include "../base/DPBuffer.h"
+
+#include <casacore/casa/Arrays/Array.h>
+#include <casacore/casa/Arrays/Cube.h>
+#include <casacore/casa/Arrays/Matrix.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace dp3 {
+namespace pythondp3 {
+
+/// Time slots that are passed at once to a Python step that sets a
+/// batch_size. The time slots are stacked in arrays that are allocated once
+/// and reused for every batch. Python gets numpy views on these arrays, with
+/// the time slot as first axis, so it can change the data in place.
+/// Slot() gives a DPBuffer that references a time slot, for passing the
+/// result to the next step.
+class DPBufferBatch {
+ public:
+  using Complex = base::DPBuffer::Complex;
+
+  /// Copy a time slot into the batch. The weights and UVW are only stored if
+  /// they are not empty; they should be given for all time slots of a batch
+  /// or for none of them.
+  void Add(const base::DPBuffer& buffer, const casacore::Cube<float>& weights,
+           const casacore::Matrix<double>& uvw, std::size_t capacity) {
+    const casacore::IPosition& shape = buffer.getData().shape();
+    if (size_ == 0) {
+      Allocate(shape, !weights.empty(), !uvw.empty(), capacity);
+    }
+    const std::size_t slot_size = shape.product();
+    std::copy_n(buffer.getData().data(), slot_size,
+                data_.data() + size_ * slot_size);
+    std::copy_n(buffer.getFlags().data(), slot_size,
+                flags_.data() + size_ * slot_size);
+    if (has_weights_) {
+      std::copy_n(weights.data(), slot_size,
+                  weights_.data() + size_ * slot_size);
+    }
+    if (has_uvw_) {
+      std::copy_n(uvw.data(), uvw.size(), uvw_.data() + size_ * uvw.size());
+    }
+    base::DPBuffer& slot = slots_[size_];
+    slot.setTime(buffer.getTime());
+    slot.setExposure(buffer.getExposure());
+    slot.setRowNrs(buffer.getRowNrs());
+    slot.getFullResFlags().assign(buffer.getFullResFlags());
+    ++size_;
+  }
+
+  /// Return a buffer that references time slot i of the batch.
+  base::DPBuffer& Slot(std::size_t i) {
+    const casacore::IPosition shape = data_.shape().getFirst(3);
+    const std::size_t offset = i * shape.product();
+    base::DPBuffer& slot = slots_[i];
+    slot.setData(casacore::Cube<Complex>(shape, data_.data() + offset,
+                                         casacore::SHARE));
+    slot.setFlags(casacore::Cube<bool>(shape, flags_.data() + offset,
+                                       casacore::SHARE));
+    if (has_weights_) {
+      slot.setWeights(casacore::Cube<float>(shape, weights_.data() + offset,
+                                            casacore::SHARE));
+    }
+    if (has_uvw_) {
+      const casacore::IPosition uvw_shape(2, 3, shape[2]);
+      slot.setUVW(casacore::Matrix<double>(
+          uvw_shape, uvw_.data() + i * uvw_shape.product(), casacore::SHARE));
+    }
+    return slot;
+  }
+
+  /// Number of time slots in the batch.
+  std::size_t Size() const { return size_; }
+  void Clear() { size_ = 0; }
+
+  bool HasWeights() const { return has_weights_; }
+  bool HasUvw() const { return has_uvw_; }
+
+  std::vector<double> Times() const {
+    std::vector<double> times;
+    for (std::size_t i = 0; i < size_; ++i) {
+      times.push_back(slots_[i].getTime());
+    }
+    return times;
+  }
+
+  /// Data, flags and weights have shape [ncorr, nchan, nbl, ntime] and UVW
+  /// has shape [3, nbl, ntime], where only the first Size() time slots are
+  /// filled.
+  /// @{
+  casacore::Array<Complex>& Data() { return data_; }
+  casacore::Array<bool>& Flags() { return flags_; }
+  casacore::Array<float>& Weights() { return weights_; }
+  casacore::Cube<double>& Uvw() { return uvw_; }
+  /// @}
+
+ private:
+  /// Make sure the arrays have room for the given shape and capacity. They
+  /// are only reallocated if the shape changes.
+  void Allocate(const casacore::IPosition& slot_shape, bool has_weights,
+                bool has_uvw, std::size_t capacity) {
+    const casacore::IPosition shape(4, slot_shape[0], slot_shape[1],
+                                    slot_shape[2], capacity);
+    if (data_.shape() != shape) {
+      data_.resize(shape);
+      flags_.resize(shape);
+      slots_.resize(capacity);
+    }
+    has_weights_ = has_weights;
+    if (has_weights_ && weights_.shape() != shape) {
+      weights_.resize(shape);
+    }
+    has_uvw_ = has_uvw;
+    if (has_uvw_ &&
+        uvw_.shape() != casacore::IPosition(3, 3, shape[2], capacity)) {
+      uvw_.resize(3, shape[2], capacity);
+    }
+  }
+
+  casacore::Array<Complex> data_;
+  casacore::Array<bool> flags_;
+  casacore::Array<float> weights_;
+  casacore::Cube<double> uvw_;
+  /// Metadata of the time slots; also used for passing them on.
+  std::vector<base::DPBuffer> slots_;
+  std::size_t size_ = 0;
+  bool has_weights_ = false;
+  bool has_uvw_ = false;
+};
+
+}  // namespace pythondp3
+}  // namespace dp3
+
+#endif
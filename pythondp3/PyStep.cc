@@ -36,8 +36,15 @@ void PyStepImpl::show(std::ostream& os) const {
 }
 
 void PyStepImpl::finish() {
-  pybind11::function overload = pybind11::get_overload(this, "finish");
-  if (overload) overload();  // Call the Python function.
+  if (m_batch.Size() > 0) {
+    process_batch();
+  }
+
+  {
+    pybind11::gil_scoped_acquire gil;
+    pybind11::function overload = pybind11::get_overload(this, "finish");
+    if (overload) overload();  // Call the Python function.
+  }
 
   getNextStep()->finish();
 }
@@ -45,6 +52,24 @@ void PyStepImpl::finish() {
 bool PyStepImpl::process(const DPBuffer& bufin) {
   m_count++;
 
+  if (m_batch_size > 0) {
+    // Copy the time slot straight into the batch arrays. The input may need
+    // the data and flags for reading the weights.
+    m_fetch_buffer.setData(bufin.getData());
+    m_fetch_buffer.setFlags(bufin.getFlags());
+    const casacore::Cube<float>& weights =
+        m_fetch_weights ? m_input->fetchWeights(bufin, m_fetch_buffer, m_timer)
+                        : bufin.getWeights();
+    const casacore::Matrix<double>& uvw =
+        m_fetch_uvw ? m_input->fetchUVW(bufin, m_fetch_buffer, m_timer)
+                    : bufin.getUVW();
+    m_batch.Add(bufin, weights, uvw, m_batch_size);
+    if (m_batch.Size() == m_batch_size) {
+      process_batch();
+    }
+    return true;
+  }
+
   // Make a deep copy of the buffer to make the data
   // persistent across multiple process calls
   // This is not always necessary, but for python Steps
@@ -69,6 +94,30 @@ bool PyStepImpl::process(const DPBuffer& bufin) {
   );
 }
 
+void PyStepImpl::process_batch() {
+  {
+    pybind11::gil_scoped_acquire gil;
+    pybind11::function overload =
+        pybind11::get_overload(this, "process_batch");
+    if (!overload) {
+      throw std::runtime_error(
+          "Python step sets batch_size, but does not define process_batch");
+    }
+    overload(
+        pybind11::cast(&m_batch, pybind11::return_value_policy::reference));
+  }
+
+  // The next steps do not need the GIL. Python steps acquire it themselves.
+  std::unique_ptr<pybind11::gil_scoped_release> release;
+  if (PyGILState_Check()) {
+    release.reset(new pybind11::gil_scoped_release());
+  }
+  for (size_t i = 0; i < m_batch.Size(); ++i) {
+    getNextStep()->process(m_batch.Slot(i));
+  }
+  m_batch.Clear();
+}
+
 void PyStepImpl::updateInfo(const DPInfo& dpinfo) {
   PYBIND11_OVERLOAD_NAME(void,          /* Return type */
                          StepWrapper,   /* Parent class */
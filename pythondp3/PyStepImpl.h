@@ -5,6 +5,7 @@
 #define DPPP_PYDPSTEPIMPL_H
 
 #include "PyStep.h"
+#include "DPBufferBatch.h"
 #include "../steps/InputStep.h"
 
 #include <memory>
@@ -51,6 +52,9 @@ class StepWrapper : public steps::Step {
 
   bool m_fetch_uvw = false;
   bool m_fetch_weights = false;
+  /// If nonzero, process_batch is called with this many time slots at once,
+  /// instead of calling process for each time slot.
+  size_t m_batch_size = 0;
 
  protected:
   int m_count = 0;
@@ -78,6 +82,12 @@ class PyStepImpl final : public StepWrapper {
   void release();
 
  private:
+  /// Let Python process the batch in place and pass its time slots to the
+  /// next step.
+  void process_batch();
+
+  DPBufferBatch m_batch;
+  base::DPBuffer m_fetch_buffer;
   // See the comment above near the forward declaration of pybind11::object.
   std::unique_ptr<pybind11::object> m_py_object;
 };
@@ -1,5 +1,14 @@
 # Copyright (C) 2020 ASTRON (Netherlands Institute for Radio Astronomy)
 # SPDX-License-Identifier: GPL-3.0-or-later
 
-from . import parameterset
-from .pydp3 import *
+try:
+    from . import parameterset
+    from .pydp3 import *
+except ImportError as error:
+    # These modules use symbols from the DP3 executable, so they can only be
+    # loaded by a Python step that DP3 runs. Outside DP3, only the pipeline
+    # module is available. Any other import error is a real problem.
+    message = str(error)
+    if "undefined symbol" not in message and "Symbol not found" not in message:
+        raise
+    del message
@@ -0,0 +1,189 @@
+// pipeline.cc: python bindings to run DP3 steps on in-memory data
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../base/MemoryPipeline.h"
+#include "../common/ParameterSet.h"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <casacore/measures/Measures/MDirection.h>
+#include <casacore/measures/Measures/MPosition.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using dp3::base::DPBuffer;
+using dp3::base::DPInfo;
+using dp3::base::MemoryPipeline;
+
+namespace py = pybind11;
+
+namespace dp3 {
+namespace pythondp3 {
+
+namespace {
+
+std::unique_ptr<MemoryPipeline> make_pipeline(
+    const std::map<std::string, std::string> &parset_values,
+    const std::vector<std::string> &antenna_names,
+    const std::vector<std::array<double, 3>> &antenna_positions,
+    const std::vector<int> &antenna1, const std::vector<int> &antenna2,
+    std::vector<double> channel_frequencies,
+    std::vector<double> channel_widths, double start_time,
+    double time_interval, unsigned int n_times, unsigned int n_correlations,
+    const std::vector<double> &phase_center) {
+  common::ParameterSet parset;
+  for (const std::pair<const std::string, std::string> &value :
+       parset_values) {
+    parset.add(value.first, value.second);
+  }
+
+  DPInfo info;
+  info.init(n_correlations, 0, channel_frequencies.size(), n_times,
+            start_time, time_interval, "", "");
+  std::vector<casacore::MPosition> positions;
+  for (const std::array<double, 3> &position : antenna_positions) {
+    positions.emplace_back(
+        casacore::MVPosition(position[0], position[1], position[2]),
+        casacore::MPosition::ITRF);
+  }
+  casacore::Vector<casacore::String> names(antenna_names.size());
+  std::copy(antenna_names.begin(), antenna_names.end(), names.begin());
+  info.set(names, casacore::Vector<casacore::Double>(names.size(), 0.0),
+           positions, casacore::Vector<casacore::Int>(antenna1),
+           casacore::Vector<casacore::Int>(antenna2));
+  info.set(std::move(channel_frequencies), std::move(channel_widths));
+  if (!phase_center.empty()) {
+    if (phase_center.size() != 2 || positions.empty()) {
+      throw std::invalid_argument(
+          "phase_center should be [ra, dec] and requires antenna positions");
+    }
+    const casacore::MDirection direction(
+        casacore::MVDirection(phase_center[0], phase_center[1]),
+        casacore::MDirection::J2000);
+    info.set(positions.front(), direction, direction, direction);
+  }
+
+  return std::unique_ptr<MemoryPipeline>(new MemoryPipeline(parset, info));
+}
+
+/// Copy a numpy array with shape @p shape (in C order) into @p cube, which
+/// gets the reverse (casacore) shape.
+template <typename T>
+void copy_to_cube(const py::array_t<T, py::array::c_style |
+                                            py::array::forcecast> &array,
+                  const casacore::IPosition &shape,
+                  casacore::Array<T> &cube) {
+  if (static_cast<size_t>(array.ndim()) != shape.size()) {
+    throw std::invalid_argument("Array has the wrong number of dimensions");
+  }
+  for (size_t i = 0; i < shape.size(); ++i) {
+    if (array.shape(i) != shape[shape.size() - 1 - i]) {
+      throw std::invalid_argument("Array has the wrong shape");
+    }
+  }
+  cube.resize(shape);
+  std::copy_n(array.data(), cube.size(), cube.data());
+}
+
+/// Return a numpy copy of a casacore array, with the reverse shape.
+template <typename T>
+py::array_t<T> to_numpy(const casacore::Array<T> &array) {
+  std::vector<py::ssize_t> shape(array.shape().rbegin(),
+                                 array.shape().rend());
+  return py::array_t<T>(shape, array.data());
+}
+
+}  // namespace
+
+PYBIND11_MODULE(pipeline, m) {
+  m.doc() =
+      "Run DP3 steps on in-memory data, without reading or writing a "
+      "MeasurementSet";
+
+  py::class_<MemoryPipeline>(m, "Pipeline")
+      .def(py::init(&make_pipeline), py::arg("parset"),
+           py::arg("antenna_names"), py::arg("antenna_positions"),
+           py::arg("antenna1"), py::arg("antenna2"),
+           py::arg("channel_frequencies"), py::arg("channel_widths"),
+           py::arg("start_time"), py::arg("time_interval"),
+           py::arg("n_times"), py::arg("n_correlations") = 4,
+           py::arg("phase_center") = std::vector<double>(),
+           "Create the steps given by the 'steps' key of the parset, which "
+           "is a dictionary with parset keys and values (as strings). The "
+           "other arguments describe the input data: antenna positions are "
+           "ITRF XYZ coordinates, the phase center is [ra, dec] in J2000 "
+           "(radians).")
+      .def(
+          "process",
+          [](MemoryPipeline &self, double time,
+             const py::array_t<casacore::Complex, py::array::c_style |
+                                                      py::array::forcecast>
+                 &data,
+             const py::array_t<bool, py::array::c_style |
+                                         py::array::forcecast> &flags,
+             const py::array_t<float, py::array::c_style |
+                                          py::array::forcecast> &weights,
+             const py::array_t<double, py::array::c_style |
+                                           py::array::forcecast> &uvw) {
+            const DPInfo &info = self.getInputInfo();
+            DPBuffer buffer(time, info.timeInterval());
+            const casacore::IPosition shape(3, info.ncorr(), info.nchan(),
+                                            info.nbaselines());
+            copy_to_cube(data, shape, buffer.getData());
+            copy_to_cube(flags, shape, buffer.getFlags());
+            copy_to_cube(weights, shape, buffer.getWeights());
+            copy_to_cube(uvw, casacore::IPosition(2, 3, info.nbaselines()),
+                         buffer.getUVW());
+            // The steps do not use Python, so let other threads run.
+            py::gil_scoped_release release;
+            self.process(buffer);
+          },
+          py::arg("time"), py::arg("data"), py::arg("flags"),
+          py::arg("weights"), py::arg("uvw"),
+          "Process a time slot. data, flags and weights have shape (nr "
+          "baselines, nr channels, nr correlations); uvw has shape (nr "
+          "baselines, 3).")
+      .def("finish", &MemoryPipeline::finish,
+           py::call_guard<py::gil_scoped_release>(),
+           "Finish the processing, which flushes the time slots that steps "
+           "still hold")
+      .def(
+          "get_results",
+          [](MemoryPipeline &self) {
+            py::list results;
+            for (size_t i = 0; i < self.nResults(); ++i) {
+              const DPBuffer &buffer = self.getResults()[i];
+              py::dict result;
+              result["time"] = buffer.getTime();
+              result["data"] = to_numpy(buffer.getData());
+              result["flags"] = to_numpy(buffer.getFlags());
+              result["weights"] = to_numpy(buffer.getWeights());
+              result["uvw"] = to_numpy(buffer.getUVW());
+              results.append(result);
+            }
+            self.clearResults();
+            return results;
+          },
+          "Get the output time slots since the previous call, as a list of "
+          "dictionaries with time, data, flags, weights and uvw")
+      .def(
+          "show",
+          [](const MemoryPipeline &self) {
+            std::ostringstream os;
+            self.show(os);
+            return os.str();
+          },
+          "Get a description of the steps and their parameters");
+}
+
+}  // namespace pythondp3
+}  // namespace dp3
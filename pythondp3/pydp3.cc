@@ -70,6 +70,16 @@ void register_vector(py::module &m, const char *name) {
       });
 }
 
+/// Numpy view on the first batch.Size() time slots of a batch array, with the
+/// time slot as first axis. The view keeps the Python batch object alive.
+template <typename T>
+py::array batch_view(py::object batch_object, T *data,
+                     std::vector<py::ssize_t> shape) {
+  DPBufferBatch &batch = batch_object.cast<DPBufferBatch &>();
+  shape.insert(shape.begin(), batch.Size());
+  return py::array_t<T>(shape, data, batch_object);
+}
+
 PYBIND11_MODULE(pydp3, m) {
   m.doc() = "pybind11 example plugin";  // optional module docstring
 
@@ -97,13 +107,69 @@ PYBIND11_MODULE(pydp3, m) {
       .def("get_next_step", &StepWrapper::get_next_step,
            py::return_value_policy::copy, "Get a reference to the next step")
       .def("process_next_step", &StepWrapper::process_next_step,
-           "Process the next step")
+           py::call_guard<py::gil_scoped_release>(),
+           "Process the next step (the GIL is released while it runs)")
       .def("get_count", &StepWrapper::get_count,
            "Get the number of time slots processed")
       .def_readwrite("fetch_uvw", &StepWrapper::m_fetch_uvw,
                      "Fill the UVW data in the buffer")
       .def_readwrite("fetch_weights", &StepWrapper::m_fetch_weights,
-                     "Fill the weights data in the buffer");
+                     "Fill the weights data in the buffer")
+      .def_readwrite("batch_size", &StepWrapper::m_batch_size,
+                     "If nonzero, call process_batch with this many time "
+                     "slots at once instead of process for each time slot. "
+                     "The time slots are passed to the next step after "
+                     "process_batch returns.");
+
+  py::class_<DPBufferBatch>(m, "DPBufferBatch")
+      .def("size", &DPBufferBatch::Size,
+           "Get the number of time slots in the batch")
+      .def("get_times", &DPBufferBatch::Times,
+           "Get the times of the time slots")
+      .def(
+          "get_data",
+          [](py::object self) {
+            DPBufferBatch &batch = self.cast<DPBufferBatch &>();
+            const casacore::IPosition &shape = batch.Data().shape();
+            return batch_view(self, batch.Data().data(),
+                              {shape[2], shape[1], shape[0]});
+          },
+          "Get a numpy view on the data, which can be changed in place. "
+          "Shape is (nr times, nr baselines, nr channels, nr polarizations)")
+      .def(
+          "get_flags",
+          [](py::object self) {
+            DPBufferBatch &batch = self.cast<DPBufferBatch &>();
+            const casacore::IPosition &shape = batch.Flags().shape();
+            return batch_view(self, batch.Flags().data(),
+                              {shape[2], shape[1], shape[0]});
+          },
+          "Get a numpy view on the flags, with the same shape as the data")
+      .def(
+          "get_weights",
+          [](py::object self) {
+            DPBufferBatch &batch = self.cast<DPBufferBatch &>();
+            if (!batch.HasWeights()) {
+              throw std::runtime_error(
+                  "The batch has no weights; set fetch_weights");
+            }
+            const casacore::IPosition &shape = batch.Weights().shape();
+            return batch_view(self, batch.Weights().data(),
+                              {shape[2], shape[1], shape[0]});
+          },
+          "Get a numpy view on the weights, with the same shape as the data")
+      .def(
+          "get_uvw",
+          [](py::object self) {
+            DPBufferBatch &batch = self.cast<DPBufferBatch &>();
+            if (!batch.HasUvw()) {
+              throw std::runtime_error("The batch has no UVW; set fetch_uvw");
+            }
+            const casacore::IPosition &shape = batch.Uvw().shape();
+            return batch_view(self, batch.Uvw().data(), {shape[1], shape[0]});
+          },
+          "Get a numpy view on the UVW coordinates. Shape is "
+          "(nr times, nr baselines, 3)");
 
   py::class_<DPBuffer, std::shared_ptr<DPBuffer>>(m, "DPBuffer")
       .def(py::init<>())
@@ -156,7 +222,8 @@ PYBIND11_MODULE(pydp3, m) {
             return ret;
           },
           "Get a list of antenna positions in ITRF XYZ (read only)")
-      .def("set_need_vis_data", &DPInfo::setNeedVisData,
+      .def("set_need_vis_data",
+           static_cast<void (DPInfo::*)()>(&DPInfo::setNeedVisData),
            "Set whether data needs to be read before this step")
       .def("set_write_data", &DPInfo::setWriteData,
            "Set whether data needs to be written after this step")
@@ -12,6 +12,7 @@
 #include "ApplyBeam.h"
 #include "ApplyCal.h"
 // for matrix inversion
+#include "../base/BeamResponseCache.h"
 #include "../base/DPInfo.h"
 #include "../base/Exceptions.h"
 #include "../base/FlagCounter.h"
@@ -29,7 +30,9 @@
 
 #include <aocommon/matrix2x2diag.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <ostream>
 #include <stddef.h>
 #include <string>
@@ -61,7 +64,13 @@ ApplyBeam::ApplyBeam(InputStep* input, const common::ParameterSet& parset,
       itsMode(everybeam::ParseCorrectionMode(
           parset.getString(prefix + "beammode", "default"))),
       itsModeAtStart(everybeam::CorrectionMode::kNone),
-      itsDebugLevel(parset.getInt(prefix + "debuglevel", 0)) {
+      itsDebugLevel(parset.getInt(prefix + "debuglevel", 0)),
+      itsUpdateInterval(parset.getDouble(prefix + "updateinterval", 0.0)),
+      itsBeamCacheContext(0),
+      itsParallelFor(1),
+      itsGridStart(0.0),
+      itsNEvaluations(0),
+      itsMaxInterpolationError(0.0) {
   // only read 'invert' parset key if it is a separate step
   // if applybeam is called from gaincal/predict, the invert key should always
   // be false
@@ -70,6 +79,9 @@ ApplyBeam::ApplyBeam(InputStep* input, const common::ParameterSet& parset,
   } else {
     itsInvert = parset.getBool(prefix + "invert", true);
   }
+  if (itsUpdateInterval < 0.0) {
+    throw Exception("ApplyBeam updateinterval should not be negative");
+  }
 
   string element_model = boost::to_lower_copy(
       parset.getString(prefix + "elementmodel", "hamaker"));
@@ -88,7 +100,13 @@ ApplyBeam::ApplyBeam(InputStep* input, const common::ParameterSet& parset,
   }
 }
 
-ApplyBeam::ApplyBeam() {}
+ApplyBeam::ApplyBeam()
+    : itsUpdateInterval(0.0),
+      itsBeamCacheContext(0),
+      itsParallelFor(1),
+      itsGridStart(0.0),
+      itsNEvaluations(0),
+      itsMaxInterpolationError(0.0) {}
 
 ApplyBeam::~ApplyBeam() {}
 
@@ -151,29 +169,23 @@ void ApplyBeam::updateInfo(const DPInfo& infoIn) {
     info().setBeamCorrectionMode(everybeam::CorrectionMode::kNone);
   }
 
-  const size_t nSt = info().nantenna();
-  const size_t nCh = info().nchan();
-
-  const size_t nThreads = getInfo().nThreads();
-  itsBeamValues.resize(nThreads);
+  itsParallelFor.SetNThreads(getInfo().nThreads());
 
   // Create the Measure ITRF conversion info given the array position.
   // The time and direction are filled in later.
-  itsMeasConverters.resize(nThreads);
-  itsMeasFrames.resize(nThreads);
-  telescopes_.resize(nThreads);
-
-  for (size_t thread = 0; thread < nThreads; ++thread) {
-    itsBeamValues[thread].resize(nSt * nCh);
-    itsMeasFrames[thread].set(info().arrayPosCopy());
-    itsMeasFrames[thread].set(
-        MEpoch(MVEpoch(info().startTime() / 86400), MEpoch::UTC));
-    itsMeasConverters[thread].set(
-        MDirection::J2000,
-        MDirection::Ref(MDirection::ITRF, itsMeasFrames[thread]));
-    telescopes_[thread] =
-        itsInput->GetTelescope(itsElementResponseModel, itsUseChannelFreq);
-  }
+  itsMeasFrame.set(info().arrayPosCopy());
+  itsMeasFrame.set(MEpoch(MVEpoch(info().startTime() / 86400), MEpoch::UTC));
+  itsMeasConverter.set(MDirection::J2000,
+                       MDirection::Ref(MDirection::ITRF, itsMeasFrame));
+  itsTelescope =
+      itsInput->GetTelescope(itsElementResponseModel, itsUseChannelFreq);
+  itsStationIndices = InputStep::SelectStationIndices(itsTelescope.get(),
+                                                      info().antennaNames());
+  itsBeamCacheContext = base::BeamResponseCache::Instance().GetContext(
+      base::BeamResponseCache::MakeContextDescription(
+          itsInput->msName(), itsElementResponseModel, itsUseChannelFreq,
+          info().antennaNames(), info().chanFreqs()));
+  itsGridStart = info().startTime();
 }
 
 void ApplyBeam::show(std::ostream& os) const {
@@ -183,6 +195,11 @@ void ApplyBeam::show(std::ostream& os) const {
      << "  direction:         " << itsDirectionStr << '\n'
      << "  invert:            " << std::boolalpha << itsInvert << '\n'
      << "  update weights:    " << std::boolalpha << itsUpdateWeights << '\n';
+  if (itsUpdateInterval > 0.0) {
+    os << "  update interval:   " << itsUpdateInterval << " s\n";
+  } else {
+    os << "  update interval:   every time slot\n";
+  }
   if (itsInvert) {
     if (itsModeAtStart != everybeam::CorrectionMode::kNone)
       os << "  input data has already a beam correction applied: will be "
@@ -192,13 +209,22 @@ void ApplyBeam::show(std::ostream& os) const {
   }
 }
 
+void ApplyBeam::showCounts(std::ostream& os) const {
+  os << "\nApplyBeam " << itsName << '\n'
+     << "  beam evaluations:  " << itsNEvaluations << '\n';
+  if (itsUpdateInterval > 0.0) {
+    os << "  max. estimated relative interpolation error: "
+       << itsMaxInterpolationError << '\n';
+  }
+}
+
 void ApplyBeam::showTimings(std::ostream& os, double duration) const {
   os << "  ";
   base::FlagCounter::showPerc1(os, itsTimer.getElapsed(), duration);
   os << " ApplyBeam " << itsName << '\n';
 }
 
-bool ApplyBeam::processMultithreaded(const DPBuffer& bufin, size_t thread) {
+bool ApplyBeam::process(const DPBuffer& bufin) {
   itsTimer.start();
   itsBuffer.copy(bufin);
   casacore::Complex* data = itsBuffer.getData().data();
@@ -209,50 +235,122 @@ bool ApplyBeam::processMultithreaded(const DPBuffer& bufin, size_t thread) {
   float* weight = itsBuffer.getWeights().data();
 
   const double time = itsBuffer.getTime();
+  const size_t nBl = info().nbaselines();
 
-  // Set up directions for beam evaluation
-  everybeam::vector3r_t srcdir;
-
-  /**
-   * I'm not sure this is correct the way it is. These loops
-   * seem to initialize variables that are never used in a
-   * multi-threaded way, and if they were used from multiple
-   * threads, it would imply process() is called multiple times,
-   * and hence this initialization is already subject to a race
-   * condition... ???
-   * André, 2018-10-07
-   */
-  bool undoInputBeam =
-      itsInvert && itsModeAtStart != everybeam::CorrectionMode::kNone;
-  for (size_t threadIter = 0; threadIter < getInfo().nThreads(); ++threadIter) {
-    itsMeasFrames[threadIter].resetEpoch(
-        MEpoch(MVEpoch(time / 86400), MEpoch::UTC));
-    // Do a conversion on all threads, because converters are not
-    // thread safe and apparently need to be used at least once
-    if (undoInputBeam)
-      srcdir = dir2Itrf(itsDirectionAtStart, itsMeasConverters[threadIter]);
-    else
-      srcdir = dir2Itrf(itsDirection, itsMeasConverters[threadIter]);
-  }
-
-  if (undoInputBeam) {
+  if (itsInvert && itsModeAtStart != everybeam::CorrectionMode::kNone) {
     // A beam was previously applied to this MS, and a different direction
     // was asked this time. 'Undo' applying the input beam.
     // TODO itsElementResponseModel should be read from the measurement set
     // instead of assumed to be the same from the target beam.
-    applyBeam(info(), time, data, weight, srcdir, telescopes_[thread].get(),
-              itsBeamValues[thread], false, itsModeAtStart, itsUpdateWeights);
-    srcdir = dir2Itrf(itsDirection, itsMeasConverters[thread]);
+    const std::vector<aocommon::MC2x2>& undoValues = getBeamValues(
+        time, itsDirectionAtStart, itsModeAtStart, false, itsUndoCache);
+    itsParallelFor.Run(0, nBl, [&](size_t bl, size_t) {
+      applyBaseline(info(), bl, data, weight, undoValues, itsUpdateWeights);
+    });
   }
 
-  applyBeam(info(), time, data, weight, srcdir, telescopes_[thread].get(),
-            itsBeamValues[thread], itsInvert, itsMode, itsUpdateWeights);
+  const std::vector<aocommon::MC2x2>& values =
+      getBeamValues(time, itsDirection, itsMode, itsInvert, itsCache);
+  itsParallelFor.Run(0, nBl, [&](size_t bl, size_t) {
+    applyBaseline(info(), bl, data, weight, values, itsUpdateWeights);
+  });
 
   itsTimer.stop();
   getNextStep()->process(itsBuffer);
   return false;
 }
 
+const std::vector<aocommon::MC2x2>& ApplyBeam::getBeamValues(
+    double time, const MDirection& direction, everybeam::CorrectionMode mode,
+    bool invert, BeamCache& cache) {
+  if (itsUpdateInterval <= 0.0) {
+    evaluateBeam(time, direction, mode, invert, cache.interpolated);
+    return cache.interpolated;
+  }
+
+  const double position = (time - itsGridStart) / itsUpdateInterval;
+  const long index = std::floor(position);
+  if (cache.index >= 0 && index == cache.index + 1) {
+    // Move one grid point forward; only the next one has to be evaluated.
+    std::swap(cache.previous, cache.values);
+    std::swap(cache.values, cache.next);
+    cache.hasPrevious = true;
+    evaluateBeam(itsGridStart + (index + 1) * itsUpdateInterval, direction,
+                 mode, invert, cache.next);
+  } else if (index != cache.index || cache.values.empty()) {
+    cache.hasPrevious = false;
+    evaluateBeam(itsGridStart + index * itsUpdateInterval, direction, mode,
+                 invert, cache.values);
+    evaluateBeam(itsGridStart + (index + 1) * itsUpdateInterval, direction,
+                 mode, invert, cache.next);
+  }
+
+  if (cache.hasPrevious && index != cache.index) {
+    // The error of linear interpolation is at most 1/8 of the second
+    // difference of the values on the grid.
+    for (size_t i = 0; i < cache.values.size(); ++i) {
+      double secondDiff = 0.0;
+      double norm = 0.0;
+      for (size_t j = 0; j < 4; ++j) {
+        secondDiff += std::norm(cache.previous[i][j] -
+                                2.0 * cache.values[i][j] + cache.next[i][j]);
+        norm += std::norm(cache.values[i][j]);
+      }
+      if (norm > 0.0) {
+        itsMaxInterpolationError = std::max(
+            itsMaxInterpolationError, std::sqrt(secondDiff / norm) / 8.0);
+      }
+    }
+  }
+  cache.index = index;
+
+  const double weight = position - index;
+  cache.interpolated.resize(cache.values.size());
+  for (size_t i = 0; i < cache.values.size(); ++i) {
+    cache.interpolated[i] =
+        cache.values[i] * (1.0 - weight) + cache.next[i] * weight;
+  }
+  return cache.interpolated;
+}
+
+void ApplyBeam::evaluateBeam(double time, const MDirection& direction,
+                             everybeam::CorrectionMode mode, bool invert,
+                             std::vector<aocommon::MC2x2>& values) {
+  const base::BeamResponseCache::Evaluator evaluate =
+      [&](double evaluationTime, std::vector<aocommon::MC2x2>& result) {
+        itsMeasFrame.resetEpoch(
+            MEpoch(MVEpoch(evaluationTime / 86400), MEpoch::UTC));
+        const everybeam::vector3r_t srcdir =
+            dir2Itrf(direction, itsMeasConverter);
+
+        const size_t nSt = info().nantenna();
+        const std::vector<double>& freqs = info().chanFreqs();
+        const size_t nCh = freqs.size();
+        result.resize(nSt * nCh);
+
+        // Every thread gets its own point response.
+        std::vector<std::unique_ptr<everybeam::pointresponse::PointResponse>>
+            pointResponses(itsParallelFor.NThreads());
+        for (std::unique_ptr<everybeam::pointresponse::PointResponse>&
+                 response : pointResponses) {
+          response = itsTelescope->GetPointResponse(evaluationTime);
+        }
+        itsParallelFor.Run(0, nSt * nCh, [&](size_t i, size_t thread) {
+          result[i] = beamValue(*pointResponses[thread], mode,
+                                itsStationIndices[i / nCh], freqs[i % nCh],
+                                srcdir, &itsMutex);
+        });
+        ++itsNEvaluations;
+      };
+  base::BeamResponseCache::Instance().Get(itsBeamCacheContext, mode, direction,
+                                          time, evaluate, values);
+  if (invert) {
+    for (aocommon::MC2x2& value : values) {
+      invertBeamValue(value, mode);
+    }
+  }
+}
+
 everybeam::vector3r_t ApplyBeam::dir2Itrf(const MDirection& dir,
                                           MDirection::Convert& measConverter) {
   const MDirection& itrfDir = measConverter(dir);
@@ -277,7 +375,6 @@ void ApplyBeam::applyBeam(const DPInfo& info, double time, T* data0,
   // Get the beam values for each station.
   const size_t nCh = info.chanFreqs().size();
   const size_t nSt = beamValues.size() / nCh;
-  const size_t nBl = info.nbaselines();
 
   std::unique_ptr<everybeam::pointresponse::PointResponse> point_response =
       telescope->GetPointResponse(time);
@@ -285,59 +382,108 @@ void ApplyBeam::applyBeam(const DPInfo& info, double time, T* data0,
   const std::vector<size_t> station_indices =
       InputStep::SelectStationIndices(telescope, info.antennaNames());
 
-  // Apply the beam values of both stations to the ApplyBeamed data.
-  for (size_t ch = 0; ch < nCh; ++ch) {
-    switch (mode) {
-      case everybeam::CorrectionMode::kFull:
-      case everybeam::CorrectionMode::kElement:
-        // Fill beamValues for channel ch
-        for (size_t st = 0; st < nSt; ++st) {
-          beamValues[nCh * st + ch] = point_response->Response(
-              mode, station_indices[st], info.chanFreqs()[ch], srcdir, mutex);
-          if (invert) {
-            beamValues[nCh * st + ch].Invert();
-          }
-        }
-        break;
-      case everybeam::CorrectionMode::kArrayFactor: {
-        aocommon::MC2x2 af_tmp;
-        // Fill beamValues for channel ch
-        for (size_t st = 0; st < nSt; ++st) {
-          af_tmp = point_response->Response(
-              mode, station_indices[st], info.chanFreqs()[ch], srcdir, mutex);
-
-          if (invert) {
-            af_tmp[0] = 1. / af_tmp[0];
-            af_tmp[3] = 1. / af_tmp[3];
-          }
-          beamValues[nCh * st + ch] = af_tmp;
-        }
-        break;
+  // Fill beamValues for all stations and channels.
+  for (size_t st = 0; st < nSt; ++st) {
+    for (size_t ch = 0; ch < nCh; ++ch) {
+      beamValues[nCh * st + ch] =
+          beamValue(*point_response, mode, station_indices[st],
+                    info.chanFreqs()[ch], srcdir, mutex);
+      if (invert) {
+        invertBeamValue(beamValues[nCh * st + ch], mode);
       }
-      case everybeam::CorrectionMode::kNone:  // this should not happen
-        for (size_t st = 0; st < nSt; ++st) {
-          beamValues[nCh * st + ch] = aocommon::MC2x2::Unity();
-        }
-        break;
     }
+  }
 
-    // Apply beam for channel ch on all baselines
-    // For mode=ARRAY_FACTOR, too much work is done here because we know
-    // that r and l are diagonal
-    for (size_t bl = 0; bl < nBl; ++bl) {
-      T* data = data0 + bl * 4 * nCh + ch * 4;
-      const aocommon::MC2x2F mat(data);
-      //
-      const aocommon::MC2x2F left(
-          beamValues[nCh * info.getAnt1()[bl] + ch].Data());
-      const aocommon::MC2x2F right(
-          beamValues[nCh * info.getAnt2()[bl] + ch].Data());
-      const aocommon::MC2x2F result = left.Multiply(mat).MultiplyHerm(right);
-      result.AssignTo(data);
-      if (doUpdateWeights) {
-        ApplyCal::applyWeights(left.Data(), right.Data(),
-                               weight0 + bl * 4 * nCh + ch * 4);
-      }
+  applyBeamValues(info, data0, weight0, beamValues, doUpdateWeights);
+}
+
+aocommon::MC2x2 ApplyBeam::beamValue(
+    everybeam::pointresponse::PointResponse& pointResponse,
+    everybeam::CorrectionMode mode, size_t station, double frequency,
+    const everybeam::vector3r_t& srcdir, std::mutex* mutex) {
+  if (mode == everybeam::CorrectionMode::kNone) {  // this should not happen
+    return aocommon::MC2x2::Unity();
+  }
+  return pointResponse.Response(mode, station, frequency, srcdir, mutex);
+}
+
+void ApplyBeam::invertBeamValue(aocommon::MC2x2& value,
+                                everybeam::CorrectionMode mode) {
+  switch (mode) {
+    case everybeam::CorrectionMode::kFull:
+    case everybeam::CorrectionMode::kElement:
+      value.Invert();
+      break;
+    case everybeam::CorrectionMode::kArrayFactor:
+      value[0] = 1. / value[0];
+      value[3] = 1. / value[3];
+      break;
+    case everybeam::CorrectionMode::kNone:
+      break;
+  }
+}
+
+template <typename T>
+void ApplyBeam::applyBeamValues(const DPInfo& info, T* data0, float* weight0,
+                                const std::vector<aocommon::MC2x2>& beamValues,
+                                bool doUpdateWeights) {
+  for (size_t bl = 0; bl < info.nbaselines(); ++bl) {
+    applyBaseline(info, bl, data0, weight0, beamValues, doUpdateWeights);
+  }
+}
+
+template void ApplyBeam::applyBeamValues(
+    const DPInfo& info, std::complex<double>* data0, float* weight0,
+    const std::vector<aocommon::MC2x2>& beamValues, bool doUpdateWeights);
+
+template void ApplyBeam::applyBeamValues(
+    const DPInfo& info, std::complex<float>* data0, float* weight0,
+    const std::vector<aocommon::MC2x2>& beamValues, bool doUpdateWeights);
+
+template <typename T>
+void ApplyBeam::applyBeamValuesStokesI(
+    const DPInfo& info, T* data0,
+    const std::vector<aocommon::MC2x2>& beamValues) {
+  const size_t nCh = info.chanFreqs().size();
+  for (size_t bl = 0; bl < info.nbaselines(); ++bl) {
+    const aocommon::MC2x2* left = &beamValues[nCh * info.getAnt1()[bl]];
+    const aocommon::MC2x2* right = &beamValues[nCh * info.getAnt2()[bl]];
+    for (size_t ch = 0; ch < nCh; ++ch) {
+      T* data = data0 + bl * nCh + ch;
+      data[0] =
+          left[ch][0] * std::complex<double>(data[0]) * std::conj(right[ch][0]);
+    }
+  }
+}
+
+template void ApplyBeam::applyBeamValuesStokesI(
+    const DPInfo& info, std::complex<double>* data0,
+    const std::vector<aocommon::MC2x2>& beamValues);
+
+template void ApplyBeam::applyBeamValuesStokesI(
+    const DPInfo& info, std::complex<float>* data0,
+    const std::vector<aocommon::MC2x2>& beamValues);
+
+template <typename T>
+void ApplyBeam::applyBaseline(const DPInfo& info, size_t baseline, T* data0,
+                              float* weight0,
+                              const std::vector<aocommon::MC2x2>& beamValues,
+                              bool doUpdateWeights) {
+  const size_t nCh = info.chanFreqs().size();
+  const size_t ant1 = info.getAnt1()[baseline];
+  const size_t ant2 = info.getAnt2()[baseline];
+  // For mode=ARRAY_FACTOR, too much work is done here because we know
+  // that r and l are diagonal
+  for (size_t ch = 0; ch < nCh; ++ch) {
+    T* data = data0 + baseline * 4 * nCh + ch * 4;
+    const aocommon::MC2x2F mat(data);
+    const aocommon::MC2x2F left(beamValues[nCh * ant1 + ch].Data());
+    const aocommon::MC2x2F right(beamValues[nCh * ant2 + ch].Data());
+    const aocommon::MC2x2F result = left.Multiply(mat).MultiplyHerm(right);
+    result.AssignTo(data);
+    if (doUpdateWeights) {
+      ApplyCal::applyWeights(left.Data(), right.Data(),
+                             weight0 + baseline * 4 * nCh + ch * 4);
     }
   }
 }
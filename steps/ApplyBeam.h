@@ -13,11 +13,19 @@
 
 #include "../base/DPBuffer.h"
 
+#include <EveryBeam/pointresponse/pointresponse.h>
 #include <EveryBeam/telescope/telescope.h>
 #include <aocommon/matrix2x2.h>
+#include <aocommon/parallelfor.h>
 
 #include <casacore/casa/Arrays/Cube.h>
 #include <casacore/measures/Measures/MDirection.h>
+#include <casacore/measures/Measures/MeasConvert.h>
+#include <casacore/measures/Measures/MeasFrame.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace dp3 {
 namespace common {
@@ -31,6 +39,11 @@ namespace steps {
 /// This class is a Step class to apply the beam model, optionally inverted.
 /// The input MeasurementSet it operates on, must have the LOFAR subtables
 /// defining the station layout and tiles/dipoles used.
+///
+/// The beam responses of the stations and channels are evaluated in parallel
+/// by the threads of the step. Because the beam changes slowly, the responses
+/// can be evaluated on a coarser time grid (parset key updateinterval), in
+/// which case the Jones matrices are linearly interpolated in between.
 
 class ApplyBeam : public Step {
  public:
@@ -46,13 +59,7 @@ class ApplyBeam : public Step {
   /// Process the data.
   /// It keeps the data.
   /// When processed, it invokes the process function of the next step.
-  virtual bool process(const base::DPBuffer& buffer) {
-    return processMultithreaded(buffer, 0);
-  }
-
-  /// If apply beam is called from multiple threads, it needs the thread index
-  /// to determine what scratch space to use etc.
-  bool processMultithreaded(const base::DPBuffer&, size_t thread);
+  virtual bool process(const base::DPBuffer&);
 
   /// Finish the processing of this step and subsequent steps.
   virtual void finish();
@@ -63,6 +70,9 @@ class ApplyBeam : public Step {
   /// Show the step parameters.
   virtual void show(std::ostream&) const;
 
+  /// Show the number of beam evaluations and the interpolation error.
+  virtual void showCounts(std::ostream&) const;
+
   /// Show the timings.
   virtual void showTimings(std::ostream&, double duration) const;
 
@@ -85,10 +95,67 @@ class ApplyBeam : public Step {
       std::vector<everybeam::complex_t>& beamValues, bool invert,
       everybeam::CorrectionMode mode, std::mutex* mutex = nullptr);
 
+  /// Get the beam value of a single station and channel.
+  static aocommon::MC2x2 beamValue(
+      everybeam::pointresponse::PointResponse& pointResponse,
+      everybeam::CorrectionMode mode, size_t station, double frequency,
+      const everybeam::vector3r_t& srcdir, std::mutex* mutex);
+
+  /// Invert a beam value that was obtained with the given mode.
+  static void invertBeamValue(aocommon::MC2x2& value,
+                              everybeam::CorrectionMode mode);
+
+  /// Apply beam values, with index station * nchan + channel, to all
+  /// baselines of the data.
+  template <typename T>
+  static void applyBeamValues(const base::DPInfo& info, T* data0,
+                              float* weight0,
+                              const std::vector<aocommon::MC2x2>& beamValues,
+                              bool doUpdateWeights);
+
+  /// Apply array factor beam values to Stokes I data, which has a single
+  /// correlation. Only the first element of the beam values is used.
+  template <typename T>
+  static void applyBeamValuesStokesI(
+      const base::DPInfo& info, T* data0,
+      const std::vector<aocommon::MC2x2>& beamValues);
+
  private:
+  /// Beam values (for each station and channel) on the grid of times where
+  /// the beam is evaluated, for one direction and mode.
+  struct BeamCache {
+    /// Grid index of 'values'; the others are at index - 1 and index + 1.
+    long index = -1;
+    bool hasPrevious = false;
+    std::vector<aocommon::MC2x2> previous;
+    std::vector<aocommon::MC2x2> values;
+    std::vector<aocommon::MC2x2> next;
+    /// The values interpolated at the time of the current time slot.
+    std::vector<aocommon::MC2x2> interpolated;
+  };
+
   everybeam::vector3r_t dir2Itrf(const casacore::MDirection& dir,
                                  casacore::MDirection::Convert& measConverter);
 
+  /// Get the beam values at the given time. They are evaluated directly, or
+  /// interpolated from the values on the update grid kept in the cache.
+  const std::vector<aocommon::MC2x2>& getBeamValues(
+      double time, const casacore::MDirection& direction,
+      everybeam::CorrectionMode mode, bool invert, BeamCache& cache);
+
+  /// Get the beam for all stations and channels from the beam response
+  /// cache, which evaluates it in parallel if needed.
+  void evaluateBeam(double time, const casacore::MDirection& direction,
+                    everybeam::CorrectionMode mode, bool invert,
+                    std::vector<aocommon::MC2x2>& values);
+
+  /// Apply the beam values to all channels of a single baseline.
+  template <typename T>
+  static void applyBaseline(const base::DPInfo& info, size_t baseline,
+                            T* data0, float* weight0,
+                            const std::vector<aocommon::MC2x2>& beamValues,
+                            bool doUpdateWeights);
+
   InputStep* itsInput;
   string itsName;
   base::DPBuffer itsBuffer;
@@ -109,17 +176,34 @@ class ApplyBeam : public Step {
 
   unsigned int itsDebugLevel;
 
+  /// Time between beam evaluations in seconds; 0 means every time slot.
+  double itsUpdateInterval;
+
   /// The info needed to calculate the station beams.
   ///@{
-  // TODO: a copy initialization (?) somewhere is preventing a unique_ptr to
-  // work
-  std::vector<std::shared_ptr<everybeam::telescope::Telescope>> telescopes_;
-  std::vector<size_t> ant_to_msindex_;
-  std::vector<casacore::MeasFrame> itsMeasFrames;
-  std::vector<casacore::MDirection::Convert> itsMeasConverters;
-  std::vector<std::vector<aocommon::MC2x2>> itsBeamValues;
+  std::unique_ptr<everybeam::telescope::Telescope> itsTelescope;
+  std::vector<size_t> itsStationIndices;
+  /// Context of the telescope in the shared beam response cache.
+  size_t itsBeamCacheContext;
+  casacore::MeasFrame itsMeasFrame;
+  casacore::MDirection::Convert itsMeasConverter;
+  /// Guards the element response, which is shared by the threads.
+  std::mutex itsMutex;
+  aocommon::ParallelFor<size_t> itsParallelFor;
   ///@}
 
+  /// The beam values for undoing the input beam and for applying the beam.
+  BeamCache itsUndoCache;
+  BeamCache itsCache;
+
+  /// Start time of the update grid.
+  double itsGridStart;
+  /// The number of beam evaluations (of all stations and channels).
+  size_t itsNEvaluations;
+  /// The largest estimated relative interpolation error, which is derived
+  /// from the second differences of the beam values on the update grid.
+  double itsMaxInterpolationError;
+
   common::NSTimer itsTimer;
 };
 
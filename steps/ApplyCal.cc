@@ -29,8 +29,9 @@ namespace dp3 {
 namespace steps {
 
 ApplyCal::ApplyCal(InputStep* input, const common::ParameterSet& parset,
-                   const string& prefix, bool substep, string predictDirection)
-    : itsIsSubstep(substep) {
+                   const string& prefix, bool substep, string predictDirection,
+                   MsType inputType)
+    : itsIsSubstep(substep), itsInputType(inputType) {
   std::vector<std::string> subStepNames;
   common::ParameterValue namesPar(parset.getString(prefix + "steps", ""));
 
@@ -53,7 +54,8 @@ ApplyCal::ApplyCal(InputStep* input, const common::ParameterSet& parset,
       subStepPrefix = prefix + subStepName + ".";
     }
     itsApplyCals.push_back(std::make_shared<OneApplyCal>(
-        input, parset, subStepPrefix, prefix, substep, predictDirection));
+        input, parset, subStepPrefix, prefix, substep, predictDirection,
+        inputType));
   }
 
   unsigned int numSteps = itsApplyCals.size();
@@ -99,6 +101,11 @@ bool ApplyCal::process(const DPBuffer& bufin) {
   return true;
 }
 
+bool ApplyCal::process(std::unique_ptr<base::BDABuffer> buffer) {
+  getNextStep()->process(std::move(buffer));
+  return true;
+}
+
 void ApplyCal::finish() {
   // Let the next steps finish.
   getNextStep()->finish();
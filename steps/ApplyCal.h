@@ -11,6 +11,7 @@
 
 #include "InputStep.h"
 
+#include "../base/BDABuffer.h"
 #include "../base/DPBuffer.h"
 
 #include "OneApplyCal.h"
@@ -34,7 +35,8 @@ class ApplyCal : public Step {
   /// Construct the object.
   /// Parameters are obtained from the parset using the given prefix.
   ApplyCal(InputStep*, const common::ParameterSet&, const string& prefix,
-           bool substep = false, std::string predictDirection = "");
+           bool substep = false, std::string predictDirection = "",
+           MsType inputType = MsType::kRegular);
 
   ApplyCal() = default;
 
@@ -45,6 +47,10 @@ class ApplyCal : public Step {
   /// When processed, it invokes the process function of the next step.
   virtual bool process(const base::DPBuffer& buffer);
 
+  /// Process the BDA data.
+  /// When processed, it invokes the process function of the next step.
+  bool process(std::unique_ptr<base::BDABuffer>) override;
+
   /// Finish the processing of this step and subsequent steps.
   virtual void finish();
 
@@ -62,6 +68,14 @@ class ApplyCal : public Step {
   /// OneApplyCals.
   virtual void showTimings(std::ostream&, double duration) const;
 
+  bool accepts(MsType dt) const override { return dt == itsInputType; }
+
+  MsType outputs() const override { return itsInputType; }
+
+  bool canSplitTime() const override {
+    return itsInputType == MsType::kRegular;
+  }
+
   /// Invert a 2x2 matrix in place
   template <typename NumType>
   static void invert(std::complex<NumType>* v, NumType sigmaMMSE = 0);
@@ -102,6 +116,7 @@ class ApplyCal : public Step {
  private:
   bool itsIsSubstep;
   string itsName;
+  MsType itsInputType = MsType::kRegular;
 
   std::vector<OneApplyCal::ShPtr> itsApplyCals;
 };
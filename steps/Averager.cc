@@ -19,6 +19,7 @@
 
 #include <boost/algorithm/string/trim.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 
@@ -136,18 +137,19 @@ bool Averager::process(const base::DPBuffer& buf) {
   itsTimer.start();
   // Sum the data in time applying the weights.
   // The summing in channel and the averaging is done in function average.
+  // The summation is done per baseline, because most baselines are either
+  // fully flagged or fully unflagged, which can be handled much faster.
+  const IPosition& shapeIn = buf.getData().shape();
+  const unsigned int npin = shapeIn[0] * shapeIn[1];
+  const unsigned int nbl = shapeIn[2];
   if (itsNTimes == 0) {
-    // The first time we assign because that is faster than first clearing
-    // and adding thereafter.
-    itsBuf.getData().assign(buf.getData());
-    itsBuf.getFlags().assign(buf.getFlags());
+    itsBuf.getData().resize(shapeIn);
+    itsBuf.getWeights().resize(shapeIn);
     itsBuf.getUVW().assign(itsInput.fetchUVW(buf, itsBuf, itsTimer));
-    itsBuf.getWeights().assign(itsInput.fetchWeights(buf, itsBuf, itsTimer));
-    IPosition shapeIn = buf.getData().shape();
     itsNPoints.resize(shapeIn);
-    itsAvgAll.reference(buf.getData() * itsBuf.getWeights());
+    itsAvgAll.resize(shapeIn);
     itsWeightAll.resize(shapeIn);
-    itsWeightAll = itsBuf.getWeights();
+    itsFlagStates.resize(nbl);
     // Take care of the fullRes flags.
     // We have to shape the output array and copy to a part of it.
     const Cube<bool>& fullResFlags =
@@ -161,35 +163,11 @@ bool Averager::process(const base::DPBuffer& buf) {
     double time = buf.getTime() + 0.5 * (itsNTimeAvg - 1) * itsTimeInterval;
     itsBuf.setTime(time);
     itsBuf.setExposure(itsNTimeAvg * itsTimeInterval);
-    // Only set.
-    itsNPoints = 1;
-    // Set flagged points to zero.
-    casacore::Array<bool>::const_contiter infIter = buf.getFlags().cbegin();
-    casacore::Array<casacore::Complex>::contiter dataIter =
-        itsBuf.getData().cbegin();
-    casacore::Array<float>::contiter wghtIter = itsBuf.getWeights().cbegin();
-    casacore::Array<int>::contiter outnIter = itsNPoints.cbegin();
-    casacore::Array<int>::contiter outnIterEnd = itsNPoints.cend();
-    while (outnIter != outnIterEnd) {
-      if (*infIter) {
-        // Flagged data point
-        *outnIter = 0;
-        *dataIter = casacore::Complex();
-        *wghtIter = 0;
-      } else {
-        // Weigh the data point
-        *dataIter *= *wghtIter;
-      }
-      ++infIter;
-      ++dataIter;
-      ++wghtIter;
-      ++outnIter;
-    }
   } else {
     // Not the first time.
     // For now we assume that all timeslots have the same nr of baselines,
     // so check if the buffer sizes are the same.
-    if (itsBuf.getData().shape() != buf.getData().shape())
+    if (itsBuf.getData().shape() != shapeIn)
       throw std::runtime_error(
           "Inconsistent buffer sizes in Averager, possibly because of "
           "inconsistent nr of baselines in timeslots");
@@ -197,38 +175,93 @@ bool Averager::process(const base::DPBuffer& buf) {
     itsBuf.getUVW() += itsInput.fetchUVW(buf, itsBufTmp, itsTimer);
     copyFullResFlags(itsInput.fetchFullResFlags(buf, itsBufTmp, itsTimer),
                      buf.getFlags(), itsNTimes);
-    const Cube<float>& weights =
-        itsInput.fetchWeights(buf, itsBufTmp, itsTimer);
-    // Ignore flagged points.
-    casacore::Array<casacore::Complex>::const_contiter indIter =
-        buf.getData().cbegin();
-    casacore::Array<float>::const_contiter inwIter = weights.cbegin();
-    casacore::Array<bool>::const_contiter infIter = buf.getFlags().cbegin();
-    casacore::Array<casacore::Complex>::contiter outdIter =
-        itsBuf.getData().cbegin();
-    casacore::Array<casacore::Complex>::contiter alldIter = itsAvgAll.cbegin();
-    casacore::Array<float>::contiter outwIter = itsBuf.getWeights().cbegin();
-    casacore::Array<float>::contiter allwIter = itsWeightAll.cbegin();
-    casacore::Array<int>::contiter outnIter = itsNPoints.cbegin();
-    casacore::Array<int>::contiter outnIterEnd = itsNPoints.cend();
-    while (outnIter != outnIterEnd) {
-      *alldIter += *indIter * *inwIter;
-      *allwIter += *inwIter;
-      if (!*infIter) {
-        *outdIter += *indIter * *inwIter;
-        *outwIter += *inwIter;
-        (*outnIter)++;
+  }
+  const Cube<float>& weights = itsInput.fetchWeights(buf, itsBufTmp, itsTimer);
+  aocommon::ParallelFor<unsigned int> loop(getInfo().nThreads());
+  loop.Run(0, nbl, [&](unsigned int k, size_t /*thread*/) {
+    const size_t offset = size_t(k) * npin;
+    const casacore::Complex* indata = buf.getData().data() + offset;
+    const float* inwght = weights.data() + offset;
+    const bool* inflags = buf.getFlags().data() + offset;
+    casacore::Complex* outdata = itsBuf.getData().data() + offset;
+    float* outwght = itsBuf.getWeights().data() + offset;
+    casacore::Complex* alldata = itsAvgAll.data() + offset;
+    float* allwght = itsWeightAll.data() + offset;
+    int* npoints = itsNPoints.data() + offset;
+    const FlagState slotState = GetFlagState(inflags, npin);
+    FlagState& state = itsFlagStates[k];
+    if (itsNTimes == 0) {
+      state = slotState;
+    } else if (state != slotState && state != FlagState::kMixed) {
+      // The baseline becomes mixed, so the sums that were not kept yet
+      // have to be filled.
+      if (state == FlagState::kNoneFlagged) {
+        std::copy_n(outdata, npin, alldata);
+        std::copy_n(outwght, npin, allwght);
+        std::fill_n(npoints, npin, itsNTimes);
+      } else {
+        std::fill_n(outdata, npin, casacore::Complex());
+        std::fill_n(outwght, npin, 0.0f);
+        std::fill_n(npoints, npin, 0);
       }
-      ++indIter;
-      ++inwIter;
-      ++infIter;
-      ++outdIter;
-      ++alldIter;
-      ++outwIter;
-      ++allwIter;
-      ++outnIter;
+      state = FlagState::kMixed;
     }
-  }
+    const bool first = (itsNTimes == 0);
+    switch (state) {
+      case FlagState::kNoneFlagged:
+        // Only the sums of the unflagged data are kept.
+        if (first) {
+          for (unsigned int i = 0; i < npin; ++i) {
+            outdata[i] = indata[i] * inwght[i];
+            outwght[i] = inwght[i];
+          }
+        } else {
+          for (unsigned int i = 0; i < npin; ++i) {
+            outdata[i] += indata[i] * inwght[i];
+            outwght[i] += inwght[i];
+          }
+        }
+        break;
+      case FlagState::kAllFlagged:
+        // Only the sums of all data are kept.
+        if (first) {
+          for (unsigned int i = 0; i < npin; ++i) {
+            alldata[i] = indata[i] * inwght[i];
+            allwght[i] = inwght[i];
+          }
+        } else {
+          for (unsigned int i = 0; i < npin; ++i) {
+            alldata[i] += indata[i] * inwght[i];
+            allwght[i] += inwght[i];
+          }
+        }
+        break;
+      case FlagState::kMixed:
+        if (first) {
+          for (unsigned int i = 0; i < npin; ++i) {
+            alldata[i] = indata[i] * inwght[i];
+            allwght[i] = inwght[i];
+            // Ignore flagged points.
+            outdata[i] = inflags[i] ? casacore::Complex() : alldata[i];
+            outwght[i] = inflags[i] ? 0.0f : inwght[i];
+            npoints[i] = inflags[i] ? 0 : 1;
+          }
+        } else {
+          for (unsigned int i = 0; i < npin; ++i) {
+            const casacore::Complex weighted = indata[i] * inwght[i];
+            alldata[i] += weighted;
+            allwght[i] += inwght[i];
+            // Ignore flagged points.
+            if (!inflags[i]) {
+              outdata[i] += weighted;
+              outwght[i] += inwght[i];
+              ++npoints[i];
+            }
+          }
+        }
+        break;
+    }
+  });
   // Do the averaging if enough time steps have been processed.
   itsNTimes += 1;
   if (itsNTimes >= itsNTimeAvg) {
@@ -277,6 +310,7 @@ void Averager::average() {
     casacore::Complex* outdata = itsBufOut.getData().data() + k * npout;
     float* outwght = itsBufOut.getWeights().data() + k * npout;
     bool* outflags = itsBufOut.getFlags().data() + k * npout;
+    const FlagState state = itsFlagStates[k];
     for (unsigned int i = 0; i < ncorr; ++i) {
       unsigned int inxi = i;
       unsigned int inxo = i;
@@ -288,13 +322,36 @@ void Averager::average() {
         float sumw = 0;
         float sumaw = 0;
         unsigned int np = 0;
-        for (unsigned int j = 0; j < nch; ++j) {
-          sumd += indata[inxi];  // Note: weight is accounted for in process
-          sumad += inalld[inxi];
-          sumw += inwght[inxi];
-          sumaw += inallw[inxi];
-          np += innp[inxi];
-          inxi += ncorr;
+        switch (state) {
+          case FlagState::kNoneFlagged:
+            // All data are unflagged, so only those sums are kept.
+            for (unsigned int j = 0; j < nch; ++j) {
+              sumd += indata[inxi];
+              sumw += inwght[inxi];
+              inxi += ncorr;
+            }
+            sumad = sumd;
+            sumaw = sumw;
+            np = navgAll;
+            break;
+          case FlagState::kAllFlagged:
+            // All data are flagged, so only the sums of all data are kept.
+            for (unsigned int j = 0; j < nch; ++j) {
+              sumad += inalld[inxi];
+              sumaw += inallw[inxi];
+              inxi += ncorr;
+            }
+            break;
+          case FlagState::kMixed:
+            for (unsigned int j = 0; j < nch; ++j) {
+              sumd += indata[inxi];  // Note: weight is accounted for in process
+              sumad += inalld[inxi];
+              sumw += inwght[inxi];
+              sumaw += inallw[inxi];
+              np += innp[inxi];
+              inxi += ncorr;
+            }
+            break;
         }
         // Flag the point if insufficient unflagged data.
         if (sumw == 0 || np < itsMinNPoint || np < navgAll * itsMinPerc) {
@@ -363,6 +420,16 @@ void Averager::copyFullResFlags(const Cube<bool>& fullResFlags,
   }
 }
 
+Averager::FlagState Averager::GetFlagState(const bool* flags, size_t n) {
+  const bool* end = flags + n;
+  if (std::find(flags, end, true) == end) {
+    return FlagState::kNoneFlagged;
+  } else if (std::find(flags, end, false) == end) {
+    return FlagState::kAllFlagged;
+  }
+  return FlagState::kMixed;
+}
+
 double Averager::getFreqHz(const string& freqstr) {
   casacore::String unit;
   // See if a unit is given at the end.
@@ -67,9 +67,15 @@ class Averager : public Step {
   virtual void showTimings(std::ostream&, double duration) const;
 
  private:
+  /// Flag state of a baseline in the time slots summed so far.
+  enum class FlagState { kNoneFlagged, kAllFlagged, kMixed };
+
   /// Average into itsBufOut.
   void average();
 
+  /// Determine if none, all or some of the given flags are set.
+  static FlagState GetFlagState(const bool* flags, size_t n);
+
   /// Copy the fullRes flags in the input buffer to the correct
   /// time index in the output buffer.
   /// If a flag is set, set all flags in corresponding FullRes window.
@@ -89,6 +95,10 @@ class Averager : public Step {
   casacore::Cube<casacore::Complex> itsAvgAll;
   casacore::Cube<float> itsWeightAll;
   casacore::Cube<bool> itsFullResFlags;
+  /// For each baseline, tells which sums are kept. If no data is flagged,
+  /// only itsBuf is used. If all data is flagged, only itsAvgAll and
+  /// itsWeightAll are used. Otherwise all sums and itsNPoints are used.
+  std::vector<FlagState> itsFlagStates;
   double itsFreqResolution;
   double itsTimeResolution;
   unsigned int itsNChanAvg;
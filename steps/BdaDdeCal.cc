@@ -15,6 +15,8 @@
 #include "../ddecal/gain_solvers/SolveData.h"
 #include "../ddecal/SolverFactory.h"
 
+#include <aocommon/threadpool.h>
+
 #include <boost/make_unique.hpp>
 
 #include <algorithm>
@@ -48,6 +50,7 @@ BdaDdeCal::BdaDdeCal(InputStep* input, const common::ParameterSet& parset,
       iterations_(),
       approx_iterations_(),
       constraint_solutions_(),
+      thread_pool_(),
       timer_(),
       predict_timer_(),
       solve_timer_(),
@@ -65,6 +68,8 @@ BdaDdeCal::BdaDdeCal(InputStep* input, const common::ParameterSet& parset,
   }
 }
 
+BdaDdeCal::~BdaDdeCal() = default;
+
 void BdaDdeCal::InitializePredictSteps(InputStep* input,
                                        const common::ParameterSet& parset,
                                        const string& prefix) {
@@ -91,7 +96,10 @@ void BdaDdeCal::updateInfo(const DPInfo& _info) {
   Step::updateInfo(_info);
 
   // Update info for substeps
+  thread_pool_ = boost::make_unique<aocommon::ThreadPool>(info().nThreads());
   for (unsigned int i = 0; i < settings_.directions.size(); i++) {
+    auto group_predict = std::dynamic_pointer_cast<BdaGroupPredict>(steps_[i]);
+    if (group_predict) group_predict->SetThreadData(*thread_pool_);
     steps_[i]->setInfo(_info);
   }
 
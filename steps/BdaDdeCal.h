@@ -10,6 +10,10 @@
 #include "../ddecal/gain_solvers/BdaSolverBuffer.h"
 #include "../ddecal/gain_solvers/SolverBase.h"
 
+namespace aocommon {
+class ThreadPool;
+}  // namespace aocommon
+
 namespace dp3 {
 namespace steps {
 
@@ -62,6 +66,8 @@ class BdaDdeCal : public Step {
   BdaDdeCal(InputStep* input_step, const common::ParameterSet& parset,
             const std::string& prefix);
 
+  ~BdaDdeCal() override;
+
   bool process(std::unique_ptr<base::BDABuffer>) override;
 
   void finish() override;
@@ -168,6 +174,9 @@ class BdaDdeCal : public Step {
   std::vector<std::vector<std::vector<ddecal::Constraint::Result>>>
       constraint_solutions_;
 
+  /// Thread pool for the predict steps, which run one after the other.
+  std::unique_ptr<aocommon::ThreadPool> thread_pool_;
+
   common::NSTimer timer_;
   common::NSTimer predict_timer_;
   common::NSTimer solve_timer_;
@@ -9,16 +9,32 @@
 
 #include <iostream>
 
+#include "../base/SourceDBUtil.h"
+
 #include "../common/ParameterSet.h"
 #include "../common/Timer.h"
 
+#include <aocommon/threadpool.h>
+
+#include <casacore/casa/Arrays/Vector.h>
+#include <casacore/casa/Quanta/Quantum.h>
+#include <casacore/measures/Measures/MDirection.h>
+#include <casacore/measures/Measures/MeasConvert.h>
+
+#include <boost/make_unique.hpp>
+
+#include <algorithm>
+#include <numeric>
 #include <stddef.h>
 #include <string>
 #include <sstream>
 #include <utility>
 #include <vector>
 
+using casacore::MDirection;
+
 using dp3::base::BDABuffer;
+using dp3::base::BdaSimulator;
 using dp3::base::DPInfo;
 
 namespace dp3 {
@@ -156,7 +172,9 @@ class BdaGroupPredict::BaselineGroup {
 BdaGroupPredict::BdaGroupPredict(InputStep &input,
                                  const common::ParameterSet &parset,
                                  const string &prefix)
-    : input_(input), parset_(parset), name_(prefix) {}
+    : input_(input), parset_(parset), name_(prefix), thread_pool_(nullptr) {
+  ReadNativeSettings(parset);
+}
 
 BdaGroupPredict::BdaGroupPredict(
     InputStep &input, const common::ParameterSet &parset, const string &prefix,
@@ -164,15 +182,89 @@ BdaGroupPredict::BdaGroupPredict(
     : input_(input),
       parset_(parset),
       name_(prefix),
-      source_patterns_(source_patterns) {}
+      source_patterns_(source_patterns),
+      thread_pool_(nullptr) {
+  ReadNativeSettings(parset);
+}
 
 BdaGroupPredict::~BdaGroupPredict() {}
 
+void BdaGroupPredict::ReadNativeSettings(const common::ParameterSet &parset) {
+  // The beam, applycal and time smearing are only supported by the regular
+  // predict.
+  native_ = !parset.getBool(name_ + "usebeammodel", false) &&
+            !parset.isDefined(name_ + "applycal.parmdb") &&
+            !parset.isDefined(name_ + "applycal.steps") &&
+            parset.getUint(name_ + "correcttimesmearing", 1) <= 1;
+  if (!native_) return;
+
+  source_db_name_ = parset.getString(name_ + "sourcedb");
+  correct_freq_smearing_ =
+      parset.getBool(name_ + "correctfreqsmearing", false);
+  operation_ = parset.getString(name_ + "operation", "replace");
+  if (operation_ != "replace" && operation_ != "add" &&
+      operation_ != "subtract") {
+    throw std::invalid_argument(
+        "Operation must be 'replace', 'add' or 'subtract'.");
+  }
+
+  const std::vector<std::string> source_patterns =
+      source_patterns_.empty()
+          ? parset.getStringVector(name_ + "sources",
+                                   std::vector<std::string>())
+          : source_patterns_;
+  base::SourceDB source_db{source_db_name_, source_patterns};
+  patch_list_ = source_db.MakePatchList();
+  if (patch_list_.empty()) {
+    throw std::runtime_error("Couldn't find patch for the given sources in " +
+                             source_db_name_);
+  }
+  source_list_ = base::makeSourceList(patch_list_);
+  stokes_i_only_ = !source_db.CheckPolarized();
+}
+
 void BdaGroupPredict::updateInfo(const DPInfo &infoIn) {
   Step::updateInfo(infoIn);
   info().setNeedVisData();
   info().setWriteData();
 
+  if (native_) {
+    try {
+      MDirection dirJ2000(
+          MDirection::Convert(infoIn.phaseCenter(), MDirection::J2000)());
+      casacore::Quantum<casacore::Vector<double>> angles = dirJ2000.getAngle();
+      phase_ref_ =
+          base::Direction(angles.getBaseValue()[0], angles.getBaseValue()[1]);
+    } catch (casacore::AipsError &) {
+      // Phase direction (in J2000) is time dependent, which only the regular
+      // predict supports.
+      native_ = false;
+    }
+  }
+
+  if (native_) {
+    channel_layouts_.clear();
+    baseline_layouts_.clear();
+    baseline_layouts_.reserve(info().nbaselines());
+    for (std::size_t bl = 0; bl < info().nbaselines(); ++bl) {
+      const std::vector<double> &freqs = info().chanFreqs(bl);
+      const std::vector<double> &widths = info().chanWidths(bl);
+      auto layout = std::find_if(
+          channel_layouts_.begin(), channel_layouts_.end(),
+          [&](const BdaSimulator::ChannelLayout &l) {
+            return l.frequencies == freqs && l.widths == widths;
+          });
+      if (layout == channel_layouts_.end()) {
+        channel_layouts_.push_back({freqs, widths});
+        layout = channel_layouts_.end() - 1;
+      }
+      baseline_layouts_.push_back(layout - channel_layouts_.begin());
+    }
+    // The simulators refer to the channel layouts, which may have changed.
+    thread_data_.clear();
+    return;
+  }
+
   // Loop over all baselines, grouping them by averaging parameters
   for (std::size_t bl = 0; bl < info().nbaselines(); ++bl) {
     // Create a key describing the averaging in time and frequency
@@ -195,6 +287,12 @@ void BdaGroupPredict::updateInfo(const DPInfo &infoIn) {
 }
 
 base::Direction BdaGroupPredict::GetFirstDirection() const {
+  if (native_) {
+    if (baseline_layouts_.empty()) {
+      throw std::runtime_error("BdaGroupPredict is not initialized");
+    }
+    return patch_list_.front()->direction();
+  }
   if (index_to_baseline_group_map_.empty()) {
     throw std::runtime_error("BdaGroupPredict is not initialized");
   }
@@ -203,6 +301,18 @@ base::Direction BdaGroupPredict::GetFirstDirection() const {
 
 void BdaGroupPredict::show(std::ostream &os) const {
   os << "BdaGroupPredict " << name_ << '\n';
+  if (native_) {
+    os << "Predicting directly on the BDA rows.\n";
+    os << "  sourcedb:           " << source_db_name_ << '\n';
+    os << "   number of patches: " << patch_list_.size() << '\n';
+    os << "   number of sources: " << source_list_.size() << '\n';
+    os << "   all unpolarized:   " << std::boolalpha << stokes_i_only_ << '\n';
+    os << "   correct freq smearing: " << std::boolalpha
+       << correct_freq_smearing_ << '\n';
+    os << "  channel layouts:    " << channel_layouts_.size() << '\n';
+    os << "  operation:          " << operation_ << '\n';
+    return;
+  }
   os << "Using a regular predict per baseline group. Baseline groups total: "
      << averaging_to_baseline_group_map_.size() << "\n";
   if (!averaging_to_baseline_group_map_.empty()) {
@@ -215,11 +325,17 @@ void BdaGroupPredict::showTimings(std::ostream &os, double duration) const {
   os << "  ";
   base::FlagCounter::showPerc1(os, timer_.getElapsed(), duration);
   os << " BdaGroupPredict " << name_ << '\n';
+  if (native_) return;
   os << " Predict for first baseline group\n";
   averaging_to_baseline_group_map_.begin()->second.ShowTimings(os, duration);
 }
 
 bool BdaGroupPredict::process(std::unique_ptr<base::BDABuffer> buffer) {
+  if (native_) {
+    PredictRows(std::move(buffer));
+    return false;
+  }
+
   timer_.start();
 
   buffers_.push({std::move(buffer), 0});
@@ -243,6 +359,101 @@ bool BdaGroupPredict::process(std::unique_ptr<base::BDABuffer> buffer) {
   return false;
 }
 
+void BdaGroupPredict::PredictRows(std::unique_ptr<base::BDABuffer> buffer) {
+  timer_.start();
+
+  if (!thread_pool_) {
+    local_thread_pool_ =
+        boost::make_unique<aocommon::ThreadPool>(getInfo().nThreads());
+    thread_pool_ = local_thread_pool_.get();
+  }
+  if (thread_data_.size() != thread_pool_->NThreads()) {
+    thread_data_.clear();
+    thread_data_.reserve(thread_pool_->NThreads());
+    for (std::size_t thread = 0; thread != thread_pool_->NThreads();
+         ++thread) {
+      thread_data_.push_back(ThreadData{
+          BdaSimulator(phase_ref_, info().nantenna(), channel_layouts_,
+                       correct_freq_smearing_, stokes_i_only_),
+          {},
+          {}});
+    }
+  }
+
+  // Group the rows by time, since rows with the same time share the station
+  // phase terms.
+  const std::vector<BDABuffer::Row> &rows = buffer->GetRows();
+  std::vector<std::size_t> order(rows.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&rows](std::size_t a, std::size_t b) {
+                     return rows[a].time < rows[b].time;
+                   });
+  std::vector<std::size_t> time_starts;
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    if (i == 0 || rows[order[i]].time - rows[order[i - 1]].time > 1e-3) {
+      time_starts.push_back(i);
+    }
+  }
+  time_starts.push_back(order.size());
+
+  const std::size_t n_model_correlations = stokes_i_only_ ? 1 : 4;
+  const bool replace = operation_ == "replace";
+  const float sign = operation_ == "subtract" ? -1.0f : 1.0f;
+
+  thread_pool_->For(
+      0, time_starts.size() - 1, [&](std::size_t group, std::size_t thread) {
+        ThreadData &data = thread_data_[thread];
+        const std::size_t begin = time_starts[group];
+        const std::size_t end = time_starts[group + 1];
+
+        std::size_t model_size = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+          model_size += rows[order[i]].n_channels * n_model_correlations;
+        }
+        data.model.assign(model_size, 0.0);
+        data.rows.clear();
+        std::size_t offset = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+          const BDABuffer::Row &row = rows[order[i]];
+          data.rows.push_back({std::size_t(info().getAnt1()[row.baseline_nr]),
+                               std::size_t(info().getAnt2()[row.baseline_nr]),
+                               row.uvw, baseline_layouts_[row.baseline_nr],
+                               &data.model[offset]});
+          offset += row.n_channels * n_model_correlations;
+        }
+
+        data.simulator.SetRows(data.rows);
+        for (const auto &source : source_list_) {
+          data.simulator.simulate(source.first);
+        }
+
+        // Put the predicted visibilities in the buffer. For Stokes I only,
+        // the model is added to the first and last correlation.
+        for (std::size_t i = begin; i < end; ++i) {
+          const BDABuffer::Row &row = rows[order[i]];
+          const std::complex<double> *model = data.rows[i - begin].buffer;
+          std::complex<float> *visibilities = row.data;
+          const std::size_t n_correlations = row.n_correlations;
+          for (std::size_t ch = 0; ch < row.n_channels; ++ch) {
+            for (std::size_t cr = 0; cr < n_correlations; ++cr) {
+              std::complex<float> value;
+              if (!stokes_i_only_) {
+                value = model[ch * n_model_correlations + cr];
+              } else if (cr == 0 || cr == n_correlations - 1) {
+                value = model[ch];
+              }
+              *visibilities = replace ? value : *visibilities + sign * value;
+              ++visibilities;
+            }
+          }
+        }
+      });
+
+  timer_.stop();
+  getNextStep()->process(std::move(buffer));
+}
+
 void BdaGroupPredict::finish() {
   // Let the next steps finish.
   if (!buffers_.empty()) {
@@ -13,11 +13,20 @@
 #include "InputStep.h"
 
 #include "../base/BDABuffer.h"
+#include "../base/BdaSimulator.h"
+#include "../base/ModelComponent.h"
+#include "../base/Patch.h"
 
+#include <complex>
 #include <map>
+#include <memory>
 #include <queue>
 #include <utility>
 
+namespace aocommon {
+class ThreadPool;
+}  // namespace aocommon
+
 namespace dp3 {
 namespace common {
 class ParameterSet;
@@ -26,6 +35,12 @@ class ParameterSet;
 namespace steps {
 
 /// @brief DP3 step class to predict BDA visibilities from a source model
+///
+/// By default, the visibilities are predicted directly for the BDA rows, with
+/// the channel frequencies and UVW of each row. Rows with the same time share
+/// the station phase terms. When the beam, applycal or time smearing
+/// correction is requested, the baselines are regrouped into regular buffers
+/// per averaging factor instead, which are predicted with a Predict step.
 /// @author Sebastiaan van der Tol
 
 class BdaGroupPredict : public ModelDataStep {
@@ -47,6 +62,10 @@ class BdaGroupPredict : public ModelDataStep {
 
   virtual ~BdaGroupPredict();
 
+  /// Let the predict use the given thread pool, which may be shared with
+  /// other steps. Without a thread pool, the step creates its own.
+  void SetThreadData(aocommon::ThreadPool& pool) { thread_pool_ = &pool; }
+
   /// Processes the data.
   /// Buffers incoming BDABuffers in a queue and sends them to the the next step
   /// when all baseline groups are complete.
@@ -70,6 +89,13 @@ class BdaGroupPredict : public ModelDataStep {
   base::Direction GetFirstDirection() const override;
 
  private:
+  /// Reads the settings for predicting directly on the BDA rows, if the
+  /// parset does not require the regular predict.
+  void ReadNativeSettings(const common::ParameterSet& parset);
+
+  /// Predicts all rows of a buffer directly and sends it to the next step.
+  void PredictRows(std::unique_ptr<base::BDABuffer> buffer);
+
   InputStep& input_;
 
   // Need to store a reference to the parset to create the OnePredict
@@ -100,6 +126,32 @@ class BdaGroupPredict : public ModelDataStep {
   /// that group
   std::vector<std::pair<BaselineGroup*, int>> index_to_baseline_group_map_;
 
+  /// True if the visibilities are predicted directly for the BDA rows.
+  bool native_;
+  std::string source_db_name_;
+  bool correct_freq_smearing_;
+  std::string operation_;
+  bool stokes_i_only_;
+  base::Direction phase_ref_;
+  std::vector<base::Patch::ConstPtr> patch_list_;
+  std::vector<std::pair<base::ModelComponent::ConstPtr, base::Patch::ConstPtr>>
+      source_list_;
+
+  /// Distinct channel layouts of the baselines.
+  std::vector<base::BdaSimulator::ChannelLayout> channel_layouts_;
+  /// Channel layout index for each baseline.
+  std::vector<std::size_t> baseline_layouts_;
+
+  struct ThreadData {
+    base::BdaSimulator simulator;
+    std::vector<std::complex<double>> model;
+    std::vector<base::BdaSimulator::Row> rows;
+  };
+  std::vector<ThreadData> thread_data_;
+
+  aocommon::ThreadPool* thread_pool_;
+  std::unique_ptr<aocommon::ThreadPool> local_thread_pool_;
+
   common::NSTimer timer_;
 };
 
@@ -63,20 +63,11 @@ void Counter::updateInfo(const base::DPInfo& infoIn) {
 }
 
 bool Counter::process(const base::DPBuffer& buf) {
-  const casacore::IPosition& shape = buf.getFlags().shape();
-  unsigned int nrcorr = shape[0];
-  unsigned int nrchan = shape[1];
-  unsigned int nrbl = shape[2];
-  const bool* flagPtr = buf.getFlags().data();
-  for (unsigned int i = 0; i < nrbl; ++i) {
-    for (unsigned int j = 0; j < nrchan; ++j) {
-      if (*flagPtr) {
-        itsFlagCounter.incrBaseline(i);
-        itsFlagCounter.incrChannel(j);
-      }
-      flagPtr += nrcorr;  // only count 1st corr
-    }
-  }
+  // A channel counts as flagged if any correlation is flagged, which is
+  // the same as the 1st correlation, because all correlations have the
+  // same flag.
+  itsPackedFlags.Pack(buf.getFlags());
+  itsFlagCounter.countFlags(itsPackedFlags);
   // Let the next step do its processing.
   getNextStep()->process(buf);
   itsCount++;
@@ -13,6 +13,7 @@
 
 #include "../base/DPBuffer.h"
 #include "../base/FlagCounter.h"
+#include "../base/PackedFlags.h"
 
 namespace dp3 {
 
@@ -60,6 +61,7 @@ class Counter : public Step {
   bool itsSaveToJson;
   std::string itsJsonFilename;
   base::FlagCounter itsFlagCounter;
+  base::PackedFlags itsPackedFlags;
 };
 
 }  // namespace steps
@@ -249,29 +249,60 @@ void DDECal::updateInfo(const DPInfo& infoIn) {
   itsThreadPool =
       boost::make_unique<aocommon::ThreadPool>(getInfo().nThreads());
 
-  // Update info for substeps and set other required parameters
+  if (itsRequestedSolInt == 0) {
+    itsRequestedSolInt = info().ntime();
+  }
+
+  // Update info for substeps and set other required parameters.
+  // The solution intervals are solved one after another, so buffering more
+  // than one interval only helps IDGPredict, which predicts all buffered
+  // time steps at once.
+  size_t wanted_sol_int_count = 1;
   for (size_t dir = 0; dir < itsSteps.size(); ++dir) {
     itsSteps[dir]->setInfo(infoIn);
 
     if (auto s = std::dynamic_pointer_cast<Predict>(itsSteps[dir])) {
       s->SetThreadData(*itsThreadPool, &itsMeasuresMutex);
     } else if (auto s = std::dynamic_pointer_cast<IDGPredict>(itsSteps[dir])) {
-      itsSolIntCount =
-          std::max(itsSolIntCount,
+      wanted_sol_int_count =
+          std::max(wanted_sol_int_count,
                    s->GetBufferSize() / itsSteps.size() / itsRequestedSolInt);
-      // We increment by one so the IDGPredict will not flush in its process
-      s->SetBufferSize(itsRequestedSolInt * itsSolIntCount + 1);
     } else if (!std::dynamic_pointer_cast<ColumnReader>(itsSteps[dir])) {
       throw std::runtime_error("DDECal received an invalid first model step");
     }
   }
 
-  itsSolver->SetNThreads(getInfo().nThreads());
-
-  if (itsRequestedSolInt == 0) {
-    itsRequestedSolInt = info().ntime();
+  // Limit the number of buffered solution intervals to the memory budget.
+  const size_t n_correlations = info().ncorr();
+  const bool keep_model = itsSettings.subtract || itsSettings.only_predict;
+  itsMemoryPlan = ddecal::MakeMemoryPlan(
+      common::AvailableMemory(itsSettings.memory_max,
+                              itsSettings.memory_percentage),
+      ddecal::EstimateIntervalMemory(info().nbaselines(), info().nchan(),
+                                     n_correlations, itsSteps.size(),
+                                     itsRequestedSolInt, keep_model),
+      ddecal::EstimateSolverMemory(itsSettings.solver_algorithm,
+                                   info().nbaselines(), info().nchan(),
+                                   n_correlations, itsSteps.size(),
+                                   itsRequestedSolInt),
+      wanted_sol_int_count);
+  itsSolIntCount = itsMemoryPlan.n_buffered_intervals;
+  if (itsMemoryPlan.ExceedsBudget()) {
+    DPLOG_WARN_STR(
+        "Warning: DDECal " + itsSettings.name +
+        " is estimated to need more memory than available for one solution "
+        "interval. Consider a smaller solint or fewer directions.");
+  }
+
+  for (const std::shared_ptr<ModelDataStep>& step : itsSteps) {
+    if (auto s = std::dynamic_pointer_cast<IDGPredict>(step)) {
+      // We increment by one so the IDGPredict will not flush in its process
+      s->SetBufferSize(itsRequestedSolInt * itsSolIntCount + 1);
+    }
   }
 
+  itsSolver->SetNThreads(getInfo().nThreads());
+
   itsDataResultStep = std::make_shared<ResultStep>();
   itsUVWFlagStep.setNextStep(itsDataResultStep);
 
@@ -374,6 +405,8 @@ void DDECal::updateInfo(const DPInfo& infoIn) {
   for (size_t i = 0; i < nSolTimes; ++i) {
     itsSols[i].resize(nChannelBlocks);
   }
+
+  if (!itsSettings.only_predict) StartSolutionWriter(used_antenna_names);
 }
 
 void DDECal::show(std::ostream& os) const {
@@ -406,6 +439,7 @@ void DDECal::show(std::ostream& os) const {
   os << "  approximate fitter:  " << itsSettings.approximate_tec << '\n'
      << "  only predict:        " << itsSettings.only_predict << '\n'
      << "  subtract model:      " << itsSettings.subtract << '\n';
+  ShowMemoryPlan(os, itsMemoryPlan);
   for (unsigned int i = 0; i < itsSteps.size(); ++i) {
     std::shared_ptr<Step> step = itsSteps[i];
     os << "Model steps for direction " << itsDirections[i][0] << '\n';
@@ -688,6 +722,8 @@ void DDECal::doSolve() {
     }
   }
 
+  if (!itsSettings.only_predict) WriteSolutions();
+
   itsTimer.stop();
 
   for (size_t i = 0; i < itsSolIntBuffers.size(); ++i) {
@@ -798,17 +834,9 @@ void DDECal::doPrepare(const DPBuffer& bufin, size_t sol_int, size_t step) {
 
   itsAvgTime += itsAvgTime + bufin.getTime();
 }
-void DDECal::WriteSolutions() {
-  itsTimer.start();
-  itsTimerWrite.start();
-
-  // Create antenna info for H5Parm, used antennas only.
-  std::vector<std::string> used_antenna_names;
-  used_antenna_names.reserve(info().antennaUsed().size());
-  for (size_t used_antenna : info().antennaUsed()) {
-    used_antenna_names.emplace_back(info().antennaNames()[used_antenna]);
-  }
 
+void DDECal::StartSolutionWriter(
+    const std::vector<std::string>& used_antenna_names) {
   const std::string history = "CREATE by " + DP3Version::AsString() + "\n" +
                               "step " + itsSettings.name + " in parset: \n" +
                               itsSettings.parset_string;
@@ -816,31 +844,52 @@ void DDECal::WriteSolutions() {
   const size_t n_directions = itsSolutionsPerDirection.size();
   const size_t n_solutions = std::accumulate(
       itsSolutionsPerDirection.begin(), itsSolutionsPerDirection.end(), 0u);
-  if (n_solutions == n_directions) {
-    itsSolutionWriter.Write(itsSols, itsConstraintSols, info().startTime(),
-                            info().timeInterval() * itsRequestedSolInt,
-                            itsSettings.mode, used_antenna_names,
-                            itsSourceDirections, itsDirections,
-                            info().chanFreqs(), itsChanBlockFreqs, history);
-  } else {
-    const size_t n_antennas = used_antenna_names.size();
-    ddecal::SolutionResampler resampler(itsSolutionsPerDirection, n_antennas,
-                                        itsSolver->NSolutionPolarizations(),
-                                        itsRequestedSolInt);
-    const size_t solution_interval =
-        itsRequestedSolInt / resampler.GetNrSubSteps();
-
-    std::vector<std::vector<std::vector<casacore::DComplex>>>
-        upsampled_solutions = resampler.Upsample(itsSols);
-    itsSolutionWriter.Write(
-        upsampled_solutions, itsConstraintSols, info().startTime(),
-        info().timeInterval() * solution_interval, itsSettings.mode,
-        used_antenna_names, itsSourceDirections, itsDirections,
-        info().chanFreqs(), itsChanBlockFreqs, history);
+  size_t solution_interval = itsRequestedSolInt;
+  if (n_solutions != n_directions) {
+    itsSolutionResampler = boost::make_unique<ddecal::SolutionResampler>(
+        itsSolutionsPerDirection, used_antenna_names.size(),
+        itsSolver->NSolutionPolarizations(), itsRequestedSolInt);
+    solution_interval /= itsSolutionResampler->GetNrSubSteps();
+  }
+
+  itsSolutionWriter.Start(info().startTime(),
+                          info().timeInterval() * solution_interval,
+                          itsSettings.mode, used_antenna_names,
+                          itsSourceDirections, itsDirections,
+                          info().chanFreqs(), itsChanBlockFreqs, history, true);
+}
+
+void DDECal::WriteSolutions() {
+  itsTimerWrite.start();
+
+  for (const base::SolutionInterval& interval : itsSolIntBuffers) {
+    const size_t solution_index = interval.NSolution();
+    if (itsSolutionResampler) {
+      std::vector<std::vector<std::vector<casacore::DComplex>>>
+          upsampled_solutions =
+              itsSolutionResampler->Upsample({itsSols[solution_index]});
+      for (std::vector<std::vector<casacore::DComplex>>& solutions :
+           upsampled_solutions) {
+        itsSolutionWriter.AddSolutions(std::move(solutions),
+                                       itsConstraintSols[solution_index]);
+      }
+    } else {
+      itsSolutionWriter.AddSolutions(
+          itsSols[solution_index],
+          std::move(itsConstraintSols[solution_index]));
+    }
+    std::vector<std::vector<ddecal::Constraint::Result>>().swap(
+        itsConstraintSols[solution_index]);
+
+    // Only the latest solutions are used again, to initialize the solutions
+    // of the next solution interval.
+    if (solution_index > 0) {
+      std::vector<std::vector<casacore::DComplex>>().swap(
+          itsSols[solution_index - 1]);
+    }
   }
 
   itsTimerWrite.stop();
-  itsTimer.stop();
 }
 
 void DDECal::finish() {
@@ -850,7 +899,11 @@ void DDECal::finish() {
     doSolve();
   }
 
-  if (!itsSettings.only_predict) WriteSolutions();
+  if (!itsSettings.only_predict) {
+    itsTimerWrite.start();
+    itsSolutionWriter.Finish();
+    itsTimerWrite.stop();
+  }
 
   itsSolIntBuffers.clear();
   itsTimer.stop();
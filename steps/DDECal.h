@@ -21,7 +21,9 @@
 #include "../base/SourceDBUtil.h"
 #include "../base/SolutionInterval.h"
 
+#include "../ddecal/MemoryPlan.h"
 #include "../ddecal/Settings.h"
+#include "../ddecal/SolutionResampler.h"
 #include "../ddecal/SolutionWriter.h"
 #include "../ddecal/constraints/Constraint.h"
 #include "../ddecal/gain_solvers/SolverBase.h"
@@ -105,7 +107,11 @@ class DDECal : public Step {
 
   void initializeFullMatrixSolutions(size_t);
 
-  /// Write all solutions to an H5Parm file using itsSolutionWriter.
+  /// Prepare itsSolutionWriter for writing the solutions incrementally.
+  void StartSolutionWriter(const std::vector<std::string>& used_antenna_names);
+
+  /// Pass the solutions of the solution intervals in itsSolIntBuffers to
+  /// itsSolutionWriter, and release the solutions that are no longer needed.
   void WriteSolutions();
 
   void storeModelData(
@@ -123,13 +129,14 @@ class DDECal : public Step {
 
   /// For each time, for each channel block, a vector of size nAntennas *
   /// SolverBase::NSolutions() * nPolarizations, with nPolarizations changing
-  /// fastest.
+  /// fastest. Once written, the solutions of a time are released, except for
+  /// the latest time, which can initialize the solutions of the next time.
   std::vector<std::vector<std::vector<casacore::DComplex>>> itsSols;
   std::vector<size_t> itsNIter,  // Number of iterations taken
       itsNApproxIter;
 
   /// For each time, for each constraint, a vector of results (e.g. tec and
-  /// phase)
+  /// phase). The results of a time are released once they are written.
   std::vector<std::vector<std::vector<ddecal::Constraint::Result>>>
       itsConstraintSols;
 
@@ -142,6 +149,8 @@ class DDECal : public Step {
   /// For each direction, a number of solutions per solution interval
   std::vector<size_t> itsSolutionsPerDirection;
   size_t itsSolIntCount;  ///< Number of solution intervals to buffer
+  /// Memory estimates, which limit itsSolIntCount.
+  ddecal::MemoryPlan itsMemoryPlan;
   size_t itsNSolInts;     ///< Total number of created solution intervals
   /// The current amount of solution intervals in itsSolInts
   size_t itsBufferedSolInts;
@@ -181,6 +190,9 @@ class DDECal : public Step {
   common::NSTimer itsTimerWrite;
   std::mutex itsMeasuresMutex;
   std::unique_ptr<ddecal::SolverBase> itsSolver;
+  /// Upsamples the solutions for writing when directions have more than one
+  /// solution per solution interval. Otherwise it is empty.
+  std::unique_ptr<ddecal::SolutionResampler> itsSolutionResampler;
   std::unique_ptr<aocommon::ThreadPool> itsThreadPool;
   std::unique_ptr<std::ofstream> itsStatStream;
 };
@@ -105,12 +105,8 @@ GainCal::GainCal(InputStep& input, const common::ParameterSet& parset,
     itsParmDBName = parset.getString("msin") + "/instrument";
   }
 
-  if (!itsUseH5Parm) {
-    itsTimeSlotsPerParmUpdate =
-        parset.getInt(prefix + "timeslotsperparmupdate", 500);
-  } else {
-    itsTimeSlotsPerParmUpdate = 0;
-  }
+  itsTimeSlotsPerParmUpdate =
+      parset.getInt(prefix + "timeslotsperparmupdate", 500);
 
   itsDataResultStep = std::make_shared<ResultStep>();
   itsUVWFlagStep.setNextStep(itsDataResultStep);
@@ -209,7 +205,9 @@ void GainCal::updateInfo(const DPInfo& infoIn) {
   if (itsSolInt == 0) {
     itsSolInt = info().ntime();
   }
-  if (itsTimeSlotsPerParmUpdate == 0) {
+  // The debug output contains the solutions of all time slots, which are
+  // then written at once.
+  if (itsTimeSlotsPerParmUpdate == 0 || itsDebugLevel > 0) {
     itsTimeSlotsPerParmUpdate = info().ntime();
   }
 
@@ -328,9 +326,7 @@ void GainCal::show(std::ostream& os) const {
   os << "  apply solution:      " << std::boolalpha << itsApplySolution << '\n';
   os << "  propagate solutions: " << std::boolalpha << itsPropagateSolutions
      << '\n';
-  if (!itsUseH5Parm) {
-    os << "  timeslotsperparmupdate: " << itsTimeSlotsPerParmUpdate << '\n';
-  }
+  os << "  timeslotsperparmupdate: " << itsTimeSlotsPerParmUpdate << '\n';
   os << "  detect stalling:     " << std::boolalpha << itsDetectStalling
      << '\n';
   os << "  use model column:    " << std::boolalpha << itsUseModelColumn
@@ -454,8 +450,12 @@ bool GainCal::process(const DPBuffer& bufin) {
 
   itsTimer.stop();
 
-  if (!itsUseH5Parm && (itsStepInParmUpdate == itsTimeSlotsPerParmUpdate)) {
-    writeSolutionsParmDB(itsChunkStartTime);
+  if (itsStepInParmUpdate == itsTimeSlotsPerParmUpdate) {
+    if (itsUseH5Parm) {
+      writeSolutionsH5Parm(itsChunkStartTime);
+    } else {
+      writeSolutionsParmDB(itsChunkStartTime);
+    }
     itsChunkStartTime +=
         itsSolInt * itsTimeSlotsPerParmUpdate * info().timeInterval();
     itsSols.clear();
@@ -564,28 +564,17 @@ void GainCal::fillMatrices(casacore::Complex* model, casacore::Complex* data,
           // The nCrDiv is there such that for nCr==2 the visibilities end up at
           // (0,0) for cr==0, (1,1) for cr==1
           unsigned int nCrDiv = (nCr == 4 ? 2 : 1);
-          iS[ch / itsNChan].getVis()(IPosition(6, ant1, cr / nCrDiv,
-                                               itsStepInSolInt, ch % itsNChan,
-                                               cr % 2, ant2)) =
-              casacore::DComplex(data[bl * nCr * nCh + ch * nCr + cr]) *
-              casacore::DComplex(sqrt(weight[bl * nCr * nCh + ch * nCr + cr]));
-          iS[ch / itsNChan].getMVis()(IPosition(6, ant1, cr / nCrDiv,
-                                                itsStepInSolInt, ch % itsNChan,
-                                                cr % 2, ant2)) =
-              casacore::DComplex(model[bl * nCr * nCh + ch * nCr + cr]) *
-              casacore::DComplex(sqrt(weight[bl * nCr * nCh + ch * nCr + cr]));
-
+          const size_t index = bl * nCr * nCh + ch * nCr + cr;
+          const float sqrtWeight = std::sqrt(weight[index]);
+          const casacore::Complex vis = data[index] * sqrtWeight;
+          const casacore::Complex mvis = model[index] * sqrtWeight;
+          iS[ch / itsNChan].setVisibility(ant1, cr / nCrDiv, itsStepInSolInt,
+                                          ch % itsNChan, cr % 2, ant2, vis,
+                                          mvis);
           // conjugate transpose
-          iS[ch / itsNChan].getVis()(IPosition(6, ant2, cr % 2, itsStepInSolInt,
-                                               ch % itsNChan, cr / nCrDiv,
-                                               ant1)) =
-              casacore::DComplex(conj(data[bl * nCr * nCh + ch * nCr + cr])) *
-              casacore::DComplex(sqrt(weight[bl * nCr * nCh + ch * nCr + cr]));
-          iS[ch / itsNChan].getMVis()(IPosition(6, ant2, cr % 2,
-                                                itsStepInSolInt, ch % itsNChan,
-                                                cr / nCrDiv, ant1)) =
-              casacore::DComplex(conj(model[bl * nCr * nCh + ch * nCr + cr])) *
-              casacore::DComplex(sqrt(weight[bl * nCr * nCh + ch * nCr + cr]));
+          iS[ch / itsNChan].setVisibility(ant2, cr % 2, itsStepInSolInt,
+                                          ch % itsNChan, cr / nCrDiv, ant1,
+                                          std::conj(vis), std::conj(mvis));
         }
       }
     }
@@ -622,20 +611,34 @@ void GainCal::calibrate() {
   std::vector<GainCalAlgorithm::Status> converged(
       itsNFreqCells, GainCalAlgorithm::NOTCONVERGED);
 
+  // With fewer frequency cells than threads, solve the frequency cells one
+  // after the other and parallelize over the stations within a cell.
+  const bool parallelStations = itsNFreqCells < itsParallelFor.NThreads();
+
   for (; iter < itsMaxIter; ++iter) {
     bool allConverged = true;
-    itsParallelFor.Run(
-        0, itsNFreqCells, [&](size_t freqCell, size_t /*thread*/) {
-          // Do another step when stalled and not all converged
-          if (converged[freqCell] != GainCalAlgorithm::CONVERGED) {
-            converged[freqCell] = iS[freqCell].doStep(iter);
-            // Only continue if there are steps worth continuing
-            // (so not converged, failed or stalled)
-            if (converged[freqCell] == GainCalAlgorithm::NOTCONVERGED) {
-              allConverged = false;
-            }
-          }
-        });
+    auto doStep = [&](size_t freqCell,
+                      aocommon::ParallelFor<size_t>* stationLoop) {
+      // Do another step when stalled and not all converged
+      if (converged[freqCell] != GainCalAlgorithm::CONVERGED) {
+        converged[freqCell] = iS[freqCell].doStep(iter, stationLoop);
+        // Only continue if there are steps worth continuing
+        // (so not converged, failed or stalled)
+        if (converged[freqCell] == GainCalAlgorithm::NOTCONVERGED) {
+          allConverged = false;
+        }
+      }
+    };
+    if (parallelStations) {
+      for (unsigned int freqCell = 0; freqCell < itsNFreqCells; ++freqCell) {
+        doStep(freqCell, &itsParallelFor);
+      }
+    } else {
+      itsParallelFor.Run(0, itsNFreqCells,
+                         [&](size_t freqCell, size_t /*thread*/) {
+                           doStep(freqCell, nullptr);
+                         });
+    }
 
     if (itsDebugLevel > 0) {
       for (unsigned int freqCell = 0; freqCell < itsNFreqCells; ++freqCell) {
@@ -891,11 +894,10 @@ std::string GainCal::parmName() {
   return name;
 }
 
-void GainCal::writeSolutionsH5Parm(double) {
-  itsTimer.start();
-  itsTimerWrite.start();
-
-  H5Parm h5parm(itsParmDBName, true);
+void GainCal::initH5Parm() {
+  itsH5Parm = boost::make_unique<H5Parm>(itsParmDBName, true);
+  itsExtendibleSolTabs =
+      boost::make_unique<ddecal::ExtendibleSolTabs>(itsParmDBName);
 
   // Fill antenna info in H5Parm, need to convert from casa types to std types
   std::vector<std::string> allAntennaNames(info().antennaNames().size());
@@ -909,7 +911,7 @@ void GainCal::writeSolutionsH5Parm(double) {
     antennaPos[i][2] = pos.getValue()[2];
   }
 
-  h5parm.AddAntennas(allAntennaNames, antennaPos);
+  itsH5Parm->AddAntennas(allAntennaNames, antennaPos);
 
   std::vector<std::pair<double, double>> pointingPosition(1);
   casacore::MDirection phasecenter = info().phaseCenter();
@@ -917,7 +919,7 @@ void GainCal::writeSolutionsH5Parm(double) {
   pointingPosition[0].second = phasecenter.getValue().get()[1];
   std::vector<string> pointingName(1, "POINTING");
 
-  h5parm.AddSources(pointingName, pointingPosition);
+  itsH5Parm->AddSources(pointingName, pointingPosition);
 
   unsigned int nPol;
   std::vector<string> polarizations;
@@ -936,15 +938,6 @@ void GainCal::writeSolutionsH5Parm(double) {
     nPol = 4;
   }
 
-  // Construct time axis
-  unsigned int nSolTimes = (info().ntime() + itsSolInt - 1) / itsSolInt;
-  std::vector<double> solTimes(nSolTimes);
-  assert(nSolTimes == itsSols.size());
-  double starttime = info().startTime();
-  for (unsigned int t = 0; t < nSolTimes; ++t) {
-    solTimes[t] = starttime + (t + 0.5) * info().timeInterval() * itsSolInt;
-  }
-
   // Construct frequency axis
   unsigned int nSolFreqs;
   if (itsMode == CalType::kTec || itsMode == CalType::kTecAndPhase) {
@@ -953,56 +946,77 @@ void GainCal::writeSolutionsH5Parm(double) {
     nSolFreqs = itsNFreqCells;
   }
 
+  // The time axis is extended when solutions are written.
   std::vector<AxisInfo> axes;
-  axes.push_back(AxisInfo("time", itsSols.size()));
+  axes.push_back(AxisInfo("time", 0));
   axes.push_back(AxisInfo("freq", nSolFreqs));
   axes.push_back(AxisInfo("ant", info().antennaUsed().size()));
   if (nPol > 1) {
     axes.push_back(AxisInfo("pol", nPol));
   }
 
-  std::vector<SolTab> soltabs = makeSolTab(h5parm, itsMode, axes);
+  itsSolTabs = makeSolTab(*itsH5Parm, itsMode, axes);
 
   std::vector<std::string> antennaUsedNames;
   for (unsigned int st = 0; st < info().antennaUsed().size(); ++st) {
     antennaUsedNames.push_back(info().antennaNames()[info().antennaUsed()[st]]);
   }
 
-  std::vector<SolTab>::iterator soltabiter = soltabs.begin();
-  for (; soltabiter != soltabs.end(); ++soltabiter) {
-    (*soltabiter).SetAntennas(antennaUsedNames);
+  string historyString = "CREATE by " + DP3Version::AsString() + "\n" +
+                         "step " + itsName + " in parset: \n" + itsParsetString;
+
+  for (SolTab& soltab : itsSolTabs) {
+    itsExtendibleSolTabs->Create(soltab, historyString);
+    soltab.SetAntennas(antennaUsedNames);
     if (nPol > 1) {
-      (*soltabiter).SetPolarizations(polarizations);
+      soltab.SetPolarizations(polarizations);
     }
     if (itsMode == CalType::kTec || itsMode == CalType::kTecAndPhase) {
       // Set channel to frequency of middle channel
       // TODO: fix this for nchan
       std::vector<double> oneFreq(1);
       oneFreq[0] = info().chanFreqs()[info().nchan() / 2];
-      (*soltabiter).SetFreqs(oneFreq);
+      soltab.SetFreqs(oneFreq);
     } else {
-      (*soltabiter).SetFreqs(itsFreqData);
+      soltab.SetFreqs(itsFreqData);
     }
-    (*soltabiter).SetTimes(solTimes);
   }
+}
 
-  // Put solutions in a contiguous piece of memory
-  string historyString = "CREATE by " + DP3Version::AsString() + "\n" +
-                         "step " + itsName + " in parset: \n" + itsParsetString;
+void GainCal::writeSolutionsH5Parm(double startTime) {
+  itsTimer.start();
+  itsTimerWrite.start();
+
+  // Create the H5Parm at the first write, like the ParmDB.
+  if (!itsH5Parm) {
+    initH5Parm();
+  }
+
+  const SolTab& firstSolTab = itsSolTabs.front();
+  const unsigned int nSolFreqs = firstSolTab.GetAxis("freq").size;
+  const unsigned int nPol =
+      firstSolTab.HasAxis("pol") ? firstSolTab.GetAxis("pol").size : 1;
+  const unsigned int nSt = info().antennaUsed().size();
 
+  // Construct time axis of the solutions since the previous write
+  const unsigned int nSolTimes = itsSols.size();
+  std::vector<double> solTimes(nSolTimes);
+  for (unsigned int t = 0; t < nSolTimes; ++t) {
+    solTimes[t] = startTime + (t + 0.5) * info().timeInterval() * itsSolInt;
+  }
+
+  // Put solutions in a contiguous piece of memory
   if (itsMode == CalType::kTec || itsMode == CalType::kTecAndPhase) {
-    std::vector<double> tecsols(nSolFreqs * antennaUsedNames.size() *
-                                nSolTimes * nPol);
-    std::vector<double> weights(
-        nSolFreqs * antennaUsedNames.size() * nSolTimes * nPol, 1.);
+    std::vector<double> tecsols(nSolFreqs * nSt * nSolTimes * nPol);
+    std::vector<double> weights(nSolFreqs * nSt * nSolTimes * nPol, 1.);
     std::vector<double> phasesols;
     if (itsMode == CalType::kTecAndPhase) {
-      phasesols.resize(nSolFreqs * antennaUsedNames.size() * nSolTimes * nPol);
+      phasesols.resize(nSolFreqs * nSt * nSolTimes * nPol);
     }
     size_t i = 0;
     for (unsigned int time = 0; time < nSolTimes; ++time) {
       for (unsigned int freqCell = 0; freqCell < nSolFreqs; ++freqCell) {
-        for (unsigned int ant = 0; ant < info().antennaUsed().size(); ++ant) {
+        for (unsigned int ant = 0; ant < nSt; ++ant) {
           for (unsigned int pol = 0; pol < nPol; ++pol) {
             assert(!itsTECSols[time].empty());
             tecsols[i] = itsTECSols[time](0, ant) / 8.44797245e9;
@@ -1017,19 +1031,18 @@ void GainCal::writeSolutionsH5Parm(double) {
         }
       }
     }
-    soltabs[0].SetValues(tecsols, weights, historyString);
+    itsExtendibleSolTabs->Append(itsSolTabs[0], tecsols, weights, solTimes);
     if (itsMode == CalType::kTecAndPhase) {
-      soltabs[1].SetValues(phasesols, weights, historyString);
+      itsExtendibleSolTabs->Append(itsSolTabs[1], phasesols, weights,
+                                   solTimes);
     }
   } else {
-    std::vector<casacore::DComplex> sols(nSolFreqs * antennaUsedNames.size() *
-                                         nSolTimes * nPol);
-    std::vector<double> weights(
-        nSolFreqs * antennaUsedNames.size() * nSolTimes * nPol, 1.);
+    std::vector<casacore::DComplex> sols(nSolFreqs * nSt * nSolTimes * nPol);
+    std::vector<double> weights(nSolFreqs * nSt * nSolTimes * nPol, 1.);
     size_t i = 0;
     for (unsigned int time = 0; time < nSolTimes; ++time) {
       for (unsigned int freqCell = 0; freqCell < nSolFreqs; ++freqCell) {
-        for (unsigned int ant = 0; ant < info().antennaUsed().size(); ++ant) {
+        for (unsigned int ant = 0; ant < nSt; ++ant) {
           for (unsigned int pol = 0; pol < nPol; ++pol) {
             assert(!itsSols[time].empty());
             sols[i] = itsSols[time](pol, ant, freqCell);
@@ -1043,13 +1056,16 @@ void GainCal::writeSolutionsH5Parm(double) {
     }
 
     if (itsMode != CalType::kDiagonalAmplitude) {
-      soltabs[0].SetComplexValues(sols, weights, false, historyString);
+      itsExtendibleSolTabs->AppendComplex(itsSolTabs[0], sols, weights, false,
+                                          solTimes);
     } else {
-      soltabs[0].SetComplexValues(sols, weights, true, historyString);
+      itsExtendibleSolTabs->AppendComplex(itsSolTabs[0], sols, weights, true,
+                                          solTimes);
     }
-    if (soltabs.size() > 1) {
+    if (itsSolTabs.size() > 1) {
       // Also write amplitudes
-      soltabs[1].SetComplexValues(sols, weights, true, historyString);
+      itsExtendibleSolTabs->AppendComplex(itsSolTabs[1], sols, weights, true,
+                                          solTimes);
     }
   }
 
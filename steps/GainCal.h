@@ -21,6 +21,8 @@
 #include "../base/Patch.h"
 #include "../base/SourceDBUtil.h"
 
+#include "../ddecal/SolutionWriter.h"
+
 #include "../parmdb/Parm.h"
 #include "../parmdb/ParmFacade.h"
 #include "../parmdb/ParmSet.h"
@@ -122,6 +124,11 @@ class GainCal final : public Step {
 
   /// Write out the solutions of the current parameter chunk
   /// (timeslotsperparmupdate) Variant for writing H5Parm
+  /// Create the H5Parm with soltabs that are extended by
+  /// writeSolutionsH5Parm.
+  void initH5Parm();
+
+  /// Append the solutions since the previous write to the H5Parm.
   void writeSolutionsH5Parm(double startTime);
 
   InputStep& itsInput;
@@ -132,6 +139,9 @@ class GainCal final : public Step {
   std::string itsParmDBName;
   bool itsUseH5Parm;
   std::shared_ptr<parmdb::ParmDB> itsParmDB;
+  std::unique_ptr<schaapcommon::h5parm::H5Parm> itsH5Parm;
+  std::vector<schaapcommon::h5parm::SolTab> itsSolTabs;  ///< In itsH5Parm
+  std::unique_ptr<ddecal::ExtendibleSolTabs> itsExtendibleSolTabs;
   std::string itsParsetString;  ///< Parset, for logging in H5Parm
 
   base::CalType itsMode;
@@ -20,6 +20,8 @@
 #include <casacore/casa/Arrays/Vector.h>
 
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace casacore {
 class MeasurementSet;
@@ -89,6 +91,13 @@ class InputStep : public Step {
   /// this will stay true.
   virtual void setReadVisData(bool);
 
+  /// Tell that the visibility data are only needed for the baselines that
+  /// are true in the vector. Like setReadVisData, baselines that were needed
+  /// before stay needed. The default implementation reads all baselines.
+  virtual void setReadVisDataBaselines(const std::vector<bool>&) {
+    setReadVisData(true);
+  }
+
   /// Get the main MS table.
   const virtual casacore::Table& table() const;
 
@@ -144,6 +153,22 @@ class InputStep : public Step {
   /// Creates an MS reader.
   /// Based on the MS it will create either a BDAMSReader or a regular
   static std::unique_ptr<InputStep> CreateReader(const common::ParameterSet&);
+
+  /// Set the mutex that guards the table and file accesses of the steps that
+  /// use this input. It is used when several step chains process the same MS
+  /// concurrently, since casacore tables and HDF5 files can not be used by
+  /// multiple threads at the same time. The mutex should outlive the step.
+  /// By default there is no mutex.
+  virtual void setIoMutex(std::mutex* mutex) { io_mutex_ = mutex; }
+
+  /// Lock the I/O mutex, if set, until the returned lock is destroyed.
+  std::unique_lock<std::mutex> lockIo() const {
+    return io_mutex_ ? std::unique_lock<std::mutex>(*io_mutex_)
+                     : std::unique_lock<std::mutex>();
+  }
+
+ private:
+  std::mutex* io_mutex_ = nullptr;
 };
 
 }  // namespace steps
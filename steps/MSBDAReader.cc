@@ -174,61 +174,65 @@ bool MSBDAReader::process(const DPBuffer&) {
   auto buffer = boost::make_unique<base::BDABuffer>(
       info().nbaselines() * info().nchan() * info().ncorr());
 
-  ScalarColumn<int> ant1_col(ms_, MS::columnName(MS::ANTENNA1));
-  ScalarColumn<int> ant2_col(ms_, MS::columnName(MS::ANTENNA2));
-  ArrayColumn<float> weights_col(ms_, MS::columnName(MS::WEIGHT_SPECTRUM));
-  ArrayColumn<casacore::Complex> data_col(ms_, MS::columnName(MS::DATA));
-  ArrayColumn<double> uvw_col(ms_, MS::columnName(MS::UVW));
-  ScalarColumn<double> time_col(ms_, MS::columnName(MS::TIME));
-  ScalarColumn<double> interval_col(ms_, MS::columnName(MS::INTERVAL));
-  ScalarColumn<double> exposure_col(ms_, MS::columnName(MS::EXPOSURE));
-  ScalarColumn<int> data_desc_id_col(ms_, MS::columnName(MS::DATA_DESC_ID));
-
-  // Cache the data that will be add to the buffer
-  RefRows cell_range{
-      nread_,
-      std::min(ms_.nrow() - 1, common::rownr_t(nread_ + info().nbaselines()))};
-
-  auto time = time_col.getColumnCells(cell_range);
-  auto interval = interval_col.getColumnCells(cell_range);
-  auto exposure = exposure_col.getColumnCells(cell_range);
-  auto data_desc_id = data_desc_id_col.getColumnCells(cell_range);
-
-  unsigned i = 0;
-  while (nread_ < ms_.nrow() && i < info().nbaselines()) {
-    const double ms_time = time[i];
-    const double ms_interval = interval[i];
-
-    if (ms_time + ms_interval / 2 <
-        last_ms_time_ + last_ms_interval_ / 2 - 0.001) {
-      DPLOG_WARN_STR("Time at rownr " + std::to_string(nread_) + " of MS " +
-                     msName() + " is less than previous time slot");
+  {
+    // Other threads may not use casacore while the rows are read.
+    const std::unique_lock<std::mutex> lock = lockIo();
+    ScalarColumn<int> ant1_col(ms_, MS::columnName(MS::ANTENNA1));
+    ScalarColumn<int> ant2_col(ms_, MS::columnName(MS::ANTENNA2));
+    ArrayColumn<float> weights_col(ms_, MS::columnName(MS::WEIGHT_SPECTRUM));
+    ArrayColumn<casacore::Complex> data_col(ms_, MS::columnName(MS::DATA));
+    ArrayColumn<double> uvw_col(ms_, MS::columnName(MS::UVW));
+    ScalarColumn<double> time_col(ms_, MS::columnName(MS::TIME));
+    ScalarColumn<double> interval_col(ms_, MS::columnName(MS::INTERVAL));
+    ScalarColumn<double> exposure_col(ms_, MS::columnName(MS::EXPOSURE));
+    ScalarColumn<int> data_desc_id_col(ms_, MS::columnName(MS::DATA_DESC_ID));
+
+    // Cache the data that will be add to the buffer
+    RefRows cell_range{nread_,
+                       std::min(ms_.nrow() - 1,
+                                common::rownr_t(nread_ + info().nbaselines()))};
+
+    auto time = time_col.getColumnCells(cell_range);
+    auto interval = interval_col.getColumnCells(cell_range);
+    auto exposure = exposure_col.getColumnCells(cell_range);
+    auto data_desc_id = data_desc_id_col.getColumnCells(cell_range);
+
+    unsigned i = 0;
+    while (nread_ < ms_.nrow() && i < info().nbaselines()) {
+      const double ms_time = time[i];
+      const double ms_interval = interval[i];
+
+      if (ms_time + ms_interval / 2 <
+          last_ms_time_ + last_ms_interval_ / 2 - 0.001) {
+        DPLOG_WARN_STR("Time at rownr " + std::to_string(nread_) + " of MS " +
+                       msName() + " is less than previous time slot");
+        ++i;
+        ++nread_;
+        continue;
+      }
+
+      const auto ant12 = std::make_pair(ant1_col(nread_), ant2_col(nread_));
+      casacore::Complex* data_ptr = nullptr;
+      std::vector<casacore::Complex> data;
+      if (read_vis_data_) {
+        data = data_col.get(nread_).tovector();
+        data_ptr = data.data();
+      }
+      Cube<float> weights = weights_col.get(nread_);
+      Cube<double> uvw = uvw_col.get(nread_);
+
+      const bool success = buffer->AddRow(
+          ms_time, interval[i], exposure[i], bl_to_id_[ant12],
+          desc_id_to_nchan_[data_desc_id[i]], info().ncorr(), data_ptr, nullptr,
+          weights.tovector().data(), nullptr, uvw.tovector().data());
+      (void)success;
+      assert(success);  // The buffer should always be large enough.
+
+      last_ms_time_ = ms_time;
+      last_ms_interval_ = ms_interval;
       ++i;
       ++nread_;
-      continue;
-    }
-
-    const auto ant12 = std::make_pair(ant1_col(nread_), ant2_col(nread_));
-    casacore::Complex* data_ptr = nullptr;
-    std::vector<casacore::Complex> data;
-    if (read_vis_data_) {
-      data = data_col.get(nread_).tovector();
-      data_ptr = data.data();
     }
-    Cube<float> weights = weights_col.get(nread_);
-    Cube<double> uvw = uvw_col.get(nread_);
-
-    const bool success = buffer->AddRow(
-        ms_time, interval[i], exposure[i], bl_to_id_[ant12],
-        desc_id_to_nchan_[data_desc_id[i]], info().ncorr(), data_ptr, nullptr,
-        weights.tovector().data(), nullptr, uvw.tovector().data());
-    (void)success;
-    assert(success);  // The buffer should always be large enough.
-
-    last_ms_time_ = ms_time;
-    last_ms_interval_ = ms_interval;
-    ++i;
-    ++nread_;
   }
 
   getNextStep()->process(std::move(buffer));
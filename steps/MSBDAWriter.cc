@@ -9,6 +9,8 @@
 #include "../base/DPLogger.h"
 #include "../base/MS.h"
 
+#include <casacore/casa/Arrays/Matrix.h>
+#include <casacore/casa/Arrays/Slicer.h>
 #include <casacore/ms/MeasurementSets/MeasurementSet.h>
 #include <casacore/tables/DataMan/IncrementalStMan.h>
 #include <casacore/tables/DataMan/StandardStMan.h>
@@ -19,6 +21,7 @@
 #include <casacore/tables/Tables/TableDesc.h>
 #include <casacore/tables/TaQL/TableParse.h>
 
+#include <algorithm>
 #include <map>
 
 using casacore::Array;
@@ -34,10 +37,12 @@ using casacore::IncrementalStMan;
 using casacore::Int;
 using casacore::IPosition;
 using casacore::MeasurementSet;
+using casacore::Matrix;
 using casacore::MS;
 using casacore::ScalarColumn;
 using casacore::ScalarColumnDesc;
 using casacore::SetupNewTable;
+using casacore::Slicer;
 using casacore::StandardStMan;
 using casacore::Table;
 using casacore::TableCopy;
@@ -55,6 +60,16 @@ namespace {
 const std::string kBDATimeAxisVersionKW = "BDA_TIME_AXIS_VERSION";
 const std::string kBDATimeAxisVersion = "1.0";
 /// @}
+
+/// True if @p next directly follows @p row in the buffers of their BDABuffer
+/// and has the same shape, such that both can be written as one array.
+bool IsNextInRun(const BDABuffer::Row& row, const BDABuffer::Row& next) {
+  const std::size_t size = row.GetDataSize();
+  return next.n_channels == row.n_channels &&
+         next.n_correlations == row.n_correlations &&
+         next.data == row.data + size && next.weights == row.weights + size &&
+         next.flags == row.flags + size;
+}
 }  // namespace
 
 namespace dp3 {
@@ -67,9 +82,16 @@ MSBDAWriter::MSBDAWriter(InputStep* reader, const std::string& out_name,
       outName_(out_name),
       parset_(parset),
       prefix_(prefix),
-      overwrite_(parset.getBool(prefix + "overwrite", false)) {}
+      overwrite_(parset.getBool(prefix + "overwrite", false)),
+      async_write_(parset.getBool(prefix + "asyncwrite", false)) {
+  // The writing thread and the reader may not use casacore at the same time.
+  if (async_write_ && reader_) reader_->setIoMutex(&io_mutex_);
+}
 
-MSBDAWriter::~MSBDAWriter() {}
+MSBDAWriter::~MSBDAWriter() {
+  // Do not throw from the destructor; finish() reports write errors.
+  if (pending_write_.valid()) pending_write_.wait();
+}
 
 void MSBDAWriter::updateInfo(const DPInfo& info_in) {
   if (info_in.ntimeAvgs().size() != info_in.nbaselines()) {
@@ -89,68 +111,106 @@ void MSBDAWriter::updateInfo(const DPInfo& info_in) {
 }
 
 bool MSBDAWriter::process(std::unique_ptr<BDABuffer> buffer) {
+  if (async_write_) {
+    // Waiting for the previous buffer also rethrows its write errors.
+    if (pending_write_.valid()) pending_write_.get();
+    pending_write_ = std::async(std::launch::async, &MSBDAWriter::WriteBuffer,
+                                this, std::move(buffer));
+  } else {
+    WriteBuffer(std::move(buffer));
+  }
+  return true;
+}
+
+void MSBDAWriter::WriteBuffer(std::unique_ptr<BDABuffer> buffer) {
+  const std::unique_lock<std::mutex> lock =
+      reader_ ? reader_->lockIo() : std::unique_lock<std::mutex>();
   buffer->SetBaseRowNr(ms_.nrow());
 
   const std::vector<BDABuffer::Row>& rows = buffer->GetRows();
-
-  ms_.addRow(rows.size());
-
-  Vector<Float> sigma_weight(info().ncorr(), 1);
-
-  ScalarColumn<Double> time(ms_, MS::columnName(MS::TIME));
-  ScalarColumn<Double> time_centroid(ms_, MS::columnName(MS::TIME_CENTROID));
-  ScalarColumn<Double> exposure(ms_, MS::columnName(MS::EXPOSURE));
-  ScalarColumn<Int> ant1(ms_, MS::columnName(MS::ANTENNA1));
-  ScalarColumn<Int> ant2(ms_, MS::columnName(MS::ANTENNA2));
+  if (rows.empty()) return;
+  const std::size_t n_rows = rows.size();
+  const common::rownr_t first_row = rows.front().row_nr;
+
+  ms_.addRow(n_rows);
+
+  // Collect the metadata of all rows, so each column is written at once.
+  Vector<Double> times(n_rows);
+  Vector<Double> intervals(n_rows);
+  Vector<Double> exposures(n_rows);
+  Vector<Int> ant1(n_rows);
+  Vector<Int> ant2(n_rows);
+  Vector<Int> data_desc_ids(n_rows);
+  Vector<Bool> row_flags(n_rows);
+  Matrix<Double> uvws(3, n_rows);
+  for (std::size_t i = 0; i < n_rows; ++i) {
+    const BDABuffer::Row& row = rows[i];
+    times[i] = row.time;
+    intervals[i] = row.interval;
+    exposures[i] = row.exposure;
+    ant1[i] = info().getAnt1()[row.baseline_nr];
+    ant2[i] = info().getAnt2()[row.baseline_nr];
+    data_desc_ids[i] = nchanToDescId[row.n_channels];
+    // Set the row_flag if all flags in the row are true / none are false.
+    row_flags[i] =
+        std::count(row.flags, row.flags + row.GetDataSize(), false) == 0;
+    std::copy_n(row.uvw, 3, &uvws(0, i));
+  }
+  const Matrix<Float> sigma_weight(info().ncorr(), n_rows, 1.0f);
+
+  const Slicer row_range(IPosition(1, first_row), IPosition(1, n_rows));
+  ScalarColumn<Double>(ms_, MS::columnName(MS::TIME))
+      .putColumnRange(row_range, times);
+  ScalarColumn<Double>(ms_, MS::columnName(MS::TIME_CENTROID))
+      .putColumnRange(row_range, times);
+  ScalarColumn<Double>(ms_, MS::columnName(MS::INTERVAL))
+      .putColumnRange(row_range, intervals);
+  ScalarColumn<Double>(ms_, MS::columnName(MS::EXPOSURE))
+      .putColumnRange(row_range, exposures);
+  ScalarColumn<Int>(ms_, MS::columnName(MS::ANTENNA1))
+      .putColumnRange(row_range, ant1);
+  ScalarColumn<Int>(ms_, MS::columnName(MS::ANTENNA2))
+      .putColumnRange(row_range, ant2);
+  ScalarColumn<Int>(ms_, MS::columnName(MS::DATA_DESC_ID))
+      .putColumnRange(row_range, data_desc_ids);
+  ScalarColumn<Bool>(ms_, MS::columnName(MS::FLAG_ROW))
+      .putColumnRange(row_range, row_flags);
+  ArrayColumn<Double>(ms_, MS::columnName(MS::UVW))
+      .putColumnRange(row_range, uvws);
+  ArrayColumn<Float>(ms_, MS::columnName(MS::SIGMA))
+      .putColumnRange(row_range, sigma_weight);
+  ArrayColumn<Float>(ms_, MS::columnName(MS::WEIGHT))
+      .putColumnRange(row_range, sigma_weight);
+
+  // Write the visibilities in runs of rows with the same shape. The rows of a
+  // BDABuffer are stored one after another, so a run is a single array.
   ArrayColumn<Complex> data(ms_, MS::columnName(MS::DATA));
   ArrayColumn<Float> weights(ms_, MS::columnName(MS::WEIGHT_SPECTRUM));
   ArrayColumn<Bool> flags(ms_, MS::columnName(MS::FLAG));
-  ScalarColumn<Bool> flags_row(ms_, MS::columnName(MS::FLAG_ROW));
-  ArrayColumn<Double> uvw(ms_, MS::columnName(MS::UVW));
-  ScalarColumn<Double> interval(ms_, MS::columnName(MS::INTERVAL));
-  ArrayColumn<Float> sigma(ms_, MS::columnName(MS::SIGMA));
-  ArrayColumn<Float> weight(ms_, MS::columnName(MS::WEIGHT));
-  ScalarColumn<Int> dataDescId(ms_, MS::columnName(MS::DATA_DESC_ID));
-
-  std::vector<common::rownr_t> row_nrs;
-  row_nrs.reserve(rows.size());
-  for (const BDABuffer::Row& row : rows) {
-    time.put(row.row_nr, row.time);
-    time_centroid.put(row.row_nr, row.time);
-    interval.put(row.row_nr, row.interval);
-    exposure.put(row.row_nr, row.exposure);
-
-    ant1.put(row.row_nr, info().getAnt1()[row.baseline_nr]);
-    ant2.put(row.row_nr, info().getAnt2()[row.baseline_nr]);
-
-    const std::size_t n_chan = info().chanFreqs(row.baseline_nr).size();
-    const IPosition dim(2, info().ncorr(), n_chan);
-    data.put(row.row_nr, Array<Complex>(dim, row.data, casacore::SHARE));
-    weights.put(row.row_nr, Array<Float>(dim, row.weights, casacore::SHARE));
-    flags.put(row.row_nr, Array<Bool>(dim, row.flags, casacore::SHARE));
-    // Set the row_flag if all flags in the row are true / none are false.
-    const bool row_flag =
-        std::count(row.flags, row.flags + row.GetDataSize(), false) == 0;
-    flags_row.put(row.row_nr, row_flag);
-
-    const IPosition uvw_dim(1, 3);
-    uvw.put(row.row_nr, Array<Double>(uvw_dim, row.uvw));
-
-    // Fill values in all the cells of various columns.
-    sigma.put(row.row_nr, sigma_weight);
-    weight.put(row.row_nr, sigma_weight);
-    dataDescId.put(row.row_nr, nchanToDescId[n_chan]);
-
-    row_nrs.push_back(row.row_nr);
+  std::size_t run_start = 0;
+  while (run_start < n_rows) {
+    std::size_t run_end = run_start + 1;
+    while (run_end < n_rows && IsNextInRun(rows[run_end - 1], rows[run_end])) {
+      ++run_end;
+    }
+    const BDABuffer::Row& row = rows[run_start];
+    const IPosition shape(3, row.n_correlations, row.n_channels,
+                          run_end - run_start);
+    const Slicer run_range(IPosition(1, first_row + run_start),
+                           IPosition(1, run_end - run_start));
+    data.putColumnRange(run_range,
+                        Array<Complex>(shape, row.data, casacore::SHARE));
+    weights.putColumnRange(run_range,
+                           Array<Float>(shape, row.weights, casacore::SHARE));
+    flags.putColumnRange(run_range,
+                         Array<Bool>(shape, row.flags, casacore::SHARE));
+    run_start = run_end;
   }
-
-  // Create a table view containing only the added rows.
-  Table tbl_added(ms_(row_nrs));
-
-  return true;
 }
 
-void MSBDAWriter::finish() {}
+void MSBDAWriter::finish() {
+  if (pending_write_.valid()) pending_write_.get();
+}
 
 void MSBDAWriter::addToMS(const std::string&) {
   getPrevStep()->addToMS(outName_);
@@ -163,6 +223,7 @@ void MSBDAWriter::show(std::ostream& os) const {
   os << "  nbaselines:     " << nbl_ << '\n';
   os << "  DATA column:    DATA" << '\n';
   os << "  Compressed:     no\n";
+  os << "  Async write:    " << std::boolalpha << async_write_ << '\n';
 }
 
 void MSBDAWriter::CreateMS() {
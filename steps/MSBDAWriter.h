@@ -9,7 +9,9 @@
 #define DPPP_MSBDAWRITER_H
 
 #include <casacore/tables/Tables/Table.h>
+#include <future>
 #include <map>
+#include <mutex>
 
 #include "Step.h"
 #include "MSReader.h"
@@ -18,6 +20,11 @@
 namespace dp3 {
 namespace steps {
 
+/// Writes BDA buffers to a new MS. Consecutive rows of a buffer with the
+/// same shape are written with a single put per column. If the
+/// 'asyncwrite' parset key is true, a buffer is written in a separate thread
+/// while the previous steps process the next one. The reader then shares an
+/// I/O mutex with the writing thread, since casacore is not thread-safe.
 class MSBDAWriter : public Step {
  public:
   MSBDAWriter(InputStep*, const std::string&, const common::ParameterSet&,
@@ -44,6 +51,9 @@ class MSBDAWriter : public Step {
 
   void CreateMainTable();
 
+  /// Append the rows of a buffer to the main table.
+  void WriteBuffer(std::unique_ptr<base::BDABuffer> buffer);
+
   ///  Add the BDA_TIME_AXIS table to the measurement set
   /// if it does not already exist.
   void CreateBDATimeAxis();
@@ -80,11 +90,16 @@ class MSBDAWriter : public Step {
   const common::ParameterSet parset_;
   const std::string prefix_;
   const bool overwrite_;
+  const bool async_write_;
 
   unsigned int ncorr_;
   unsigned int nbl_;
   std::map<std::size_t, unsigned int> nchanToDescId;
   casacore::Table ms_;
+  /// Write of the previous buffer, if asynchronous writing is enabled.
+  std::future<void> pending_write_;
+  /// Serialises the table access of the writing thread and the reader.
+  std::mutex io_mutex_;
 };
 
 }  // namespace steps
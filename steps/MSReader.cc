@@ -40,6 +40,8 @@
 
 #include <boost/make_unique.hpp>
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
 
 using casacore::ArrayColumn;
@@ -79,7 +81,12 @@ namespace dp3 {
 namespace steps {
 
 MSReader::MSReader()
-    : itsReadVisData(false), itsLastMSTime(0), itsNrRead(0), itsNrInserted(0) {}
+    : itsReadVisData(false),
+      itsComputeUVW(false),
+      itsUVWInterval(0.0),
+      itsLastMSTime(0),
+      itsNrRead(0),
+      itsNrInserted(0) {}
 
 MSReader::MSReader(const casacore::MeasurementSet& ms,
                    const common::ParameterSet& parset, const string& prefix,
@@ -109,6 +116,8 @@ MSReader::MSReader(const casacore::MeasurementSet& ms,
   itsAutoWeight = parset.getBool(prefix + "autoweight", false);
   itsAutoWeightForce = parset.getBool(prefix + "forceautoweight", false);
   itsNeedSort = parset.getBool(prefix + "sort", false);
+  itsComputeUVW = parset.getBool(prefix + "computeuvw", false);
+  itsUVWInterval = parset.getDouble(prefix + "uvwinterval", 0.0);
   itsSelBL = parset.getString(prefix + "baseline", string());
   // Try to open the MS and get its full name.
   if (itsMissingData && ms.isNull()) {
@@ -290,7 +299,34 @@ void MSReader::updateInfo(const DPInfo& dpInfo) {
 std::string MSReader::msName() const { return itsMS.tableName(); }
 
 void MSReader::setReadVisData(bool readVisData) {
-  itsReadVisData = (itsReadVisData || readVisData);
+  if (readVisData) {
+    itsReadVisData = true;
+    itsReadBaselines.clear();
+  }
+}
+
+void MSReader::setReadVisDataBaselines(const std::vector<bool>& baselines) {
+  if (itsReadVisData && itsReadBaselines.empty()) {
+    // All baselines are read already.
+    return;
+  }
+  if (baselines.size() != itsNrBl) {
+    // The vector refers to other baselines, so read them all.
+    setReadVisData(true);
+    return;
+  }
+  if (itsReadVisData) {
+    std::transform(itsReadBaselines.begin(), itsReadBaselines.end(),
+                   baselines.begin(), itsReadBaselines.begin(),
+                   std::logical_or<bool>());
+  } else {
+    itsReadBaselines = baselines;
+    itsReadVisData = true;
+  }
+  if (std::all_of(itsReadBaselines.begin(), itsReadBaselines.end(),
+                  [](bool read) { return read; })) {
+    itsReadBaselines.clear();
+  }
 }
 
 bool MSReader::process(const DPBuffer&) {
@@ -304,6 +340,7 @@ bool MSReader::process(const DPBuffer&) {
   }
   {
     common::NSTimer::StartStop sstime(itsTimer);
+    const std::unique_lock<std::mutex> lock = lockIo();
     // Use time from the current time slot in the MS.
     bool useIter = false;
     while (!itsIter.pastEnd()) {
@@ -368,13 +405,7 @@ bool MSReader::process(const DPBuffer&) {
             ScalarColumn<double>(itsIter.table(), "EXPOSURE")(0));
         // Get data and flags from the MS.
         if (itsReadVisData) {
-          ArrayColumn<casacore::Complex> dataCol(itsIter.table(),
-                                                 itsDataColName);
-          if (itsUseAllChan) {
-            dataCol.getColumn(itsBuffer.getData());
-          } else {
-            dataCol.getColumn(itsColSlicer, itsBuffer.getData());
-          }
+          readData(itsIter.table());
         }
         if (itsUseFlags) {
           ArrayColumn<bool> flagCol(itsIter.table(), itsFlagColName);
@@ -384,9 +415,10 @@ bool MSReader::process(const DPBuffer&) {
             flagCol.getColumn(itsColSlicer, itsBuffer.getFlags());
           }
           // Set flags if FLAG_ROW is set.
-          ScalarColumn<bool> flagrowCol(itsIter.table(), "FLAG_ROW");
-          for (unsigned int i = 0; i < itsIter.table().nrow(); ++i) {
-            if (flagrowCol(i)) {
+          const casacore::Vector<bool> flagRows =
+              ScalarColumn<bool>(itsIter.table(), "FLAG_ROW").getColumn();
+          for (unsigned int i = 0; i < flagRows.size(); ++i) {
+            if (flagRows[i]) {
               itsBuffer.getFlags()(
                   IPosition(3, 0, 0, i),
                   IPosition(3, itsNrCorr - 1, itsNrChan - 1, i)) = true;
@@ -415,6 +447,31 @@ bool MSReader::process(const DPBuffer&) {
   return true;
 }
 
+void MSReader::readData(const Table& slot) {
+  ArrayColumn<casacore::Complex> dataCol(slot, itsDataColName);
+  Cube<casacore::Complex>& data = itsBuffer.getData();
+  if (itsReadBaselines.empty()) {
+    if (itsUseAllChan) {
+      dataCol.getColumn(data);
+    } else {
+      dataCol.getColumn(itsColSlicer, data);
+    }
+  } else {
+    // Only read the cells of the baselines that are needed.
+    data = casacore::Complex();
+    for (unsigned int bl = 0; bl < itsNrBl; ++bl) {
+      if (itsReadBaselines[bl]) {
+        Matrix<casacore::Complex> cell = data.xyPlane(bl);
+        if (itsUseAllChan) {
+          dataCol.get(bl, cell);
+        } else {
+          dataCol.getSlice(bl, itsColSlicer, cell);
+        }
+      }
+    }
+  }
+}
+
 void MSReader::flagInfNaN(const casacore::Cube<casacore::Complex>& dataCube,
                           casacore::Cube<bool>& flagsCube,
                           FlagCounter& flagCounter) {
@@ -471,9 +528,21 @@ void MSReader::show(std::ostream& os) const {
       os << "  (not present)";
     }
     os << '\n';
+    if (itsReadVisData && !itsReadBaselines.empty()) {
+      os << "  data read for:  "
+         << std::count(itsReadBaselines.begin(), itsReadBaselines.end(), true)
+         << " of " << itsNrBl << " baselines\n";
+    }
     os << "  WEIGHT column:  " << itsWeightColName << '\n';
     os << "  FLAG column:    " << itsFlagColName << '\n';
     os << "  autoweight:     " << std::boolalpha << itsAutoWeight << '\n';
+    if (itsComputeUVW) {
+      os << "  UVW:            calculated";
+      if (itsUVWInterval > 0.0) {
+        os << " (rotation interpolated over " << itsUVWInterval << " s)";
+      }
+      os << '\n';
+    }
   }
 }
 
@@ -661,8 +730,8 @@ void MSReader::prepare(double& firstTime, double& lastTime, double& interval) {
   }
   info().set(arrayPos, phaseCenter, delayCenter, tileBeamDir);
   // Create the UVW calculator.
-  itsUVWCalc =
-      boost::make_unique<base::UVWCalculator>(phaseCenter, arrayPos, antPos);
+  itsUVWCalc = boost::make_unique<base::UVWCalculator>(
+      phaseCenter, arrayPos, antPos, itsUVWInterval);
 }
 
 void MSReader::prepare2() {
@@ -747,23 +816,15 @@ void MSReader::skipFirstTimes() {
 }
 
 void MSReader::calcUVW(double time, DPBuffer& buf) {
-  Matrix<double>& uvws = buf.getUVW();
-  uvws.resize(3, itsNrBl);
-  const casacore::Vector<int>& ant1 = getInfo().getAnt1();
-  const casacore::Vector<int>& ant2 = getInfo().getAnt2();
-  double* uvw_ptr = uvws.data();
-  for (unsigned int i = 0; i < itsNrBl; ++i) {
-    const std::array<double, 3> uvw =
-        itsUVWCalc->getUVW(ant1[i], ant2[i], time);
-    std::copy_n(uvw.data(), uvw.size(), uvw_ptr);
-    uvw_ptr += uvw.size();
-  }
+  itsUVWCalc->getUVWs(time, getInfo().getAnt1(), getInfo().getAnt2(),
+                      buf.getUVW());
 }
 
 void MSReader::getUVW(const RefRows& rowNrs, double time, DPBuffer& buf) {
   common::NSTimer::StartStop sstime(itsTimer);
-  // Calculate UVWs if empty rownrs (i.e., missing data).
-  if (rowNrs.rowVector().empty()) {
+  const std::unique_lock<std::mutex> lock = lockIo();
+  // Calculate UVWs if empty rownrs (i.e., missing data) or if asked to.
+  if (itsComputeUVW || rowNrs.rowVector().empty()) {
     calcUVW(time, buf);
   } else {
     ArrayColumn<double> dataCol(itsMS, "UVW");
@@ -773,6 +834,7 @@ void MSReader::getUVW(const RefRows& rowNrs, double time, DPBuffer& buf) {
 
 void MSReader::getWeights(const RefRows& rowNrs, DPBuffer& buf) {
   common::NSTimer::StartStop sstime(itsTimer);
+  const std::unique_lock<std::mutex> lock = lockIo();
   Cube<float>& weights = buf.getWeights();
   // Resize if needed (probably when called for first time).
   if (weights.empty()) {
@@ -869,6 +931,7 @@ void MSReader::autoWeight(Cube<float>& weights, const DPBuffer& buf) {
 
 bool MSReader::getFullResFlags(const RefRows& rowNrs, DPBuffer& buf) {
   common::NSTimer::StartStop sstime(itsTimer);
+  const std::unique_lock<std::mutex> lock = lockIo();
   Cube<bool>& flags = buf.getFullResFlags();
   int norigchan = itsNrChan * itsFullResNChanAvg;
   // Resize if needed (probably when called for first time).
@@ -39,6 +39,10 @@ namespace steps {
 ///           WEIGHT]
 ///  <li> msin.starttime: first time to use [first time in MS]
 ///  <li> msin.endtime: last time to use [last time in MS]
+///  <li> msin.computeuvw: calculate the UVWs instead of reading them [no]
+///  <li> msin.uvwinterval: interval (in seconds) on which the rotation used
+///           to calculate UVWs is obtained from casacore and interpolated in
+///           between. 0 calculates the exact UVWs for each time. [0]
 /// </ul>
 ///
 /// If a time slot is missing, it is inserted with flagged data set to zero.
@@ -89,7 +93,8 @@ namespace steps {
 ///  <tr>
 ///   <td>UVW</td>
 ///   <td>The UVW coordinates in meters as [3,nbaseline].
-///       They are calculated for a missing time slot.
+///       They are calculated for a missing time slot, or for all time
+///       slots if computeuvw is set.
 ///   </td>
 ///  </tr>
 ///  <tr>
@@ -122,6 +127,10 @@ class MSReader : public InputStep {
   /// Finish the processing of this step and subsequent steps.
   void finish() override;
 
+  /// The time range to read is given by the parset, so separate readers can
+  /// read separate time ranges.
+  bool canSplitTime() const override { return true; }
+
   /// Update the general info.
   void updateInfo(const base::DPInfo&) override;
 
@@ -161,6 +170,10 @@ class MSReader : public InputStep {
   /// this will stay true.
   void setReadVisData(bool readVisData) override;
 
+  /// Only read the visibility data of the baselines that are true in the
+  /// vector. The other baselines get zero data.
+  void setReadVisDataBaselines(const std::vector<bool>& baselines) override;
+
   /// Get the main MS table.
   const casacore::Table& table() const override { return itsMS; }
 
@@ -233,7 +246,11 @@ class MSReader : public InputStep {
   /// If needed, it sets itsFirstTime properly.
   void skipFirstTimes();
 
-  /// Calculate the UVWs for a missing time slot.
+  /// Read the visibility data of a time slot, for the baselines given by
+  /// itsReadBaselines.
+  void readData(const casacore::Table& slot);
+
+  /// Calculate the UVWs for a missing time slot or if computeuvw is set.
   void calcUVW(double time, base::DPBuffer&);
 
   /// Calculate the weights from the autocorrelations.
@@ -251,7 +268,11 @@ class MSReader : public InputStep {
   std::string itsNrChanStr;     ///< nchan expression
   std::string itsSelBL;         ///< Baseline selection string
   bool itsReadVisData;          ///< read visibility data?
+  /// Baselines to read the visibility data of; empty means all.
+  std::vector<bool> itsReadBaselines;
   bool itsNeedSort;             ///< sort needed on time,baseline?
+  bool itsComputeUVW;           ///< calculate UVWs instead of reading them?
+  double itsUVWInterval;        ///< UVW rotation interpolation interval (s)
   bool itsAutoWeight;           ///< calculate weights from autocorr?
   bool itsAutoWeightForce;      ///< always calculate weights?
   bool itsHasWeightSpectrum;
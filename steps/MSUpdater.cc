@@ -207,6 +207,7 @@ bool MSUpdater::process(const DPBuffer& buf) {
   }
   itsNrDone++;
   if (itsNrTimesFlush > 0 && itsNrDone % itsNrTimesFlush == 0) {
+    const std::unique_lock<std::mutex> lock = itsReader->lockIo();
     itsMS.flush();
   }
   getNextStep()->process(buf);
@@ -350,6 +351,7 @@ void MSUpdater::showTimings(std::ostream& os, double duration) const {
 void MSUpdater::putFlags(const RefRows& rowNrs, const Cube<bool>& flags) {
   // Only put if rownrs are filled, thus if data were not inserted.
   if (!rowNrs.rowVector().empty()) {
+    const std::unique_lock<std::mutex> lock = itsReader->lockIo();
     Slicer colSlicer(IPosition(2, 0, info().startchan()),
                      IPosition(2, info().ncorr(), info().nchan()));
     ArrayColumn<bool> flagCol(itsMS, itsFlagColName);
@@ -374,6 +376,7 @@ void MSUpdater::putFlags(const RefRows& rowNrs, const Cube<bool>& flags) {
 void MSUpdater::putWeights(const RefRows& rowNrs, const Cube<float>& weights) {
   // Only put if rownrs are filled, thus if data were not inserted.
   if (!rowNrs.rowVector().empty()) {
+    const std::unique_lock<std::mutex> lock = itsReader->lockIo();
     Slicer colSlicer(IPosition(2, 0, info().startchan()),
                      IPosition(2, info().ncorr(), info().nchan()));
     ArrayColumn<float> weightCol(itsMS, itsWeightColName);
@@ -392,6 +395,7 @@ void MSUpdater::putData(const RefRows& rowNrs,
                         const Cube<casacore::Complex>& data) {
   // Only put if rownrs are filled, thus if data were not inserted.
   if (!rowNrs.rowVector().empty()) {
+    const std::unique_lock<std::mutex> lock = itsReader->lockIo();
     Slicer colSlicer(IPosition(2, 0, info().startchan()),
                      IPosition(2, info().ncorr(), info().nchan()));
     ArrayColumn<casacore::Complex> dataCol(itsMS, itsDataColName);
@@ -52,6 +52,10 @@ class MSUpdater : public Step {
   /// Finish the processing of this step and subsequent steps.
   virtual void finish();
 
+  /// Each time slot is written to its own rows, so several updaters can
+  /// write different time ranges of the MS.
+  bool canSplitTime() const override { return true; }
+
   /// Update the general info.
   virtual void updateInfo(const base::DPInfo&);
 
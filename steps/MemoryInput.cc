@@ -0,0 +1,45 @@
+// MemoryInput.cc: Input step for buffers given by the caller
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "MemoryInput.h"
+
+#include <iostream>
+
+using dp3::base::DPBuffer;
+using dp3::base::DPInfo;
+
+namespace dp3 {
+namespace steps {
+
+MemoryInput::MemoryInput(const DPInfo& info) : input_info_(info) {}
+
+MemoryInput::~MemoryInput() {}
+
+void MemoryInput::updateInfo(const DPInfo&) {
+  info() = input_info_;
+}
+
+bool MemoryInput::process(const DPBuffer& buffer) {
+  getNextStep()->process(buffer);
+  return true;
+}
+
+void MemoryInput::finish() { getNextStep()->finish(); }
+
+void MemoryInput::show(std::ostream& os) const {
+  os << "MemoryInput" << '\n';
+  os << "  nbaselines:     " << getInfo().nbaselines() << '\n';
+  os << "  nchan:          " << getInfo().nchan() << '\n';
+  os << "  ncorrelations:  " << getInfo().ncorr() << '\n';
+}
+
+bool MemoryInput::getFullResFlags(const casacore::RefRows&, DPBuffer& buf) {
+  casacore::Cube<bool>& flags = buf.getFullResFlags();
+  flags.resize(getInfo().nchan(), 1, getInfo().nbaselines());
+  flags = false;
+  return false;
+}
+
+}  // namespace steps
+}  // namespace dp3
@@ -0,0 +1,54 @@
+// MemoryInput.h: Input step for buffers given by the caller
+// Copyright (C) 2021 ASTRON (Netherlands Institute for Radio Astronomy)
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DP3_MEMORYINPUT_H
+#define DP3_MEMORYINPUT_H
+
+#include "InputStep.h"
+
+#include "../base/DPInfo.h"
+
+namespace dp3 {
+namespace steps {
+
+/// @brief Input step for buffers that are given by the caller.
+
+/// Unlike MSReader, this step does not read data itself. The meta data is
+/// given when creating the step and each time slot is given to process(),
+/// which passes it on to the next step. Since there is no MeasurementSet,
+/// the buffers should contain the data, flags, weights and UVW coordinates.
+/// Steps that need the MeasurementSet itself, e.g. for the beam, can not be
+/// used after this step.
+class MemoryInput : public InputStep {
+ public:
+  explicit MemoryInput(const base::DPInfo& info);
+
+  ~MemoryInput() override;
+
+  /// Pass the buffer on to the next step.
+  bool process(const base::DPBuffer&) override;
+
+  void finish() override;
+
+  void show(std::ostream&) const override;
+
+  /// There are no full resolution flags, so this sets an empty cube of the
+  /// right shape and returns false.
+  bool getFullResFlags(const casacore::RefRows& rowNrs,
+                       base::DPBuffer&) override;
+
+  unsigned int nchanAvgFullRes() const override { return 1; }
+  unsigned int ntimeAvgFullRes() const override { return 1; }
+
+ private:
+  /// Use the info given to the constructor, instead of the argument.
+  void updateInfo(const base::DPInfo&) override;
+
+  const base::DPInfo input_info_;
+};
+
+}  // namespace steps
+}  // namespace dp3
+
+#endif
@@ -95,6 +95,13 @@ MultiMSReader::MultiMSReader(const std::vector<std::string>& msNames,
 
 MultiMSReader::~MultiMSReader() {}
 
+void MultiMSReader::setIoMutex(std::mutex* mutex) {
+  InputStep::setIoMutex(mutex);
+  for (const std::shared_ptr<MSReader>& reader : itsReaders) {
+    if (reader) reader->setIoMutex(mutex);
+  }
+}
+
 void MultiMSReader::setReadVisData(bool readVisData) {
   itsReadVisData = readVisData || itsReadVisData;
   for (unsigned int i = 0; i < itsReaders.size(); ++i) {
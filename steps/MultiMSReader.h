@@ -157,6 +157,9 @@ class MultiMSReader final : public MSReader {
   /// Get the name of the first MS.
   std::string msName() const override;
 
+  /// Also let the readers of the individual MSs use the mutex.
+  void setIoMutex(std::mutex* mutex) override;
+
  private:
   /// Handle the info for all bands.
   void handleBands();
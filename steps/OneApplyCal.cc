@@ -10,6 +10,7 @@
 #include "MSReader.h"
 
 #include "../base/Exceptions.h"
+#include "../base/BDABuffer.h"
 #include "../base/DPBuffer.h"
 #include "../base/DPInfo.h"
 
@@ -29,6 +30,7 @@
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/make_unique.hpp>
 
+using dp3::base::BDABuffer;
 using dp3::base::DPBuffer;
 using dp3::base::DPInfo;
 
@@ -45,9 +47,10 @@ std::mutex OneApplyCal::theirHDF5Mutex;
 OneApplyCal::OneApplyCal(InputStep* input, const common::ParameterSet& parset,
                          const std::string& prefix,
                          const std::string& defaultPrefix, bool substep,
-                         std::string predictDirection)
+                         std::string predictDirection, MsType inputType)
     : itsInput(input),
       itsName(prefix),
+      itsInputType(inputType),
       itsParmDBName(parset.isDefined(prefix + "parmdb")
                         ? parset.getString(prefix + "parmdb")
                         : parset.getString(defaultPrefix + "parmdb")),
@@ -182,6 +185,28 @@ void OneApplyCal::updateInfo(const DPInfo& infoIn) {
   if (itsNCorr != 4)
     throw std::runtime_error("Applycal only works with 4 correlations");
 
+  if (itsInputType == MsType::kBda) {
+    if (!itsUseH5Parm)
+      throw std::runtime_error("Applycal on BDA data requires an H5Parm");
+    // Baselines with the same channel frequencies share their solutions.
+    itsBdaLayoutFreqs.clear();
+    itsBdaBaselineLayouts.clear();
+    itsBdaChanStarts.clear();
+    for (std::size_t bl = 0; bl < infoIn.nbaselines(); ++bl) {
+      const std::vector<double>& freqs =
+          infoIn.chanFreqs(infoIn.hasBDAChannels() ? bl : 0);
+      auto layout =
+          std::find(itsBdaLayoutFreqs.begin(), itsBdaLayoutFreqs.end(), freqs);
+      if (layout == itsBdaLayoutFreqs.end()) {
+        itsBdaLayoutFreqs.push_back(freqs);
+        layout = itsBdaLayoutFreqs.end() - 1;
+      }
+      itsBdaBaselineLayouts.push_back(layout - itsBdaLayoutFreqs.begin());
+      itsBdaChanStarts.push_back(infoIn.BdaChannelStarts(bl));
+    }
+    itsBdaJonesParameters.clear();
+  }
+
   if (itsUseH5Parm) {
     itsTimeSlotsPerParmUpdate = info().ntime();
   } else {  // Use ParmDB
@@ -297,6 +322,9 @@ void OneApplyCal::updateInfo(const DPInfo& infoIn) {
   }
 
   itsFlagCounter.init(getInfo());
+  // Each thread counts its flags separately; they are merged after each
+  // time slot, because finish is not called if used as a substep.
+  itsFlagCounter.initShards(getInfo().nThreads());
 
   // Check that channels are evenly spaced
   if (!itsUseH5Parm && !info().channelsAreRegular()) {
@@ -348,6 +376,7 @@ bool OneApplyCal::process(const DPBuffer& bufin) {
   itsBuffer.copy(bufin);
 
   if (bufin.getTime() > itsLastTime) {
+    const std::unique_lock<std::mutex> lock = itsInput->lockIo();
     if (itsUseH5Parm) {
       updateParmsH5(bufin.getTime());
     } else {
@@ -372,7 +401,8 @@ bool OneApplyCal::process(const DPBuffer& bufin) {
   size_t nchan = itsBuffer.getData().shape()[1];
 
   aocommon::ParallelFor<size_t> loop(getInfo().nThreads());
-  loop.Run(0, nbl, [&](size_t bl, size_t /*thread*/) {
+  loop.Run(0, nbl, [&](size_t bl, size_t thread) {
+    base::FlagCounter& flagCounter = itsFlagCounter.shard(thread);
     for (size_t chan = 0; chan < nchan; chan++) {
       unsigned int timeFreqOffset = (itsTimeStep * info().nchan()) + chan;
       unsigned int antA = info().getAnt1()[bl];
@@ -384,7 +414,7 @@ bool OneApplyCal::process(const DPBuffer& bufin) {
             &data[bl * itsNCorr * nchan + chan * itsNCorr],
             &weight[bl * itsNCorr * nchan + chan * itsNCorr],
             &flag[bl * itsNCorr * nchan + chan * itsNCorr], bl, chan,
-            itsUpdateWeights, itsFlagCounter);
+            itsUpdateWeights, flagCounter);
       } else {
         ApplyCal::applyDiag(
             &itsJonesParameters->GetParms()(0, antA, timeFreqOffset),
@@ -392,10 +422,11 @@ bool OneApplyCal::process(const DPBuffer& bufin) {
             &data[bl * itsNCorr * nchan + chan * itsNCorr],
             &weight[bl * itsNCorr * nchan + chan * itsNCorr],
             &flag[bl * itsNCorr * nchan + chan * itsNCorr], bl, chan,
-            itsUpdateWeights, itsFlagCounter);
+            itsUpdateWeights, flagCounter);
       }
     }
   });
+  itsFlagCounter.mergeShards();
 
   itsTimer.stop();
   getNextStep()->process(itsBuffer);
@@ -404,6 +435,75 @@ bool OneApplyCal::process(const DPBuffer& bufin) {
   return true;
 }
 
+bool OneApplyCal::process(std::unique_ptr<BDABuffer> buffer) {
+  itsTimer.start();
+  if (itsBdaJonesParameters.empty()) {
+    updateParmsBda();
+  }
+
+  std::vector<BDABuffer::Row>& rows = buffer->GetRows();
+  aocommon::ParallelFor<size_t> loop(getInfo().nThreads());
+  loop.Run(0, rows.size(), [&](size_t r, size_t thread) {
+    const BDABuffer::Row& row = rows[r];
+    base::FlagCounter& flagCounter = itsFlagCounter.shard(thread);
+    const size_t bl = row.baseline_nr;
+    const casacore::Cube<casacore::Complex>& parms =
+        itsBdaJonesParameters[itsBdaBaselineLayouts[bl]]->GetParms();
+    const std::vector<std::size_t>& chanStarts = itsBdaChanStarts[bl];
+    const std::pair<unsigned int, unsigned int> slots =
+        info().TimeSlots(row.time, row.interval);
+    const unsigned int nslots = slots.second - slots.first;
+    // Use the solutions of the time slot that contains the centroid time.
+    const double centroidSlot =
+        (row.time - info().startTime()) / info().timeInterval();
+    const size_t timeStep = std::min<size_t>(
+        std::max(0.0, std::floor(centroidSlot)), info().ntime() - 1);
+    const unsigned int antA = info().getAnt1()[bl];
+    const unsigned int antB = info().getAnt2()[bl];
+    for (size_t chan = 0; chan < row.n_channels; chan++) {
+      const unsigned int timeFreqOffset = timeStep * row.n_channels + chan;
+      casacore::Complex* data = row.data + chan * itsNCorr;
+      float* weight = row.weights + chan * itsNCorr;
+      bool* flag = row.flags + chan * itsNCorr;
+      const bool wasFlagged = flag[0];
+      if (parms.shape()[0] > 2) {
+        ApplyCal::applyFull(&parms(0, antA, timeFreqOffset),
+                            &parms(0, antB, timeFreqOffset), data, weight,
+                            flag, bl, chanStarts[chan], itsUpdateWeights,
+                            flagCounter);
+      } else {
+        ApplyCal::applyDiag(&parms(0, antA, timeFreqOffset),
+                            &parms(0, antB, timeFreqOffset), data, weight,
+                            flag, bl, chanStarts[chan], itsUpdateWeights,
+                            flagCounter);
+      }
+      if (!wasFlagged && flag[0]) {
+        // The flag was counted once, for the first full resolution channel.
+        // Also count the other time slots and channels that it covers.
+        const size_t startChan = chanStarts[chan];
+        const size_t endChan = chanStarts[chan + 1];
+        flagCounter.incrBaseline(bl,
+                                 int64_t(nslots) * (endChan - startChan) - 1);
+        flagCounter.incrChannel(startChan, nslots - 1);
+        for (size_t ch = startChan + 1; ch < endChan; ++ch) {
+          flagCounter.incrChannel(ch, nslots);
+        }
+      }
+    }
+  });
+  itsFlagCounter.mergeShards();
+
+  // The time slots of the rows determine the number of time slots.
+  for (const BDABuffer::Row& row : rows) {
+    itsCount = std::max(itsCount,
+                        info().TimeSlots(row.time, row.interval).second);
+  }
+
+  itsTimer.stop();
+  getNextStep()->process(std::move(buffer));
+  return true;
+}
+
 void OneApplyCal::finish() {
   // Let the next steps finish.
   getNextStep()->finish();
@@ -445,6 +545,35 @@ void OneApplyCal::updateParmsH5(const double bufStartTime) {
       itsSigmaMMSE, itsParmExprs.size(), itsMissingAntennaBehavior);
 }
 
+void OneApplyCal::updateParmsBda() {
+  std::lock_guard<std::mutex> lock(theirHDF5Mutex);
+
+  // Figure out whether time or frequency is first axis
+  if (itsSolTab.HasAxis("freq") && itsSolTab.HasAxis("time") &&
+      itsSolTab.GetAxisIndex("freq") < itsSolTab.GetAxisIndex("time")) {
+    throw std::runtime_error("Fastest varying axis should be freq");
+  }
+
+  vector<double> times(info().ntime());
+  for (size_t t = 0; t < times.size(); ++t) {
+    // time centroids
+    times[t] = info().startTime() + (t + 0.5) * info().timeInterval();
+  }
+
+  std::vector<std::string> ant_names;
+  for (const std::string& name : info().antennaNames()) {
+    ant_names.push_back(name);
+  }
+
+  itsBdaJonesParameters.clear();
+  for (const std::vector<double>& freqs : itsBdaLayoutFreqs) {
+    itsBdaJonesParameters.push_back(boost::make_unique<JonesParameters>(
+        freqs, times, ant_names, itsCorrectType, itsInterpolationType,
+        itsDirection, &itsSolTab, &itsSolTab2, itsInvert, itsSigmaMMSE,
+        itsParmExprs.size(), itsMissingAntennaBehavior));
+  }
+}
+
 void OneApplyCal::updateParmsParmDB(const double bufStartTime) {
   unsigned int numAnts = info().antennaNames().size();
 
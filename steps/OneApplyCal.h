@@ -11,6 +11,7 @@
 
 #include "InputStep.h"
 
+#include "../base/BDABuffer.h"
 #include "../base/DPBuffer.h"
 #include "../base/FlagCounter.h"
 
@@ -34,6 +35,10 @@ namespace steps {
 
 /// This class is a Step class applying calibration parameters to the data.
 /// It only applies one correction.
+///
+/// BDA data can be corrected with solutions from an H5Parm. The solutions
+/// are gridded for each distinct channel layout of the baselines, and a row
+/// gets the solutions of the time slot that contains its centroid time.
 
 class OneApplyCal : public Step {
  public:
@@ -44,7 +49,8 @@ class OneApplyCal : public Step {
   /// Parameters are obtained from the parset using the given prefix.
   OneApplyCal(InputStep*, const common::ParameterSet&,
               const std::string& prefix, const std::string& defaultPrefix,
-              bool substep = false, std::string predictDirection = "");
+              bool substep = false, std::string predictDirection = "",
+              MsType inputType = MsType::kRegular);
 
   virtual ~OneApplyCal();
 
@@ -53,6 +59,10 @@ class OneApplyCal : public Step {
   /// When processed, it invokes the process function of the next step.
   virtual bool process(const base::DPBuffer& buffer);
 
+  /// Process the BDA data.
+  /// When processed, it invokes the process function of the next step.
+  bool process(std::unique_ptr<base::BDABuffer>) override;
+
   /// Finish the processing of this step and subsequent steps.
   virtual void finish();
 
@@ -67,6 +77,10 @@ class OneApplyCal : public Step {
 
   bool invert() { return itsInvert; }
 
+  bool accepts(MsType dt) const override { return dt == itsInputType; }
+
+  MsType outputs() const override { return itsInputType; }
+
  private:
   /// Read parameters from the associated parmdb and store them in
   /// itsJonesParameters
@@ -76,6 +90,10 @@ class OneApplyCal : public Step {
   /// itsJonesParameters
   void updateParmsH5(const double bufStartTime);
 
+  /// Read the parameters from the associated h5 for BDA data and store them
+  /// in itsBdaJonesParameters, for all time slots.
+  void updateParmsBda();
+
   /// If needed, show the flag counts.
   virtual void showCounts(std::ostream&) const;
 
@@ -91,6 +109,7 @@ class OneApplyCal : public Step {
   InputStep* itsInput;
   base::DPBuffer itsBuffer;
   std::string itsName;
+  const MsType itsInputType;
   std::string itsParmDBName;
   bool itsUseH5Parm;
   std::string itsSolSetName;
@@ -118,6 +137,15 @@ class OneApplyCal : public Step {
   /// * time as returned by ParmDB numparms, antennas, time x frequency
   std::unique_ptr<JonesParameters> itsJonesParameters;
   unsigned int itsTimeStep;  ///< time step within current chunk
+  /// For BDA data, the gridded parameters per channel layout.
+  std::vector<std::unique_ptr<JonesParameters>> itsBdaJonesParameters;
+  /// For BDA data, the channel frequencies of each channel layout.
+  std::vector<std::vector<double>> itsBdaLayoutFreqs;
+  /// For BDA data, the index of the channel layout of each baseline.
+  std::vector<std::size_t> itsBdaBaselineLayouts;
+  /// For BDA data, the full resolution channels per baseline channel,
+  /// see DPInfo::BdaChannelStarts.
+  std::vector<std::vector<std::size_t>> itsBdaChanStarts;
   unsigned int itsNCorr;
   double itsTimeInterval;
   double itsLastTime;  ///< last time of current chunk
@@ -17,6 +17,7 @@
 #include "../parmdb/PatchInfo.h"
 #include "../parmdb/SkymodelToSourceDB.h"
 
+#include "../base/BeamResponseCache.h"
 #include "../base/DPInfo.h"
 #include "../base/Exceptions.h"
 #include "../base/FlagCounter.h"
@@ -40,6 +41,7 @@
 
 #include <boost/make_unique.hpp>
 
+#include <algorithm>
 #include <stddef.h>
 #include <string>
 #include <sstream>
@@ -62,6 +64,25 @@ using dp3::common::operator<<;
 namespace dp3 {
 namespace steps {
 
+namespace {
+/// Add the model of a thread to the visibilities in @p data. With Stokes I
+/// only, the model has one correlation, which is added to XX and YY.
+template <typename T>
+void addModel(const std::complex<T>* model, size_t nVisibilities,
+              size_t nCorrelations, bool stokesIOnly,
+              casacore::Complex* data) {
+  if (stokesIOnly) {
+    for (size_t i = 0, j = 0; i < nVisibilities; i += nCorrelations, j++) {
+      data[i] += model[j];
+      data[i + nCorrelations - 1] += model[j];
+    }
+  } else {
+    std::transform(data, data + nVisibilities, model, data,
+                   std::plus<std::complex<T>>());
+  }
+}
+}  // namespace
+
 OnePredict::OnePredict(InputStep* input, const common::ParameterSet& parset,
                        const string& prefix,
                        const std::vector<string>& source_patterns)
@@ -84,6 +105,7 @@ void OnePredict::init(InputStep* input, const common::ParameterSet& parset,
       parset.getBool(prefix + "correctfreqsmearing", false);
   SetOperation(parset.getString(prefix + "operation", "replace"));
   apply_beam_ = parset.getBool(prefix + "usebeammodel", false);
+  single_precision_ = parset.getBool(prefix + "singleprecisionmodel", false);
   debug_level_ = parset.getInt(prefix + "debuglevel", 0);
   patch_list_.clear();
 
@@ -200,14 +222,56 @@ void OnePredict::initializeThreadData() {
   uvw_split_index_ = base::nsetupSplitUVW(info().nantenna(), info().getAnt1(),
                                           info().getAnt2(), antenna_pos);
 
-  if (!predict_buffer_) {
+  // A buffer that is shared with other steps (e.g. the directions of
+  // H5ParmPredict) may have been sized for another number of correlations.
+  // Resizing it would reallocate the models that the simulators of those
+  // steps write into, so use a separate buffer in that case.
+  if (!predict_buffer_ || !predict_buffer_->IsCompatible(
+                              nThreads, nCr, nCh, nBl, single_precision_)) {
     predict_buffer_ = std::make_shared<base::PredictBuffer>();
   }
   if (apply_beam_ && predict_buffer_->GetStationList().empty()) {
     telescope_ =
         input_->GetTelescope(element_response_model_, use_channel_freq_);
+    station_indices_ = InputStep::SelectStationIndices(telescope_.get(),
+                                                       info().antennaNames());
+    beam_cache_context_ = base::BeamResponseCache::Instance().GetContext(
+        base::BeamResponseCache::MakeContextDescription(
+            input_->msName(), element_response_model_, use_channel_freq_,
+            info().antennaNames(), info().chanFreqs()));
+  }
+  predict_buffer_->resize(nThreads, nCr, nCh, nBl, nSt, apply_beam_,
+                          single_precision_);
+  // process() expects cleared buffers, and clears the parts it uses.
+  for (size_t thread = 0; thread < nThreads; ++thread) {
+    clearModel(thread, false);
+    if (apply_beam_) clearModel(thread, true);
+  }
+
+  // When applying beam, simulate into patch vector
+  simulators_.clear();
+  simulators_.reserve(nThreads);
+  for (size_t thread = 0; thread < nThreads; ++thread) {
+    if (single_precision_) {
+      Cube<std::complex<float>>& simulatedest =
+          (apply_beam_ ? predict_buffer_->GetSinglePatchModel(thread)
+                       : predict_buffer_->GetSingleModel(thread));
+      simulators_.emplace_back(phase_ref_, nSt, baselines_,
+                               info().chanFreqs(), info().chanWidths(),
+                               station_uwv_, simulatedest,
+                               correct_freq_smearing_, stokes_i_only_);
+    } else {
+      Cube<dcomplex>& simulatedest =
+          (apply_beam_ ? predict_buffer_->GetPatchModel(thread)
+                       : predict_buffer_->GetModel(thread));
+      simulators_.emplace_back(phase_ref_, nSt, baselines_,
+                               info().chanFreqs(), info().chanWidths(),
+                               station_uwv_, simulatedest,
+                               correct_freq_smearing_, stokes_i_only_);
+    }
   }
-  predict_buffer_->resize(nThreads, nCr, nCh, nBl, nSt, apply_beam_);
+  current_patches_.assign(nThreads, nullptr);
+  model_in_use_.assign(nThreads, false);
   // Create the Measure ITRF conversion info given the array position.
   // The time and direction are filled in later.
   meas_convertors_.resize(nThreads);
@@ -253,6 +317,17 @@ void OnePredict::updateInfo(const DPInfo& infoIn) {
 
   initializeThreadData();
 
+  // Make at least as many batches as threads, such that all threads get
+  // work. This also holds when batching per patch, since that only adds
+  // batches.
+  const size_t n_threads = std::max(1u, getInfo().nThreads());
+  const size_t max_batch_size =
+      std::min(base::Simulator::BatchSize(info().nantenna(), info().nchan()),
+               std::max<size_t>(
+                   1, (source_list_.size() + n_threads - 1) / n_threads));
+  component_batches_ = base::MakeComponentBatches(source_list_,
+                                                  max_batch_size, apply_beam_);
+
   if (do_apply_cal_) {
     info() = apply_cal_step_.setInfo(info());
   }
@@ -278,6 +353,8 @@ void OnePredict::show(std::ostream& os) const {
   os << "   all unpolarized:   " << std::boolalpha << stokes_i_only_ << '\n';
   os << "   correct freq smearing: " << std::boolalpha << correct_freq_smearing_
      << '\n';
+  os << "   single precision:  " << std::boolalpha << single_precision_
+     << '\n';
   os << "  apply beam:         " << std::boolalpha << apply_beam_ << '\n';
   if (apply_beam_) {
     os << "   mode:              " << everybeam::ToString(beam_mode_);
@@ -365,85 +442,75 @@ bool OnePredict::process(const DPBuffer& bufin) {
         base::Direction(angles.getBaseValue()[0], angles.getBaseValue()[1]);
   }
 
-  std::unique_ptr<aocommon::ThreadPool> localThreadPool;
   aocommon::ThreadPool* pool = thread_pool_;
   if (pool == nullptr) {
-    // If no ThreadPool was specified, we create a temporary one just
-    // for executation of this part.
-    localThreadPool =
-        boost::make_unique<aocommon::ThreadPool>(info().nThreads());
-    pool = localThreadPool.get();
+    // If no ThreadPool was specified, a local one is created once and kept
+    // for the next time slots.
+    if (!local_thread_pool_) {
+      local_thread_pool_ =
+          boost::make_unique<aocommon::ThreadPool>(info().nThreads());
+    }
+    pool = local_thread_pool_.get();
   } else {
     if (pool->NThreads() != info().nThreads())
       throw std::runtime_error(
           "Thread pool has inconsistent number of threads!");
   }
-  std::vector<base::Simulator> simulators;
-  simulators.reserve(pool->NThreads());
+  // The (patch) model buffers are all zero here: they are cleared after
+  // their use, see below.
   for (size_t thread = 0; thread != pool->NThreads(); ++thread) {
-    predict_buffer_->GetModel(thread) = dcomplex();
-    if (apply_beam_) predict_buffer_->GetPatchModel(thread) = dcomplex();
-
-    // When applying beam, simulate into patch vector
-    Cube<dcomplex>& simulatedest =
-        (apply_beam_ ? predict_buffer_->GetPatchModel(thread)
-                     : predict_buffer_->GetModel(thread));
-    simulators.emplace_back(phase_ref_, nSt, baselines_, info().chanFreqs(),
-                            info().chanWidths(), station_uwv_, simulatedest,
-                            correct_freq_smearing_, stokes_i_only_);
+    simulators_[thread].setReference(phase_ref_);
+    current_patches_[thread] = nullptr;
+    model_in_use_[thread] = false;
   }
-  std::vector<base::Patch::ConstPtr> curPatches(pool->NThreads());
 
-  pool->For(0, source_list_.size(), [&](size_t source_index, size_t thread) {
+  pool->For(0, component_batches_.size(), [&](size_t batch_index,
+                                              size_t thread) {
     const common::ScopedMicroSecondAccumulator<decltype(predict_time_)>
         scoped_time{predict_time_};
+    const base::ComponentBatch& batch = component_batches_[batch_index];
     // OnePredict the source model and apply beam when an entire patch is
     // done
-    base::Patch::ConstPtr& curPatch = curPatches[thread];
+    base::Patch::ConstPtr& curPatch = current_patches_[thread];
     const bool patchIsFinished =
-        curPatch != source_list_[source_index].second && curPatch != nullptr;
+        curPatch != batch.GetPatch() && curPatch != nullptr;
     if (apply_beam_ && patchIsFinished) {
       // Apply the beam and add PatchModel to Model
-      addBeamToData(curPatch, time, thread, nBeamValues,
-                    predict_buffer_->GetPatchModel(thread).data(),
-                    stokes_i_only_);
-      // Initialize patchmodel to zero for the next patch
-      predict_buffer_->GetPatchModel(thread) = dcomplex();
+      addPatchToModel(curPatch, time, thread, nBeamValues);
     }
     // Depending on apply_beam_, the following call will add to either
     // the Model or the PatchModel of the predict buffer
-    simulators[thread].simulate(source_list_[source_index].first);
+    simulators_[thread].simulate(batch);
 
-    curPatch = source_list_[source_index].second;
+    curPatch = batch.GetPatch();
+    model_in_use_[thread] = true;
   });
   // Apply beam to the last patch
   if (apply_beam_) {
     pool->For(0, pool->NThreads(), [&](size_t thread, size_t) {
       const common::ScopedMicroSecondAccumulator<decltype(predict_time_)>
           scoped_time{predict_time_};
-      if (curPatches[thread] != nullptr) {
-        addBeamToData(curPatches[thread], time, thread, nBeamValues,
-                      predict_buffer_->GetPatchModel(thread).data(),
-                      stokes_i_only_);
+      if (current_patches_[thread] != nullptr) {
+        addPatchToModel(current_patches_[thread], time, thread, nBeamValues);
       }
     });
   }
 
-  // Add all thread model data to one buffer
+  // Add all thread model data to one buffer. Threads that predicted nothing
+  // have an empty model. Used models are cleared for the next time slot.
   scratch_buffer.getData() = casacore::Complex();
   casacore::Complex* tdata = scratch_buffer.getData().data();
   const size_t nVisibilities = nBl * nCh * nCr;
   for (size_t thread = 0; thread < pool->NThreads(); ++thread) {
-    if (stokes_i_only_) {
-      for (size_t i = 0, j = 0; i < nVisibilities; i += nCr, j++) {
-        tdata[i] += predict_buffer_->GetModel(thread).data()[j];
-        tdata[i + nCr - 1] += predict_buffer_->GetModel(thread).data()[j];
-      }
+    if (!model_in_use_[thread]) continue;
+    if (single_precision_) {
+      addModel(predict_buffer_->GetSingleModel(thread).data(), nVisibilities,
+               nCr, stokes_i_only_, tdata);
     } else {
-      std::transform(tdata, tdata + nVisibilities,
-                     predict_buffer_->GetModel(thread).data(), tdata,
-                     std::plus<dcomplex>());
+      addModel(predict_buffer_->GetModel(thread).data(), nVisibilities, nCr,
+               stokes_i_only_, tdata);
     }
+    clearModel(thread, false);
   }
 
   // Call ApplyCal step
@@ -484,36 +551,95 @@ everybeam::vector3r_t OnePredict::dir2Itrf(const MDirection& dir,
   return vec;
 }
 
+void OnePredict::clearModel(size_t thread, bool patch_model) {
+  if (single_precision_) {
+    if (patch_model) {
+      predict_buffer_->GetSinglePatchModel(thread) = std::complex<float>();
+    } else {
+      predict_buffer_->GetSingleModel(thread) = std::complex<float>();
+    }
+  } else {
+    if (patch_model) {
+      predict_buffer_->GetPatchModel(thread) = dcomplex();
+    } else {
+      predict_buffer_->GetModel(thread) = dcomplex();
+    }
+  }
+}
+
+void OnePredict::addPatchToModel(base::Patch::ConstPtr patch, double time,
+                                 size_t thread, size_t nBeamValues) {
+  if (single_precision_) {
+    addBeamToData(patch, time, thread, nBeamValues,
+                  predict_buffer_->GetSinglePatchModel(thread).data(),
+                  predict_buffer_->GetSingleModel(thread).data(),
+                  stokes_i_only_);
+  } else {
+    addBeamToData(patch, time, thread, nBeamValues,
+                  predict_buffer_->GetPatchModel(thread).data(),
+                  predict_buffer_->GetModel(thread).data(), stokes_i_only_);
+  }
+  // Initialize patchmodel to zero for the next patch
+  clearModel(thread, true);
+}
+
+template <typename T>
 void OnePredict::addBeamToData(base::Patch::ConstPtr patch, double time,
                                size_t thread, size_t nBeamValues,
-                               dcomplex* data0, bool stokesIOnly) {
+                               std::complex<T>* data0,
+                               std::complex<T>* model, bool stokesIOnly) {
   // Apply beam for a patch, add result to Model
-  MDirection dir(MVDirection(patch->direction().ra, patch->direction().dec),
-                 MDirection::J2000);
-  everybeam::vector3r_t srcdir = dir2Itrf(dir, meas_convertors_[thread]);
-
-  if (stokesIOnly) {
+  const MDirection dir(
+      MVDirection(patch->direction().ra, patch->direction().dec),
+      MDirection::J2000);
+  // In Stokes I mode, only the array factor is used.
+  const everybeam::CorrectionMode mode =
+      stokesIOnly ? everybeam::CorrectionMode::kArrayFactor : beam_mode_;
+
+  {
     const common::ScopedMicroSecondAccumulator<decltype(apply_beam_time_)>
         scoped_time{apply_beam_time_};
-    ApplyBeam::applyBeamStokesIArrayFactor(
-        info(), time, data0, srcdir, telescope_.get(),
-        predict_buffer_->GetScalarBeamValues(thread), false, beam_mode_,
-        &mutex_);
-  } else {
-    const common::ScopedMicroSecondAccumulator<decltype(apply_beam_time_)>
-        scoped_time{apply_beam_time_};
-    float* dummyweight = nullptr;
-    ApplyBeam::applyBeam(info(), time, data0, dummyweight, srcdir,
-                         telescope_.get(),
-                         predict_buffer_->GetFullBeamValues(thread), false,
-                         beam_mode_, false, &mutex_);
+    // The beam values are shared with other steps that use the same beam
+    // through the beam response cache.
+    const base::BeamResponseCache::Evaluator evaluate =
+        [&](double evaluation_time, std::vector<aocommon::MC2x2>& values) {
+          everybeam::vector3r_t srcdir;
+          {
+            std::unique_lock<std::mutex> lock;
+            if (measures_mutex_ != nullptr)
+              lock = std::unique_lock<std::mutex>(*measures_mutex_);
+            meas_frame_[thread].resetEpoch(
+                MEpoch(MVEpoch(evaluation_time / 86400), MEpoch::UTC));
+            srcdir = dir2Itrf(dir, meas_convertors_[thread]);
+          }
+          std::unique_ptr<everybeam::pointresponse::PointResponse>
+              point_response = telescope_->GetPointResponse(evaluation_time);
+          const size_t n_channels = info().nchan();
+          values.resize(station_indices_.size() * n_channels);
+          for (size_t st = 0; st < station_indices_.size(); ++st) {
+            for (size_t ch = 0; ch < n_channels; ++ch) {
+              values[st * n_channels + ch] = ApplyBeam::beamValue(
+                  *point_response, mode, station_indices_[st],
+                  info().chanFreqs()[ch], srcdir, &mutex_);
+            }
+          }
+        };
+    std::vector<aocommon::MC2x2>& beam_values =
+        predict_buffer_->GetFullBeamValues(thread);
+    base::BeamResponseCache::Instance().Get(beam_cache_context_, mode, dir,
+                                            time, evaluate, beam_values);
+    if (stokesIOnly) {
+      ApplyBeam::applyBeamValuesStokesI(info(), data0, beam_values);
+    } else {
+      float* dummyweight = nullptr;
+      ApplyBeam::applyBeamValues(info(), data0, dummyweight, beam_values,
+                                 false);
+    }
   }
 
   // Add temporary buffer to Model
-  std::transform(predict_buffer_->GetModel(thread).data(),
-                 predict_buffer_->GetModel(thread).data() + nBeamValues, data0,
-                 predict_buffer_->GetModel(thread).data(),
-                 std::plus<dcomplex>());
+  std::transform(model, model + nBeamValues, data0, model,
+                 std::plus<std::complex<T>>());
 }
 
 void OnePredict::finish() {
@@ -13,10 +13,12 @@
 #include "ApplyCal.h"
 #include "InputStep.h"
 
+#include "../base/ComponentBatch.h"
 #include "../base/DPBuffer.h"
 #include "../base/ModelComponent.h"
 #include "../base/Patch.h"
 #include "../base/PredictBuffer.h"
+#include "../base/Simulator.h"
 #include "../base/SourceDBUtil.h"
 
 #include <EveryBeam/station.h>
@@ -114,9 +116,16 @@ class OnePredict : public ModelDataStep {
   void initializeThreadData();
   everybeam::vector3r_t dir2Itrf(const casacore::MDirection& dir,
                                  casacore::MDirection::Convert& measConverter);
+  /// Clear the (patch) model buffer of a thread.
+  void clearModel(size_t thread, bool patch_model);
+  /// Apply the beam to the patch model of a thread, add it to the model of
+  /// the thread and clear the patch model.
+  void addPatchToModel(base::Patch::ConstPtr patch, double time,
+                       size_t thread, size_t nBeamValues);
+  template <typename T>
   void addBeamToData(base::Patch::ConstPtr patch, double time, size_t thread,
-                     size_t nBeamValues, std::complex<double>* data0,
-                     bool stokesIOnly);
+                     size_t nBeamValues, std::complex<T>* data0,
+                     std::complex<T>* model, bool stokesIOnly);
 
   InputStep* input_;
   std::string name_;
@@ -125,6 +134,9 @@ class OnePredict : public ModelDataStep {
   bool correct_freq_smearing_;
   std::string operation_;
   bool apply_beam_;
+  /// If true, the model buffers of predict_buffer_ hold single precision
+  /// visibilities, which halves their size.
+  bool single_precision_;
   bool use_channel_freq_;
   bool one_beam_per_patch_;
   /// If two sources are closer together than given by this setting, they
@@ -157,12 +169,28 @@ class OnePredict : public ModelDataStep {
   std::vector<casacore::MeasFrame> meas_frame_;
   std::vector<casacore::MDirection::Convert> meas_convertors_;
   std::shared_ptr<everybeam::telescope::Telescope> telescope_;
+  std::vector<size_t> station_indices_;
+  /// Context of the telescope in the shared beam response cache.
+  size_t beam_cache_context_;
 
   std::string direction_str_;  ///< Definition of patches, to pass to applycal
   std::vector<base::Patch::ConstPtr> patch_list_;
 
   std::vector<std::pair<base::ModelComponent::ConstPtr, base::Patch::ConstPtr>>
       source_list_;
+  /// The components of source_list_ in batches of the same kind. When the
+  /// beam is applied, a batch only holds components of one patch.
+  std::vector<base::ComponentBatch> component_batches_;
+
+  /// Simulators per thread, which add to the (patch) model buffers of
+  /// predict_buffer_. They are made in updateInfo() and reused for all time
+  /// slots.
+  std::vector<base::Simulator> simulators_;
+  /// Per thread, the patch of the last batch that the thread predicted.
+  std::vector<base::Patch::ConstPtr> current_patches_;
+  /// Per thread, tells if the thread added to its model buffer. A char is
+  /// used since threads write their elements concurrently.
+  std::vector<char> model_in_use_;
 
   common::NSTimer timer_;
 
@@ -186,6 +214,8 @@ class OnePredict : public ModelDataStep {
   std::atomic<int64_t> apply_beam_time_{0};
 
   aocommon::ThreadPool* thread_pool_;
+  /// Thread pool that is used if SetThreadData() is not called.
+  std::unique_ptr<aocommon::ThreadPool> local_thread_pool_;
   std::mutex* measures_mutex_;
   std::mutex mutex_;
 };
@@ -6,6 +6,7 @@
 
 #include "PreFlagger.h"
 
+#include "../base/BDABuffer.h"
 #include "../base/DPBuffer.h"
 #include "../base/DPInfo.h"
 #include "../base/DPLogger.h"
@@ -32,6 +33,7 @@
 #include <boost/algorithm/string/trim.hpp>
 
 #include <iostream>
+#include <limits>
 #include <stack>
 
 using casacore::Block;
@@ -50,6 +52,7 @@ using casacore::Record;
 using casacore::RecordGram;
 using casacore::TableExprNode;
 
+using dp3::base::BDABuffer;
 using dp3::base::DPBuffer;
 using dp3::base::DPInfo;
 using dp3::base::FlagCounter;
@@ -59,9 +62,10 @@ namespace dp3 {
 namespace steps {
 
 PreFlagger::PreFlagger(InputStep* input, const common::ParameterSet& parset,
-                       const string& prefix)
+                       const string& prefix, MsType inputType)
     : itsName(prefix),
       itsInput(input),
+      itsInputType(inputType),
       itsMode(SetFlag),
       itsPSet(input, parset, prefix),
       itsCount(0),
@@ -119,11 +123,28 @@ void PreFlagger::showTimings(std::ostream& os, double duration) const {
 
 void PreFlagger::updateInfo(const DPInfo& infoIn) {
   info() = infoIn;
-  info().setNeedVisData();
   info().setWriteFlags();
-  itsPSet.updateInfo(getInfo());
+  itsPSet.updateInfo(getInfo(), itsInputType == MsType::kBda);
+  // The data is used by the flagging criteria and, when clearing flags, to
+  // keep the flags of invalid data. Only the baselines that the pset can flag
+  // are needed, except when clearing the complement.
+  if (itsMode == ClearComp || itsInputType == MsType::kBda) {
+    info().setNeedVisData();
+  } else if (itsMode == ClearFlag || itsPSet.usesData()) {
+    info().setNeedVisData(itsPSet.selectedBaselines());
+  }
   // Initialize the flag counters.
   itsFlagCounter.init(getInfo());
+  if (itsInputType == MsType::kBda) {
+    itsBdaChanStarts.resize(getInfo().nbaselines());
+    for (std::size_t bl = 0; bl < itsBdaChanStarts.size(); ++bl) {
+      itsBdaChanStarts[bl] = getInfo().BdaChannelStarts(bl);
+    }
+  }
+}
+
+bool PreFlagger::canSplitTime() const {
+  return itsInputType == MsType::kRegular && !itsPSet.usesRelativeTime();
 }
 
 bool PreFlagger::process(const DPBuffer& buf) {
@@ -162,6 +183,36 @@ bool PreFlagger::process(const DPBuffer& buf) {
   return true;
 }
 
+bool PreFlagger::process(std::unique_ptr<BDABuffer> buffer) {
+  itsTimer.start();
+  for (BDABuffer::Row& row : buffer->GetRows()) {
+    const std::pair<unsigned int, unsigned int> slots =
+        getInfo().TimeSlots(row.time, row.interval);
+    const unsigned int nslots = slots.second - slots.first;
+    // Do the PSet steps and combine the result with the current flags.
+    const Matrix<bool>* flags =
+        itsPSet.processRow(row, slots.first, slots.second, true);
+    switch (itsMode) {
+      case SetFlag:
+        setRowFlags(*flags, row, true, nslots);
+        break;
+      case ClearFlag:
+        clearRowFlags(*flags, row, true, nslots);
+        break;
+      case SetComp:
+        setRowFlags(*flags, row, false, nslots);
+        break;
+      case ClearComp:
+        clearRowFlags(*flags, row, false, nslots);
+        break;
+    }
+    itsCount = std::max(itsCount, slots.second);
+  }
+  itsTimer.stop();
+  getNextStep()->process(std::move(buffer));
+  return true;
+}
+
 void PreFlagger::setFlags(const bool* inPtr, bool* outPtr, unsigned int nrcorr,
                           unsigned int nrchan, unsigned int nrbl, bool mode) {
   for (unsigned int i = 0; i < nrbl; ++i) {
@@ -214,6 +265,60 @@ void PreFlagger::clearFlags(const bool* inPtr, bool* outPtr,
   }
 }
 
+void PreFlagger::setRowFlags(const Matrix<bool>& flags,
+                             const BDABuffer::Row& row, bool mode,
+                             unsigned int nslots) {
+  const unsigned int nrcorr = row.n_correlations;
+  const std::vector<std::size_t>& chanStarts =
+      itsBdaChanStarts[row.baseline_nr];
+  const bool* inPtr = flags.data();
+  bool* outPtr = row.flags;
+  for (unsigned int j = 0; j < row.n_channels; ++j) {
+    if (*inPtr == mode && !*outPtr) {
+      // Only 1st corr is counted.
+      itsFlagCounter.incrBdaChannel(row.baseline_nr, chanStarts[j],
+                                    chanStarts[j + 1], nslots);
+      std::fill(outPtr, outPtr + nrcorr, true);
+    }
+    inPtr += nrcorr;
+    outPtr += nrcorr;
+  }
+}
+
+void PreFlagger::clearRowFlags(const Matrix<bool>& flags,
+                               const BDABuffer::Row& row, bool mode,
+                               unsigned int nslots) {
+  const unsigned int nrcorr = row.n_correlations;
+  const std::vector<std::size_t>& chanStarts =
+      itsBdaChanStarts[row.baseline_nr];
+  const bool* inPtr = flags.data();
+  bool* outPtr = row.flags;
+  const std::complex<float>* dataPtr = row.data;
+  const float* weightPtr = row.weights;
+  for (unsigned int j = 0; j < row.n_channels; ++j) {
+    if (*inPtr == mode) {
+      bool flag = false;
+      // Flags for invalid data are not cleared.
+      for (unsigned int k = 0; k < nrcorr; ++k) {
+        if (!std::isfinite(dataPtr[k].real()) ||
+            !std::isfinite(dataPtr[k].imag()) || weightPtr[k] == 0) {
+          flag = true;
+          break;
+        }
+      }
+      if (*outPtr != flag) {
+        itsFlagCounter.incrBdaChannel(row.baseline_nr, chanStarts[j],
+                                      chanStarts[j + 1], nslots);
+        std::fill(outPtr, outPtr + nrcorr, flag);
+      }
+    }
+    inPtr += nrcorr;
+    outPtr += nrcorr;
+    dataPtr += nrcorr;
+    weightPtr += nrcorr;
+  }
+}
+
 void PreFlagger::finish() {
   // Let the next step finish its processing.
   getNextStep()->finish();
@@ -287,8 +392,10 @@ PreFlagger::PSet::PSet(InputStep* input, const common::ParameterSet& parset,
   }
 }
 
-void PreFlagger::PSet::updateInfo(const DPInfo& info) {
+void PreFlagger::PSet::updateInfo(const DPInfo& info, bool bda) {
   itsInfo = &info;
+  itsAzElTime = std::numeric_limits<double>::quiet_NaN();
+  itsAzElMatch.assign(info.nantenna(), -1);
   // Fill the matrix with the baselines to flag.
   fillBLMatrix();
   // Handle the possible date/time parameters.
@@ -329,18 +436,55 @@ void PreFlagger::PSet::updateInfo(const DPInfo& info) {
   itsMatchBL.resize(info.nbaselines());
   // Determine the channels to be flagged.
   if (!(itsStrChan.empty() && itsStrFreq.empty())) {
-    fillChannels(info);
+    fillChannels(info, bda);
     if (!itsChannels.empty()) {
       itsFlagOnTimeOnly = false;
     }
   }
   // Do the same for the child steps.
   for (unsigned int i = 0; i < itsPSets.size(); ++i) {
-    itsPSets[i]->updateInfo(info);
+    itsPSets[i]->updateInfo(info, bda);
   }
 }
 
-void PreFlagger::PSet::fillChannels(const DPInfo& info) {
+bool PreFlagger::PSet::usesData() const {
+  if (itsFlagOnTimeOnly) {
+    return false;
+  }
+  if (itsFlagOnAmpl || itsFlagOnPhase || itsFlagOnReal || itsFlagOnImag) {
+    return true;
+  }
+  for (const PSet::ShPtr& pset : itsPSets) {
+    if (pset->usesData()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PreFlagger::PSet::usesRelativeTime() const {
+  if (!itsTimeSlot.empty() || !itsStrRTime.empty()) {
+    return true;
+  }
+  for (const PSet::ShPtr& pset : itsPSets) {
+    if (pset->usesRelativeTime()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<bool> PreFlagger::PSet::selectedBaselines() const {
+  std::vector<bool> selected(itsInfo->nbaselines(), true);
+  if (itsFlagOnBL) {
+    for (unsigned int i = 0; i < selected.size(); ++i) {
+      selected[i] = itsFlagBL(itsInfo->getAnt1()[i], itsInfo->getAnt2()[i]);
+    }
+  }
+  return selected;
+}
+
+void PreFlagger::PSet::fillChannels(const DPInfo& info, bool bda) {
   unsigned int nrcorr = info.ncorr();
   unsigned int nrchan = info.nchan();
   casacore::Vector<bool> selChan(nrchan);
@@ -389,7 +533,11 @@ void PreFlagger::PSet::fillChannels(const DPInfo& info) {
   }
   // Now determine which channels to use from given frequency ranges.
   // AND it with the channel selection given above.
-  if (!itsStrFreq.empty()) {
+  // BDA channels are handled per baseline, because each baseline has its
+  // own frequencies.
+  if (bda) {
+    selChan = fillBdaChannels(info, selChan);
+  } else if (!itsStrFreq.empty()) {
     selChan = selChan && handleFreqRanges(itsInfo->chanFreqs());
   }
   // Turn the channels into a mask.
@@ -406,6 +554,38 @@ void PreFlagger::PSet::fillChannels(const DPInfo& info) {
   }
 }
 
+casacore::Vector<bool> PreFlagger::PSet::fillBdaChannels(
+    const DPInfo& info, const casacore::Vector<bool>& selChan) {
+  unsigned int nrcorr = info.ncorr();
+  casacore::Vector<bool> fullResChan(selChan.size(), false);
+  itsBdaChanFlags.resize(info.nbaselines());
+  for (std::size_t bl = 0; bl < info.nbaselines(); ++bl) {
+    const std::vector<std::size_t> chanStarts = info.BdaChannelStarts(bl);
+    const unsigned int nrchan = chanStarts.size() - 1;
+    casacore::Vector<bool> freqChan(nrchan, true);
+    if (!itsStrFreq.empty()) {
+      freqChan = handleFreqRanges(info.chanFreqs(bl));
+    }
+    casacore::Matrix<bool>& chanFlags = itsBdaChanFlags[bl];
+    chanFlags.resize(nrcorr, nrchan);
+    chanFlags = false;
+    for (unsigned int i = 0; i < nrchan; ++i) {
+      // A channel is flagged if it covers a selected full resolution channel.
+      bool flag = false;
+      for (std::size_t ch = chanStarts[i]; ch < chanStarts[i + 1]; ++ch) {
+        flag = flag || selChan[ch];
+      }
+      if (flag && freqChan[i]) {
+        chanFlags.column(i) = true;
+        for (std::size_t ch = chanStarts[i]; ch < chanStarts[i + 1]; ++ch) {
+          fullResChan[ch] = true;
+        }
+      }
+    }
+  }
+  return fullResChan;
+}
+
 void PreFlagger::PSet::show(std::ostream& os, bool showName) const {
   if (showName) {
     os << "  pset " << itsName << '\n';
@@ -476,7 +656,7 @@ Cube<bool>* PreFlagger::PSet::process(const DPBuffer& in, DPBuffer& out,
                                       common::NSTimer& timer) {
   // No need to process it if the time mismatches or if only time selection.
   if (itsFlagOnTime) {
-    if (!matchTime(out.getTime(), timeSlot)) {
+    if (!matchTime(out.getTime(), timeSlot, timeSlot + 1)) {
       itsFlags = false;
       return &itsFlags;
     }
@@ -530,63 +710,139 @@ Cube<bool>* PreFlagger::PSet::process(const DPBuffer& in, DPBuffer& out,
     flagChannels();
   }
   // Flag on amplitude, phase or real/imaginary if necessary.
+  const casacore::Complex* data = out.getData().data();
+  const std::size_t npoints = shape[1] * shape[2];
   if (itsFlagOnAmpl) {
-    flagAmpl(amplitude(out.getData()));
+    flagAmpl(data, itsFlags.data(), shape[0], npoints);
   }
   if (itsFlagOnReal) {
-    flagReal(out.getData());
+    flagReal(data, itsFlags.data(), shape[0], npoints);
   }
   if (itsFlagOnImag) {
-    flagImag(out.getData());
+    flagImag(data, itsFlags.data(), shape[0], npoints);
   }
   if (itsFlagOnPhase) {
-    flagPhase(out.getData());
+    flagPhase(data, itsFlags.data(), shape[0], npoints);
   }
   // Evaluate the PSet expression.
-  // The expression is in RPN notation. A stack of array pointers is used
-  // to keep track of intermediate results. The arrays (in the PSet objects)
-  // are reused to AND or OR subexpressions. This can be done harmlessly
-  // and saves the creation of too many arrays.
   if (!itsPSets.empty()) {
-    std::stack<Cube<bool>*> results;
-    for (int oper : itsRpn) {
-      if (oper >= 0) {
-        results.push(
-            itsPSets[oper]->process(in, out, timeSlot, itsMatchBL, timer));
-      } else if (oper == OpNot) {
-        Cube<bool>* left = results.top();
-        // No ||= operator exists, so use the transform function.
+    evaluateExpression(itsFlags, [&](PSet& pset) {
+      return pset.process(in, out, timeSlot, itsMatchBL, timer);
+    });
+  }
+  return &itsFlags;
+}
+
+Matrix<bool>* PreFlagger::PSet::processRow(const BDABuffer::Row& row,
+                                           unsigned int firstSlot,
+                                           unsigned int endSlot,
+                                           bool matchBL) {
+  itsRowFlags.resize(row.n_correlations, row.n_channels);
+  // No need to process it if the time mismatches or if only time selection.
+  if (itsFlagOnTime) {
+    if (!matchTime(row.time, firstSlot, endSlot)) {
+      itsRowFlags = false;
+      return &itsRowFlags;
+    }
+  }
+  if (itsFlagOnTimeOnly) {
+    itsRowFlags = itsFlagOnTime;
+    return &itsRowFlags;
+  }
+  // Initialize the flags.
+  itsRowFlags = false;
+  // Determine if the baseline matches, like flagBL, flagUV and flagAzEl.
+  const std::size_t a1 = itsInfo->getAnt1()[row.baseline_nr];
+  const std::size_t a2 = itsInfo->getAnt2()[row.baseline_nr];
+  if (matchBL && itsFlagOnBL) {
+    matchBL = itsFlagBL(a1, a2);
+  }
+  if (matchBL && itsFlagOnUV) {
+    double uvdist = row.uvw[0] * row.uvw[0] + row.uvw[1] * row.uvw[1];
+    matchBL = uvdist < itsMinUV || uvdist > itsMaxUV;
+  }
+  if (matchBL && itsFlagOnAzEl) {
+    matchBL = matchAzEl(row.time, a1) && matchAzEl(row.time, a2);
+  }
+  if (!matchBL) {
+    return &itsRowFlags;
+  }
+  itsRowFlags = true;
+  // Flag on channel if necessary.
+  if (!itsChannels.empty()) {
+    const Matrix<bool>& chanFlags = itsBdaChanFlags.empty()
+                                        ? itsChanFlags
+                                        : itsBdaChanFlags[row.baseline_nr];
+    casacore::transformInPlace(itsRowFlags.cbegin(), itsRowFlags.cend(),
+                               chanFlags.cbegin(), std::logical_and<bool>());
+  }
+  // Flag on amplitude, phase or real/imaginary if necessary.
+  if (itsFlagOnAmpl) {
+    flagAmpl(row.data, itsRowFlags.data(), row.n_correlations, row.n_channels);
+  }
+  if (itsFlagOnReal) {
+    flagReal(row.data, itsRowFlags.data(), row.n_correlations, row.n_channels);
+  }
+  if (itsFlagOnImag) {
+    flagImag(row.data, itsRowFlags.data(), row.n_correlations, row.n_channels);
+  }
+  if (itsFlagOnPhase) {
+    flagPhase(row.data, itsRowFlags.data(), row.n_correlations,
+              row.n_channels);
+  }
+  // Evaluate the PSet expression.
+  if (!itsPSets.empty()) {
+    evaluateExpression(itsRowFlags, [&](PSet& pset) {
+      return pset.processRow(row, firstSlot, endSlot, matchBL);
+    });
+  }
+  return &itsRowFlags;
+}
+
+// The expression is in RPN notation. A stack of array pointers is used
+// to keep track of intermediate results. The arrays (in the PSet objects)
+// are reused to AND or OR subexpressions. This can be done harmlessly
+// and saves the creation of too many arrays.
+template <typename ArrayType, typename ProcessChild>
+void PreFlagger::PSet::evaluateExpression(ArrayType& flags,
+                                          ProcessChild processChild) {
+  std::stack<ArrayType*> results;
+  for (int oper : itsRpn) {
+    if (oper >= 0) {
+      results.push(processChild(*itsPSets[oper]));
+    } else if (oper == OpNot) {
+      ArrayType* left = results.top();
+      // No ||= operator exists, so use the transform function.
+      casacore::transformInPlace(left->cbegin(), left->cend(),
+                                 std::logical_not<bool>());
+    } else if (oper == OpOr || oper == OpAnd) {
+      ArrayType* right = results.top();
+      results.pop();
+      ArrayType* left = results.top();
+      // No ||= operator exists, so use the transform function.
+      if (oper == OpOr) {
         casacore::transformInPlace(left->cbegin(), left->cend(),
-                                   std::logical_not<bool>());
-      } else if (oper == OpOr || oper == OpAnd) {
-        Cube<bool>* right = results.top();
-        results.pop();
-        Cube<bool>* left = results.top();
-        // No ||= operator exists, so use the transform function.
-        if (oper == OpOr) {
-          casacore::transformInPlace(left->cbegin(), left->cend(),
-                                     right->cbegin(), std::logical_or<bool>());
-        } else {
-          casacore::transformInPlace(left->cbegin(), left->cend(),
-                                     right->cbegin(), std::logical_and<bool>());
-        }
+                                   right->cbegin(), std::logical_or<bool>());
       } else {
-        throw std::runtime_error("Expected operation NOT, OR or AND");
+        casacore::transformInPlace(left->cbegin(), left->cend(),
+                                   right->cbegin(), std::logical_and<bool>());
       }
+    } else {
+      throw std::runtime_error("Expected operation NOT, OR or AND");
     }
-    // Finally AND the children's flags with the flags of this pset.
-    if (results.size() != 1)
-      throw std::runtime_error(
-          "Something went wrong while evaluating expression: results.size() != "
-          "1");
-    Cube<bool>* mflags = results.top();
-    casacore::transformInPlace(itsFlags.cbegin(), itsFlags.cend(),
-                               mflags->cbegin(), std::logical_and<bool>());
   }
-  return &itsFlags;
+  // Finally AND the children's flags with the flags of this pset.
+  if (results.size() != 1)
+    throw std::runtime_error(
+        "Something went wrong while evaluating expression: results.size() != "
+        "1");
+  ArrayType* mflags = results.top();
+  casacore::transformInPlace(flags.cbegin(), flags.cend(), mflags->cbegin(),
+                             std::logical_and<bool>());
 }
 
-bool PreFlagger::PSet::matchTime(double time, unsigned int timeSlot) const {
+bool PreFlagger::PSet::matchTime(double time, unsigned int firstSlot,
+                                 unsigned int endSlot) const {
   if (!itsATimes.empty() && !matchRange(time, itsATimes)) {
     return false;
   }
@@ -602,8 +858,10 @@ bool PreFlagger::PSet::matchTime(double time, unsigned int timeSlot) const {
     }
   }
   if (!itsTimeSlot.empty()) {
-    if (std::find(itsTimeSlot.begin(), itsTimeSlot.end(), timeSlot) ==
-        itsTimeSlot.end()) {
+    if (std::find_if(itsTimeSlot.begin(), itsTimeSlot.end(),
+                     [&](unsigned int slot) {
+                       return slot >= firstSlot && slot < endSlot;
+                     }) == itsTimeSlot.end()) {
       return false;
     }
   }
@@ -712,20 +970,11 @@ void PreFlagger::PSet::testAzEl(MDirection::Convert& converter,
                                 unsigned int blnr, std::size_t ant,
                                 const std::vector<std::size_t>& ant1,
                                 const std::vector<std::size_t>& ant2) {
-  // Calculate AzEl (n seconds because ranges are in seconds too).
-  MVDirection mvAzel(converter().getValue());
-  casacore::Vector<double> azel = mvAzel.getAngle("s").getValue();
-  double az = azel[0];
-  double el = azel[1];
-  if (az < 0) az += 86400;
-  if (el < 0) el += 86400;
   // If outside the ranges, there is no match.
   // Set no match for all baselines containing this antenna.
   // It needs to be done from this baseline on, because the earlier
   // baselines have already been handled.
-  bool res = ((itsAzimuth.empty() || matchRange(az, itsAzimuth)) &&
-              (itsElevation.empty() || matchRange(el, itsElevation)));
-  if (!res) {
+  if (!matchAzEl(converter)) {
     for (unsigned int i = blnr; i < itsMatchBL.size(); ++i) {
       if (ant1[i] == ant || ant2[i] == ant) {
         itsMatchBL[i] = false;
@@ -734,102 +983,108 @@ void PreFlagger::PSet::testAzEl(MDirection::Convert& converter,
   }
 }
 
-void PreFlagger::PSet::flagAmpl(const Cube<float>& values) {
-  const IPosition& shape = values.shape();
-  unsigned int nrcorr = shape[0];
-  unsigned int nr = shape[1] * shape[2];
-  const float* valPtr = values.data();
-  bool* flagPtr = itsFlags.data();
-  for (unsigned int i = 0; i < nr; ++i) {
+bool PreFlagger::PSet::matchAzEl(MDirection::Convert& converter) const {
+  // Calculate AzEl (n seconds because ranges are in seconds too).
+  MVDirection mvAzel(converter().getValue());
+  casacore::Vector<double> azel = mvAzel.getAngle("s").getValue();
+  double az = azel[0];
+  double el = azel[1];
+  if (az < 0) az += 86400;
+  if (el < 0) el += 86400;
+  return ((itsAzimuth.empty() || matchRange(az, itsAzimuth)) &&
+          (itsElevation.empty() || matchRange(el, itsElevation)));
+}
+
+bool PreFlagger::PSet::matchAzEl(double time, std::size_t ant) {
+  // BDA rows of the same time share the AzEl of their antennae.
+  if (time != itsAzElTime) {
+    itsAzElTime = time;
+    std::fill(itsAzElMatch.begin(), itsAzElMatch.end(), -1);
+  }
+  if (itsAzElMatch[ant] < 0) {
+    MeasFrame frame;
+    Quantity qtime(time, "s");
+    MEpoch epoch(MVEpoch(qtime), MEpoch::UTC);
+    frame.set(epoch);
+    frame.set(itsInfo->antennaPos()[ant]);
+    MDirection::Convert converter(itsInfo->phaseCenter(),
+                                  MDirection::Ref(MDirection::AZEL, frame));
+    itsAzElMatch[ant] = matchAzEl(converter) ? 1 : 0;
+  }
+  return itsAzElMatch[ant] == 1;
+}
+
+void PreFlagger::PSet::flagAmpl(const casacore::Complex* data, bool* flags,
+                                unsigned int nrcorr, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
     bool flag = false;
     for (unsigned int j = 0; j < nrcorr; ++j) {
-      if (valPtr[j] < itsAmplMin[j] || valPtr[j] > itsAmplMax[j]) {
+      float ampl = std::abs(data[j]);
+      if (ampl < itsAmplMin[j] || ampl > itsAmplMax[j]) {
         flag = true;
         break;
       }
     }
     if (!flag) {
-      for (unsigned int j = 0; j < nrcorr; ++j) {
-        flagPtr[j] = false;
-      }
+      std::fill(flags, flags + nrcorr, false);
     }
-    valPtr += nrcorr;
-    flagPtr += nrcorr;
+    data += nrcorr;
+    flags += nrcorr;
   }
 }
 
-void PreFlagger::PSet::flagPhase(const Cube<casacore::Complex>& values) {
-  const IPosition& shape = values.shape();
-  unsigned int nrcorr = shape[0];
-  unsigned int nr = shape[1] * shape[2];
-  const casacore::Complex* valPtr = values.data();
-  bool* flagPtr = itsFlags.data();
-  for (unsigned int i = 0; i < nr; ++i) {
+void PreFlagger::PSet::flagPhase(const casacore::Complex* data, bool* flags,
+                                 unsigned int nrcorr, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
     bool flag = false;
     for (unsigned int j = 0; j < nrcorr; ++j) {
-      float phase = arg(valPtr[j]);
+      float phase = arg(data[j]);
       if (phase < itsPhaseMin[j] || phase > itsPhaseMax[j]) {
         flag = true;
         break;
       }
     }
     if (!flag) {
-      for (unsigned int j = 0; j < nrcorr; ++j) {
-        flagPtr[j] = false;
-      }
+      std::fill(flags, flags + nrcorr, false);
     }
-    valPtr += nrcorr;
-    flagPtr += nrcorr;
+    data += nrcorr;
+    flags += nrcorr;
   }
 }
 
-void PreFlagger::PSet::flagReal(const Cube<casacore::Complex>& values) {
-  const IPosition& shape = values.shape();
-  unsigned int nrcorr = shape[0];
-  unsigned int nr = shape[1] * shape[2];
-  const casacore::Complex* valPtr = values.data();
-  bool* flagPtr = itsFlags.data();
-  for (unsigned int i = 0; i < nr; ++i) {
+void PreFlagger::PSet::flagReal(const casacore::Complex* data, bool* flags,
+                                unsigned int nrcorr, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
     bool flag = false;
     for (unsigned int j = 0; j < nrcorr; ++j) {
-      if (valPtr[j].real() < itsRealMin[j] ||
-          valPtr[j].real() > itsRealMax[j]) {
+      if (data[j].real() < itsRealMin[j] || data[j].real() > itsRealMax[j]) {
         flag = true;
         break;
       }
     }
     if (!flag) {
-      for (unsigned int j = 0; j < nrcorr; ++j) {
-        flagPtr[j] = false;
-      }
+      std::fill(flags, flags + nrcorr, false);
     }
-    valPtr += nrcorr;
-    flagPtr += nrcorr;
+    data += nrcorr;
+    flags += nrcorr;
   }
 }
 
-void PreFlagger::PSet::flagImag(const Cube<casacore::Complex>& values) {
-  const IPosition& shape = values.shape();
-  unsigned int nrcorr = shape[0];
-  unsigned int nr = shape[1] * shape[2];
-  const casacore::Complex* valPtr = values.data();
-  bool* flagPtr = itsFlags.data();
-  for (unsigned int i = 0; i < nr; ++i) {
+void PreFlagger::PSet::flagImag(const casacore::Complex* data, bool* flags,
+                                unsigned int nrcorr, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
     bool flag = false;
     for (unsigned int j = 0; j < nrcorr; ++j) {
-      if (valPtr[j].imag() < itsImagMin[j] ||
-          valPtr[j].imag() > itsImagMax[j]) {
+      if (data[j].imag() < itsImagMin[j] || data[j].imag() > itsImagMax[j]) {
         flag = true;
         break;
       }
     }
     if (!flag) {
-      for (unsigned int j = 0; j < nrcorr; ++j) {
-        flagPtr[j] = false;
-      }
+      std::fill(flags, flags + nrcorr, false);
     }
-    valPtr += nrcorr;
-    flagPtr += nrcorr;
+    data += nrcorr;
+    flags += nrcorr;
   }
 }
 
@@ -11,6 +11,7 @@
 
 #include "InputStep.h"
 
+#include "../base/BDABuffer.h"
 #include "../base/DPBuffer.h"
 #include "../base/BaselineSelection.h"
 
@@ -48,6 +49,11 @@ namespace steps {
 /// expression of selections by means of the internal PSet class.
 /// A PSet objects contains a set of ANDed selections. The PSets can
 /// be logically combined by the user using the normal logical operators.
+///
+/// BDA data is flagged per row. Time selections match a row if they match
+/// one of the time slots that it covers. A channel selection (given as
+/// channel numbers of the full resolution data) flags a channel of a row if
+/// it selects one of the full resolution channels that the channel covers.
 
 class PreFlagger : public Step {
   /// Make this Test class a friend, so it can access private code.
@@ -58,7 +64,8 @@ class PreFlagger : public Step {
 
   /// Construct the object.
   /// Parameters are obtained from the parset using the given prefix.
-  PreFlagger(InputStep*, const common::ParameterSet&, const string& prefix);
+  PreFlagger(InputStep*, const common::ParameterSet&, const string& prefix,
+             MsType inputType = MsType::kRegular);
 
   virtual ~PreFlagger();
 
@@ -66,6 +73,10 @@ class PreFlagger : public Step {
   /// When processed, it invokes the process function of the next step.
   virtual bool process(const base::DPBuffer&);
 
+  /// Process the BDA data.
+  /// When processed, it invokes the process function of the next step.
+  bool process(std::unique_ptr<base::BDABuffer>) override;
+
   /// Finish the processing of this step and subsequent steps.
   virtual void finish();
 
@@ -82,6 +93,14 @@ class PreFlagger : public Step {
   /// Show the timings.
   virtual void showTimings(std::ostream&, double duration) const;
 
+  bool accepts(MsType dt) const override { return dt == itsInputType; }
+
+  MsType outputs() const override { return itsInputType; }
+
+  /// The time can be split, unless time slot numbers or times relative to
+  /// the start are selected.
+  bool canSplitTime() const override;
+
  private:
   /// This internal class represents a single set of ANDed selections.
   /// PSets can be logically combined by the PreFlagger class.
@@ -109,16 +128,39 @@ class PreFlagger : public Step {
                                   const casacore::Block<bool>& matchBL,
                                   common::NSTimer& timer);
 
+    /// Set and return the flags of a BDA row, which covers the time slots
+    /// [firstSlot, endSlot). matchBL tells if the parent matches the
+    /// baseline of the row. The flags have shape (ncorr, nchan) of the row.
+    casacore::Matrix<bool>* processRow(const base::BDABuffer::Row& row,
+                                       unsigned int firstSlot,
+                                       unsigned int endSlot, bool matchBL);
+
     /// Update the general info.
     /// It is used to adjust the parms if needed.
-    void updateInfo(const base::DPInfo&);
+    /// bda tells if the data is BDA data, which is flagged using processRow.
+    void updateInfo(const base::DPInfo&, bool bda = false);
+
+    /// Does process() use the visibility data, i.e. does this pset or one of
+    /// its children flag on amplitude, phase, real or imaginary part?
+    bool usesData() const;
+
+    /// Get per baseline if this pset can flag it. It can only flag the
+    /// baselines matching its baseline selection; the flags of the children
+    /// are ANDed with its own flags.
+    std::vector<bool> selectedBaselines() const;
+
+    /// Does this pset or one of its children select on time slot number or
+    /// on time relative to the start of the input?
+    bool usesRelativeTime() const;
 
     /// Show the pset parameters.
     void show(std::ostream&, bool showName) const;
 
    private:
-    /// Test if the time matches the time ranges.
-    bool matchTime(double time, unsigned int timeSlot) const;
+    /// Test if the time matches the time ranges. It matches a time slot
+    /// selection if one of the time slots [firstSlot, endSlot) is selected.
+    bool matchTime(double time, unsigned int firstSlot,
+                   unsigned int endSlot) const;
 
     /// Test if the value matches one of the ranges in the vector.
     bool matchRange(double v, const std::vector<double>& ranges) const;
@@ -141,21 +183,35 @@ class PreFlagger : public Step {
                   std::size_t ant, const std::vector<std::size_t>& ant1,
                   const std::vector<std::size_t>& ant2);
 
-    /// Set the flags based on amplitude threshold per correlation.
-    void flagAmpl(const casacore::Cube<float>& amplitudes);
+    /// Test if the azimuth and elevation given by the converter match.
+    bool matchAzEl(casacore::MDirection::Convert& converter) const;
 
-    /// Set the flags based on phase threshold per correlation.
-    void flagPhase(const casacore::Cube<casacore::Complex>& data);
+    /// Test if the azimuth and elevation of an antenna match at the given
+    /// time. The results are cached per antenna for the last time.
+    bool matchAzEl(double time, std::size_t ant);
 
-    /// Set the flags based on real/imaginary threshold per correlation.
+    /// Set the flags based on a threshold per correlation.
+    /// The data and flags contain nrcorr values for each of the n points.
     ///@{
-    void flagReal(const casacore::Cube<casacore::Complex>& data);
-    void flagImag(const casacore::Cube<casacore::Complex>& data);
+    void flagAmpl(const casacore::Complex* data, bool* flags,
+                  unsigned int nrcorr, std::size_t n);
+    void flagPhase(const casacore::Complex* data, bool* flags,
+                   unsigned int nrcorr, std::size_t n);
+    void flagReal(const casacore::Complex* data, bool* flags,
+                  unsigned int nrcorr, std::size_t n);
+    void flagImag(const casacore::Complex* data, bool* flags,
+                  unsigned int nrcorr, std::size_t n);
     ///@}
 
     /// Flag the channels given in itsChannels.
     void flagChannels();
 
+    /// Evaluate the PSet expression and AND the result with the flags.
+    /// processChild is called for the child PSets in the expression and
+    /// should return their flags, which have the same shape as flags.
+    template <typename ArrayType, typename ProcessChild>
+    void evaluateExpression(ArrayType& flags, ProcessChild processChild);
+
     /// Convert a string of (date)time ranges to double. Each range
     /// must be given with .. or +-.
     /// <tt>asTime=true</tt> means that the strings should contain times,
@@ -172,7 +228,13 @@ class PreFlagger : public Step {
     void fillBLMatrix();
 
     /// Fill itsChannels if channel/freq selection is done.
-    void fillChannels(const base::DPInfo&);
+    void fillChannels(const base::DPInfo&, bool bda);
+
+    /// Fill itsBdaChanFlags from the selection of full resolution channels
+    /// and the frequency ranges. It returns the full resolution channels
+    /// that are covered by a flagged channel of any baseline.
+    casacore::Vector<bool> fillBdaChannels(
+        const base::DPInfo&, const casacore::Vector<bool>& selChan);
 
     /// Return a vector with a value per correlation.
     /// If no parm value given use the default.
@@ -243,8 +305,13 @@ class PreFlagger : public Step {
     std::vector<int> itsRpn;            ///< PSet expression in RPN form
     std::vector<PSet::ShPtr> itsPSets;  ///< PSets used in itsRpn
     casacore::Matrix<bool> itsChanFlags;  ///< flags for channels to be flagged
+    /// For BDA data, the flags for channels to be flagged per baseline.
+    std::vector<casacore::Matrix<bool>> itsBdaChanFlags;
     casacore::Cube<bool> itsFlags;
+    casacore::Matrix<bool> itsRowFlags;  ///< flags of a BDA row
     casacore::Block<bool> itsMatchBL;  ///< true = baseline in buffer matches
+    double itsAzElTime;                ///< time of itsAzElMatch
+    std::vector<int> itsAzElMatch;     ///< per antenna; -1 = not known yet
   };
 
   /// Set the flags in outPtr where inPtr matches mode.
@@ -258,14 +325,27 @@ class PreFlagger : public Step {
                   unsigned int nrchan, unsigned int nrbl, bool mode,
                   const base::DPBuffer& buf);
 
+  /// Set or clear the flags of a BDA row where flags matches the mode,
+  /// like setFlags and clearFlags.
+  void setRowFlags(const casacore::Matrix<bool>& flags,
+                   const base::BDABuffer::Row& row, bool mode,
+                   unsigned int nslots);
+  void clearRowFlags(const casacore::Matrix<bool>& flags,
+                     const base::BDABuffer::Row& row, bool mode,
+                     unsigned int nslots);
+
   string itsName;
   InputStep* itsInput;
+  const MsType itsInputType;
   base::DPBuffer itsBuffer;
   Mode itsMode;
   common::NSTimer itsTimer;
   PSet itsPSet;
   unsigned int itsCount;
   base::FlagCounter itsFlagCounter;
+  /// For BDA data, the full resolution channels per baseline channel,
+  /// see DPInfo::BdaChannelStarts.
+  std::vector<std::vector<std::size_t>> itsBdaChanStarts;
 };
 
 }  // namespace steps
@@ -74,6 +74,10 @@ class ScaleData : public Step {
 
   MsType outputs() const override { return itsInputType; }
 
+  bool canSplitTime() const override {
+    return itsInputType == MsType::kRegular;
+  }
+
  private:
   /// Fill the scale factors for stations having different nr of tiles.
   void fillSizeScaleFactors(unsigned int nNominal, std::vector<double>& fact);
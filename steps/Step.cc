@@ -6,8 +6,6 @@
 
 #include "Step.h"
 
-#include <assert.h>
-
 using dp3::base::DPBuffer;
 using dp3::base::DPInfo;
 
@@ -66,7 +64,9 @@ MultiResultStep::MultiResultStep(unsigned int size) : itsSize(0) {
 MultiResultStep::~MultiResultStep() {}
 
 bool MultiResultStep::process(const DPBuffer& buf) {
-  assert(itsSize < itsBuffers.size());
+  if (itsSize == itsBuffers.size()) {
+    itsBuffers.emplace_back();
+  }
   itsBuffers[itsSize].copy(buf);
   itsSize++;
   getNextStep()->process(buf);
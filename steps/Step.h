@@ -127,6 +127,11 @@ class Step {
   /// and therefore requires the step to be followed by a write step.
   virtual bool modifiesData() const { return true; }
 
+  /// True when the step keeps no state over time slots, such that separate
+  /// step chains can process independent time ranges of the input
+  /// concurrently (see the 'timechunks' parameter of DP3).
+  virtual bool canSplitTime() const { return false; }
+
  protected:
   base::DPInfo& info() { return itsInfo; }
 
@@ -159,6 +164,8 @@ class NullStep : public Step {
   /// Show the step parameters.
   /// It does nothing.
   virtual void show(std::ostream&) const;
+
+  bool canSplitTime() const override { return true; }
 };
 
 /// @brief This class defines step in the DPPP pipeline that keeps the result
@@ -201,6 +208,8 @@ class ResultStep : public Step {
 class MultiResultStep : public Step {
  public:
   /// Create the object. By default it sets its next step to the NullStep.
+  /// The buffers for the given number of time slots are allocated up front;
+  /// more are added when needed.
   MultiResultStep(unsigned int size);
 
   virtual ~MultiResultStep();
@@ -6,6 +6,7 @@
 
 #include "UVWFlagger.h"
 
+#include "../base/BDABuffer.h"
 #include "../base/DPBuffer.h"
 #include "../base/DPInfo.h"
 #include "../base/Exceptions.h"
@@ -32,6 +33,7 @@ using casacore::MDirection;
 using casacore::MVAngle;
 using casacore::Quantity;
 
+using dp3::base::BDABuffer;
 using dp3::base::DPBuffer;
 using dp3::base::DPInfo;
 using dp3::common::operator<<;
@@ -40,9 +42,10 @@ namespace dp3 {
 namespace steps {
 
 UVWFlagger::UVWFlagger(InputStep* input, const common::ParameterSet& parset,
-                       const string& prefix)
+                       const string& prefix, MsType inputType)
     : itsInput(input),
       itsName(prefix),
+      itsInputType(inputType),
       itsNTimes(0),
       itsRecWavel(),
 
@@ -123,6 +126,18 @@ void UVWFlagger::updateInfo(const DPInfo& infoIn) {
   for (double& wl : itsRecWavel) {
     wl *= inv_c;
   }
+  if (itsInputType == MsType::kBda) {
+    const std::size_t nrbl = infoIn.nbaselines();
+    itsBdaRecWavel.resize(nrbl);
+    itsBdaChanStarts.resize(nrbl);
+    for (std::size_t bl = 0; bl < nrbl; ++bl) {
+      itsBdaRecWavel[bl] = infoIn.chanFreqs(infoIn.hasBDAChannels() ? bl : 0);
+      for (double& wl : itsBdaRecWavel[bl]) {
+        wl *= inv_c;
+      }
+      itsBdaChanStarts[bl] = infoIn.BdaChannelStarts(bl);
+    }
+  }
   // Handle the phase center (if given).
   if (!itsCenter.empty()) {
     handleCenter();
@@ -147,7 +162,6 @@ bool UVWFlagger::process(const DPBuffer& buf) {
   unsigned int nrcorr = shape[0];
   unsigned int nrchan = shape[1];
   unsigned int nrbl = shape[2];
-  unsigned int nr = nrcorr * nrchan;
   assert(nrchan == itsRecWavel.size());
   // Input uvw coordinates are only needed if no new phase center is used.
   Matrix<double> uvws;
@@ -167,40 +181,7 @@ bool UVWFlagger::process(const DPBuffer& buf) {
       uvwPtr = uvw.data();
       /// cout << "uvw = " << uvw << '\n';
     }
-    double uvdist = uvwPtr[0] * uvwPtr[0] + uvwPtr[1] * uvwPtr[1];
-    bool flagBL = false;
-    if (!itsRangeUVm.empty()) {
-      // UV-distance is sqrt(u^2 + v^2).
-      // The sqrt is not needed because itsRangeUVm is squared.
-      flagBL = testUVWm(uvdist, itsRangeUVm);
-    }
-    if (!(flagBL || itsRangeUm.empty())) {
-      flagBL = testUVWm(uvwPtr[0], itsRangeUm);
-    }
-    if (!(flagBL || itsRangeVm.empty())) {
-      flagBL = testUVWm(uvwPtr[1], itsRangeVm);
-    }
-    if (!(flagBL || itsRangeWm.empty())) {
-      flagBL = testUVWm(uvwPtr[2], itsRangeWm);
-    }
-    if (flagBL) {
-      // Flag entire baseline.
-      std::fill(flagPtr, flagPtr + nr, true);
-    } else {
-      if (!itsRangeUVl.empty()) {
-        // UV-distance is sqrt(u^2 + v^2).
-        testUVWl(sqrt(uvdist), itsRangeUVl, flagPtr, nrcorr);
-      }
-      if (!itsRangeUl.empty()) {
-        testUVWl(uvwPtr[0], itsRangeUl, flagPtr, nrcorr);
-      }
-      if (!itsRangeVl.empty()) {
-        testUVWl(uvwPtr[1], itsRangeVl, flagPtr, nrcorr);
-      }
-      if (!itsRangeWl.empty()) {
-        testUVWl(uvwPtr[2], itsRangeWl, flagPtr, nrcorr);
-      }
-    }
+    flagBaseline(uvwPtr, itsRecWavel, flagPtr, nrcorr);
     // Count the flags set newly.
     for (unsigned int j = 0; j < nrchan; ++j) {
       if (*flagPtr && !*origPtr) {
@@ -219,11 +200,92 @@ bool UVWFlagger::process(const DPBuffer& buf) {
   return true;
 }
 
+bool UVWFlagger::process(std::unique_ptr<BDABuffer> buffer) {
+  if (itsIsDegenerate) {
+    getNextStep()->process(std::move(buffer));
+    return true;
+  }
+
+  itsTimer.start();
+  for (BDABuffer::Row& row : buffer->GetRows()) {
+    const std::size_t bl = row.baseline_nr;
+    const unsigned int nrcorr = row.n_correlations;
+    const unsigned int nrchan = row.n_channels;
+    assert(nrchan == itsBdaRecWavel[bl].size());
+    std::array<double, 3> uvw{row.uvw[0], row.uvw[1], row.uvw[2]};
+    if (!itsCenter.empty()) {
+      // A different phase center is given, so calculate UVW for it.
+      common::NSTimer::StartStop ssuvwtimer(itsUVWTimer);
+      uvw = itsUVWCalc->getUVW(getInfo().getAnt1()[bl],
+                               getInfo().getAnt2()[bl], row.time);
+    }
+    itsOrigFlags.resize(nrchan);
+    for (unsigned int j = 0; j < nrchan; ++j) {
+      itsOrigFlags[j] = row.flags[j * nrcorr];
+    }
+    flagBaseline(uvw.data(), itsBdaRecWavel[bl], row.flags, nrcorr);
+    // Count the flags set newly for all time slots and full resolution
+    // channels that the row covers.
+    const std::pair<unsigned int, unsigned int> slots =
+        getInfo().TimeSlots(row.time, row.interval);
+    const std::vector<std::size_t>& chanStarts = itsBdaChanStarts[bl];
+    for (unsigned int j = 0; j < nrchan; ++j) {
+      if (row.flags[j * nrcorr] && !itsOrigFlags[j]) {
+        itsFlagCounter.incrBdaChannel(bl, chanStarts[j], chanStarts[j + 1],
+                                      slots.second - slots.first);
+      }
+    }
+    itsNTimes = std::max(itsNTimes, slots.second);
+  }
+  itsTimer.stop();
+  getNextStep()->process(std::move(buffer));
+  return true;
+}
+
 void UVWFlagger::finish() {
   // Let the next step finish its processing.
   getNextStep()->finish();
 }
 
+void UVWFlagger::flagBaseline(const double* uvwPtr,
+                              const std::vector<double>& recWavel,
+                              bool* flagPtr, unsigned int nrcorr) {
+  double uvdist = uvwPtr[0] * uvwPtr[0] + uvwPtr[1] * uvwPtr[1];
+  bool flagBL = false;
+  if (!itsRangeUVm.empty()) {
+    // UV-distance is sqrt(u^2 + v^2).
+    // The sqrt is not needed because itsRangeUVm is squared.
+    flagBL = testUVWm(uvdist, itsRangeUVm);
+  }
+  if (!(flagBL || itsRangeUm.empty())) {
+    flagBL = testUVWm(uvwPtr[0], itsRangeUm);
+  }
+  if (!(flagBL || itsRangeVm.empty())) {
+    flagBL = testUVWm(uvwPtr[1], itsRangeVm);
+  }
+  if (!(flagBL || itsRangeWm.empty())) {
+    flagBL = testUVWm(uvwPtr[2], itsRangeWm);
+  }
+  if (flagBL) {
+    // Flag entire baseline.
+    std::fill(flagPtr, flagPtr + nrcorr * recWavel.size(), true);
+  } else {
+    if (!itsRangeUVl.empty()) {
+      // UV-distance is sqrt(u^2 + v^2).
+      testUVWl(sqrt(uvdist), itsRangeUVl, recWavel, flagPtr, nrcorr);
+    }
+    if (!itsRangeUl.empty()) {
+      testUVWl(uvwPtr[0], itsRangeUl, recWavel, flagPtr, nrcorr);
+    }
+    if (!itsRangeVl.empty()) {
+      testUVWl(uvwPtr[1], itsRangeVl, recWavel, flagPtr, nrcorr);
+    }
+    if (!itsRangeWl.empty()) {
+      testUVWl(uvwPtr[2], itsRangeWl, recWavel, flagPtr, nrcorr);
+    }
+  }
+}
+
 bool UVWFlagger::testUVWm(double uvw, const std::vector<double>& ranges) {
   for (size_t i = 0; i < ranges.size(); i += 2) {
     if (uvw > ranges[i] && uvw < ranges[i + 1]) {
@@ -234,13 +296,14 @@ bool UVWFlagger::testUVWm(double uvw, const std::vector<double>& ranges) {
 }
 
 void UVWFlagger::testUVWl(double uvw, const std::vector<double>& ranges,
-                          bool* flagPtr, unsigned int nrcorr) {
+                          const std::vector<double>& recWavel, bool* flagPtr,
+                          unsigned int nrcorr) {
   // This loop could be made more efficient if it is guaranteed that
-  // itsRecWavel is in strict ascending or descending order.
+  // recWavel is in strict ascending or descending order.
   // It is expected that the nr of ranges is so small that it is not
   // worth the trouble, but it could be done if ever needed.
-  for (unsigned int j = 0; j < itsRecWavel.size(); ++j) {
-    double uvwl = uvw * itsRecWavel[j];
+  for (unsigned int j = 0; j < recWavel.size(); ++j) {
+    double uvwl = uvw * recWavel[j];
     for (size_t i = 0; i < ranges.size(); i += 2) {
       if (uvwl > ranges[i] && uvwl < ranges[i + 1]) {
         std::fill(flagPtr, flagPtr + nrcorr, true);
@@ -11,6 +11,7 @@
 
 #include "InputStep.h"
 
+#include "../base/BDABuffer.h"
 #include "../base/DPBuffer.h"
 #include "../base/UVWCalculator.h"
 
@@ -33,6 +34,8 @@ namespace steps {
 ///       be given as a position or as a moving source like SUN or JUPITER.
 /// </ul>
 /// The UVW values can be given in meters or in wavelengths.
+///
+/// BDA data is flagged per row, using the channels of the row's baseline.
 
 class UVWFlagger : public Step {
  public:
@@ -41,7 +44,8 @@ class UVWFlagger : public Step {
   /// The antenna names are used to find antenna numbers.
   /// The channel frequencies as they are in the input step must be given
   /// starting at the start-channel.
-  UVWFlagger(InputStep*, const common::ParameterSet&, const string& prefix);
+  UVWFlagger(InputStep*, const common::ParameterSet&, const string& prefix,
+             MsType inputType = MsType::kRegular);
 
   virtual ~UVWFlagger();
 
@@ -49,6 +53,10 @@ class UVWFlagger : public Step {
   /// When processed, it invokes the process function of the next step.
   virtual bool process(const base::DPBuffer&);
 
+  /// Process the BDA data.
+  /// When processed, it invokes the process function of the next step.
+  bool process(std::unique_ptr<base::BDABuffer>) override;
+
   /// Finish the processing of this step and subsequent steps.
   virtual void finish();
 
@@ -65,12 +73,26 @@ class UVWFlagger : public Step {
   /// Show the timings.
   virtual void showTimings(std::ostream&, double duration) const;
 
+  bool accepts(MsType dt) const override { return dt == itsInputType; }
+
+  MsType outputs() const override { return itsInputType; }
+
+  bool canSplitTime() const override {
+    return itsInputType == MsType::kRegular;
+  }
+
  private:
+  /// Set the flags of a baseline with the given uvw (in m). The baseline has
+  /// a channel for each element of recWavel.
+  void flagBaseline(const double* uvw, const std::vector<double>& recWavel,
+                    bool* flagPtr, unsigned int nrcorr);
+
   /// Test if uvw matches a range in meters.
   bool testUVWm(double uvw, const std::vector<double>& ranges);
 
   /// Set flags for channels where uvw (in m) matches a range in wavelengths.
-  void testUVWl(double uvw, const std::vector<double>& ranges, bool* flagPtr,
+  void testUVWl(double uvw, const std::vector<double>& ranges,
+                const std::vector<double>& recWavel, bool* flagPtr,
                 unsigned int nrcorr);
 
   /// Return a vector with UVW ranges.
@@ -89,10 +111,17 @@ class UVWFlagger : public Step {
 
   InputStep* itsInput;
   string itsName;
+  const MsType itsInputType;
   base::DPBuffer itsBuffer;
   unsigned int itsNTimes;
 
   std::vector<double> itsRecWavel;        ///< reciprokes of wavelengths
+  /// For BDA data, the reciprokes of wavelengths per baseline.
+  std::vector<std::vector<double>> itsBdaRecWavel;
+  /// For BDA data, the full resolution channels per baseline channel,
+  /// see DPInfo::BdaChannelStarts.
+  std::vector<std::vector<std::size_t>> itsBdaChanStarts;
+  std::vector<bool> itsOrigFlags;  ///< original flags of a BDA row
   const std::vector<double> itsRangeUVm;  ///< UV ranges (in m) to be flagged
   const std::vector<double> itsRangeUm;   ///< U  ranges (in m) to be flagged
   const std::vector<double> itsRangeVm;   ///< V  ranges (in m) to be flagged
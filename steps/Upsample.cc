@@ -85,14 +85,8 @@ bool Upsample::process(const DPBuffer& bufin) {
     buffers_[i].setExposure(exposure);
 
     if (update_uvw_) {
-      buffers_[i].getUVW().resize(3, info().nbaselines());
-      double* uvw_ptr = buffers_[i].getUVW().data();
-      for (std::size_t bl = 0; bl < info().nbaselines(); ++bl) {
-        const std::array<double, 3> uvw = uvw_calculator_->getUVW(
-            info().getAnt1()[bl], info().getAnt2()[bl], time);
-        std::copy_n(uvw.data(), 3, uvw_ptr);
-        uvw_ptr += 3;
-      }
+      uvw_calculator_->getUVWs(time, info().getAnt1(), info().getAnt2(),
+                               buffers_[i].getUVW());
     }
   }
 
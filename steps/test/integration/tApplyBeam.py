@@ -3,6 +3,7 @@
 
 import pytest
 import os
+import re
 import shutil
 import uuid
 from subprocess import check_call, check_output
@@ -80,6 +81,36 @@ def test_with_invert_and_chanfreq(usechannelfreq):
     assert_taql(taql_command)
 
 
+def test_with_updateinterval():
+    # An update interval of 25 s spans two to three time slots of 10 s, so
+    # the beam is interpolated between grid points. The result should match
+    # the beam evaluated at every time slot within the reported error.
+    msout = "outinv.ms"
+    output = check_output(
+        [
+            tcf.DP3EXE,
+            f"msin={MSIN}",
+            f"msout={msout}",
+            "steps=[applybeam]",
+            "applybeam.updateinterval=25",
+            "applybeam.invert=true",
+        ]
+    ).decode()
+    match = re.search(r"max\. estimated relative interpolation error: (\S+)", output)
+    assert match
+    max_error = float(match.group(1))
+    assert max_error > 0
+
+    # The relative error applies to the beam of both stations of a baseline.
+    # It is relative to the largest value of a row, since the error of the
+    # beam matrices also affects the smaller cross-polarizations.
+    tolerance = 2 * max_error + 8e-5
+    reference = "t2.DATA_ucf"
+    scale = f"max(iif(isnan({reference}), 0., abs({reference})))"
+    taql_command = f"select from {msout} t1, {MSAPPLYBEAM} t2 where not all(nearAbs(t1.DATA,{reference},{tolerance}*{scale}) || (isnan(t1.DATA) && isnan({reference})))"
+    assert_taql(taql_command)
+
+
 @pytest.mark.parametrize("beammode", ["ARRAY_FACTOR", "ELEMENT"])
 def test_beammodes(beammode):
     msout = "outinv.ms"
@@ -73,3 +73,37 @@ class MockPyStep(Step):
         step accumulates multiple time slots.
         """
         pass
+
+
+class MockPyBatchStep(MockPyStep):
+    """
+    Example python DPStep that does the same as MockPyStep, but processes
+    multiple time slots at once.
+    """
+    def __init__(self, parset, prefix):
+        super().__init__(parset, prefix)
+
+        # Pass batches of up to 4 time slots to process_batch.
+        self.batch_size = 4
+
+    def show(self):
+        """Print a summary of the step and its settings"""
+        print("\nMockPyBatchStep")
+        print(f"  data factor:    {self.datafactor}")
+        print(f"  weights factor: {self.weightsfactor}")
+
+    def process_batch(self, batch):
+        """
+        Process a batch of time slots in place. The time slots are passed to
+        the next step after this function returns.
+
+        Args:
+          batch: DPBufferBatch object with numpy views on the data, flags and
+                 weights of all time slots in the batch. The time slot is the
+                 first axis.
+        """
+        data = batch.get_data()
+        weights = batch.get_weights()
+
+        data *= self.datafactor
+        weights *= self.weightsfactor
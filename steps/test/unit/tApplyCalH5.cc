@@ -12,7 +12,11 @@
 #include <schaapcommon/h5parm/h5parm.h>
 #include <schaapcommon/h5parm/soltab.h>
 
+#include <cmath>
+
 #include "tStepCommon.h"
+#include "mock/MockInput.h"
+#include "mock/MockStep.h"
 #include "../../Step.h"
 #include "../../ApplyCal.h"
 #include "../../InputStep.h"
@@ -23,12 +27,14 @@
 #include "../../../common/StreamUtil.h"
 
 using casacore::max;
+using dp3::base::BDABuffer;
 using dp3::base::DPBuffer;
 using dp3::base::DPInfo;
 using dp3::common::ParameterSet;
 using dp3::steps::ApplyCal;
 using dp3::steps::InputStep;
 using dp3::steps::Step;
+using dp3::steps::test::BdaAveraging;
 using schaapcommon::h5parm::H5Parm;
 using schaapcommon::h5parm::SolTab;
 using std::complex;
@@ -457,4 +463,79 @@ BOOST_AUTO_TEST_CASE(testmissingant_unit) {
   testmissingant(9, 2, "unit", true, true);
 }
 
+BOOST_AUTO_TEST_CASE(bda) {
+  // Channels below 103.5 MHz use the first solution and the other channels
+  // use the second one, so the solutions are constant within the averaged
+  // channels of the BDA data.
+  createH5Parm(vector<double>(), vector<double>{101.5e6, 105.5e6});
+  const vector<BdaAveraging> averaging{
+      {1, {1, 1, 1, 1, 1, 1, 1, 1}}, {2, {2, 2, 2, 2}}, {4, {1, 3, 4}}};
+  const DPInfo bda_info = dp3::steps::test::CreateBdaInfo(
+      dp3::steps::test::CreateTestInfo(4, 8), averaging);
+  std::unique_ptr<BDABuffer> bda_buffer =
+      dp3::steps::test::CreateBdaBuffer(bda_info, averaging);
+  const BDABuffer original(*bda_buffer, BDABuffer::Fields());
+  DPInfo regular_info;
+  const vector<DPBuffer> regular_buffers =
+      dp3::steps::test::ExpandBda(bda_info, *bda_buffer, regular_info);
+
+  ParameterSet parset;
+  parset.add("correction", "myampl");
+  parset.add("parmdb", "tApplyCalH5_tmp.h5");
+  dp3::steps::MockInput input;
+
+  auto regular_applycal = std::make_shared<ApplyCal>(&input, parset, "");
+  auto regular_result =
+      std::make_shared<dp3::steps::MultiResultStep>(regular_buffers.size());
+  regular_applycal->setNextStep(regular_result);
+  regular_applycal->setInfo(regular_info);
+  for (const DPBuffer& buffer : regular_buffers) {
+    regular_applycal->process(buffer);
+  }
+  regular_applycal->finish();
+
+  auto bda_applycal = std::make_shared<ApplyCal>(&input, parset, "", false, "",
+                                                 Step::MsType::kBda);
+  auto bda_result = std::make_shared<dp3::steps::MockStep>();
+  bda_applycal->setNextStep(bda_result);
+  bda_applycal->setInfo(bda_info);
+  bda_applycal->process(std::move(bda_buffer));
+  bda_applycal->finish();
+
+  // Each BDA sample should equal the corrected regular samples it covers.
+  BOOST_REQUIRE_EQUAL(bda_result->GetBdaBuffers().size(), 1u);
+  const BDABuffer& corrected = *bda_result->GetBdaBuffers().front();
+  BOOST_REQUIRE_EQUAL(corrected.GetRows().size(), original.GetRows().size());
+  std::size_t n_changed = 0;
+  for (std::size_t r = 0; r < corrected.GetRows().size(); ++r) {
+    const BDABuffer::Row& row = corrected.GetRows()[r];
+    const BdaAveraging& bl_averaging = averaging[row.baseline_nr];
+    const unsigned int first_slot =
+        std::round((row.time - 0.5 * row.interval - bda_info.startTime()) /
+                   bda_info.timeInterval());
+    unsigned int first_chan = 0;
+    for (std::size_t chan = 0; chan < row.n_channels; ++chan) {
+      const unsigned int end_chan = first_chan + bl_averaging.n_channels[chan];
+      for (std::size_t corr = 0; corr < row.n_correlations; ++corr) {
+        const std::size_t index = chan * row.n_correlations + corr;
+        BOOST_CHECK(!row.flags[index]);
+        if (row.data[index] != original.GetRows()[r].data[index]) ++n_changed;
+        for (unsigned int slot = first_slot;
+             slot < first_slot + bl_averaging.n_times; ++slot) {
+          const DPBuffer& regular = regular_result->get()[slot];
+          for (unsigned int ch = first_chan; ch < end_chan; ++ch) {
+            BOOST_CHECK(!regular.getFlags()(corr, ch, row.baseline_nr));
+            BOOST_CHECK_SMALL(std::abs(row.data[index] -
+                                       regular.getData()(corr, ch,
+                                                         row.baseline_nr)),
+                              1.0e-5f);
+          }
+        }
+      }
+      first_chan = end_chan;
+    }
+  }
+  BOOST_CHECK_GT(n_changed, 0u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -426,6 +426,101 @@ class TestOutput4 : public Step {
   int itsNrTime, itsNrBl, itsNrChan, itsNrCorr, itsStep;
 };
 
+// Simple class to flag entire baselines, which differ per time slot.
+// Baseline ib is flagged in time slot it if (ib + it) % 3 == 0.
+// Furthermore, the first channel of the last baseline is always flagged.
+class TestBaselineFlagger : public Step {
+ public:
+  TestBaselineFlagger() : itsCount(0) {}
+
+ private:
+  virtual bool process(const DPBuffer& buf) {
+    DPBuffer buf2(buf);
+    buf2.getFlags().unique();
+    casacore::Cube<bool>& flags = buf2.getFlags();
+    const int nbl = flags.shape()[2];
+    for (int ib = 0; ib < nbl; ++ib) {
+      if ((ib + itsCount) % 3 == 0) {
+        flags(casacore::IPosition(3, 0, 0, ib),
+              casacore::IPosition(3, flags.shape()[0] - 1,
+                                  flags.shape()[1] - 1, ib)) = true;
+      }
+    }
+    for (int ip = 0; ip < flags.shape()[0]; ++ip) {
+      flags(ip, 0, nbl - 1) = true;
+    }
+    getNextStep()->process(buf2);
+    ++itsCount;
+    return true;
+  }
+
+  virtual void finish() { getNextStep()->finish(); }
+  virtual void show(std::ostream&) const {}
+
+  int itsCount;
+};
+
+// Class to check result of averaging TestInput after TestBaselineFlagger.
+class TestOutputBaselineFlags : public Step {
+ public:
+  TestOutputBaselineFlags(int nbl, int nchan, int ncorr, int navgtime,
+                          int navgchan)
+      : itsCount(0),
+        itsNBl(nbl),
+        itsNChan(nchan),
+        itsNCorr(ncorr),
+        itsNAvgTime(navgtime),
+        itsNAvgChan(navgchan) {}
+
+ private:
+  virtual bool process(const DPBuffer& buf) {
+    const int nchan = itsNChan / itsNAvgChan;
+    casacore::Cube<casacore::Complex> result(itsNCorr, nchan, itsNBl);
+    casacore::Cube<float> weights(itsNCorr, nchan, itsNBl);
+    casacore::Cube<bool> flags(itsNCorr, nchan, itsNBl);
+    for (int ib = 0; ib < itsNBl; ++ib) {
+      for (int ic = 0; ic < nchan; ++ic) {
+        for (int ip = 0; ip < itsNCorr; ++ip) {
+          casacore::Complex sum, sumAll;
+          int n = 0;
+          int nAll = 0;
+          for (int it = itsCount * itsNAvgTime;
+               it < (itsCount + 1) * itsNAvgTime; ++it) {
+            for (int ich = ic * itsNAvgChan; ich < (ic + 1) * itsNAvgChan;
+                 ++ich) {
+              // Same data as generated by TestInput.
+              const int i = ip + itsNCorr * (ich + itsNChan * ib);
+              const casacore::Complex value(i + it * 10, i - 1000 + it * 6);
+              const bool flagged =
+                  (ib + it) % 3 == 0 || (ib == itsNBl - 1 && ich == 0);
+              sumAll += value;
+              ++nAll;
+              if (!flagged) {
+                sum += value;
+                ++n;
+              }
+            }
+          }
+          flags(ip, ic, ib) = (n == 0);
+          result(ip, ic, ib) = n == 0 ? sumAll / float(nAll) : sum / float(n);
+          weights(ip, ic, ib) = n == 0 ? nAll : n;
+        }
+      }
+    }
+    BOOST_CHECK(allNear(real(buf.getData()), real(result), 1e-5));
+    BOOST_CHECK(allNear(imag(buf.getData()), imag(result), 1e-5));
+    BOOST_CHECK(allEQ(buf.getFlags(), flags));
+    BOOST_CHECK(allNear(buf.getWeights(), weights, 1e-5));
+    ++itsCount;
+    return true;
+  }
+
+  virtual void finish() {}
+  virtual void show(std::ostream&) const {}
+
+  int itsCount, itsNBl, itsNChan, itsNCorr, itsNAvgTime, itsNAvgChan;
+};
+
 // Test simple averaging without flagged points.
 void test1(int ntime, int nbl, int nchan, int ncorr, int navgtime, int navgchan,
            bool flag) {
@@ -523,6 +618,21 @@ void test4(int nrbl, int nrcorr, int flagstep) {
   }
 }
 
+// Do tests where entire baselines are flagged in some time slots, such that
+// baselines change between fully flagged, unflagged and partially flagged.
+void test5(int ntime, int nbl, int nchan, int ncorr, int navgtime,
+           int navgchan) {
+  auto step1 = std::make_shared<TestInput>(ntime, nbl, nchan, ncorr, false);
+  ParameterSet parset;
+  parset.add("freqstep", std::to_string(navgchan));
+  parset.add("timestep", std::to_string(navgtime));
+  auto step2a = std::make_shared<TestBaselineFlagger>();
+  auto step2b = std::make_shared<Averager>(*step1, parset, "");
+  auto step3 = std::make_shared<TestOutputBaselineFlags>(nbl, nchan, ncorr,
+                                                         navgtime, navgchan);
+  dp3::steps::test::Execute({step1, step2a, step2b, step3});
+}
+
 BOOST_AUTO_TEST_CASE(testaverager1) { test1(10, 3, 32, 4, 2, 4, false); }
 
 BOOST_AUTO_TEST_CASE(testaverager2) { test1(10, 3, 30, 1, 3, 3, true); }
@@ -546,6 +656,12 @@ BOOST_AUTO_TEST_CASE(testaverager11) { test4(1, 4, 3); }
 
 BOOST_AUTO_TEST_CASE(testaverager12) { test4(20, 4, 5); }
 
+BOOST_AUTO_TEST_CASE(testaverager13) { test5(6, 5, 8, 4, 3, 2); }
+
+BOOST_AUTO_TEST_CASE(testaverager14) { test5(6, 4, 4, 1, 2, 4); }
+
+BOOST_AUTO_TEST_CASE(testaverager15) { test5(6, 4, 4, 2, 1, 2); }
+
 BOOST_AUTO_TEST_CASE(testresolution1) {
   test1resolution(10, 3, 32, 4, 10., 100000, "Hz", false);
 }
@@ -145,6 +145,88 @@ BOOST_FIXTURE_TEST_CASE(process_simple, FixtureDirectory,
   BOOST_TEST(t.col("FIELD_ID").getInt(0) == -1);
 }
 
+// Test that rows with different shapes are written correctly, both with
+// synchronous and asynchronous writing.
+BOOST_FIXTURE_TEST_CASE(process_mixed_shapes, FixtureDirectory,
+                        *boost::unit_test::label("slow")) {
+  for (const std::string async : {"false", "true"}) {
+    const std::string kMsName = "bda_mixed_" + async + ".MS";
+    ParameterSet parset;
+    parset.add(prefix + "asyncwrite", async);
+    const casacore::MeasurementSet ms_in("../tNDPPP_tmp.MS");
+    MSReader reader(ms_in, parset, prefix);
+    MSBDAWriter writer(&reader, kMsName, parset, prefix);
+
+    // Baseline 0 has two channels, baseline 1 has one averaged channel.
+    DPInfo info;
+    info.init(1, 0, 2, 2, 3.0, 1.5, "", "");
+    info.set(std::vector<std::string>{"ant", "ant2"},
+             std::vector<double>{1.0, 1.0},
+             {casacore::MVPosition{0, 0, 0}, casacore::MVPosition{10, 10, 0}},
+             std::vector<int>{0, 0}, std::vector<int>{0, 1});
+    info.set(std::vector<std::vector<double>>{{1., 2.}, {1.5}},
+             std::vector<std::vector<double>>{{1., 1.}, {2.}});
+    info.update(std::vector<unsigned int>{1, 1});
+    writer.updateInfo(info);
+
+    const std::complex<float> kData[5]{
+        {1.0, 2.0}, {3.0, 4.0}, {5.0, 6.0}, {7.0, 8.0}, {9.0, 10.0}};
+    const float kWeights[5]{1.0, 2.0, 3.0, 4.0, 5.0};
+    const bool kFlags[5]{false, true, true, true, false};
+    const double kUVW[3]{45.0, 46.0, 47.0};
+    auto buffer = boost::make_unique<BDABuffer>(5);
+    buffer->AddRow(3.0, 1.5, 1.5, 0, 2, 1, &kData[0], &kFlags[0],
+                   &kWeights[0], nullptr, kUVW);
+    buffer->AddRow(4.5, 1.5, 1.5, 0, 2, 1, &kData[2], &kFlags[2],
+                   &kWeights[2], nullptr, kUVW);
+    buffer->AddRow(4.5, 1.5, 1.5, 1, 1, 1, &kData[4], &kFlags[4],
+                   &kWeights[4], nullptr, kUVW);
+    writer.process(std::move(buffer));
+    writer.finish();
+
+    MeasurementSet ms(kMsName, TableLock::AutoNoReadLocking);
+    BOOST_REQUIRE_EQUAL(ms.nrow(), 3U);
+    const std::vector<size_t> kFirstValue{0, 2, 4};
+    const std::vector<size_t> kNChannels{2, 2, 1};
+    for (size_t row = 0; row < 3; ++row) {
+      const std::vector<std::complex<double>> data =
+          ms.col("DATA").getArrayDComplex(row).tovector();
+      const std::vector<double> weights =
+          ms.col("WEIGHT_SPECTRUM").getArrayDouble(row).tovector();
+      const std::vector<bool> flags =
+          ms.col("FLAG").getArrayBool(row).tovector();
+      BOOST_REQUIRE_EQUAL(data.size(), kNChannels[row]);
+      for (size_t ch = 0; ch < kNChannels[row]; ++ch) {
+        const size_t i = kFirstValue[row] + ch;
+        BOOST_TEST(data[ch].real() == kData[i].real());
+        BOOST_TEST(data[ch].imag() == kData[i].imag());
+        BOOST_TEST(weights[ch] == kWeights[i]);
+        BOOST_TEST(flags[ch] == kFlags[i]);
+      }
+    }
+    BOOST_TEST(ms.col("TIME").getDouble(1) == 4.5);
+    BOOST_TEST(ms.col("ANTENNA2").getInt(2) == 1);
+    BOOST_TEST(!ms.col("FLAG_ROW").getBool(0));
+    BOOST_TEST(ms.col("FLAG_ROW").getBool(1));
+  }
+}
+
+// Test that asynchronous writing gives the reader an I/O mutex, which the
+// writing thread holds while it uses casacore.
+BOOST_FIXTURE_TEST_CASE(async_write_sets_io_mutex, FixtureDirectory,
+                        *boost::unit_test::label("slow")) {
+  const casacore::MeasurementSet ms_in("../tNDPPP_tmp.MS");
+  MSReader sync_reader(ms_in, ParameterSet(), prefix);
+  MSBDAWriter sync_writer(&sync_reader, "bda_sync.MS", ParameterSet(), prefix);
+  BOOST_TEST(!sync_reader.lockIo().owns_lock());
+
+  ParameterSet parset;
+  parset.add(prefix + "asyncwrite", "true");
+  MSReader async_reader(ms_in, parset, prefix);
+  MSBDAWriter async_writer(&async_reader, "bda_async.MS", parset, prefix);
+  BOOST_TEST(async_reader.lockIo().owns_lock());
+}
+
 // Test that an exception is thrown when the base lines are not correct
 BOOST_FIXTURE_TEST_CASE(exception_when_mismatch, FixtureDirectory) {
   const double kTime(3.0);
@@ -4,6 +4,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "../../MSReader.h"
+#include "../../MultiMSReader.h"
 #include "../../../common/ParameterSet.h"
 
 #include <EveryBeam/load.h>
@@ -12,7 +13,27 @@
 #include <casacore/casa/Arrays/Vector.h>
 #include <vector>
 
+using dp3::base::DPBuffer;
 using dp3::steps::MSReader;
+using dp3::steps::MultiMSReader;
+using dp3::steps::MultiResultStep;
+
+namespace {
+/// Read all time slots using the given reader and return the buffers.
+std::vector<DPBuffer> ReadAll(dp3::steps::InputStep& reader) {
+  auto result_step = std::make_shared<MultiResultStep>(1);
+  reader.setNextStep(result_step);
+  reader.setInfo(dp3::base::DPInfo());
+  reader.setReadVisData(true);
+  DPBuffer buffer;
+  while (reader.process(buffer)) {
+  }
+  reader.finish();
+  return std::vector<DPBuffer>(
+      result_step->get().begin(),
+      result_step->get().begin() + result_step->size());
+}
+}  // namespace
 
 BOOST_AUTO_TEST_SUITE(msreader)
 
@@ -69,4 +90,46 @@ BOOST_AUTO_TEST_CASE(read_oskar) {
   }
 }
 
+// Reading multiple MSs gives the bands of the individual MSs, read one after
+// the other, in consecutive channels.
+BOOST_AUTO_TEST_CASE(read_multiple_ms) {
+  const std::string kMsName = "tNDPPP-generic.MS";
+  const casacore::MeasurementSet ms(kMsName);
+  const dp3::common::ParameterSet parset;
+  MSReader single_reader(ms, parset, "msin.");
+  const std::vector<DPBuffer> expected = ReadAll(single_reader);
+  BOOST_REQUIRE(!expected.empty());
+
+  MultiMSReader multi_reader({kMsName, kMsName}, parset, "msin.");
+  const std::vector<DPBuffer> result = ReadAll(multi_reader);
+  BOOST_REQUIRE_EQUAL(result.size(), expected.size());
+
+  const casacore::IPosition& shape = expected.front().getData().shape();
+  const size_t n_correlations = shape[0];
+  const size_t n_channels = shape[1];
+  const size_t n_baselines = shape[2];
+  BOOST_REQUIRE_EQUAL(multi_reader.getInfo().nchan(), 2 * n_channels);
+  for (size_t time = 0; time < result.size(); ++time) {
+    BOOST_CHECK_CLOSE(result[time].getTime(), expected[time].getTime(), 1e-9);
+    const casacore::Cube<casacore::Complex>& data = result[time].getData();
+    const casacore::Cube<bool>& flags = result[time].getFlags();
+    BOOST_REQUIRE_EQUAL(data.shape(),
+                        casacore::IPosition(3, n_correlations, 2 * n_channels,
+                                            n_baselines));
+    for (size_t band = 0; band < 2; ++band) {
+      for (size_t bl = 0; bl < n_baselines; ++bl) {
+        for (size_t chan = 0; chan < n_channels; ++chan) {
+          const size_t result_chan = band * n_channels + chan;
+          for (size_t corr = 0; corr < n_correlations; ++corr) {
+            BOOST_CHECK_EQUAL(data(corr, result_chan, bl),
+                              expected[time].getData()(corr, chan, bl));
+            BOOST_CHECK_EQUAL(flags(corr, result_chan, bl),
+                              expected[time].getFlags()(corr, chan, bl));
+          }
+        }
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,7 +3,10 @@
 
 #include "tPredict.h"
 #include "../../OnePredict.h"
+#include "../../../base/PredictBuffer.h"
 #include "../../../common/ParameterSet.h"
+#include "../../../common/test/unit/fixtures/fDirectory.h"
+#include "../../../common/test/unit/fixtures/fSkymodel.h"
 
 #include "mock/MockInput.h"
 
@@ -23,6 +26,24 @@ constexpr double kStartTime = 0.0;
 constexpr double kInterval = 1.0;
 constexpr std::size_t kNBaselines = 3;
 
+dp3::base::DPInfo CreateInfo(unsigned int n_correlations = 1) {
+  dp3::base::DPInfo info;
+  info.init(n_correlations, 0, 1, 10, 0.0, 1.0, "", "");
+
+  const std::vector<int> kAnt1{0, 0, 1};
+  const std::vector<int> kAnt2{1, 2, 2};
+  const std::vector<std::string> kAntNames{"ant0", "ant1", "ant2"};
+  const std::vector<double> kAntDiam(3, 1.0);
+  const std::vector<casacore::MPosition> kAntPos(3);
+  info.set(kAntNames, kAntDiam, kAntPos, kAnt1, kAnt2);
+
+  std::vector<double> chan_freqs(1, 10.0e6);
+  std::vector<double> chan_widths(1, 3.0e6);
+
+  info.set(std::move(chan_freqs), std::move(chan_widths));
+  return info;
+}
+
 class OnePredictFixture {
  public:
   OnePredictFixture() : input_(), predict_() {
@@ -34,23 +55,7 @@ class OnePredictFixture {
     SetInfo();
   }
 
-  void SetInfo() {
-    dp3::base::DPInfo info;
-    info.init(1, 0, 1, 10, 0.0, 1.0, "", "");
-
-    const std::vector<int> kAnt1{0, 0, 1};
-    const std::vector<int> kAnt2{1, 2, 2};
-    const std::vector<std::string> kAntNames{"ant0", "ant1", "ant2"};
-    const std::vector<double> kAntDiam(3, 1.0);
-    const std::vector<casacore::MPosition> kAntPos(3);
-    info.set(kAntNames, kAntDiam, kAntPos, kAnt1, kAnt2);
-
-    std::vector<double> chan_freqs(1, 10.0e6);
-    std::vector<double> chan_widths(1, 3.0e6);
-
-    info.set(std::move(chan_freqs), std::move(chan_widths));
-    predict_->setInfo(info);
-  }
+  void SetInfo() { predict_->setInfo(CreateInfo()); }
 
  protected:
   dp3::steps::MockInput input_;
@@ -179,4 +184,82 @@ BOOST_FIXTURE_TEST_CASE(showTimings, OnePredictFixture) {
   }
 }
 
+const std::string kMixedSkymodelName = "mixed_polarization.skymodel";
+
+// A Stokes I only source and a polarized source, which are predicted with
+// one and four correlations, respectively.
+const std::string kMixedSkymodel =
+    R"(FORMAT = Name, Type, Ra, Dec, I, Q, U, V, ReferenceFrequency='10e6', SpectralIndex='[0.0]'
+unpolarized, POINT, 00:00:10.0, +00.10.00.0, 1, 0, 0, 0, ,
+polarized, POINT, 00:00:20.0, -00.10.00.0, 2, 0.5, 0.25, 0.125, ,
+)";
+
+/// Predicts the unpolarized and polarized source of kMixedSkymodel with
+/// separate OnePredict steps, like the directions of H5ParmPredict.
+/// @param share_buffer If true, the steps share a single PredictBuffer.
+/// @return The predicted data of both steps.
+std::vector<casacore::Cube<casacore::Complex>> PredictMixedPolarization(
+    bool share_buffer) {
+  dp3::steps::MockInput input;
+  dp3::common::ParameterSet parset;
+  parset.add("unpolarized.sourcedb", kMixedSkymodelName);
+  parset.add("polarized.sourcedb", kMixedSkymodelName);
+
+  const auto shared_buffer = std::make_shared<dp3::base::PredictBuffer>();
+  std::vector<std::shared_ptr<OnePredict>> predicts;
+  std::vector<std::shared_ptr<dp3::steps::ResultStep>> results;
+  for (const std::string& name : {"unpolarized", "polarized"}) {
+    predicts.push_back(std::make_shared<OnePredict>(
+        &input, parset, name + ".", std::vector<std::string>{name}));
+    results.push_back(std::make_shared<dp3::steps::ResultStep>());
+    predicts.back()->setNextStep(results.back());
+    if (share_buffer) predicts.back()->SetPredictBuffer(shared_buffer);
+  }
+
+  // All steps get their info before processing any data, as in
+  // H5ParmPredict.
+  for (const std::shared_ptr<OnePredict>& predict : predicts) {
+    predict->setInfo(CreateInfo(kNCorr));
+  }
+
+  const dp3::base::DPBuffer buffer =
+      CreateBuffer(kStartTime, kInterval, kNBaselines, {1}, 0.0);
+  std::vector<casacore::Cube<casacore::Complex>> predicted;
+  for (size_t i = 0; i < predicts.size(); ++i) {
+    predicts[i]->process(buffer);
+    predicted.push_back(results[i]->get().getData().copy());
+  }
+  return predicted;
+}
+
+BOOST_AUTO_TEST_CASE(
+    shared_buffer_mixed_polarization,
+    // clang-format off
+    *boost::unit_test::fixture<FixtureDirectory>()
+    *boost::unit_test::fixture<FixtureSkymodel>(FixtureSkymodel::Arguments{
+            kMixedSkymodelName, "", kMixedSkymodel})) {
+  // clang-format on
+  const std::vector<casacore::Cube<casacore::Complex>> separate =
+      PredictMixedPolarization(false);
+  const std::vector<casacore::Cube<casacore::Complex>> shared =
+      PredictMixedPolarization(true);
+
+  BOOST_REQUIRE_EQUAL(separate.size(), 2u);
+  BOOST_REQUIRE_EQUAL(shared.size(), 2u);
+  // The unpolarized source is only visible in XX and YY.
+  BOOST_CHECK_GT(std::abs(separate[0](0, 0, 0)), 0.5);
+  BOOST_CHECK_GT(std::abs(separate[0](3, 0, 0)), 0.5);
+  BOOST_CHECK_LT(std::abs(separate[0](1, 0, 0)), 1.0e-6);
+  BOOST_CHECK_GT(std::abs(separate[1](1, 0, 0)), 0.1);
+
+  for (size_t direction = 0; direction < separate.size(); ++direction) {
+    BOOST_REQUIRE(shared[direction].shape() == separate[direction].shape());
+    for (size_t i = 0; i < separate[direction].size(); ++i) {
+      BOOST_CHECK_LT(std::abs(shared[direction].data()[i] -
+                              separate[direction].data()[i]),
+                     1.0e-6);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -54,6 +54,26 @@ class TestInput : public dp3::steps::InputStep {
     info().set(std::move(chanFreqs), std::move(chanWidth));
   }
 
+  // Give the odd baselines BDA channels, which average every 4 channels.
+  void averageOddBaselines() {
+    std::vector<std::vector<double>> chanFreqs;
+    std::vector<std::vector<double>> chanWidths;
+    for (unsigned int bl = 0; bl < info().nbaselines(); ++bl) {
+      chanFreqs.push_back(std::vector<double>());
+      chanWidths.push_back(std::vector<double>());
+      for (int i = 0; i < itsNChan; ++i) {
+        if (bl % 2 == 0) {
+          chanFreqs.back().push_back(1050000. + i * 100000.);
+          chanWidths.back().push_back(100000.);
+        } else if (i % 4 == 0) {
+          chanFreqs.back().push_back(1200000. + i * 100000.);
+          chanWidths.back().push_back(400000.);
+        }
+      }
+    }
+    info().set(std::move(chanFreqs), std::move(chanWidths));
+  }
+
  private:
   virtual bool process(const dp3::base::DPBuffer&) { return false; }
   virtual void finish() {}
@@ -83,6 +103,7 @@ class TestPSet {
   void testChan1();
   void testChan2();
   void testChan3();
+  void testBdaChan();
 
   void testTime1();
   void testTime2();
@@ -218,6 +239,29 @@ void TestPSet::testChan3() {
   BOOST_CHECK_EQUAL(pset.itsChannels[0], size_t{4});
 }
 
+void TestPSet::testBdaChan() {
+  in_->averageOddBaselines();
+  parset_.add("chan", "[3]");
+  PreFlagger::PSet pset(in_.get(), parset_, "");
+  pset.updateInfo(in_->getInfo(), true);
+  BOOST_CHECK_EQUAL(pset.itsBdaChanFlags.size(), size_t{16});
+  BOOST_CHECK_EQUAL(pset.itsBdaChanFlags[0].shape(),
+                    casacore::IPosition(2, 4, 8));
+  BOOST_CHECK_EQUAL(pset.itsBdaChanFlags[1].shape(),
+                    casacore::IPosition(2, 4, 2));
+  for (unsigned int i = 0; i < 8; ++i) {
+    BOOST_CHECK(allEQ(pset.itsBdaChanFlags[0].column(i), i == 3));
+  }
+  BOOST_CHECK(allEQ(pset.itsBdaChanFlags[1].column(0), true));
+  BOOST_CHECK(allEQ(pset.itsBdaChanFlags[1].column(1), false));
+  // The channels are the full resolution channels covered by flagged
+  // averaged channels.
+  BOOST_CHECK_EQUAL(pset.itsChannels.size(), size_t{4});
+  for (unsigned int i = 0; i < 4; ++i) {
+    BOOST_CHECK_EQUAL(pset.itsChannels[i], size_t{i});
+  }
+}
+
 void TestPSet::testTime1() {
   parset_.add("abstime", "[1mar2009/12:00:00..2mar2009/13:00:00]");
   PreFlagger::PSet pset(in_.get(), parset_, "");
@@ -365,6 +409,7 @@ BOOST_AUTO_TEST_CASE(test_bl_error3) { TestPSet().testBLError3(); }
 BOOST_AUTO_TEST_CASE(test_chan1) { TestPSet().testChan1(); }
 BOOST_AUTO_TEST_CASE(test_chan2) { TestPSet().testChan2(); }
 BOOST_AUTO_TEST_CASE(test_chan3) { TestPSet().testChan3(); }
+BOOST_AUTO_TEST_CASE(test_bda_chan) { TestPSet().testBdaChan(); }
 
 BOOST_AUTO_TEST_CASE(test_time1) { TestPSet().testTime1(); }
 BOOST_AUTO_TEST_CASE(test_time2) { TestPSet().testTime2(); }
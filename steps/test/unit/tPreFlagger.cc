@@ -10,6 +10,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "tStepCommon.h"
+#include "mock/MockInput.h"
 #include "../../PreFlagger.h"
 #include "../../Counter.h"
 #include "../../InputStep.h"
@@ -23,6 +24,7 @@ using dp3::base::DPInfo;
 using dp3::common::ParameterSet;
 using dp3::steps::Counter;
 using dp3::steps::InputStep;
+using dp3::steps::MockInput;
 using dp3::steps::PreFlagger;
 using dp3::steps::Step;
 using std::vector;
@@ -537,6 +539,14 @@ void testMany() {
   test6("blmin", "10", "blmax", "145", &checkBLMinMax);
 }
 
+// Flag BDA data and the regular data it expands to, using the same parset.
+void testBda(const ParameterSet& parset) {
+  MockInput input;
+  dp3::steps::test::CheckBdaFlagging(
+      std::make_shared<PreFlagger>(&input, parset, ""),
+      std::make_shared<PreFlagger>(&input, parset, "", Step::MsType::kBda));
+}
+
 BOOST_AUTO_TEST_CASE(test_1) { test1(10, 16, 32, 4, false, true, false); }
 
 BOOST_AUTO_TEST_CASE(test_2) { test1(10, 16, 32, 4, true, true, false); }
@@ -565,4 +575,33 @@ BOOST_AUTO_TEST_CASE(test_13) { test4(3, 16, 32, 4, false); }
 
 BOOST_AUTO_TEST_CASE(test_many) { testMany(); }
 
+BOOST_AUTO_TEST_CASE(bda_baseline_channel) {
+  ParameterSet parset;
+  parset.add("baseline", "[[ant1,ant3],[ant2,ant3]]");
+  parset.add("chan", "[1,5..6]");
+  testBda(parset);
+}
+
+BOOST_AUTO_TEST_CASE(bda_timeslot) {
+  ParameterSet parset;
+  parset.add("timeslot", "[1]");
+  parset.add("chan", "[3]");
+  testBda(parset);
+}
+
+BOOST_AUTO_TEST_CASE(bda_amplitude) {
+  ParameterSet parset;
+  parset.add("amplmin", "2.7");
+  testBda(parset);
+}
+
+BOOST_AUTO_TEST_CASE(bda_expression) {
+  ParameterSet parset;
+  parset.add("expr", "s1 | s2");
+  parset.add("s1.uvmmin", "30");
+  parset.add("s2.timeslot", "[3]");
+  parset.add("s2.chan", "[6..7]");
+  testBda(parset);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
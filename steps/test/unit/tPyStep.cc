@@ -124,7 +124,8 @@ class TestOutput final : public Step {
 };
 
 // Test simple python step
-void test(int ntime, int nbl, int nchan, int ncorr) {
+void test(int ntime, int nbl, int nchan, int ncorr,
+          const std::string& class_name = "MockPyStep") {
   // Weak pointer that will be used to monitor the lifetime of the last step
   // Because of the complicated ownership across the Python-C++ boundary
   // we need to check whether the steps are destroyed at the right time
@@ -138,7 +139,7 @@ void test(int ntime, int nbl, int nchan, int ncorr) {
     // Requires mockpystep to be on the PYTHONPATH!
     ParameterSet parset;
     parset.add("python.module", "mockpystep");
-    parset.add("python.class", "MockPyStep");
+    parset.add("python.class", class_name);
     parset.add("datafactor", "2");
     parset.add("weightsfactor", "0.5");
     {
@@ -153,9 +154,9 @@ void test(int ntime, int nbl, int nchan, int ncorr) {
       // indeed redirected to output stream
       std::ostringstream output_stream_step;
       step2->show(output_stream_step);
-      BOOST_TEST(
-          output_stream_step.str() ==
-          "\nMockPyStep\n  data factor:    2.0\n  weights factor: 0.5\n");
+      BOOST_TEST(output_stream_step.str() ==
+                 "\n" + class_name +
+                     "\n  data factor:    2.0\n  weights factor: 0.5\n");
 
       dp3::steps::test::Execute({step1, step2, step3});
     }
@@ -171,6 +172,11 @@ void test(int ntime, int nbl, int nchan, int ncorr) {
 
 BOOST_AUTO_TEST_CASE(testpystep) { test(10, 3, 32, 4); }
 
+// The last batch of MockPyBatchStep only has two time slots.
+BOOST_AUTO_TEST_CASE(testpybatchstep) {
+  test(10, 3, 32, 4, "MockPyBatchStep");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace pythondp3
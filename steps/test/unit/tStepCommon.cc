@@ -4,9 +4,18 @@
 /// This file has generic helper routines for testing steps.
 
 #include "tStepCommon.h"
+#include "mock/MockStep.h"
+#include "../../BDAExpander.h"
 #include "../../../base/DPBuffer.h"
 #include "../../../base/DPInfo.h"
 
+#include <boost/make_unique.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 namespace dp3 {
 namespace steps {
 namespace test {
@@ -36,6 +45,177 @@ dp3::common::ParameterSet CreateParameterSet(
   return result;
 }
 
+base::DPInfo CreateTestInfo(unsigned int n_times, unsigned int n_channels) {
+  base::DPInfo info;
+  info.init(4, 0, n_channels, n_times, 4472025740.0, 5.0, "", "");
+  const std::vector<std::string> names{"ant1", "ant2", "ant3"};
+  const std::vector<casacore::MPosition> positions{
+      casacore::MVPosition{0, 0, 0}, casacore::MVPosition{300, 0, 0},
+      casacore::MVPosition{200, 400, 0}};
+  const std::vector<double> diameters(names.size(), 70.0);
+  const std::vector<int> ant1{0, 0, 1};
+  const std::vector<int> ant2{1, 2, 2};
+  info.set(names, diameters, positions, ant1, ant2);
+  std::vector<double> freqs(n_channels);
+  for (unsigned int ch = 0; ch < n_channels; ++ch) {
+    freqs[ch] = 100.0e6 + ch * 1.0e6;
+  }
+  info.set(std::move(freqs), std::vector<double>(n_channels, 1.0e6));
+  return info;
+}
+
+base::DPInfo CreateBdaInfo(const base::DPInfo& regular_info,
+                           const std::vector<BdaAveraging>& averaging) {
+  BOOST_REQUIRE_EQUAL(averaging.size(), regular_info.nbaselines());
+  const std::vector<double>& full_res_freqs = regular_info.chanFreqs();
+  const std::vector<double>& full_res_widths = regular_info.chanWidths();
+  std::vector<std::vector<double>> freqs(averaging.size());
+  std::vector<std::vector<double>> widths(averaging.size());
+  for (std::size_t bl = 0; bl < averaging.size(); ++bl) {
+    std::size_t first = 0;
+    for (unsigned int n : averaging[bl].n_channels) {
+      const std::size_t last = first + n - 1;
+      BOOST_REQUIRE_LT(last, full_res_freqs.size());
+      // The channel lies halfway the edges of the channels it covers.
+      freqs[bl].push_back(0.5 * (full_res_freqs[first] -
+                                 0.5 * full_res_widths[first] +
+                                 full_res_freqs[last] +
+                                 0.5 * full_res_widths[last]));
+      widths[bl].push_back(std::accumulate(full_res_widths.begin() + first,
+                                           full_res_widths.begin() + last + 1,
+                                           0.0));
+      first = last + 1;
+    }
+    BOOST_REQUIRE_EQUAL(first, full_res_freqs.size());
+  }
+  base::DPInfo bda_info(regular_info);
+  bda_info.set(std::move(freqs), std::move(widths));
+  bda_info.setIsBDAIntervalFactorInteger(true);
+  return bda_info;
+}
+
+std::unique_ptr<base::BDABuffer> CreateBdaBuffer(
+    const base::DPInfo& bda_info, const std::vector<BdaAveraging>& averaging) {
+  const unsigned int n_correlations = bda_info.ncorr();
+  std::size_t pool_size = 0;
+  for (const BdaAveraging& bl_averaging : averaging) {
+    BOOST_REQUIRE_EQUAL(bda_info.ntime() % bl_averaging.n_times, 0u);
+    pool_size += bda_info.ntime() / bl_averaging.n_times *
+                 bl_averaging.n_channels.size() * n_correlations;
+  }
+  auto buffer = boost::make_unique<base::BDABuffer>(pool_size);
+  // BDABuffer requires adding the rows in the order of their end times.
+  for (unsigned int end = 1; end <= bda_info.ntime(); ++end) {
+    for (std::size_t bl = 0; bl < averaging.size(); ++bl) {
+      const unsigned int n_times = averaging[bl].n_times;
+      if (end % n_times != 0) continue;
+      const unsigned int first = end - n_times;
+      const double interval = n_times * bda_info.timeInterval();
+      const double time = bda_info.startTime() +
+                          first * bda_info.timeInterval() + 0.5 * interval;
+      const std::size_t n_channels = averaging[bl].n_channels.size();
+      std::vector<std::complex<float>> data;
+      for (std::size_t chan = 0; chan < n_channels; ++chan) {
+        for (unsigned int corr = 0; corr < n_correlations; ++corr) {
+          data.emplace_back(1.0 + chan + 0.25 * corr, bl + 0.5 * first);
+        }
+      }
+      const std::vector<float> weights(data.size(), 1.0);
+      const double uvw[3]{10.0 * (bl + 1) + first, 20.0 * (bl + 1) - first,
+                          1.0 + bl};
+      BOOST_REQUIRE(buffer->AddRow(time, interval, interval, bl, n_channels,
+                                   n_correlations, data.data(), nullptr,
+                                   weights.data(), nullptr, uvw));
+    }
+  }
+  return buffer;
+}
+
+std::vector<base::DPBuffer> ExpandBda(const base::DPInfo& bda_info,
+                                      const base::BDABuffer& buffer,
+                                      base::DPInfo& regular_info) {
+  auto expander = std::make_shared<BDAExpander>("expander.");
+  auto result_step = std::make_shared<MultiResultStep>(bda_info.ntime());
+  expander->setNextStep(result_step);
+  regular_info = expander->setInfo(bda_info);
+  expander->process(
+      boost::make_unique<base::BDABuffer>(buffer, base::BDABuffer::Fields()));
+  expander->finish();
+  BOOST_REQUIRE_EQUAL(result_step->size(), bda_info.ntime());
+  return result_step->get();
+}
+
+void CheckBdaFlags(const std::vector<BdaAveraging>& averaging,
+                   const base::DPInfo& bda_info, const base::BDABuffer& buffer,
+                   const std::vector<base::DPBuffer>& regular_buffers) {
+  BOOST_REQUIRE_EQUAL(regular_buffers.size(), bda_info.ntime());
+  for (const base::BDABuffer::Row& row : buffer.GetRows()) {
+    const BdaAveraging& bl_averaging = averaging[row.baseline_nr];
+    const unsigned int first_slot = std::round(
+        (row.time - 0.5 * row.interval - bda_info.startTime()) /
+        bda_info.timeInterval());
+    BOOST_REQUIRE_EQUAL(row.n_channels, bl_averaging.n_channels.size());
+    unsigned int first_chan = 0;
+    for (std::size_t chan = 0; chan < row.n_channels; ++chan) {
+      const unsigned int end_chan = first_chan + bl_averaging.n_channels[chan];
+      for (std::size_t corr = 0; corr < row.n_correlations; ++corr) {
+        bool expected = false;
+        for (unsigned int slot = first_slot;
+             slot < first_slot + bl_averaging.n_times; ++slot) {
+          const casacore::Cube<bool>& flags = regular_buffers[slot].getFlags();
+          for (unsigned int ch = first_chan; ch < end_chan; ++ch) {
+            expected = expected || flags(corr, ch, row.baseline_nr);
+          }
+        }
+        BOOST_CHECK_EQUAL(row.flags[chan * row.n_correlations + corr],
+                          expected);
+      }
+      first_chan = end_chan;
+    }
+  }
+}
+
+void CheckBdaFlagging(const std::shared_ptr<Step>& regular_step,
+                      const std::shared_ptr<Step>& bda_step) {
+  const std::vector<BdaAveraging> averaging{{1, {1, 1, 1, 1, 1, 1, 1, 1}},
+                                            {2, {2, 2, 2, 2}},
+                                            {4, {1, 3, 4}}};
+  const base::DPInfo bda_info = CreateBdaInfo(CreateTestInfo(4, 8), averaging);
+  std::unique_ptr<base::BDABuffer> bda_buffer =
+      CreateBdaBuffer(bda_info, averaging);
+  base::DPInfo regular_info;
+  const std::vector<base::DPBuffer> regular_buffers =
+      ExpandBda(bda_info, *bda_buffer, regular_info);
+
+  auto regular_result =
+      std::make_shared<MultiResultStep>(regular_buffers.size());
+  regular_step->setNextStep(regular_result);
+  regular_step->setInfo(regular_info);
+  for (const base::DPBuffer& buffer : regular_buffers) {
+    regular_step->process(buffer);
+  }
+  regular_step->finish();
+
+  auto bda_result = std::make_shared<MockStep>();
+  bda_step->setNextStep(bda_result);
+  bda_step->setInfo(bda_info);
+  bda_step->process(std::move(bda_buffer));
+  bda_step->finish();
+
+  BOOST_REQUIRE_EQUAL(bda_result->GetBdaBuffers().size(), 1u);
+  const base::BDABuffer& flagged = *bda_result->GetBdaBuffers().front();
+  CheckBdaFlags(averaging, bda_info, flagged, regular_result->get());
+  std::size_t n_flagged = 0;
+  std::size_t n_samples = 0;
+  for (const base::BDABuffer::Row& row : flagged.GetRows()) {
+    const std::size_t size = row.GetDataSize();
+    n_flagged += std::count(row.flags, row.flags + size, true);
+    n_samples += size;
+  }
+  BOOST_CHECK_GT(n_flagged, 0u);
+  BOOST_CHECK_LT(n_flagged, n_samples);
+}
+
 }  // namespace test
 }  // namespace steps
 }  // namespace dp3
@@ -8,7 +8,11 @@
 
 #include "../../Step.h"
 #include "../../InputStep.h"
+#include "../../../base/BDABuffer.h"
+#include "../../../base/DPBuffer.h"
+#include "../../../base/DPInfo.h"
 #include "../../../common/ParameterSet.h"
+#include <memory>
 #include <vector>
 
 namespace dp3 {
@@ -43,6 +47,71 @@ inline std::string Show(const dp3::common::ParameterSet& parset) {
   return output.str();
 }
 
+/**
+ * Create the info of regular test data with 4 correlations and 3 antennas,
+ * named ant1, ant2 and ant3. The baselines are ant1-ant2, ant1-ant3 and
+ * ant2-ant3. The channels are 1 MHz wide, starting at 100 MHz, and the
+ * time slots are 5 s long.
+ */
+base::DPInfo CreateTestInfo(unsigned int n_times, unsigned int n_channels);
+
+/// The averaging of a baseline in BDA test data.
+struct BdaAveraging {
+  /// Number of full resolution time slots that each row covers.
+  unsigned int n_times;
+  /// Number of full resolution channels that each channel covers.
+  std::vector<unsigned int> n_channels;
+};
+
+/**
+ * Create the info of BDA data from the info of regular data, which defines
+ * the full resolution channels and time slots. The averaging of a baseline
+ * defines its channel frequencies and widths.
+ */
+base::DPInfo CreateBdaInfo(const base::DPInfo& regular_info,
+                           const std::vector<BdaAveraging>& averaging);
+
+/**
+ * Create a BDA buffer with all rows of the observation in the given BDA
+ * info, averaged as given. The data of the rows differ per row, channel and
+ * correlation. The flags are false and the weights are one. The UVWs differ
+ * per row.
+ */
+std::unique_ptr<base::BDABuffer> CreateBdaBuffer(
+    const base::DPInfo& bda_info, const std::vector<BdaAveraging>& averaging);
+
+/**
+ * Expand BDA data to regular data using a BDAExpander.
+ * @param bda_info The info of the BDA data.
+ * @param buffer BDA buffer with all rows of the observation.
+ * @param[out] regular_info The info of the expanded data.
+ * @return The expanded buffers, one per time slot.
+ */
+std::vector<base::DPBuffer> ExpandBda(const base::DPInfo& bda_info,
+                                      const base::BDABuffer& buffer,
+                                      base::DPInfo& regular_info);
+
+/**
+ * Check that each channel of a BDA row is flagged if, and only if, one of the
+ * full resolution samples that it covers is flagged in the regular buffers.
+ * The BDA data must be averaged as given.
+ */
+void CheckBdaFlags(const std::vector<BdaAveraging>& averaging,
+                   const base::DPInfo& bda_info, const base::BDABuffer& buffer,
+                   const std::vector<base::DPBuffer>& regular_buffers);
+
+/**
+ * Test that a step flags BDA data like it flags the regular data that the BDA
+ * data expands to. The steps should be configured the same, except for their
+ * input type. The test data has 4 time slots and 8 channels, see
+ * @ref CreateTestInfo. Its first baseline is not averaged, its second
+ * baseline averages 2 time slots and pairs of channels and its third
+ * baseline averages all time slots and channel groups of 1, 3 and 4
+ * channels. The steps should flag part, but not all, of the data.
+ */
+void CheckBdaFlagging(const std::shared_ptr<Step>& regular_step,
+                      const std::shared_ptr<Step>& bda_step);
+
 }  // namespace test
 }  // namespace steps
 }  // namespace dp3
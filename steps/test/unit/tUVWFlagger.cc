@@ -5,6 +5,7 @@
 // @author Ger van Diepen
 
 #include "tStepCommon.h"
+#include "mock/MockInput.h"
 
 #include "../../UVWFlagger.h"
 #include "../../InputStep.h"
@@ -24,6 +25,7 @@ using dp3::base::DPBuffer;
 using dp3::base::DPInfo;
 using dp3::common::ParameterSet;
 using dp3::steps::InputStep;
+using dp3::steps::MockInput;
 using dp3::steps::Step;
 using std::vector;
 
@@ -361,6 +363,15 @@ void test3(int ntime, int nbl, int nchan, int ncorr) {
   dp3::steps::test::Execute({step1, step2, step3});
 }
 
+// Flag BDA data and the regular data it expands to, using the same parset.
+void testBda(const ParameterSet& parset) {
+  MockInput input;
+  dp3::steps::test::CheckBdaFlagging(
+      std::make_shared<dp3::steps::UVWFlagger>(&input, parset, ""),
+      std::make_shared<dp3::steps::UVWFlagger>(&input, parset, "",
+                                               Step::MsType::kBda));
+}
+
 }  // namespace
 
 BOOST_AUTO_TEST_SUITE(uvwflagger)
@@ -388,4 +399,20 @@ BOOST_AUTO_TEST_CASE(sun_as_phase_center) {
       std::make_shared<dp3::steps::UVWFlagger>(in.get(), parset, ""));
 }
 
+BOOST_AUTO_TEST_CASE(bda_meters) {
+  // The u coordinate of the BDA test data differs per row.
+  ParameterSet parset;
+  parset.add("umrange", "[11.5..21]");
+  testBda(parset);
+}
+
+BOOST_AUTO_TEST_CASE(bda_lambda) {
+  // The w coordinates of the BDA test data are 1, 2 and 3 m for the three
+  // baselines. Each range starts near 103.5 MHz for one of the baselines,
+  // which is the edge of a channel group in all baselines.
+  ParameterSet parset;
+  parset.add("wlambdarange", "[0.3452..0.5, 0.6904..0.9, 1.0355..2]");
+  testBda(parset);
+}
+
 BOOST_AUTO_TEST_SUITE_END()